@@ -0,0 +1,173 @@
+"""Export the pickled scikit-learn models to the plain-text files read by scoring_service.cpp.
+
+The pickles are decoded with small stand-ins for the numpy and scikit-learn
+classes they reference, so neither library has to be installed:
+
+    python export_models.py
+
+writes models/kmeans_model.txt, models/best_dbscan_model.txt and
+models/isolation_forest_model.txt next to the .pkl files. If the StandardScaler
+the models were trained behind is pickled as models/scaler.pkl, its mean_ and
+scale_ go to models/scaler.txt, and scoring_service.cpp standardises the raw
+values main.py sends with them.
+"""
+import os
+import pickle
+import struct
+
+# Step 1: Minimal stand-ins for the classes named in the pickles
+
+class Stub:
+    """Any scikit-learn object: keeps its constructor arguments and pickled state."""
+
+    def __init__(self, *args):
+        self.args = args
+
+    def __setstate__(self, state):
+        if isinstance(state, dict):
+            self.__dict__.update(state)
+        else:
+            self.state = state
+
+
+class DType:
+    """numpy.dtype: element format, size and (for record types) named fields."""
+
+    def __init__(self, name, align=False, copy=True):
+        self.name = name
+        self.fields = None
+        self.names = None
+
+    def __setstate__(self, state):
+        # (version, byte order, subarray, names, fields, itemsize, alignment, flags)
+        self.order = '<' if state[1] in ('<', '|', '=') else '>'
+        self.names = state[3]
+        self.fields = state[4]
+
+    def size(self):
+        return int(self.name[1:])
+
+    def unpack(self, raw, count):
+        if self.fields:
+            field_formats = [(self.fields[name][0], self.fields[name][1]) for name in self.names]
+            rows = []
+            for i in range(count):
+                base = i * self.size()
+                row = {}
+                for name, (dtype, offset) in zip(self.names, field_formats):
+                    row[name] = struct.unpack_from(self.order + dtype.code(), raw, base + offset)[0]
+                rows.append(row)
+            return rows
+        return list(struct.unpack(self.order + self.code() * count, raw[:count * self.size()]))
+
+    def code(self):
+        return {'f8': 'd', 'f4': 'f', 'i8': 'q', 'i4': 'i', 'u8': 'Q', 'u1': 'B'}[self.name]
+
+
+class NDArray:
+    """numpy.ndarray: shape and a flat list of its elements."""
+
+    def __init__(self, *args):
+        self.shape = ()
+        self.values = []
+
+    def __setstate__(self, state):
+        # (version, shape, dtype, is_fortran, raw data or list of objects)
+        _, self.shape, dtype, _, data = state
+        count = 1
+        for extent in self.shape:
+            count *= extent
+        self.values = data if isinstance(data, list) else dtype.unpack(data, count)
+
+
+def reconstruct(cls, shape, typecode):
+    return NDArray()
+
+
+def scalar(dtype, raw):
+    return dtype.unpack(raw, 1)[0]
+
+
+class ModelUnpickler(pickle.Unpickler):
+    def find_class(self, module, name):
+        if module.startswith('numpy') and name == '_reconstruct':
+            return reconstruct
+        if module.startswith('numpy') and name == 'scalar':
+            return scalar
+        if module.startswith('numpy') and name == 'dtype':
+            return DType
+        if module.startswith('numpy') and name == 'ndarray':
+            return NDArray
+        return type(name, (Stub,), {})
+
+
+def load(filename):
+    with open(filename, 'rb') as file:
+        return ModelUnpickler(file).load()
+
+
+def rows(array, width):
+    return [array.values[i:i + width] for i in range(0, len(array.values), width)]
+
+# Step 2: Write each model's parameters
+
+def header(out, kind, model):
+    out.write('FAI %s 1\n' % kind)
+    out.write('features %d %s\n' % (len(model.feature_names_in_.values), ' '.join(model.feature_names_in_.values)))
+
+
+def export_kmeans(model, filename):
+    width = model.n_features_in_
+    with open(filename, 'w') as out:
+        header(out, 'kmeans', model)
+        centers = rows(model.cluster_centers_, width)
+        out.write('centers %d\n' % len(centers))
+        for center in centers:
+            out.write(' '.join(repr(float(v)) for v in center) + '\n')
+
+
+def export_dbscan(model, filename):
+    width = model.n_features_in_
+    with open(filename, 'w') as out:
+        header(out, 'dbscan', model)
+        out.write('eps %r\n' % float(model.eps))
+        out.write('min_samples %d\n' % model.min_samples)
+        core = rows(model.components_, width) if hasattr(model, 'components_') else []
+        labels = [model.labels_.values[i] for i in model.core_sample_indices_.values] if core else []
+        out.write('core_points %d\n' % len(core))
+        for point, label in zip(core, labels):
+            out.write(' '.join(repr(float(v)) for v in point) + ' %d\n' % label)
+
+
+def export_isolation_forest(model, filename):
+    # Trees index the feature subset they were trained on only when features were subsampled
+    subsampled = model._max_features != model.n_features_in_
+    with open(filename, 'w') as out:
+        header(out, 'isolation_forest', model)
+        out.write('max_samples %d\n' % model.max_samples_)
+        out.write('offset %r\n' % float(model.offset_))
+        out.write('trees %d\n' % len(model.estimators_))
+        for estimator, features in zip(model.estimators_, model.estimators_features_):
+            nodes = estimator.tree_.nodes.values
+            out.write('tree %d\n' % len(nodes))
+            for node in nodes:
+                feature = node['feature']
+                if subsampled and feature >= 0:
+                    feature = features.values[feature]
+                out.write('%d %d %d %r %d\n' % (node['left_child'], node['right_child'], feature,
+                                                float(node['threshold']), node['n_node_samples']))
+
+
+def export_scaler(model, filename):
+    with open(filename, 'w') as out:
+        header(out, 'scaler', model)
+        out.write('mean %s\n' % ' '.join(repr(float(v)) for v in model.mean_.values))
+        out.write('scale %s\n' % ' '.join(repr(float(v)) for v in model.scale_.values))
+
+
+if __name__ == '__main__':
+    export_kmeans(load('models/kmeans_model.pkl'), 'models/kmeans_model.txt')
+    export_dbscan(load('models/best_dbscan_model.pkl'), 'models/best_dbscan_model.txt')
+    export_isolation_forest(load('models/isolation_forest_model.pkl'), 'models/isolation_forest_model.txt')
+    if os.path.exists('models/scaler.pkl'):
+        export_scaler(load('models/scaler.pkl'), 'models/scaler.txt')
@@ -0,0 +1,498 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../common/clustering.h"
+#include "../common/isolation_forest.h"
+#include "../common/model_text.h"
+#include "../common/parquet_reader.h"
+#include "../common/task_scheduler.h"
+
+using namespace std;
+
+// Features every model of the project scores, in the order of their model files
+const vector<string> FLOW_FEATURES = {"dur", "tot_pkts", "tot_bytes", "src_bytes"};
+
+// The four CTU-13 captures of the project
+const vector<string> CAPTURE_FILES = {
+    "data/11-Rbot-20110818-2.binetflow.parquet", "data/12-NsisAy-20110819.binetflow.parquet",
+    "data/5-Virut-20110815-2.binetflow.parquet", "data/7-Sogou-20110816-2.binetflow.parquet"};
+
+// Flows the grid DBSCAN is checked against the quadratic one on
+const size_t DBSCAN_CHECK_ROWS = 4096;
+
+// Bytes read from a connection at a time; every complete line in them is scored as one batch
+const size_t SOCKET_READ_BYTES = 64 * 1024;
+
+// Longest unfinished request line a connection may hold; a client that sends more is disconnected
+const size_t MAX_PENDING_BYTES = 1 << 20;
+
+/**
+ * @struct FlowScaler
+ * @brief The z-score transform the models were trained behind: (value - mean) / scale per column.
+ *
+ * The Flask app sends raw flow values, so the service standardises every request
+ * with this before scoring. load() reads the scikit-learn StandardScaler that
+ * export_models.py writes to scaler.txt:
+ *
+ *   FAI scaler 1
+ *   features 4 dur tot_pkts tot_bytes src_bytes
+ *   mean <4 numbers>
+ *   scale <4 numbers>
+ */
+struct FlowScaler {
+    vector<string> features;
+    vector<double> mean, scale;
+
+    bool load(const string& filename) {
+        ifstream in(filename);
+        FlowScaler loaded;
+        string word;
+        if (!read_model_header(in, "scaler", loaded.features)) return false;
+        loaded.mean.resize(loaded.features.size());
+        loaded.scale.resize(loaded.features.size());
+        if (!(in >> word) || word != "mean") return false;
+        for (double& value : loaded.mean) {
+            if (!(in >> value)) return false;
+        }
+        if (!(in >> word) || word != "scale") return false;
+        for (double& value : loaded.scale) {
+            if (!(in >> value) || !(value > 0.0)) return false;
+        }
+        *this = move(loaded);
+        return true;
+    }
+
+    /**
+     * @brief Fits the transform to row-major `rows` (mean and population standard deviation per column)
+     *
+     * A constant column gets scale 1, as StandardScaler does.
+     */
+    static FlowScaler fit(const vector<string>& features, const vector<double>& rows) {
+        const size_t width = features.size(), count = rows.size() / max<size_t>(width, 1);
+        FlowScaler scaler;
+        scaler.features = features;
+        scaler.mean.assign(width, 0.0);
+        scaler.scale.assign(width, 0.0);
+        for (size_t f = 0; f < width; ++f) {
+            double mean = 0.0, squares = 0.0;
+            for (size_t row = 0; row < count; ++row) mean += rows[row * width + f];
+            mean /= max<size_t>(count, 1);
+            for (size_t row = 0; row < count; ++row) {
+                squares += (rows[row * width + f] - mean) * (rows[row * width + f] - mean);
+            }
+            double stddev = sqrt(squares / max<size_t>(count, 1));
+            scaler.mean[f] = mean;
+            scaler.scale[f] = stddev == 0.0 ? 1.0 : stddev;
+        }
+        return scaler;
+    }
+
+    /**
+     * @brief Standardises `count` row-major rows in place
+     */
+    void transform(double* rows, size_t count) const {
+        const size_t width = features.size();
+        for (size_t row = 0; row < count; ++row) {
+            for (size_t f = 0; f < width; ++f) rows[row * width + f] = (rows[row * width + f] - mean[f]) / scale[f];
+        }
+    }
+};
+
+/**
+ * @struct FlowModels
+ * @brief The three models the Flask app serves, as native scoring engines, and their input scaler.
+ */
+struct FlowModels {
+    KMeansModel kmeans;
+    DbscanModel dbscan;
+    IsolationForestModel isolation;
+    FlowScaler scaler;
+};
+
+/**
+ * @struct FlowScores
+ * @brief The answers of the three models for a batch of flows.
+ */
+struct FlowScores {
+    vector<int32_t> kmeans;    // Cluster index
+    vector<int32_t> dbscan;    // Cluster index, -1 for noise
+    vector<int32_t> isolation; // -1 for an anomaly, 1 for a normal flow
+};
+
+/**
+ * @brief Loads the exported models from a directory
+ *
+ * Reads kmeans_model.txt, best_dbscan_model.txt and isolation_forest_model.txt
+ * (written by export_models.py) and checks that all three score FLOW_FEATURES.
+ *
+ * @param directory Directory holding the model files.
+ * @param models Receives the models.
+ * @return bool False if a file is missing, malformed or has other features.
+ */
+bool load_flow_models(const string& directory, FlowModels& models) {
+    if (!models.kmeans.load(directory + "/kmeans_model.txt") ||
+        !models.dbscan.load(directory + "/best_dbscan_model.txt") ||
+        !models.isolation.load(directory + "/isolation_forest_model.txt")) {
+        return false;
+    }
+    return models.kmeans.feature_names() == FLOW_FEATURES && models.dbscan.feature_names() == FLOW_FEATURES &&
+           models.isolation.feature_names() == FLOW_FEATURES;
+}
+
+/**
+ * @brief Scores `count` flows, given row-major in FLOW_FEATURES order, with all three models
+ */
+FlowScores score_flows(const FlowModels& models, const double* rows, size_t count) {
+    FlowScores scores;
+    scores.kmeans.resize(count);
+    scores.dbscan.resize(count);
+    scores.isolation.resize(count);
+    models.kmeans.predict_batch(rows, count, scores.kmeans.data());
+    models.dbscan.predict_batch(rows, count, scores.dbscan.data());
+    models.isolation.predict_batch(rows, count, scores.isolation.data());
+    return scores;
+}
+
+/**
+ * @brief Reads the four model features of a capture, unscaled
+ *
+ * @param filename Path of a .binetflow.parquet capture.
+ * @return vector<double> Row-major flows in FLOW_FEATURES order (empty if the file cannot be read).
+ */
+vector<double> load_flows(const string& filename) {
+    CsvColumns columns = read_parquet_columns(filename, FLOW_FEATURES);
+    const size_t width = FLOW_FEATURES.size();
+    vector<double> rows(columns.num_rows * width);
+    for (size_t f = 0; f < width; ++f) {
+        const vector<double>& values = columns.numbers[f];
+        for (size_t row = 0; row < values.size(); ++row) rows[row * width + f] = values[row];
+    }
+    return rows;
+}
+
+/**
+ * @brief Reads the four model features of a capture and standardises each column
+ *
+ * The models were trained on z-scored columns (see the StandardScaler cells of
+ * FAI_Project.ipynb), so every column is centred on its mean and divided by its
+ * standard deviation over the whole capture.
+ *
+ * @param filename Path of a .binetflow.parquet capture.
+ * @return vector<double> Row-major flows in FLOW_FEATURES order (empty if the file cannot be read).
+ */
+vector<double> load_standardized_flows(const string& filename) {
+    vector<double> rows = load_flows(filename);
+    FlowScaler::fit(FLOW_FEATURES, rows).transform(rows.data(), rows.size() / FLOW_FEATURES.size());
+    return rows;
+}
+
+/**
+ * @brief Answers every complete request line in `pending` and removes them from it
+ *
+ * Protocol: one flow per line, "dur tot_pkts tot_bytes src_bytes" separated by
+ * spaces or commas, in raw units as the Flask form posts them (models.scaler
+ * standardises them); the reply is one line per flow, in order,
+ * "kmeans dbscan isolation" (e.g. "0 -1 1"), or "error" for a line that does not
+ * hold four numbers. All complete lines are scored as one batch, so a client
+ * that pipelines many flows gets the batched SIMD loops.
+ *
+ * @param models The models.
+ * @param pending Bytes received so far; a trailing partial line is kept.
+ * @param response Receives the reply lines.
+ */
+void answer_requests(const FlowModels& models, string& pending, string& response) {
+    const size_t width = FLOW_FEATURES.size();
+    vector<double> rows;
+    vector<bool> valid;
+    size_t start = 0, end;
+    while ((end = pending.find('\n', start)) != string::npos) {
+        const char* p = pending.c_str() + start;
+        const char* line_end = pending.c_str() + end;
+        double values[4];
+        size_t parsed = 0;
+        while (parsed < width) {
+            while (p < line_end && (*p == ' ' || *p == ',' || *p == '\t' || *p == '\r')) ++p;
+            char* number_end;
+            double value = strtod(p, &number_end);
+            if (number_end == p || number_end > line_end) break;
+            values[parsed++] = value;
+            p = number_end;
+        }
+        while (p < line_end && (*p == ' ' || *p == ',' || *p == '\t' || *p == '\r')) ++p;
+        bool ok = parsed == width && p == line_end;
+        valid.push_back(ok);
+        if (ok) rows.insert(rows.end(), values, values + width);
+        start = end + 1;
+    }
+    pending.erase(0, start);
+
+    models.scaler.transform(rows.data(), rows.size() / width);
+    FlowScores scores = score_flows(models, rows.data(), rows.size() / width);
+    size_t row = 0;
+    for (bool ok : valid) {
+        if (!ok) {
+            response += "error\n";
+            continue;
+        }
+        response += to_string(scores.kmeans[row]) + " " + to_string(scores.dbscan[row]) + " " +
+                    to_string(scores.isolation[row]) + "\n";
+        row++;
+    }
+}
+
+/**
+ * @brief Writes all of `data` to a socket; false if the peer went away
+ *
+ * MSG_NOSIGNAL turns a write to a closed peer into an error instead of a SIGPIPE
+ * that would end the whole service.
+ */
+bool write_all(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief Serves one client until it closes the connection
+ *
+ * Only an unfinished line stays in `pending` between reads; once it grows past
+ * MAX_PENDING_BYTES the client is not speaking the protocol and is disconnected,
+ * so one connection cannot grow the buffer without bound.
+ */
+void serve_connection(const FlowModels& models, int fd) {
+    string pending, response;
+    vector<char> buffer(SOCKET_READ_BYTES);
+    ssize_t n;
+    while ((n = read(fd, buffer.data(), buffer.size())) > 0) {
+        pending.append(buffer.data(), static_cast<size_t>(n));
+        response.clear();
+        answer_requests(models, pending, response);
+        if (!write_all(fd, response) || pending.size() > MAX_PENDING_BYTES) break;
+    }
+    close(fd);
+}
+
+/**
+ * @brief Creates a Unix domain socket listening at `path`, replacing a stale socket file
+ *
+ * @return int The listening socket, or -1 on failure.
+ */
+int open_listener(const string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Connects to a scoring service at `path`; -1 on failure
+ */
+int connect_to_service(const string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Accepts clients until the listener is shut down, each on its own thread
+ *
+ * The models are only read while scoring, so every connection shares them.
+ */
+void serve(const FlowModels& models, int listener) {
+    int fd;
+    while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+        thread(serve_connection, cref(models), fd).detach();
+    }
+}
+
+int main(int argc, char** argv) {
+    // Load the exported models (run from the project directory, after export_models.py)
+    FlowModels models;
+    if (!load_flow_models("models", models)) {
+        cerr << "Cannot load the models; run export_models.py first" << endl;
+        return 1;
+    }
+    vector<double> raw_flows = load_flows(CAPTURE_FILES[0]);
+    const size_t width = FLOW_FEATURES.size(), num_flows = raw_flows.size() / width;
+    TaskScheduler scheduler;
+
+    // Requests carry raw values, as main.py posts them. They are standardised with the exported
+    // StandardScaler, or without one with a scaler fitted on the capture, as the notebook did
+    if (models.scaler.load("models/scaler.txt") && models.scaler.features == FLOW_FEATURES) {
+        cout << "Standardising requests with models/scaler.txt" << endl;
+    } else {
+        cout << "No usable models/scaler.txt; standardising requests with a scaler fitted on " << CAPTURE_FILES[0]
+             << endl;
+        models.scaler = FlowScaler::fit(FLOW_FEATURES, raw_flows);
+    }
+    vector<double> flows = raw_flows;
+    models.scaler.transform(flows.data(), num_flows);
+
+    // The pickled DBSCAN kept no core points, so refit it on the capture
+    if (models.dbscan.num_core_points() == 0 && num_flows > 0) {
+        models.dbscan.fit(flows.data(), num_flows, &scheduler);
+    }
+    cout << "Loaded KMeans (" << models.kmeans.num_clusters() << " clusters), DBSCAN (eps " << models.dbscan.eps()
+         << ", " << models.dbscan.num_core_points() << " core points), Isolation Forest ("
+         << models.isolation.num_trees() << " trees)" << endl;
+
+    // Stand in for the Flask endpoint: serve until killed
+    if (argc > 1 && string(argv[1]) == "--serve") {
+        string path = argc > 2 ? argv[2] : "scoring.sock";
+        int listener = open_listener(path);
+        if (listener < 0) {
+            cerr << "Cannot listen on " << path << endl;
+            return 1;
+        }
+        cout << "Serving on " << path << endl;
+        serve(models, listener);
+        return 0;
+    }
+    if (num_flows == 0) return 0;
+
+    // Score the whole capture in-process
+    auto start = chrono::steady_clock::now();
+    FlowScores direct = score_flows(models, flows.data(), num_flows);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    map<int32_t, size_t> kmeans_sizes, dbscan_sizes;
+    size_t anomalies = 0;
+    for (size_t i = 0; i < num_flows; ++i) {
+        kmeans_sizes[direct.kmeans[i]]++;
+        dbscan_sizes[direct.dbscan[i]]++;
+        anomalies += direct.isolation[i] == -1;
+    }
+    cout << "Capture flows: " << num_flows << ", scored in-process at " << static_cast<size_t>(num_flows / seconds)
+         << " flows/sec" << endl;
+    cout << "KMeans cluster sizes:";
+    for (const auto& size : kmeans_sizes) cout << " " << size.first << ":" << size.second;
+    cout << endl << "DBSCAN clusters: " << dbscan_sizes.size() - dbscan_sizes.count(-1) << ", noise flows: "
+         << (dbscan_sizes.count(-1) ? dbscan_sizes[-1] : 0) << endl;
+    cout << "Isolation Forest anomalies: " << anomalies << endl;
+
+    // Score it again through the socket, 1024 flows per request
+    const string path = "scoring_demo.sock";
+    int listener = open_listener(path);
+    if (listener < 0) {
+        cerr << "Cannot listen on " << path << endl;
+        return 1;
+    }
+    thread server(serve, cref(models), listener);
+    int client = connect_to_service(path);
+    bool matches = client >= 0;
+    start = chrono::steady_clock::now();
+    vector<char> buffer(SOCKET_READ_BYTES);
+    for (size_t begin = 0; matches && begin < num_flows; begin += 1024) {
+        size_t end = min(num_flows, begin + 1024);
+        ostringstream request;
+        request.precision(17);
+        for (size_t i = begin; i < end; ++i) {
+            const double* row = &raw_flows[i * width];
+            request << row[0] << " " << row[1] << " " << row[2] << " " << row[3] << "\n";
+        }
+        if (!write_all(client, request.str())) {
+            matches = false;
+            break;
+        }
+        string reply;
+        while (static_cast<size_t>(count(reply.begin(), reply.end(), '\n')) < end - begin) {
+            ssize_t n = read(client, buffer.data(), buffer.size());
+            if (n <= 0) break;
+            reply.append(buffer.data(), static_cast<size_t>(n));
+        }
+        istringstream lines(reply);
+        for (size_t i = begin; i < end; ++i) {
+            int32_t kmeans, dbscan, isolation;
+            if (!(lines >> kmeans >> dbscan >> isolation) || kmeans != direct.kmeans[i] ||
+                dbscan != direct.dbscan[i] || isolation != direct.isolation[i]) {
+                matches = false;
+                break;
+            }
+        }
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (client >= 0) close(client);
+
+    // A client whose line never ends is disconnected once it passes MAX_PENDING_BYTES
+    int flooder = connect_to_service(path);
+    bool disconnected = flooder >= 0 && write_all(flooder, string(MAX_PENDING_BYTES + 1, '1')) &&
+                        read(flooder, buffer.data(), buffer.size()) == 0;
+    if (flooder >= 0) close(flooder);
+    shutdown(listener, SHUT_RDWR);
+    server.join();
+    close(listener);
+    unlink(path.c_str());
+    cout << "Socket scoring matches in-process scoring: " << (matches ? "yes" : "no") << ", "
+         << static_cast<size_t>(num_flows / seconds) << " flows/sec" << endl;
+    cout << "Unterminated request over " << MAX_PENDING_BYTES << " bytes closes the connection: "
+         << (disconnected ? "yes" : "no") << endl;
+
+    // The grid DBSCAN gives the labels of the quadratic one
+    DbscanModel grid(FLOW_FEATURES, models.dbscan.eps(), models.dbscan.min_samples());
+    DbscanModel exhaustive = grid;
+    const size_t check_rows = min(num_flows, DBSCAN_CHECK_ROWS);
+    bool same = grid.fit(flows.data(), check_rows, &scheduler) == exhaustive.fit_exhaustive(flows.data(), check_rows);
+    cout << "Grid DBSCAN matches exhaustive DBSCAN on " << check_rows << " flows: " << (same ? "yes" : "no") << endl;
+
+    // Cluster all four captures natively, each standardised on its own
+    vector<double> all_flows;
+    for (const string& file : CAPTURE_FILES) {
+        vector<double> capture = load_standardized_flows(file);
+        all_flows.insert(all_flows.end(), capture.begin(), capture.end());
+    }
+    const size_t num_all = all_flows.size() / width;
+    vector<int32_t> hamerly_labels(num_all), lloyd_labels(num_all);
+    for (size_t k : {3, 16}) {
+        KMeansModel hamerly(FLOW_FEATURES), lloyd(FLOW_FEATURES);
+        KMeansOptions options;
+        start = chrono::steady_clock::now();
+        KMeansReport pruned = hamerly.fit(all_flows.data(), num_all, k, hamerly_labels.data(), options, &scheduler);
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        options.hamerly = false;
+        KMeansReport plain = lloyd.fit(all_flows.data(), num_all, k, lloyd_labels.data(), options, &scheduler);
+        cout << "KMeans k=" << k << " on " << num_all << " flows: " << pruned.iterations << " iterations in "
+             << seconds << " s, inertia " << pruned.inertia << ", " << pruned.distance_computations
+             << " distances (Lloyd " << plain.distance_computations << "), matches Lloyd: "
+             << (hamerly_labels == lloyd_labels && pruned.inertia == plain.inertia ? "yes" : "no") << endl;
+    }
+    start = chrono::steady_clock::now();
+    vector<int32_t> dbscan_labels = grid.fit(all_flows.data(), num_all, &scheduler);
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    map<int32_t, size_t> all_sizes;
+    for (int32_t label : dbscan_labels) all_sizes[label]++;
+    cout << "DBSCAN on " << num_all << " flows: " << all_sizes.size() - all_sizes.count(-1) << " clusters, "
+         << (all_sizes.count(-1) ? all_sizes[-1] : 0) << " noise flows, " << grid.num_core_points()
+         << " core points in " << seconds << " s" << endl;
+
+    return 0;
+}
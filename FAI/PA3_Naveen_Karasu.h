@@ -0,0 +1,179 @@
+#ifndef FAI_PA3_NAVEEN_KARASU_H
+#define FAI_PA3_NAVEEN_KARASU_H
+
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+
+#include "common/profiling.h"
+
+/**
+ * Definite-clause proof procedures of PA3: bottom-up (forward chaining to all
+ * logical consequences) and top-down (backward chaining from a query).
+ *
+ * Everything lives in namespace pa3. PA3_Naveen_Karasu.cpp is the demo program;
+ * the benchmarks build against the same header through the fai_pa3 target.
+ */
+
+namespace pa3 {
+
+using namespace std;
+
+/**
+ * @brief Represents a rule in the knowledge base.
+ *
+ * A rule consists of a head (the fact to be inferred) and a body (the conditions that need
+ * to be true for the head to be inferred). The rule can be thought of as "If all the conditions
+ * in the body are true, then the head is also true."
+ */
+struct Rule {
+    vector<string> body;  // Conditions that need to be true for the head to be inferred.
+    string head;          // The fact (head) that can be inferred when all conditions (body) are true.
+};
+
+/**
+ * @brief Checks if all conditions (body) of a rule are true (i.e., present in the set of known facts).
+ *
+ * @param body The conditions (body) of the rule.
+ * @param facts The set of known facts (truths) that have been inferred so far.
+ * @return true If all conditions in the body are true.
+ * @return false If any condition in the body is not true.
+ */
+inline bool bodySatisfied(const vector<string>& body, const unordered_set<string>& facts) {
+    for (const string& literal : body) {
+        // If any condition in the body is not found in the known facts, return false.
+        if (facts.find(literal) == facts.end()) {
+            return false;
+        }
+    }
+    // If all conditions are found in the known facts, return true.
+    return true;
+}
+
+/**
+ * @brief Bottom-up proof procedure to infer all logical consequences from a knowledge base.
+ *
+ * This function takes the knowledge base (a set of rules) and known initial facts. It iteratively
+ * applies the rules to infer new facts until no more new facts can be inferred.
+ *
+ * @param kb The knowledge base, represented as a list of rules.
+ * @param facts The initial facts (atoms known to be true).
+ * @param trace Stream that each newly inferred fact is printed to, or nullptr for none.
+ * @return The set of all facts that can be inferred from the knowledge base.
+ */
+inline unordered_set<string> bottomUpProof(const vector<Rule>& kb, unordered_set<string> facts, ostream* trace) {
+    FAI_SCOPED_TIMER("pa3::bottomUpProof");
+    // Track whether new facts are inferred in the current iteration.
+    bool addedNewFact = true;
+
+    // Keep iterating while new facts are being added.
+    while (addedNewFact) {
+        addedNewFact = false;  // Reset flag for each iteration.
+
+        // Iterate over all rules in the knowledge base.
+        for (const Rule& rule : kb) {
+            // Check if all conditions in the rule's body are true (i.e., if the body is "satisfied").
+            if (bodySatisfied(rule.body, facts)) {
+                // If the rule's head is not already known (i.e., not in the set of facts).
+                if (facts.find(rule.head) == facts.end()) {
+                    // Add the rule's head (fact) to the known facts.
+                    facts.insert(rule.head);
+                    FAI_COUNT(RULE_FIRINGS);
+
+                    // Print the newly inferred fact and the rule that was applied.
+                    if (trace) {
+                        *trace << "Inferred new fact: " << rule.head << " using rule: " << rule.head << " ← ";
+                        for (size_t i = 0; i < rule.body.size(); ++i) {
+                            *trace << rule.body[i];
+                            if (i < rule.body.size() - 1) {
+                                *trace << " ∧ ";  // Print "and" symbol between conditions.
+                            }
+                        }
+                        *trace << endl;
+                    }
+
+                    // Set flag to true since a new fact was added.
+                    addedNewFact = true;
+                }
+            }
+        }
+    }
+
+    // Return the complete set of inferred facts.
+    return facts;
+}
+
+/**
+ * @brief Bottom-up proof from the assignment's initial facts c, e, h and k, printing each step to cout.
+ *
+ * @param kb The knowledge base, represented as a list of rules.
+ * @return The set of all facts that can be inferred from the knowledge base.
+ */
+inline unordered_set<string> bottomUpProof(const vector<Rule>& kb) {
+    // Set of known facts initialized with some basic facts (c, e, h, and k are known to be true).
+    cout << "Initial facts: c, e, h, k" << endl;
+    return bottomUpProof(kb, {"c", "e", "h", "k"}, &cout);
+}
+
+/**
+ * @brief Top-down proof procedure to prove a query by working backwards through the rules.
+ *
+ * This function attempts to prove a specific query (fact) by recursively proving the conditions
+ * (body) of rules that infer the query. This is also known as "backward chaining."
+ *
+ * @param kb The knowledge base, represented as a list of rules.
+ * @param query The fact (head) that we are trying to prove.
+ * @param visited The set of facts that have already been proven or assumed to be true.
+ * @return true If the query can be proven from the knowledge base.
+ * @return false If the query cannot be proven.
+ */
+inline bool topDownProof(const vector<Rule>& kb, const string& query, unordered_set<string>& visited) {
+    // If the query is already known (i.e., it has been proven or is a known fact).
+    if (visited.find(query) != visited.end()) {
+        return true;  // The query is true.
+    }
+
+    // Try to find a rule where the head matches the query.
+    for (const Rule& rule : kb) {
+        if (rule.head == query) {
+            // Print the rule being used to try to prove the query.
+            cout << "Attempting to prove: " << query << " using rule: " << rule.head << " ← ";
+            for (size_t i = 0; i < rule.body.size(); ++i) {
+                cout << rule.body[i];
+                if (i < rule.body.size() - 1) {
+                    cout << " ∧ ";  // Print "and" symbol between conditions.
+                }
+            }
+            cout << endl;
+
+            // Check if all conditions in the body of the rule can be proven.
+            bool canProve = true;
+            for (const string& literal : rule.body) {
+                // Recursively attempt to prove each condition.
+                if (!topDownProof(kb, literal, visited)) {
+                    cout << "Failed to prove: " << literal << endl;
+                    canProve = false;  // If any condition can't be proven, the query fails.
+                    break;
+                }
+            }
+
+            // If all conditions can be proven, add the query to the set of known facts.
+            if (canProve) {
+                cout << "Successfully proved: " << query << endl;
+                visited.insert(query);  // Mark the query as proven.
+                return true;  // The query is true.
+            }
+        }
+    }
+
+    // If no rule can be found to prove the query, return false.
+    cout << "Failed to prove: " << query << endl;
+    return false;
+}
+
+} // namespace pa3
+
+#endif // FAI_PA3_NAVEEN_KARASU_H
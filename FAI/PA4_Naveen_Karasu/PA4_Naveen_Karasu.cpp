@@ -1,273 +1,16 @@
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <map>
-#include <cmath>
-#include <algorithm>
-#include <cstdlib>
+#include "PA4_Naveen_Karasu.h"
 
 using namespace std;
-
-// Data structure to store each example's attributes and user action
-struct Example {
-    string author;
-    string thread;
-    string length;
-    string where_read;
-    string user_action;
-};
-
-/**
- * @brief Loads data from a CSV file
- * 
- * Reads a CSV file where each line represents an example with the following
- * columns: Author, Thread, Length, Where_read, and User_action.
- * These columns correspond to characteristics of each example.
- * 
- * @param filename Name of the CSV file to load data from.
- * @return vector<Example> The parsed dataset, where each Example contains
- *         values for the above-mentioned columns.
- * 
- * Example CSV structure:
- * Author, Thread, Length, Where_read, User_action
- * known, new, long, home, skips
- * unknown, new, short, work, reads
- */
-vector<Example> load_data(const string &filename) {
-    vector<Example> data;
-    ifstream file(filename);
-    string line, word;
-
-    // Skip header line
-    getline(file, line);
-
-    while (getline(file, line)) {
-        stringstream ss(line);
-        Example example;
-        getline(ss, example.author, ',');
-        getline(ss, example.thread, ',');
-        getline(ss, example.length, ',');
-        getline(ss, example.where_read, ',');
-        getline(ss, example.user_action, ',');
-        data.push_back(example);
-    }
-    return data;
-}
-
-/**
- * @brief Splits the dataset into training and testing sets
- * 
- * This function divides the dataset into two parts: training and testing sets,
- * based on a specified ratio. We create multiple sets with different ratios
- * (80:20, 70:30, 50:50) to evaluate the model's performance on different data splits.
- * 
- * Why different splits?
- * - Using multiple train-test splits allows us to understand how the model performs
- *   with different amounts of training data.
- * - The more training data, the more accurate the model might be, but it’s good to
- *   evaluate different scenarios.
- * 
- * @param data Original dataset to split.
- * @param train Vector to store the training set.
- * @param test Vector to store the testing set.
- * @param train_ratio Ratio of training data to total dataset.
- */
-void split_data(const vector<Example>& data, vector<Example>& train, vector<Example>& test, float train_ratio) {
-    int train_size = static_cast<int>(data.size() * train_ratio);
-    train.assign(data.begin(), data.begin() + train_size);
-    test.assign(data.begin() + train_size, data.end());
-}
-
-// Node structure representing a decision tree node
-struct TreeNode {
-    string feature;
-    map<string, TreeNode*> children;
-    string label;
-};
-
-/**
- * @brief Calculates entropy of a dataset
- * 
- * Entropy is a measure of the disorder or impurity in the data.
- * For a dataset, entropy is calculated based on the distribution of
- * labels (user actions in this case).
- * 
- * Formula: Entropy = -Σ (p * log2(p))
- * where p is the probability of each label in the data.
- * 
- * Example Calculation:
- * - Suppose the dataset has 10 examples, 6 labeled "reads" and 4 labeled "skips".
- *   - Probability of "reads" = 6/10 = 0.6
- *   - Probability of "skips" = 4/10 = 0.4
- *   - Entropy = -(0.6 * log2(0.6) + 0.4 * log2(0.4)) ≈ 0.971
- * 
- * Use in Decision Tree:
- * - Entropy helps us determine the best feature to split the data. Lower entropy
- *   means a feature creates "purer" subsets.
- * 
- * @param data The dataset for which entropy is calculated.
- * @return double Entropy value.
- */
-double calculate_entropy(const vector<Example>& data) {
-    map<string, int> label_counts;
-    for (const auto& ex : data) {
-        label_counts[ex.user_action]++;
-    }
-    double entropy = 0.0;
-    for (const auto& pair : label_counts) {
-        double p = static_cast<double>(pair.second) / data.size();
-        entropy -= p * log2(p);
-    }
-    return entropy;
-}
-
-/**
- * @brief Trains a decision tree based on the dataset
- * 
- * This function builds a decision tree by recursively splitting the data
- * using features that minimize entropy (i.e., create the "purest" subsets).
- * 
- * Steps:
- * 1. If all examples have the same label (e.g., all "reads"), create a leaf node
- *    with that label and stop.
- * 2. If there are mixed labels, calculate entropy for each feature to find the
- *    best split. The best feature is the one that gives the highest information gain.
- * 3. Divide data based on this feature and recursively build child nodes.
- * 
- * Example:
- * Let's assume we have a small dataset with 4 examples:
- * - {Author: "known", Thread: "new", Length: "short", User_action: "reads"}
- * - {Author: "unknown", Thread: "new", Length: "long", User_action: "skips"}
- * - {Author: "known", Thread: "followup", Length: "short", User_action: "reads"}
- * - {Author: "unknown", Thread: "followup", Length: "long", User_action: "skips"}
- * 
- * If splitting by "Author" reduces entropy the most, we split on "Author" and
- * create branches for "known" and "unknown". Each branch is further split
- * based on remaining features.
- * 
- * @param data The training dataset.
- * @param features List of features to consider for splits.
- * @return TreeNode* Pointer to the root node of the trained tree.
- */
-TreeNode* train_decision_tree(const vector<Example>& data, const vector<string>& features) {
-    if (data.empty()) return nullptr;
-
-    // Check if all labels are the same
-    map<string, int> label_counts;
-    for (const auto& ex : data) {
-        label_counts[ex.user_action]++;
-    }
-    if (label_counts.size() == 1) {
-        TreeNode* leaf = new TreeNode;
-        leaf->label = data[0].user_action;
-        return leaf;
-    }
-
-    // Find the best feature for splitting
-    double base_entropy = calculate_entropy(data);
-    double best_gain = 0.0;
-    string best_feature;
-    map<string, vector<Example>> best_splits;
-
-    for (const auto& feature : features) {
-        map<string, vector<Example>> splits;
-        for (const auto& ex : data) {
-            string value = feature == "author" ? ex.author :
-                           feature == "thread" ? ex.thread :
-                           feature == "length" ? ex.length :
-                           ex.where_read;
-            splits[value].push_back(ex);
-        }
-
-        double new_entropy = 0.0;
-        for (const auto& split : splits) {
-            double weight = static_cast<double>(split.second.size()) / data.size();
-            new_entropy += weight * calculate_entropy(split.second);
-        }
-
-        double gain = base_entropy - new_entropy;
-        if (gain > best_gain) {
-            best_gain = gain;
-            best_feature = feature;
-            best_splits = splits;
-        }
-    }
-
-    // Stop if no gain in entropy
-    if (best_gain == 0) {
-        TreeNode* leaf = new TreeNode;
-        leaf->label = data[0].user_action;
-        return leaf;
-    }
-
-    TreeNode* node = new TreeNode;
-    node->feature = best_feature;
-
-    vector<string> remaining_features;
-    for (const auto& feature : features) {
-        if (feature != best_feature) remaining_features.push_back(feature);
-    }
-
-    for (const auto& split : best_splits) {
-        node->children[split.first] = train_decision_tree(split.second, remaining_features);
-    }
-
-    return node;
-}
-
-/**
- * @brief Predicts the user action based on the trained tree
- * 
- * This function traverses the decision tree to predict the user action for a new example.
- * Starting from the root, it checks the example’s feature values and moves down the tree
- * until it reaches a leaf node, which holds the prediction.
- * 
- * @param root Pointer to the root of the decision tree.
- * @param example New example to classify.
- * @return string Predicted user action.
- */
-string predict(TreeNode* root, const Example& example) {
-    if (root->children.empty()) return root->label;
-    string value = root->feature == "author" ? example.author :
-                   root->feature == "thread" ? example.thread :
-                   root->feature == "length" ? example.length :
-                   example.where_read;
-    if (root->children.count(value)) {
-        return predict(root->children[value], example);
-    } else {
-        return "unknown"; // Handle unseen data
-    }
-}
-
-/**
- * @brief Calculates accuracy of the model on the test dataset
- * 
- * This function compares the predicted labels to actual labels to measure
- * the model's performance on the test dataset.
- * 
- * Accuracy Formula: (Number of Correct Predictions / Total Predictions)
- * 
- * @param root Pointer to the root of the decision tree.
- * @param test_data Test dataset for evaluation.
- * @return double Accuracy of the model.
- */
-double calculate_accuracy(TreeNode* root, const vector<Example>& test_data) {
-    int correct = 0;
-    for (const auto& ex : test_data) {
-        if (predict(root, ex) == ex.user_action) {
-            correct++;
-        }
-    }
-    return static_cast<double>(correct) / test_data.size();
-}
+using namespace pa4;
 
 /**
  * @brief Main function to train, test, and evaluate the decision tree model
  */
 int main() {
+    FAI_PROFILE_SESSION();
     string filename = "dataset.csv";  // The generated CSV file
-    vector<Example> data = load_data(filename);
+    TaskScheduler scheduler;
+    vector<Example> data = load_data(filename, &scheduler);
     
     // Define train-test split ratios
     vector<float> ratios = {0.8, 0.7, 0.5};
@@ -276,21 +19,193 @@ int main() {
         vector<Example> train_data, test_data;
         split_data(data, train_data, test_data, ratio);
 
-        // Train decision tree
+        // Train decision tree; its nodes are freed when `arena` goes out of scope
+        TreeArena arena;
         vector<string> features = {"author", "thread", "length", "where_read"};
-        TreeNode* tree = train_decision_tree(train_data, features);
+        TreeNode* tree = train_decision_tree(train_data, features, arena);
+
+        // Train the same tree on the task scheduler and confirm it is identical
+        TreeNode* parallel_tree = train_decision_tree_parallel(train_data, features, scheduler, arena);
+        cout << "Parallel tree matches sequential tree: " << (trees_equal(tree, parallel_tree) ? "yes" : "no") << endl;
 
         // Calculate and display accuracy
         double accuracy = calculate_accuracy(tree, test_data);
         cout << "Accuracy for train:test ratio " << ratio << ":" << (1 - ratio) << " is " << accuracy << endl;
 
+        // Compile the tree into the flat layout and score the test set in one batch
+        FlatTree flat_tree = compile_tree(tree, features);
+        cout << "Compiled tree accuracy: " << calculate_accuracy(flat_tree, test_data) << endl;
+
+        // Train the ensembles on the same split
+        RandomForest forest = train_random_forest(train_data, features, ForestOptions(), scheduler);
+        GradientBoostedTrees boosted = train_gradient_boosting(train_data, features, BoostingOptions(), scheduler);
+        cout << "Random forest accuracy: " << calculate_accuracy(forest, test_data) << endl;
+        cout << "Gradient boosting accuracy: " << calculate_accuracy(boosted, test_data) << endl;
+
+        // Save the compiled forest and score it straight from the memory-mapped file
+        MappedModel mapped_forest;
+        if (save_model(compile_forest(forest.trees, features), "forest_model.bin") &&
+            mapped_forest.open("forest_model.bin")) {
+            cout << "Mapped forest accuracy: " << calculate_accuracy(mapped_forest, test_data) << endl;
+        }
+
         // Predict user actions for examples e19 and e20
-        Example e19 = {"unknown", "new", "long", "work", "?"};
-        Example e20 = {"unknown", "followup", "short", "home", "?"};
+        Example e19 = {"unknown", "new", "long", "work", "?", {}};
+        Example e20 = {"unknown", "followup", "short", "home", "?", {}};
         cout << "Prediction for e19: " << predict(tree, e19) << endl;
         cout << "Prediction for e20: " << predict(tree, e20) << endl;
+    }
 
-           }
+    // Model selection: every (configuration, fold) pair trains concurrently on index-only folds
+    vector<string> features = {"author", "thread", "length", "where_read"};
+    vector<ModelConfig> configs = {{false, ForestOptions()},
+                                   {true, ForestOptions{25, 1, 42}},
+                                   {true, ForestOptions{25, 2, 42}},
+                                   {true, ForestOptions{50, 3, 42}}};
+    vector<string> config_names = {"ID3 tree", "Forest 25 trees, 1 feature", "Forest 25 trees, 2 features",
+                                   "Forest 50 trees, 3 features"};
+    vector<Fold> folds = stratified_k_fold(label_ids(data), 3, 7);
+    CrossValidationReport report = cross_validate(configs, config_names, folds,
+        [&](const ModelConfig& config, const Fold& fold) {
+            if (config.forest) {
+                RandomForest forest = train_random_forest(data, fold.train, features, config.options, scheduler);
+                return calculate_accuracy(forest, data, fold.test);
+            }
+            TreeArena arena;
+            TreeNode* tree = train_decision_tree(data, fold.train, features, arena);
+            return calculate_accuracy(tree, data, fold.test);
+        }, scheduler);
+    cout << "3-fold stratified cross-validation:" << endl;
+    print_cross_validation_report(report, cout);
+
+    // Train on continuous netflow features if an exported flow CSV is present
+    vector<Example> flows = load_flow_data("flows.csv", &scheduler);
+    if (!flows.empty()) {
+        vector<Example> train_flows, test_flows;
+        split_data(flows, train_flows, test_flows, 0.8);
+
+        TreeArena arena;
+        TreeNode* flow_tree = train_decision_tree(train_flows, NUMERIC_FEATURES, arena);
+        cout << "Flow tree nodes: " << arena.num_nodes() << endl;
+        cout << "Flow tree accuracy: " << calculate_accuracy(flow_tree, test_flows) << endl;
+        FlatTree flat_flow_tree = compile_tree(flow_tree, NUMERIC_FEATURES);
+        cout << "Compiled flow tree accuracy: " << calculate_accuracy(flat_flow_tree, test_flows) << endl;
+
+        BoostingOptions flow_boosting;
+        flow_boosting.positive_label = "botnet";
+        GradientBoostedTrees boosted_flows = train_gradient_boosting(train_flows, NUMERIC_FEATURES, flow_boosting, scheduler);
+        cout << "Flow gradient boosting accuracy: " << calculate_accuracy(boosted_flows, test_flows) << endl;
+    }
+
+    // Byte counts above 2^24, where float spacing exceeds 1: the compiled tree must still branch like the pointer tree
+    {
+        vector<Example> large_flows;
+        for (int i = 0; i < 400; ++i) {
+            const double bytes = 16777216.0 + i;
+            large_flows.push_back({"", "", "", "", (i / 5) % 2 ? "botnet" : "normal", {1.0, 10.0, bytes, 100.0}});
+        }
+        TreeArena arena;
+        TreeNode* large_tree = train_decision_tree(large_flows, NUMERIC_FEATURES, arena);
+        FlatTree flat_large_tree = compile_tree(large_tree, NUMERIC_FEATURES);
+        size_t agree = 0;
+        for (const auto& example : large_flows) agree += predict(large_tree, example) == predict(flat_large_tree, example);
+        cout << "Compiled tree agrees with pointer tree on byte counts above 2^24: " << agree << "/"
+             << large_flows.size() << endl;
+    }
+
+    // Train out of core from an on-disk column file, one pass per tree level
+    ColumnFile columns;
+    if (convert_csv_to_column_file(filename, "dataset.cols") && columns.open("dataset.cols")) {
+        TreeArena arena;
+        TreeNode* streamed = train_decision_tree_streaming(columns, features, "User_action", 0, arena);
+        TreeNode* in_memory = train_decision_tree(data, features, arena);
+        cout << "Streaming tree matches in-memory tree: " << (trees_equal(streamed, in_memory) ? "yes" : "no") << endl;
+    }
+    if (!flows.empty() && convert_csv_to_column_file("flows.csv", "flows.cols", NUMERIC_FEATURES) &&
+        columns.open("flows.cols")) {
+        TreeArena arena;
+        TreeNode* streamed = train_decision_tree_streaming(columns, NUMERIC_FEATURES, "label", 8, arena);
+        cout << "Streaming flow tree nodes (depth 8): " << arena.num_nodes() << endl;
+        cout << "Streaming flow tree accuracy on all flows: " << calculate_accuracy(streamed, flows) << endl;
+    }
+
+    // Train on a real CTU-13 capture, decoded straight from the project's Parquet file
+    vector<Example> capture = load_flow_data("../Final project_Group_2/data/11-Rbot-20110818-2.binetflow.parquet",
+                                             &scheduler);
+    if (!capture.empty()) {
+        vector<Example> train_capture, test_capture;
+        split_data(capture, train_capture, test_capture, 0.8);
+
+        TreeArena arena;
+        TreeNode* capture_tree = train_decision_tree(train_capture, NUMERIC_FEATURES, arena);
+        cout << "Capture flows: " << capture.size() << endl;
+        cout << "Capture tree accuracy: " << calculate_accuracy(capture_tree, test_capture) << endl;
+
+        // The same flows as float32 columns: one allocation per feature instead of two per row
+        Dataset capture_columns = load_flow_dataset(
+            "../Final project_Group_2/data/11-Rbot-20110818-2.binetflow.parquet", &scheduler);
+        size_t example_bytes = capture.capacity() * sizeof(Example);
+        for (const auto& ex : capture) {
+            example_bytes += ex.numeric.capacity() * sizeof(double) + ex.user_action.capacity();
+        }
+        cout << "Capture memory: Examples " << example_bytes << " bytes, Dataset "
+             << capture_columns.memory_bytes() << " bytes" << endl;
+
+        vector<size_t> train_rows, test_rows;
+        split_data(capture_columns, train_rows, test_rows, 0.8);
+        TreeNode* column_tree = train_decision_tree(capture_columns, train_rows, NUMERIC_FEATURES, arena);
+        cout << "Capture Dataset tree accuracy: " << calculate_accuracy(column_tree, capture_columns, test_rows)
+             << endl;
+
+        // Learn the training flows one at a time, in capture order, testing each before learning it
+        HoeffdingTree hoeffding(NUMERIC_FEATURES);
+        size_t prequential_correct = 0;
+        auto start = chrono::steady_clock::now();
+        for (const auto& flow : train_capture) {
+            if (hoeffding.predict(flow) == flow.user_action) prequential_correct++;
+            hoeffding.learn(flow);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Hoeffding tree: " << hoeffding.num_nodes() << " nodes, depth " << hoeffding.depth()
+             << ", prequential accuracy " << static_cast<double>(prequential_correct) / train_capture.size() << ", "
+             << static_cast<size_t>(train_capture.size() / seconds) << " examples/sec" << endl;
+        cout << "Hoeffding tree accuracy: " << calculate_accuracy(hoeffding.root(), test_capture) << endl;
+
+        // Shrink the capture tree: pre-pruning limits, or post-pruning against the last quarter of the training flows
+        vector<size_t> fit_rows, validation_rows;
+        for (size_t row = 0; row < train_capture.size(); ++row) {
+            (row < train_capture.size() * 3 / 4 ? fit_rows : validation_rows).push_back(row);
+        }
+        auto report_tree = [&](const string& name, TreeNode* tree) {
+            const size_t repeats = 10;
+            size_t correct = 0;
+            auto begin = chrono::steady_clock::now();
+            for (size_t r = 0; r < repeats; ++r) {
+                for (const auto& ex : test_capture) correct += predict(tree, ex) == ex.user_action;
+            }
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            cout << name << ": " << count_nodes(tree) << " nodes, depth " << tree_depth(tree) << ", "
+                 << static_cast<size_t>(elapsed * 1e9 / (repeats * test_capture.size())) << " ns/prediction, accuracy "
+                 << static_cast<double>(correct) / (repeats * test_capture.size()) << endl;
+        };
+        TreeArena pruning_arena;
+        report_tree("Capture tree, unpruned",
+                    train_decision_tree(train_capture, fit_rows, NUMERIC_FEATURES, pruning_arena));
+
+        TreeLimits limits;
+        limits.max_depth = 12;
+        limits.min_samples_leaf = 5;
+        report_tree("Capture tree, depth <= 12 and 5+ rows per leaf",
+                    train_decision_tree(train_capture, fit_rows, NUMERIC_FEATURES, limits, pruning_arena));
+
+        TreeNode* reduced = train_decision_tree(train_capture, fit_rows, NUMERIC_FEATURES, pruning_arena);
+        prune_reduced_error(reduced, train_capture, fit_rows, validation_rows);
+        report_tree("Capture tree, reduced-error pruned", reduced);
+
+        TreeNode* complexity = train_decision_tree(train_capture, fit_rows, NUMERIC_FEATURES, pruning_arena);
+        prune_cost_complexity(complexity, train_capture, fit_rows, validation_rows);
+        report_tree("Capture tree, cost-complexity pruned", complexity);
+    }
     
     return 0;
 }
@@ -0,0 +1,3475 @@
+#ifndef FAI_PA4_NAVEEN_KARASU_H
+#define FAI_PA4_NAVEEN_KARASU_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/column_file.h"
+#include "../common/cross_validation.h"
+#include "../common/csv_reader.h"
+#include "../common/dataset.h"
+#include "../common/parquet_reader.h"
+#include "../common/profiling.h"
+#include "../common/task_scheduler.h"
+
+/**
+ * Learners of PA4: ID3 decision trees (categorical and threshold splits, arena
+ * allocation, parallel and out-of-core training, pruning), random forests,
+ * gradient boosting, the streaming Hoeffding tree, and the compiled flat trees
+ * and model files used for batched prediction.
+ *
+ * Everything lives in namespace pa4. PA4_Naveen_Karasu.cpp is the demo program;
+ * the benchmarks build against the same header through the fai_pa4 target.
+ */
+
+namespace pa4 {
+
+using namespace std;
+
+// Continuous features of the netflow data, stored in Example::numeric in this order
+const vector<string> NUMERIC_FEATURES = {"dur", "tot_pkts", "tot_bytes", "src_bytes"};
+
+// Data structure to store each example's attributes and user action
+struct Example {
+    string author;
+    string thread;
+    string length;
+    string where_read;
+    string user_action;
+    vector<double> numeric; // Values of NUMERIC_FEATURES; empty for the categorical dataset
+};
+
+/**
+ * @brief Returns the position of a feature in NUMERIC_FEATURES, or -1 if it is categorical
+ */
+inline int numeric_index(const string& feature) {
+    for (size_t i = 0; i < NUMERIC_FEATURES.size(); ++i) {
+        if (NUMERIC_FEATURES[i] == feature) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+/**
+ * @brief Loads data from a CSV file
+ * 
+ * Reads a CSV file where each line represents an example with the following
+ * columns: Author, Thread, Length, Where_read, and User_action.
+ * These columns correspond to characteristics of each example.
+ * 
+ * The file is memory-mapped and decoded column by column with read_csv_columns,
+ * so each distinct value is parsed once and rows only copy short strings out of
+ * the column dictionaries.
+ * 
+ * @param filename Name of the CSV file to load data from.
+ * @param scheduler Optional scheduler for decoding large files in parallel.
+ * @return vector<Example> The parsed dataset, where each Example contains
+ *         values for the above-mentioned columns.
+ * 
+ * Example CSV structure:
+ * Author, Thread, Length, Where_read, User_action
+ * known, new, long, home, skips
+ * unknown, new, short, work, reads
+ */
+inline vector<Example> load_data(const string &filename, TaskScheduler* scheduler = nullptr) {
+    CsvColumns columns = read_csv_columns(filename, {}, scheduler);
+    vector<Example> data(columns.num_rows);
+
+    // Columns are positional: Author, Thread, Length, Where_read, User_action
+    const vector<string Example::*> fields = {&Example::author, &Example::thread, &Example::length,
+                                              &Example::where_read, &Example::user_action};
+    for (size_t c = 0; c < fields.size() && c < columns.names.size(); ++c) {
+        for (size_t row = 0; row < data.size(); ++row) {
+            data[row].*fields[c] = columns.value(c, row);
+        }
+    }
+    return data;
+}
+
+/**
+ * @brief Reduces a CTU-13 netflow label to its traffic class
+ * 
+ * The captures label flows like "flow=From-Botnet-V42-TCP-Established" or
+ * "flow=Background-UDP-Established"; the learners only need "botnet", "normal"
+ * or "background".
+ */
+inline string flow_class(const string& label) {
+    if (label.find("Botnet") != string::npos) return "botnet";
+    if (label.find("Normal") != string::npos) return "normal";
+    return "background";
+}
+
+/**
+ * @brief Decodes the NUMERIC_FEATURES and label columns of a flow CSV or Parquet file (see load_flow_data)
+ */
+inline CsvColumns read_flow_columns(const string &filename, TaskScheduler* scheduler = nullptr) {
+    const string suffix = ".parquet";
+    bool parquet = filename.size() >= suffix.size() &&
+                   filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+    CsvColumns columns;
+    if (parquet) {
+        vector<string> wanted = NUMERIC_FEATURES;
+        wanted.push_back("label");
+        string error;
+        columns = read_parquet_columns(filename, wanted, scheduler, &error);
+        if (!error.empty()) cerr << error << endl;
+        int label_column = columns.column("label");
+        if (label_column >= 0) {
+            for (auto& value : columns.dictionaries[label_column]) value = flow_class(value);
+        }
+    } else {
+        columns = read_csv_columns(filename, NUMERIC_FEATURES, scheduler);
+    }
+    return columns;
+}
+
+/**
+ * @brief Loads netflow records with continuous features from a CSV or Parquet file
+ * 
+ * The header names the columns, so their order does not matter. The columns
+ * listed in NUMERIC_FEATURES are parsed as numbers into Example::numeric (a
+ * missing or empty cell reads as 0) and the "label" column becomes user_action.
+ * Other columns are ignored.
+ * 
+ * Files ending in ".parquet" (the final project's .binetflow.parquet captures)
+ * are decoded natively by read_parquet_columns, reading only the needed columns,
+ * and their labels are reduced with flow_class.
+ * 
+ * Example CSV structure:
+ * dur,tot_pkts,tot_bytes,src_bytes,label
+ * 0.000278,2,1086,452,normal
+ * 4.987,10,1266,728,botnet
+ * 
+ * @param filename Name of the CSV or Parquet file to load data from.
+ * @param scheduler Optional scheduler for decoding large files in parallel.
+ * @return vector<Example> The parsed flows, or an empty vector if the file is missing.
+ */
+inline vector<Example> load_flow_data(const string &filename, TaskScheduler* scheduler = nullptr) {
+    CsvColumns columns = read_flow_columns(filename, scheduler);
+    vector<Example> data(columns.num_rows);
+
+    int label_column = columns.column("label");
+    for (size_t row = 0; row < data.size(); ++row) {
+        data[row].numeric.assign(NUMERIC_FEATURES.size(), 0.0);
+        if (label_column >= 0) data[row].user_action = columns.value(label_column, row);
+    }
+    for (size_t f = 0; f < NUMERIC_FEATURES.size(); ++f) {
+        int c = columns.column(NUMERIC_FEATURES[f]);
+        if (c < 0) continue;
+        for (size_t row = 0; row < data.size(); ++row) data[row].numeric[f] = columns.numbers[c][row];
+    }
+    return data;
+}
+
+/**
+ * @brief Loads the same flows as load_flow_data into a float32 column Dataset
+ * 
+ * The features are NUMERIC_FEATURES in that order and the label ids number the
+ * traffic classes in sorted order ("background", "botnet", "normal"), which is
+ * also the order the Example-based tree learner uses.
+ * 
+ * @param filename Name of the CSV or Parquet file to load data from.
+ * @param scheduler Optional scheduler for decoding large files in parallel.
+ * @return Dataset The flows, or an empty dataset if the file is missing.
+ */
+inline Dataset load_flow_dataset(const string &filename, TaskScheduler* scheduler = nullptr) {
+    return Dataset::from_columns(read_flow_columns(filename, scheduler), NUMERIC_FEATURES, "label");
+}
+
+/**
+ * @brief Splits the dataset into training and testing sets
+ * 
+ * This function divides the dataset into two parts: training and testing sets,
+ * based on a specified ratio. We create multiple sets with different ratios
+ * (80:20, 70:30, 50:50) to evaluate the model's performance on different data splits.
+ * 
+ * Why different splits?
+ * - Using multiple train-test splits allows us to understand how the model performs
+ *   with different amounts of training data.
+ * - The more training data, the more accurate the model might be, but it’s good to
+ *   evaluate different scenarios.
+ * 
+ * @param data Original dataset to split.
+ * @param train Vector to store the training set.
+ * @param test Vector to store the testing set.
+ * @param train_ratio Ratio of training data to total dataset.
+ */
+inline void split_data(const vector<Example>& data, vector<Example>& train, vector<Example>& test, float train_ratio) {
+    int train_size = static_cast<int>(data.size() * train_ratio);
+    train.assign(data.begin(), data.begin() + train_size);
+    test.assign(data.begin() + train_size, data.end());
+}
+
+/**
+ * @brief Same split as above for a Dataset, as index views instead of copies
+ */
+inline void split_data(const Dataset& data, vector<size_t>& train, vector<size_t>& test, float train_ratio) {
+    vector<size_t> rows = all_rows(data);
+    size_t train_size = static_cast<size_t>(data.num_rows() * train_ratio);
+    train.assign(rows.begin(), rows.begin() + train_size);
+    test.assign(rows.begin() + train_size, rows.end());
+}
+
+/**
+ * @struct TreeNode
+ * @brief Node structure representing a decision tree node
+ *
+ * A categorical node has one child per value of `feature`. A numeric node
+ * (`numeric` >= 0, an index into NUMERIC_FEATURES) has two children: LEFT_BRANCH
+ * for values <= `threshold` and RIGHT_BRANCH for larger values.
+ *
+ * The children map allocates its entries from the memory resource passed to the
+ * constructor. Nodes made by a TreeArena use the arena, so a whole tree (nodes and
+ * map entries alike) lives in a few large blocks that are freed together.
+ */
+struct TreeNode {
+    string feature;
+    pmr::map<string, TreeNode*> children;
+    string label;
+    double value = 0.0;     // Raw score of the node, used by gradient-boosted trees
+    int numeric = -1;       // NUMERIC_FEATURES index of a threshold split, -1 if categorical
+    double threshold = 0.0; // Split point of a numeric node
+
+    explicit TreeNode(pmr::memory_resource* resource = pmr::get_default_resource()) : children(resource) {}
+};
+
+// Child keys of a numeric threshold split
+const string LEFT_BRANCH = "<=";
+const string RIGHT_BRANCH = ">";
+
+/**
+ * @class TreeArena
+ * @brief Owns the nodes of one or more trees and releases them all at once.
+ *
+ * Memory comes from a monotonic buffer that grabs geometrically growing blocks
+ * (starting at ARENA_INITIAL_BYTES), so training a tree costs a handful of malloc
+ * calls instead of one per node and one per child-map entry. Nothing is freed
+ * individually; release() (or the destructor) runs the node destructors and hands
+ * every block back in one go, which keeps memory flat across retraining runs.
+ *
+ * Allocation is guarded by a mutex so parallel trainers can share one arena.
+ *
+ * Example:
+ *   {
+ *       TreeArena arena;
+ *       TreeNode* tree = train_decision_tree(train_data, features, arena);
+ *       ...
+ *   } // every node of `tree` is freed here
+ */
+class TreeArena : public pmr::memory_resource {
+public:
+    static const size_t ARENA_INITIAL_BYTES = 64 * 1024;
+
+    TreeArena() : blocks_(ARENA_INITIAL_BYTES) {}
+    ~TreeArena() override { release(); }
+    TreeArena(const TreeArena&) = delete;
+    TreeArena& operator=(const TreeArena&) = delete;
+
+    /**
+     * @brief Creates an empty node owned by the arena
+     */
+    TreeNode* make_node() {
+        void* memory = allocate(sizeof(TreeNode), alignof(TreeNode));
+        TreeNode* node = new (memory) TreeNode(this);
+        lock_guard<mutex> lock(mutex_);
+        nodes_.push_back(node);
+        return node;
+    }
+
+    /**
+     * @brief Destroys every node and returns all blocks to the system
+     */
+    void release() {
+        for (TreeNode* node : nodes_) node->~TreeNode();
+        nodes_.clear();
+        nodes_.shrink_to_fit();
+        blocks_.release();
+    }
+
+    /**
+     * @brief Number of nodes currently owned by the arena
+     */
+    size_t num_nodes() const { return nodes_.size(); }
+
+private:
+    mutex mutex_;
+    pmr::monotonic_buffer_resource blocks_;
+    vector<TreeNode*> nodes_;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        lock_guard<mutex> lock(mutex_);
+        return blocks_.allocate(bytes, alignment);
+    }
+
+    // Individual frees are no-ops; memory is reclaimed by release()
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+/**
+ * @brief Calculates entropy of a dataset
+ * 
+ * Entropy is a measure of the disorder or impurity in the data.
+ * For a dataset, entropy is calculated based on the distribution of
+ * labels (user actions in this case).
+ * 
+ * Formula: Entropy = -Σ (p * log2(p))
+ * where p is the probability of each label in the data.
+ * 
+ * Example Calculation:
+ * - Suppose the dataset has 10 examples, 6 labeled "reads" and 4 labeled "skips".
+ *   - Probability of "reads" = 6/10 = 0.6
+ *   - Probability of "skips" = 4/10 = 0.4
+ *   - Entropy = -(0.6 * log2(0.6) + 0.4 * log2(0.4)) ≈ 0.971
+ * 
+ * Use in Decision Tree:
+ * - Entropy helps us determine the best feature to split the data. Lower entropy
+ *   means a feature creates "purer" subsets.
+ * 
+ * @param data The dataset for which entropy is calculated.
+ * @return double Entropy value.
+ */
+inline double calculate_entropy(const vector<Example>& data) {
+    map<string, int> label_counts;
+    for (const auto& ex : data) {
+        label_counts[ex.user_action]++;
+    }
+    double entropy = 0.0;
+    for (const auto& pair : label_counts) {
+        double p = static_cast<double>(pair.second) / data.size();
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+/**
+ * @brief Calculates entropy of a subset of the dataset given by row indices
+ * 
+ * Same computation as calculate_entropy above, but reads the examples through
+ * `rows` instead of a copied vector. Rows may repeat (bootstrap samples).
+ * 
+ * @param data The full dataset.
+ * @param rows Indices of the examples in the subset.
+ * @return double Entropy value.
+ */
+inline double calculate_entropy(const vector<Example>& data, const vector<size_t>& rows) {
+    map<string, int> label_counts;
+    for (size_t row : rows) {
+        label_counts[data[row].user_action]++;
+    }
+    double entropy = 0.0;
+    for (const auto& pair : label_counts) {
+        double p = static_cast<double>(pair.second) / rows.size();
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+/**
+ * @brief Returns the value of a named feature for an example
+ * 
+ * @param ex The example to read from.
+ * @param feature Feature name ("author", "thread", "length" or "where_read").
+ * @return const string& The example's value for that feature.
+ * @throws invalid_argument For any other name, e.g. a NUMERIC_FEATURES column,
+ *         which has no string value to return.
+ */
+inline const string& feature_value(const Example& ex, const string& feature) {
+    if (feature == "author") return ex.author;
+    if (feature == "thread") return ex.thread;
+    if (feature == "length") return ex.length;
+    if (feature == "where_read") return ex.where_read;
+    throw invalid_argument("Unknown categorical feature: " + feature);
+}
+
+/**
+ * @brief Returns the child key an example follows at an internal node
+ * 
+ * For a categorical node this is the example's value of the node's feature; for a
+ * numeric node it is LEFT_BRANCH or RIGHT_BRANCH depending on the threshold.
+ */
+inline const string& branch_value(const TreeNode* node, const Example& ex) {
+    if (node->numeric >= 0) {
+        return ex.numeric[node->numeric] <= node->threshold ? LEFT_BRANCH : RIGHT_BRANCH;
+    }
+    return feature_value(ex, node->feature);
+}
+
+// Candidate split of a node's rows on one feature, with its information gain
+struct FeatureSplit {
+    double gain = 0.0;
+    double threshold = 0.0; // Split point, for numeric features only
+    map<string, vector<size_t>> splits;
+};
+
+// Numeric features are cut into at most this many quantile bins
+const size_t MAX_NUMERIC_BINS = 256;
+
+/**
+ * @struct NumericColumns
+ * @brief Quantile-binned numeric columns and integer labels, built once per training run.
+ * 
+ * For each numeric feature f in use, `edges[f]` holds up to MAX_NUMERIC_BINS - 1
+ * ascending cut points and `codes[f][row]` the bin of a row: bin b holds values in
+ * (edges[f][b - 1], edges[f][b]]. Splitting after bin b therefore means the
+ * threshold `value <= edges[f][b]`. When a column has fewer distinct values than
+ * bins, every distinct value is an edge and the search is exact.
+ * 
+ * `label_codes[row]` numbers the labels 0..num_labels-1 so that split scans can
+ * count classes in flat arrays instead of maps.
+ */
+struct NumericColumns {
+    vector<vector<double>> edges;
+    vector<vector<uint8_t>> codes;
+    vector<uint16_t> label_codes;
+    size_t num_labels = 0;
+};
+
+/**
+ * @brief Picks up to MAX_NUMERIC_BINS - 1 quantile cut points from sorted values
+ * 
+ * When there are few distinct values, every distinct value but the largest is an
+ * edge, so that every possible split is found.
+ */
+inline vector<double> quantile_edges(const vector<double>& sorted) {
+    vector<double> edges;
+    if (sorted.empty()) return edges;
+    for (size_t b = 1; b < MAX_NUMERIC_BINS; ++b) {
+        double cut = sorted[b * sorted.size() / MAX_NUMERIC_BINS];
+        if (cut < sorted.back() && (edges.empty() || cut > edges.back())) edges.push_back(cut);
+    }
+    vector<double> distinct;
+    unique_copy(sorted.begin(), sorted.end(), back_inserter(distinct));
+    if (distinct.size() <= MAX_NUMERIC_BINS) edges.assign(distinct.begin(), distinct.end() - 1);
+    return edges;
+}
+
+/**
+ * @brief Sorts each numeric column once and cuts it into quantile bins
+ * 
+ * Only the numeric features that appear in `features` are binned; for a purely
+ * categorical feature list the result is empty and costs nothing.
+ * 
+ * @param data The training dataset.
+ * @param features Features the tree may split on.
+ * @return NumericColumns The binned columns and label codes.
+ */
+inline NumericColumns build_numeric_columns(const vector<Example>& data, const vector<string>& features) {
+    NumericColumns columns;
+    columns.edges.resize(NUMERIC_FEATURES.size());
+    columns.codes.resize(NUMERIC_FEATURES.size());
+
+    bool any_numeric = false;
+    for (const auto& feature : features) {
+        int f = numeric_index(feature);
+        if (f < 0 || !columns.codes[f].empty() || data.empty()) continue;
+        any_numeric = true;
+
+        vector<double> sorted(data.size());
+        for (size_t row = 0; row < data.size(); ++row) sorted[row] = data[row].numeric[f];
+        sort(sorted.begin(), sorted.end());
+
+        vector<double>& edges = columns.edges[f];
+        edges = quantile_edges(sorted);
+
+        vector<uint8_t>& codes = columns.codes[f];
+        codes.resize(data.size());
+        for (size_t row = 0; row < data.size(); ++row) {
+            codes[row] = static_cast<uint8_t>(lower_bound(edges.begin(), edges.end(), data[row].numeric[f]) - edges.begin());
+        }
+    }
+
+    if (any_numeric) {
+        map<string, uint16_t> label_ids;
+        for (const auto& ex : data) label_ids[ex.user_action] = 0;
+        for (auto& entry : label_ids) entry.second = static_cast<uint16_t>(columns.num_labels++);
+        columns.label_codes.resize(data.size());
+        for (size_t row = 0; row < data.size(); ++row) columns.label_codes[row] = label_ids[data[row].user_action];
+    }
+    return columns;
+}
+
+/**
+ * @brief Entropy of a class histogram with `total` rows
+ * 
+ * Counts are usually integers; the streaming HoeffdingTree passes fractional
+ * (estimated) counts as doubles.
+ */
+template <typename Count>
+double entropy_of_counts(const Count* counts, size_t num_labels, Count total) {
+    double entropy = 0.0;
+    for (size_t l = 0; l < num_labels; ++l) {
+        if (counts[l] <= 0) continue;
+        double p = static_cast<double>(counts[l]) / total;
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+/**
+ * @brief Scans a (bin x label) histogram for the split "bin <= b" with the lowest entropy
+ * 
+ * Moves each bin's counts from the right side to the left side and scores the
+ * split from the two running class histograms.
+ * 
+ * @param histogram Counts, `num_labels` per bin.
+ * @param num_bins Number of bins.
+ * @param num_labels Number of labels.
+ * @param total Sum of all counts.
+ * @param best_entropy In: entropy to beat (the unsplit entropy); out: entropy of the best split.
+ * @param min_leaf Smallest number of rows either side may keep.
+ * @return size_t The last bin of the left side, or num_bins if no split beats `best_entropy`.
+ */
+inline size_t best_histogram_split(const vector<int>& histogram, size_t num_bins, size_t num_labels, int total,
+                                   double& best_entropy, int min_leaf = 1) {
+    FAI_COUNT_N(SPLIT_EVALUATIONS, num_bins > 1 ? num_bins - 1 : 0);
+    vector<int> left(num_labels, 0), right(num_labels, 0);
+    for (size_t b = 0; b < num_bins; ++b) {
+        for (size_t l = 0; l < num_labels; ++l) right[l] += histogram[b * num_labels + l];
+    }
+
+    int left_total = 0;
+    size_t best_bin = num_bins;
+    for (size_t b = 0; b + 1 < num_bins; ++b) {
+        for (size_t l = 0; l < num_labels; ++l) {
+            int moved = histogram[b * num_labels + l];
+            left[l] += moved;
+            right[l] -= moved;
+            left_total += moved;
+        }
+        if (left_total < min_leaf || total - left_total < min_leaf) continue;
+        double new_entropy =
+            static_cast<double>(left_total) / total * entropy_of_counts(left.data(), num_labels, left_total) +
+            static_cast<double>(total - left_total) / total *
+                entropy_of_counts(right.data(), num_labels, total - left_total);
+        if (new_entropy < best_entropy) {
+            best_entropy = new_entropy;
+            best_bin = b;
+        }
+    }
+    return best_bin;
+}
+
+/**
+ * @brief Finds the best threshold split of a numeric feature in linear time
+ * 
+ * Steps:
+ * 1. One pass over the node's rows fills a (bin x label) histogram.
+ * 2. One pass over the bins moves each bin's counts from the right side to the
+ *    left side and scores the split "value <= edge of this bin" from the two
+ *    running class histograms, so no rows are re-read per threshold.
+ * 3. The rows are partitioned into LEFT_BRANCH and RIGHT_BRANCH at the best edge.
+ * 
+ * The cost is O(rows + bins x labels) per node, with no sorting after the
+ * one-off binning in build_numeric_columns.
+ * 
+ * @param rows Indices of the examples that reached this node.
+ * @param f Index of the feature in NUMERIC_FEATURES.
+ * @param base_entropy Entropy of `rows` before the split.
+ * @param columns Binned columns of the training data.
+ * @param min_leaf Smallest number of rows either side may keep.
+ * @return FeatureSplit Gain, threshold and the two row partitions (gain 0 if no split).
+ */
+inline FeatureSplit score_threshold(const vector<size_t>& rows, int f, double base_entropy, const NumericColumns& columns,
+                                    size_t min_leaf = 1) {
+    FeatureSplit candidate;
+    const vector<uint8_t>& codes = columns.codes[f];
+    const vector<double>& edges = columns.edges[f];
+    const size_t num_labels = columns.num_labels;
+    const size_t num_bins = edges.size() + 1;
+
+    vector<int> histogram(num_bins * num_labels, 0);
+    for (size_t row : rows) histogram[codes[row] * num_labels + columns.label_codes[row]]++;
+
+    double best_entropy = base_entropy;
+    size_t best_bin = best_histogram_split(histogram, num_bins, num_labels, static_cast<int>(rows.size()), best_entropy,
+                                           static_cast<int>(min_leaf));
+    if (best_bin == num_bins) return candidate;
+
+    candidate.gain = base_entropy - best_entropy;
+    candidate.threshold = edges[best_bin];
+    vector<size_t>& left_rows = candidate.splits[LEFT_BRANCH];
+    vector<size_t>& right_rows = candidate.splits[RIGHT_BRANCH];
+    for (size_t row : rows) {
+        (codes[row] <= best_bin ? left_rows : right_rows).push_back(row);
+    }
+    return candidate;
+}
+
+/**
+ * @brief Scores splitting the node's rows on a single feature
+ * 
+ * Partitions the rows by the feature's values and computes the information gain
+ * relative to the entropy of the unsplit rows. Numeric features are scored by the
+ * threshold search in score_threshold instead. Both the sequential and the parallel
+ * trainer score features through this function, so they compute bit-identical gains.
+ * 
+ * @param data The full dataset.
+ * @param rows Indices of the examples that reached this node.
+ * @param feature Feature to split on.
+ * @param base_entropy Entropy of `rows` before the split.
+ * @param columns Binned numeric columns of the training data.
+ * @param min_leaf Smallest number of rows a child may keep; a categorical split
+ *                 with a smaller branch is rejected (gain 0).
+ * @return FeatureSplit Gain of the split and the partitioned row indices.
+ */
+inline FeatureSplit score_feature(const vector<Example>& data, const vector<size_t>& rows,
+                                  const string& feature, double base_entropy, const NumericColumns& columns,
+                                  size_t min_leaf = 1) {
+    int f = numeric_index(feature);
+    if (f >= 0) return score_threshold(rows, f, base_entropy, columns, min_leaf);
+
+    FAI_COUNT(SPLIT_EVALUATIONS);
+    FeatureSplit candidate;
+    for (size_t row : rows) {
+        candidate.splits[feature_value(data[row], feature)].push_back(row);
+    }
+    for (const auto& split : candidate.splits) {
+        if (split.second.size() < min_leaf) return FeatureSplit();
+    }
+
+    double new_entropy = 0.0;
+    for (const auto& split : candidate.splits) {
+        double weight = static_cast<double>(split.second.size()) / rows.size();
+        new_entropy += weight * calculate_entropy(data, split.second);
+    }
+
+    candidate.gain = base_entropy - new_entropy;
+    return candidate;
+}
+
+/**
+ * @brief Returns true if every example in the subset has the same label
+ */
+inline bool has_single_label(const vector<Example>& data, const vector<size_t>& rows) {
+    for (size_t row : rows) {
+        if (data[row].user_action != data[rows[0]].user_action) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Creates a leaf node predicting the label of the subset's first example
+ */
+inline TreeNode* make_leaf(const vector<Example>& data, const vector<size_t>& rows, TreeArena& arena) {
+    TreeNode* leaf = arena.make_node();
+    leaf->label = data[rows[0]].user_action;
+    return leaf;
+}
+
+/**
+ * @brief Returns the most frequent label of the subset (the smallest one on ties)
+ */
+inline string majority_label(const vector<Example>& data, const vector<size_t>& rows) {
+    map<string, size_t> counts;
+    for (size_t row : rows) counts[data[row].user_action]++;
+    auto best = counts.begin();
+    for (auto it = counts.begin(); it != counts.end(); ++it) {
+        if (it->second > best->second) best = it;
+    }
+    return best == counts.end() ? string() : best->first;
+}
+
+/**
+ * @brief Creates an internal node that splits on a feature (at `threshold` if numeric)
+ */
+inline TreeNode* make_split(const string& feature, double threshold, TreeArena& arena) {
+    TreeNode* node = arena.make_node();
+    node->feature = feature;
+    node->numeric = numeric_index(feature);
+    if (node->numeric >= 0) node->threshold = threshold;
+    return node;
+}
+
+/**
+ * @brief Removes the chosen feature from the list of features left to split on
+ * 
+ * A numeric feature stays available, since a subtree can split it again at a
+ * different threshold.
+ */
+inline vector<string> remove_feature(const vector<string>& features, const string& used) {
+    if (numeric_index(used) >= 0) return features;
+    vector<string> remaining_features;
+    for (const auto& feature : features) {
+        if (feature != used) remaining_features.push_back(feature);
+    }
+    return remaining_features;
+}
+
+/**
+ * @brief Returns the row indices 0..n-1 covering the whole dataset
+ */
+inline vector<size_t> all_rows(const vector<Example>& data) {
+    vector<size_t> rows(data.size());
+    for (size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+    return rows;
+}
+
+/**
+ * @brief Picks the features a node may split on
+ * 
+ * Plain ID3 considers every remaining feature. Random forests pass a random
+ * generator and consider only `max_features` of them, drawn without replacement;
+ * the sample keeps the original feature order so ties still resolve the same way.
+ * 
+ * @param features Features still available at this node.
+ * @param max_features Number of features to sample (0 means all of them).
+ * @param rng Random generator, or nullptr to disable sampling.
+ * @return vector<string> Candidate features for this node.
+ */
+inline vector<string> candidate_features(const vector<string>& features, size_t max_features, mt19937* rng) {
+    if (rng == nullptr || max_features == 0 || max_features >= features.size()) return features;
+    vector<size_t> order(features.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    shuffle(order.begin(), order.end(), *rng);
+    order.resize(max_features);
+    sort(order.begin(), order.end());
+
+    vector<string> sampled;
+    for (size_t i : order) sampled.push_back(features[i]);
+    return sampled;
+}
+
+/**
+ * @struct TreeLimits
+ * @brief Pre-pruning limits that stop a tree from growing until every leaf is pure.
+ * 
+ * A node that hits a limit becomes a leaf predicting its majority label. The
+ * defaults impose no limit, i.e. plain ID3. The Example, Dataset and parallel
+ * trainers all honour every limit; the streaming trainer takes a max_depth only.
+ */
+struct TreeLimits {
+    size_t max_depth = 0;         // Nodes at this depth become leaves (0 = unlimited)
+    size_t min_samples_split = 2; // Nodes with fewer rows become leaves
+    size_t min_samples_leaf = 1;  // Splits leaving a child with fewer rows are not considered
+};
+
+/**
+ * @brief Core of the decision tree learner, working on row indices
+ * 
+ * Builds the tree for the examples `data[rows[i]]` without copying them. Every
+ * learner in this file grows its trees through this function: the single ID3 tree
+ * (all rows, all features) and each tree of a random forest (a bootstrap sample of
+ * rows and a random subset of features at every node).
+ * 
+ * @param data The full training dataset.
+ * @param rows Indices of the examples that reach this node.
+ * @param features List of features still available for splits.
+ * @param max_features Features sampled per node (0 = all, plain ID3).
+ * @param rng Random generator for feature sampling, or nullptr.
+ * @param columns Binned numeric columns (see build_numeric_columns).
+ * @param arena Arena that owns the new nodes.
+ * @param limits Pre-pruning limits (none by default).
+ * @param depth Depth of this node; the root is at depth 0.
+ * @return TreeNode* Pointer to the root node of the subtree.
+ */
+inline TreeNode* build_tree(const vector<Example>& data, const vector<size_t>& rows, const vector<string>& features,
+                            size_t max_features, mt19937* rng, const NumericColumns& columns, TreeArena& arena,
+                            const TreeLimits& limits = TreeLimits(), size_t depth = 0) {
+    if (rows.empty()) return nullptr;
+
+    // Check if all labels are the same
+    if (has_single_label(data, rows)) return make_leaf(data, rows, arena);
+
+    // Stop early at the depth and size limits
+    if (rows.size() < limits.min_samples_split || (limits.max_depth > 0 && depth >= limits.max_depth)) {
+        TreeNode* leaf = arena.make_node();
+        leaf->label = majority_label(data, rows);
+        return leaf;
+    }
+
+    // Find the best feature for splitting
+    double base_entropy = calculate_entropy(data, rows);
+    double best_gain = 0.0;
+    string best_feature;
+    double best_threshold = 0.0;
+    map<string, vector<size_t>> best_splits;
+
+    for (const auto& feature : candidate_features(features, max_features, rng)) {
+        FeatureSplit candidate = score_feature(data, rows, feature, base_entropy, columns, limits.min_samples_leaf);
+        if (candidate.gain > best_gain) {
+            best_gain = candidate.gain;
+            best_feature = feature;
+            best_threshold = candidate.threshold;
+            best_splits = move(candidate.splits);
+        }
+    }
+
+    // Stop if no gain in entropy
+    if (best_gain == 0) return make_leaf(data, rows, arena);
+
+    TreeNode* node = make_split(best_feature, best_threshold, arena);
+
+    vector<string> remaining_features = remove_feature(features, best_feature);
+
+    for (const auto& split : best_splits) {
+        node->children[split.first] =
+            build_tree(data, split.second, remaining_features, max_features, rng, columns, arena, limits, depth + 1);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Trains a decision tree based on the dataset
+ * 
+ * This function builds a decision tree by recursively splitting the data
+ * using features that minimize entropy (i.e., create the "purest" subsets).
+ * 
+ * Steps:
+ * 1. If all examples have the same label (e.g., all "reads"), create a leaf node
+ *    with that label and stop.
+ * 2. If there are mixed labels, calculate entropy for each feature to find the
+ *    best split. The best feature is the one that gives the highest information gain.
+ * 3. Divide data based on this feature and recursively build child nodes.
+ * 
+ * Example:
+ * Let's assume we have a small dataset with 4 examples:
+ * - {Author: "known", Thread: "new", Length: "short", User_action: "reads"}
+ * - {Author: "unknown", Thread: "new", Length: "long", User_action: "skips"}
+ * - {Author: "known", Thread: "followup", Length: "short", User_action: "reads"}
+ * - {Author: "unknown", Thread: "followup", Length: "long", User_action: "skips"}
+ * 
+ * If splitting by "Author" reduces entropy the most, we split on "Author" and
+ * create branches for "known" and "unknown". Each branch is further split
+ * based on remaining features.
+ * 
+ * @param data The training dataset.
+ * @param features List of features to consider for splits.
+ * Features named in NUMERIC_FEATURES are continuous: they are binned once up
+ * front and split with a binary threshold (see score_threshold).
+ * 
+ * @param arena Arena that owns the nodes; the tree lives until it is released.
+ * @return TreeNode* Pointer to the root node of the trained tree.
+ */
+inline TreeNode* train_decision_tree(const vector<Example>& data, const vector<string>& features, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree(data, all_rows(data), features, 0, nullptr, columns, arena);
+}
+
+/**
+ * @brief Trains a decision tree on the examples `data[rows[i]]` only
+ * 
+ * Used by cross-validation, where the folds are index lists into one dataset.
+ * Numeric bin edges are cut from the whole dataset; they depend on the feature
+ * values only, never on the labels.
+ */
+inline TreeNode* train_decision_tree(const vector<Example>& data, const vector<size_t>& rows,
+                                     const vector<string>& features, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree(data, rows, features, 0, nullptr, columns, arena);
+}
+
+/**
+ * @brief Trains a decision tree on `data[rows[i]]` that stops at the given limits
+ * 
+ * Example:
+ *   TreeLimits limits;
+ *   limits.max_depth = 12;
+ *   limits.min_samples_leaf = 5;
+ *   TreeNode* tree = train_decision_tree(flows, train_rows, NUMERIC_FEATURES, limits, arena);
+ */
+inline TreeNode* train_decision_tree(const vector<Example>& data, const vector<size_t>& rows,
+                                     const vector<string>& features, const TreeLimits& limits, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree(data, rows, features, 0, nullptr, columns, arena, limits);
+}
+
+/**
+ * @brief Bins the numeric features of a Dataset, as build_numeric_columns does for Examples
+ * 
+ * Each column is already a contiguous float array, so it is copied and sorted
+ * without touching the other features. The label codes are the dataset's label ids.
+ */
+inline NumericColumns build_numeric_columns(const Dataset& data, const vector<string>& features) {
+    NumericColumns columns;
+    columns.edges.resize(NUMERIC_FEATURES.size());
+    columns.codes.resize(NUMERIC_FEATURES.size());
+
+    for (const auto& feature : features) {
+        int f = numeric_index(feature), c = data.feature_index(feature);
+        if (f < 0 || c < 0 || !columns.codes[f].empty() || data.num_rows() == 0) continue;
+        const float* values = data.column(c);
+
+        vector<double> sorted(values, values + data.num_rows());
+        sort(sorted.begin(), sorted.end());
+
+        vector<double>& edges = columns.edges[f];
+        edges = quantile_edges(sorted);
+
+        vector<uint8_t>& codes = columns.codes[f];
+        codes.resize(data.num_rows());
+        for (size_t row = 0; row < data.num_rows(); ++row) {
+            codes[row] = static_cast<uint8_t>(lower_bound(edges.begin(), edges.end(), double(values[row])) - edges.begin());
+        }
+    }
+
+    columns.num_labels = data.label_names().size();
+    columns.label_codes.assign(data.labels(), data.labels() + data.num_rows());
+    return columns;
+}
+
+/**
+ * @brief Entropy of the labels of the rows `rows` of a Dataset
+ */
+inline double calculate_entropy(const Dataset& data, const vector<size_t>& rows) {
+    vector<int> counts(data.label_names().size(), 0);
+    for (size_t row : rows) counts[data.label(row)]++;
+    return entropy_of_counts(counts.data(), counts.size(), static_cast<int>(rows.size()));
+}
+
+/**
+ * @brief Scores splitting a Dataset's rows on one feature (see score_feature)
+ * 
+ * Numeric features go through the same binned threshold search; categorical ones
+ * are partitioned by their dictionary values, so the child keys are the strings
+ * an Example-trained tree would use.
+ */
+inline FeatureSplit score_feature(const Dataset& data, const vector<size_t>& rows, const string& feature,
+                                  double base_entropy, const NumericColumns& columns, size_t min_leaf = 1) {
+    int f = numeric_index(feature), c = data.feature_index(feature);
+    if (f >= 0 && c >= 0) return score_threshold(rows, f, base_entropy, columns, min_leaf);
+
+    FeatureSplit candidate;
+    if (c < 0 || !data.is_categorical(c)) return candidate;
+    FAI_COUNT(SPLIT_EVALUATIONS);
+    const float* codes = data.column(c);
+    const vector<string>& values = data.dictionary(c);
+    for (size_t row : rows) {
+        candidate.splits[values[static_cast<size_t>(codes[row])]].push_back(row);
+    }
+    for (const auto& split : candidate.splits) {
+        if (split.second.size() < min_leaf) return FeatureSplit();
+    }
+
+    double new_entropy = 0.0;
+    for (const auto& split : candidate.splits) {
+        double weight = static_cast<double>(split.second.size()) / rows.size();
+        new_entropy += weight * calculate_entropy(data, split.second);
+    }
+
+    candidate.gain = base_entropy - new_entropy;
+    return candidate;
+}
+
+/**
+ * @brief Returns the most frequent label of a Dataset's rows (the lowest label id on ties)
+ */
+inline string majority_label(const Dataset& data, const vector<size_t>& rows) {
+    vector<size_t> counts(data.label_names().size(), 0);
+    for (size_t row : rows) counts[data.label(row)]++;
+    return data.label_names()[max_element(counts.begin(), counts.end()) - counts.begin()];
+}
+
+/**
+ * @brief build_tree for a Dataset: the same ID3 recursion over an index view
+ */
+inline TreeNode* build_tree(const Dataset& data, const vector<size_t>& rows, const vector<string>& features,
+                            const NumericColumns& columns, TreeArena& arena, const TreeLimits& limits = TreeLimits(),
+                            size_t depth = 0) {
+    if (rows.empty()) return nullptr;
+
+    const int32_t first_label = data.label(rows[0]);
+    bool single_label = true;
+    for (size_t row : rows) single_label = single_label && data.label(row) == first_label;
+    if (single_label) {
+        TreeNode* leaf = arena.make_node();
+        leaf->label = data.label_names()[first_label];
+        return leaf;
+    }
+
+    if (rows.size() < limits.min_samples_split || (limits.max_depth > 0 && depth >= limits.max_depth)) {
+        TreeNode* leaf = arena.make_node();
+        leaf->label = majority_label(data, rows);
+        return leaf;
+    }
+
+    double base_entropy = calculate_entropy(data, rows);
+    double best_gain = 0.0;
+    string best_feature;
+    double best_threshold = 0.0;
+    map<string, vector<size_t>> best_splits;
+
+    for (const auto& feature : features) {
+        FeatureSplit candidate = score_feature(data, rows, feature, base_entropy, columns, limits.min_samples_leaf);
+        if (candidate.gain > best_gain) {
+            best_gain = candidate.gain;
+            best_feature = feature;
+            best_threshold = candidate.threshold;
+            best_splits = move(candidate.splits);
+        }
+    }
+
+    if (best_gain == 0) {
+        TreeNode* leaf = arena.make_node();
+        leaf->label = data.label_names()[first_label];
+        return leaf;
+    }
+
+    TreeNode* node = make_split(best_feature, best_threshold, arena);
+    vector<string> remaining_features = remove_feature(features, best_feature);
+    for (const auto& split : best_splits) {
+        node->children[split.first] =
+            build_tree(data, split.second, remaining_features, columns, arena, limits, depth + 1);
+    }
+    return node;
+}
+
+/**
+ * @brief Trains a decision tree on the rows `rows` of a column Dataset
+ * 
+ * The learner reads the float32 columns and int32 labels directly and never
+ * materialises Examples; train/test splits and folds are index views (see the
+ * Dataset overload of split_data). Numeric features become threshold splits on
+ * the float32 values, categorical ones split on their dictionary values. The
+ * returned tree is an ordinary TreeNode tree that predicts label names.
+ * 
+ * Example:
+ *   Dataset flows = load_flow_dataset("flows.csv");
+ *   vector<size_t> train, test;
+ *   split_data(flows, train, test, 0.8);
+ *   TreeNode* tree = train_decision_tree(flows, train, NUMERIC_FEATURES, arena);
+ *   double accuracy = calculate_accuracy(tree, flows, test);
+ * 
+ * @param data The dataset; it must be labelled.
+ * @param rows Indices of the training rows.
+ * @param features Names of the dataset features to consider for splits.
+ * @param arena Arena that owns the nodes.
+ * @return TreeNode* Pointer to the root node of the trained tree.
+ */
+inline TreeNode* train_decision_tree(const Dataset& data, const vector<size_t>& rows, const vector<string>& features,
+                                     TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree(data, rows, features, columns, arena);
+}
+
+/**
+ * @brief Trains a decision tree on the rows `rows` of a column Dataset that stops at the given limits
+ */
+inline TreeNode* train_decision_tree(const Dataset& data, const vector<size_t>& rows, const vector<string>& features,
+                                     const TreeLimits& limits, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree(data, rows, features, columns, arena, limits);
+}
+
+// Nodes with at least this many examples score their candidate features in parallel
+const size_t PARALLEL_SCORING_MIN_ROWS = 1 << 16;
+
+// Subtrees with fewer examples than this are built inline instead of as a new task
+const size_t SUBTREE_TASK_MIN_ROWS = 1 << 10;
+
+/**
+ * @brief Parallel counterpart of build_tree (without feature sampling)
+ * 
+ * See train_decision_tree_parallel for how the work is split into tasks.
+ */
+inline TreeNode* build_tree_parallel(const vector<Example>& data, const vector<size_t>& rows, const vector<string>& features,
+                                     const NumericColumns& columns, TaskScheduler& scheduler, TreeArena& arena,
+                                     const TreeLimits& limits = TreeLimits(), size_t depth = 0) {
+    if (rows.empty()) return nullptr;
+    if (rows.size() < SUBTREE_TASK_MIN_ROWS) {
+        return build_tree(data, rows, features, 0, nullptr, columns, arena, limits, depth);
+    }
+
+    if (has_single_label(data, rows)) return make_leaf(data, rows, arena);
+
+    if (rows.size() < limits.min_samples_split || (limits.max_depth > 0 && depth >= limits.max_depth)) {
+        TreeNode* leaf = arena.make_node();
+        leaf->label = majority_label(data, rows);
+        return leaf;
+    }
+
+    double base_entropy = calculate_entropy(data, rows);
+    vector<FeatureSplit> candidates(features.size());
+    auto score = [&](size_t i) {
+        candidates[i] = score_feature(data, rows, features[i], base_entropy, columns, limits.min_samples_leaf);
+    };
+    if (rows.size() >= PARALLEL_SCORING_MIN_ROWS && features.size() > 1) {
+        scheduler.parallel_for(0, features.size(), score);
+    } else {
+        for (size_t i = 0; i < features.size(); ++i) score(i);
+    }
+
+    size_t best = features.size();
+    double best_gain = 0.0;
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (candidates[i].gain > best_gain) {
+            best_gain = candidates[i].gain;
+            best = i;
+        }
+    }
+
+    if (best == features.size()) return make_leaf(data, rows, arena);
+
+    TreeNode* node = make_split(features[best], candidates[best].threshold, arena);
+    vector<string> remaining_features = remove_feature(features, features[best]);
+    const map<string, vector<size_t>>& best_splits = candidates[best].splits;
+
+    for (const auto& split : best_splits) {
+        node->children[split.first] = nullptr;
+    }
+
+    TaskGroup group;
+    for (const auto& split : best_splits) {
+        TreeNode** slot = &node->children[split.first];
+        const vector<size_t>* subset = &split.second;
+        scheduler.spawn(group, [&data, slot, subset, &remaining_features, &columns, &scheduler, &arena, &limits, depth] {
+            *slot = build_tree_parallel(data, *subset, remaining_features, columns, scheduler, arena, limits, depth + 1);
+        });
+    }
+    scheduler.wait(group);
+
+    return node;
+}
+
+/**
+ * @brief Trains a decision tree using a work-stealing task scheduler
+ * 
+ * Produces exactly the same tree as train_decision_tree, but spreads the work
+ * over the scheduler's threads in two ways:
+ * 1. Large nodes (at least PARALLEL_SCORING_MIN_ROWS examples) score every
+ *    candidate feature as a separate task. The winner is then picked in the
+ *    original feature order with the same strict ">" comparison, so ties resolve
+ *    exactly as in the sequential trainer.
+ * 2. Every child subtree with at least SUBTREE_TASK_MIN_ROWS examples is built as
+ *    an independent task. Smaller subtrees fall back to the sequential trainer,
+ *    where spawning would cost more than the work itself.
+ * 
+ * Child slots are inserted into `children` before any task starts, so the tasks
+ * only ever write through their own pointer and never modify the map.
+ * 
+ * @param data The training dataset.
+ * @param features List of features to consider for splits.
+ * @param scheduler Scheduler that runs the scoring and subtree tasks.
+ * @param arena Arena that owns the nodes; it is shared by all tasks.
+ * @return TreeNode* Pointer to the root node of the trained tree.
+ */
+inline TreeNode* train_decision_tree_parallel(const vector<Example>& data, const vector<string>& features,
+                                              TaskScheduler& scheduler, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree_parallel");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree_parallel(data, all_rows(data), features, columns, scheduler, arena);
+}
+
+/**
+ * @brief train_decision_tree_parallel that stops at the given limits
+ * 
+ * Produces the same tree as the sequential train_decision_tree with `limits`.
+ */
+inline TreeNode* train_decision_tree_parallel(const vector<Example>& data, const vector<string>& features,
+                                              const TreeLimits& limits, TaskScheduler& scheduler, TreeArena& arena) {
+    FAI_SCOPED_TIMER("pa4::train_decision_tree_parallel");
+    NumericColumns columns = build_numeric_columns(data, features);
+    return build_tree_parallel(data, all_rows(data), features, columns, scheduler, arena, limits);
+}
+
+// Rows per numeric column kept in the reservoir sample that sets the streaming bin edges
+const size_t STREAMING_SAMPLE_ROWS = 1 << 16;
+
+/**
+ * @struct StreamingFeature
+ * @brief A feature as stored in a column file, with its values numbered for histograms.
+ * 
+ * Categorical values are counted by their rank in sorted order (`rank[code]`), so
+ * histograms are laid out in the same order as the child maps of TreeNode. Numeric
+ * values are counted by quantile bin, as in NumericColumns.
+ */
+struct StreamingFeature {
+    string name;
+    int column = -1;
+    bool numeric = false;
+    vector<double> edges;  // Numeric: bin cut points
+    vector<uint32_t> rank; // Categorical: sorted position of each dictionary code
+    vector<string> values; // Categorical: dictionary values in sorted order
+
+    size_t num_bins() const { return numeric ? edges.size() + 1 : values.size(); }
+
+    uint32_t bin(const ColumnGroup& group, size_t row) const {
+        if (!numeric) return rank[group.codes[column][row]];
+        double value = group.numbers[column][row];
+        return static_cast<uint32_t>(lower_bound(edges.begin(), edges.end(), value) - edges.begin());
+    }
+};
+
+/**
+ * @struct RouteNode
+ * @brief How a row moves through the part of a streaming tree that is already built.
+ * 
+ * A split node sends a row to `child[dictionary code]` (categorical) or to
+ * child[0] / child[1] for value <= / > `threshold` (numeric). A node of the current
+ * level has `frontier` >= 0; a finished leaf has neither and the row is dropped.
+ */
+struct RouteNode {
+    int feature = -1; // StreamingFeature index of a split, -1 otherwise
+    double threshold = 0.0;
+    vector<int32_t> child;
+    int32_t frontier = -1;
+};
+
+/**
+ * @struct FrontierNode
+ * @brief A node of the level being grown, with the counts gathered for it in one pass.
+ */
+struct FrontierNode {
+    TreeNode* node = nullptr;
+    int32_t route = 0;          // Its RouteNode
+    size_t depth = 0;
+    vector<string> features;    // Features still available at this node
+    vector<size_t> feature_ids; // Their StreamingFeature indices
+    vector<vector<int>> histograms; // (bin x label) counts, one per feature_ids entry
+    vector<int> label_counts;
+    int first_label = -1;       // Label of the first row (in file order) that reached the node
+};
+
+/**
+ * @brief Matches features to column-file columns and sets up their value numbering
+ * 
+ * Names are compared case-insensitively, so the feature "author" reads the
+ * "Author" column. Features without a column, or whose column type does not
+ * match NUMERIC_FEATURES, are skipped with a warning. Numeric edges are filled
+ * in later from a sample.
+ */
+inline vector<StreamingFeature> streaming_features(const ColumnFile& file, const vector<string>& features) {
+    auto lower = [](string text) {
+        for (char& ch : text) ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+        return text;
+    };
+    vector<StreamingFeature> result;
+    for (const auto& name : features) {
+        StreamingFeature feature;
+        feature.name = name;
+        for (size_t c = 0; c < file.num_columns(); ++c) {
+            if (lower(file.names()[c]) == lower(name)) feature.column = static_cast<int>(c);
+        }
+        if (feature.column < 0 || file.is_numeric(feature.column) != (numeric_index(name) >= 0)) {
+            cerr << "Skipping feature without a matching column: " << name << endl;
+            continue;
+        }
+        feature.numeric = file.is_numeric(feature.column);
+        if (!feature.numeric) {
+            const vector<string>& dictionary = file.dictionary(feature.column);
+            feature.values = dictionary;
+            sort(feature.values.begin(), feature.values.end());
+            for (const auto& value : dictionary) {
+                feature.rank.push_back(static_cast<uint32_t>(
+                    lower_bound(feature.values.begin(), feature.values.end(), value) - feature.values.begin()));
+            }
+        }
+        result.push_back(move(feature));
+    }
+    return result;
+}
+
+/**
+ * @brief Trains a decision tree level by level from a column file that may not fit in memory
+ * 
+ * Only the tree and the counts of one level are held in memory. Steps:
+ * 1. If there are numeric features, one pass draws a reservoir sample of at most
+ *    STREAMING_SAMPLE_ROWS rows and cuts each numeric column into quantile bins.
+ * 2. Each depth level is one pass over the file (double-buffered, see
+ *    for_each_column_group). Every row is routed from the root through the splits
+ *    made so far; if it lands on a node of the current level, its label is added
+ *    to that node's (bin x label) histogram of every candidate feature.
+ * 3. After the pass each node of the level picks its best split from the
+ *    histograms, exactly like build_tree, or becomes a leaf. Its children form the
+ *    next level.
+ * 
+ * Labels are numbered in sorted order and categorical values are scored in sorted
+ * order, so when the file has at most STREAMING_SAMPLE_ROWS rows the result is the
+ * same tree train_decision_tree builds from the whole file.
+ * 
+ * @param file An open column file.
+ * @param features Features to consider for splits (matched to columns by name).
+ * @param label_column Name of the categorical column holding the label.
+ * @param max_depth Depth at which nodes become majority-label leaves (0 = unlimited).
+ * @param arena Arena that owns the nodes.
+ * @return TreeNode* Root of the tree, or nullptr if the file is empty or has no such label column.
+ */
+inline TreeNode* train_decision_tree_streaming(const ColumnFile& file, const vector<string>& features,
+                                               const string& label_column, size_t max_depth, TreeArena& arena) {
+    const int label = file.column(label_column);
+    if (label < 0 || file.is_numeric(label) || file.num_rows() == 0) return nullptr;
+
+    vector<StreamingFeature> columns = streaming_features(file, features);
+    vector<string> usable;
+    vector<bool> wanted(file.num_columns(), false);
+    wanted[label] = true;
+    bool any_numeric = false;
+    for (const auto& feature : columns) {
+        usable.push_back(feature.name);
+        wanted[feature.column] = true;
+        any_numeric = any_numeric || feature.numeric;
+    }
+
+    // Labels numbered in sorted order, like the label maps of the in-memory trainer
+    vector<string> labels = file.dictionary(label);
+    sort(labels.begin(), labels.end());
+    vector<uint32_t> label_rank;
+    for (const auto& value : file.dictionary(label)) {
+        label_rank.push_back(static_cast<uint32_t>(lower_bound(labels.begin(), labels.end(), value) - labels.begin()));
+    }
+    const size_t num_labels = labels.size();
+
+    // Pass 0: reservoir sample of the numeric columns for the bin edges
+    if (any_numeric) {
+        vector<vector<double>> samples(columns.size());
+        mt19937_64 rng(42);
+        size_t seen = 0;
+        for_each_column_group(file, wanted, [&](const ColumnGroup& group) {
+            for (size_t row = 0; row < group.num_rows; ++row, ++seen) {
+                size_t slot = seen < STREAMING_SAMPLE_ROWS ? seen : uniform_int_distribution<size_t>(0, seen)(rng);
+                if (slot >= STREAMING_SAMPLE_ROWS) continue;
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    if (!columns[i].numeric) continue;
+                    if (slot == samples[i].size()) samples[i].push_back(group.numbers[columns[i].column][row]);
+                    else samples[i][slot] = group.numbers[columns[i].column][row];
+                }
+            }
+        });
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (!columns[i].numeric) continue;
+            sort(samples[i].begin(), samples[i].end());
+            columns[i].edges = quantile_edges(samples[i]);
+        }
+    }
+
+    vector<RouteNode> route(1);
+    vector<FrontierNode> level(1);
+    level[0].node = arena.make_node();
+    level[0].features = usable;
+    TreeNode* root = level[0].node;
+
+    while (!level.empty()) {
+        for (size_t n = 0; n < level.size(); ++n) {
+            FrontierNode& frontier = level[n];
+            route[frontier.route].frontier = static_cast<int32_t>(n);
+            frontier.label_counts.assign(num_labels, 0);
+            for (const auto& name : frontier.features) {
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    if (columns[i].name != name) continue;
+                    frontier.feature_ids.push_back(i);
+                    frontier.histograms.emplace_back(columns[i].num_bins() * num_labels, 0);
+                }
+            }
+        }
+
+        // One pass over the file for the whole level
+        for_each_column_group(file, wanted, [&](const ColumnGroup& group) {
+            const vector<uint32_t>& label_codes = group.codes[label];
+            for (size_t row = 0; row < group.num_rows; ++row) {
+                int32_t r = 0;
+                while (r >= 0 && route[r].feature >= 0) {
+                    const RouteNode& split = route[r];
+                    const StreamingFeature& feature = columns[split.feature];
+                    r = feature.numeric ? split.child[group.numbers[feature.column][row] <= split.threshold ? 0 : 1]
+                                        : split.child[group.codes[feature.column][row]];
+                }
+                if (r < 0 || route[r].frontier < 0) continue;
+
+                FrontierNode& frontier = level[route[r].frontier];
+                const uint32_t l = label_rank[label_codes[row]];
+                frontier.label_counts[l]++;
+                if (frontier.first_label < 0) frontier.first_label = static_cast<int>(l);
+                for (size_t k = 0; k < frontier.feature_ids.size(); ++k) {
+                    frontier.histograms[k][columns[frontier.feature_ids[k]].bin(group, row) * num_labels + l]++;
+                }
+            }
+        });
+
+        // Choose a split (or a leaf) for every node of the level
+        vector<FrontierNode> next_level;
+        for (FrontierNode& frontier : level) {
+            route[frontier.route].frontier = -1;
+            TreeNode* node = frontier.node;
+
+            int total = 0;
+            size_t present = 0, majority = 0;
+            for (size_t l = 0; l < num_labels; ++l) {
+                total += frontier.label_counts[l];
+                present += frontier.label_counts[l] > 0;
+                if (frontier.label_counts[l] > frontier.label_counts[majority]) majority = l;
+            }
+            if (total == 0) continue;
+            if (present == 1) {
+                node->label = labels[frontier.first_label];
+                continue;
+            }
+            if (max_depth > 0 && frontier.depth >= max_depth) {
+                node->label = labels[majority];
+                continue;
+            }
+
+            const double base_entropy = entropy_of_counts(frontier.label_counts.data(), num_labels, total);
+            double best_gain = 0.0;
+            size_t best = frontier.feature_ids.size();
+            size_t best_bin = 0;
+            for (size_t k = 0; k < frontier.feature_ids.size(); ++k) {
+                const StreamingFeature& feature = columns[frontier.feature_ids[k]];
+                const vector<int>& histogram = frontier.histograms[k];
+                double gain = 0.0;
+                size_t bin = 0;
+                if (feature.numeric) {
+                    double best_entropy = base_entropy;
+                    bin = best_histogram_split(histogram, feature.num_bins(), num_labels, total, best_entropy);
+                    if (bin < feature.num_bins()) gain = base_entropy - best_entropy;
+                } else {
+                    double new_entropy = 0.0;
+                    for (size_t v = 0; v < feature.num_bins(); ++v) {
+                        int count = 0;
+                        for (size_t l = 0; l < num_labels; ++l) count += histogram[v * num_labels + l];
+                        if (count == 0) continue;
+                        double weight = static_cast<double>(count) / total;
+                        new_entropy += weight * entropy_of_counts(&histogram[v * num_labels], num_labels, count);
+                    }
+                    gain = base_entropy - new_entropy;
+                }
+                if (gain > best_gain) {
+                    best_gain = gain;
+                    best = k;
+                    best_bin = bin;
+                }
+            }
+            if (best == frontier.feature_ids.size()) {
+                node->label = labels[frontier.first_label];
+                continue;
+            }
+
+            // Turn the node into a split and queue its children for the next level
+            const size_t f = frontier.feature_ids[best];
+            const StreamingFeature& feature = columns[f];
+            node->feature = feature.name;
+            node->numeric = numeric_index(feature.name);
+            vector<string> remaining_features = remove_feature(frontier.features, feature.name);
+            auto add_child = [&](const string& key) {
+                FrontierNode child;
+                child.node = arena.make_node();
+                child.route = static_cast<int32_t>(route.size());
+                child.depth = frontier.depth + 1;
+                child.features = remaining_features;
+                node->children[key] = child.node;
+                route.emplace_back();
+                next_level.push_back(move(child));
+                return static_cast<int32_t>(route.size() - 1);
+            };
+
+            vector<int32_t> children;
+            if (feature.numeric) {
+                node->threshold = feature.edges[best_bin];
+                children.push_back(add_child(LEFT_BRANCH));
+                children.push_back(add_child(RIGHT_BRANCH));
+            } else {
+                vector<int32_t> by_rank(feature.num_bins(), -1);
+                const vector<int>& histogram = frontier.histograms[best];
+                for (size_t v = 0; v < feature.num_bins(); ++v) {
+                    int count = 0;
+                    for (size_t l = 0; l < num_labels; ++l) count += histogram[v * num_labels + l];
+                    if (count > 0) by_rank[v] = add_child(feature.values[v]);
+                }
+                for (uint32_t rank : feature.rank) children.push_back(by_rank[rank]);
+            }
+            // `route` may have grown, so look the node up again
+            route[frontier.route].feature = static_cast<int>(f);
+            route[frontier.route].threshold = node->threshold;
+            route[frontier.route].child = move(children);
+        }
+        level = move(next_level);
+    }
+    return root;
+}
+
+/**
+ * @brief Checks whether two trees have the same structure, features and labels
+ */
+inline bool trees_equal(const TreeNode* a, const TreeNode* b) {
+    if (a == nullptr || b == nullptr) return a == b;
+    if (a->feature != b->feature || a->label != b->label || a->threshold != b->threshold) return false;
+    if (a->children.size() != b->children.size()) return false;
+    auto it_a = a->children.begin();
+    auto it_b = b->children.begin();
+    for (; it_a != a->children.end(); ++it_a, ++it_b) {
+        if (it_a->first != it_b->first || !trees_equal(it_a->second, it_b->second)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Number of nodes reachable from `root`
+ */
+inline size_t count_nodes(const TreeNode* root) {
+    if (root == nullptr) return 0;
+    size_t count = 1;
+    for (const auto& child : root->children) count += count_nodes(child.second);
+    return count;
+}
+
+/**
+ * @brief Length of the longest root-to-leaf path (0 for a single leaf)
+ */
+inline size_t tree_depth(const TreeNode* root) {
+    size_t deepest = 0;
+    for (const auto& child : root->children) {
+        if (child.second) deepest = max(deepest, tree_depth(child.second) + 1);
+    }
+    return deepest;
+}
+
+// What replacing one node of a trained tree by a leaf would cost
+struct NodePruningStats {
+    string label;                 // Label of the node as a leaf: its majority training label
+    size_t train_errors = 0;      // Training rows it would misclassify as a leaf
+    size_t train_unseen = 0;      // Training rows with a value none of its children has
+    size_t validation_errors = 0; // Held-out rows it would misclassify as a leaf
+    size_t validation_unseen = 0; // Held-out rows with a value none of its children has
+};
+
+using PruningStatistics = unordered_map<const TreeNode*, NodePruningStats>;
+
+/**
+ * @brief Routes the training and held-out rows through a tree and records, for every node, its errors as a leaf
+ * 
+ * Rows whose value has no child stop at that node; while the node splits,
+ * predict() answers "unknown" for them, so they count as errors of the subtree.
+ */
+inline PruningStatistics collect_pruning_statistics(const TreeNode* root, const vector<Example>& data,
+                                                    const vector<size_t>& train_rows, const vector<size_t>& validation_rows) {
+    PruningStatistics stats;
+    unordered_map<const TreeNode*, map<string, size_t>> label_counts;
+    for (size_t row : train_rows) {
+        const TreeNode* node = root;
+        while (true) {
+            label_counts[node][data[row].user_action]++;
+            if (node->children.empty()) break;
+            auto child = node->children.find(branch_value(node, data[row]));
+            if (child == node->children.end()) {
+                stats[node].train_unseen++;
+                break;
+            }
+            node = child->second;
+        }
+    }
+
+    vector<const TreeNode*> pending = {root};
+    while (!pending.empty()) {
+        const TreeNode* node = pending.back();
+        pending.pop_back();
+        NodePruningStats& node_stats = stats[node];
+        node_stats.label = node->label;
+        const map<string, size_t>& counts = label_counts[node];
+        size_t total = 0, best = 0;
+        for (const auto& count : counts) {
+            total += count.second;
+            if (count.second > best && !node->children.empty()) {
+                best = count.second;
+                node_stats.label = count.first;
+            }
+        }
+        auto own = counts.find(node_stats.label);
+        node_stats.train_errors = total - (own == counts.end() ? 0 : own->second);
+        for (const auto& child : node->children) pending.push_back(child.second);
+    }
+
+    for (size_t row : validation_rows) {
+        const TreeNode* node = root;
+        while (true) {
+            NodePruningStats& node_stats = stats[node];
+            if (node_stats.label != data[row].user_action) node_stats.validation_errors++;
+            if (node->children.empty()) break;
+            auto child = node->children.find(branch_value(node, data[row]));
+            if (child == node->children.end()) {
+                node_stats.validation_unseen++;
+                break;
+            }
+            node = child->second;
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief Turns an internal node into a leaf predicting `label`
+ * 
+ * The detached subtree stays in its arena until the arena is released.
+ */
+inline void collapse_to_leaf(TreeNode* node, const string& label) {
+    node->children.clear();
+    node->feature.clear();
+    node->numeric = -1;
+    node->threshold = 0.0;
+    node->label = label;
+}
+
+inline size_t reduced_error_prune(TreeNode* node, const PruningStatistics& stats) {
+    const NodePruningStats& node_stats = stats.at(node);
+    if (node->children.empty()) return node_stats.validation_errors;
+    size_t subtree_errors = node_stats.validation_unseen;
+    for (const auto& child : node->children) subtree_errors += reduced_error_prune(child.second, stats);
+    if (node_stats.validation_errors > subtree_errors) return subtree_errors;
+    collapse_to_leaf(node, node_stats.label);
+    return node_stats.validation_errors;
+}
+
+/**
+ * @brief Reduced-error pruning against a held-out set
+ * 
+ * Visits the tree bottom-up and replaces a subtree by a leaf with its majority
+ * training label whenever that leaf makes no more errors on the held-out rows
+ * than the (already pruned) subtree. The result is the smallest subtree with the
+ * lowest held-out error that this greedy pass can reach.
+ * 
+ * Example:
+ *   TreeNode* tree = train_decision_tree(data, fit_rows, features, arena);
+ *   prune_reduced_error(tree, data, fit_rows, validation_rows);
+ * 
+ * @param root Root of the tree, pruned in place.
+ * @param data The dataset.
+ * @param train_rows Rows the tree was trained on (they choose the leaf labels).
+ * @param validation_rows Held-out rows that decide what to prune.
+ * @return size_t Held-out errors of the pruned tree.
+ */
+inline size_t prune_reduced_error(TreeNode* root, const vector<Example>& data, const vector<size_t>& train_rows,
+                                  const vector<size_t>& validation_rows) {
+    PruningStatistics stats = collect_pruning_statistics(root, data, train_rows, validation_rows);
+    return reduced_error_prune(root, stats);
+}
+
+/**
+ * @struct WeakestLink
+ * @brief One internal node in prune_cost_complexity's bookkeeping.
+ * 
+ * Internal nodes are numbered in post-order, so the internal nodes of the
+ * subtree of node i are exactly first..i. Costs count pruned descendants as
+ * leaves and are updated in place as nodes below are pruned.
+ */
+struct WeakestLink {
+    TreeNode* node = nullptr;
+    size_t parent = 0;            // Index of the parent; the root is its own parent
+    size_t first = 0;             // Lowest index in this node's subtree
+    size_t subtree_errors = 0;    // R(T_t): training errors of the subtree
+    size_t leaves = 0;            // |leaves(T_t)|
+    size_t validation_errors = 0; // Held-out errors of the subtree
+    double alpha = 0.0;
+    bool active = true;           // False once the node or an ancestor is pruned
+};
+
+inline double weakest_link_alpha(const WeakestLink& link, const NodePruningStats& node_stats) {
+    return (static_cast<double>(node_stats.train_errors) - static_cast<double>(link.subtree_errors)) /
+           static_cast<double>(max<size_t>(link.leaves - 1, 1));
+}
+
+/**
+ * @brief Numbers the internal nodes of a subtree in post-order and computes their costs bottom-up
+ * 
+ * Leaves are not numbered; `link` receives the costs of `node` itself either way.
+ */
+inline void index_weakest_links(TreeNode* node, const PruningStatistics& stats, vector<WeakestLink>& links,
+                                WeakestLink& link) {
+    const NodePruningStats& node_stats = stats.at(node);
+    link.node = node;
+    if (node->children.empty()) {
+        link.subtree_errors = node_stats.train_errors;
+        link.leaves = 1;
+        link.validation_errors = node_stats.validation_errors;
+        return;
+    }
+
+    link.first = links.size();
+    link.subtree_errors = node_stats.train_unseen;
+    link.leaves = 0;
+    link.validation_errors = node_stats.validation_unseen;
+    vector<size_t> children;
+    for (const auto& child : node->children) {
+        WeakestLink child_link;
+        index_weakest_links(child.second, stats, links, child_link);
+        link.subtree_errors += child_link.subtree_errors;
+        link.leaves += child_link.leaves;
+        link.validation_errors += child_link.validation_errors;
+        if (!child.second->children.empty()) children.push_back(links.size() - 1);
+    }
+    link.alpha = weakest_link_alpha(link, node_stats);
+    for (size_t child : children) links[child].parent = links.size();
+    links.push_back(link);
+    links.back().parent = links.size() - 1;
+}
+
+/**
+ * @brief Minimal cost-complexity (weakest-link) pruning, with the subtree chosen on a held-out set
+ * 
+ * Steps:
+ * 1. Each internal node t costs alpha(t) = (R(t) - R(T_t)) / (|leaves(T_t)| - 1),
+ *    where R(t) counts the training errors of t as a leaf and R(T_t) those of its
+ *    subtree: the training error added per leaf removed.
+ * 2. The node with the smallest alpha is pruned, until only the root is left.
+ *    This gives the nested sequence of subtrees that are optimal for increasing
+ *    complexity penalties alpha. Costs are computed bottom-up once; a prune only
+ *    changes its ancestors, so their costs are updated in place and re-queued in
+ *    a min-heap, and each step costs O(depth + log nodes), not a tree walk.
+ * 3. The subtree of that sequence with the fewest held-out errors is kept (the
+ *    smallest one on ties) and applied to the tree in place.
+ * 
+ * @param root Root of the tree, pruned in place.
+ * @param data The dataset.
+ * @param train_rows Rows the tree was trained on.
+ * @param validation_rows Held-out rows that choose the subtree.
+ * @return size_t Held-out errors of the pruned tree.
+ */
+inline size_t prune_cost_complexity(TreeNode* root, const vector<Example>& data, const vector<size_t>& train_rows,
+                                    const vector<size_t>& validation_rows) {
+    PruningStatistics stats = collect_pruning_statistics(root, data, train_rows, validation_rows);
+    vector<WeakestLink> links;
+    WeakestLink root_link;
+    index_weakest_links(root, stats, links, root_link);
+    if (links.empty()) return root_link.validation_errors;
+
+    // Smallest alpha first, the first node in post-order on ties
+    using Entry = pair<double, size_t>;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+    for (size_t i = 0; i < links.size(); ++i) queue.push({links[i].alpha, i});
+
+    const size_t root_index = links.size() - 1;
+    vector<TreeNode*> sequence;
+    size_t best_errors = links[root_index].validation_errors, best_length = 0;
+    while (!queue.empty()) {
+        const Entry top = queue.top();
+        queue.pop();
+        WeakestLink& weakest = links[top.second];
+        if (!weakest.active || top.first != weakest.alpha) continue; // Pruned, or superseded by a later entry
+
+        // Prune it: deactivate its subtree, skipping subtrees that were pruned before
+        for (size_t i = top.second + 1; i-- > weakest.first;) {
+            if (!links[i].active) {
+                i = links[i].first;
+                continue;
+            }
+            links[i].active = false;
+        }
+        sequence.push_back(weakest.node);
+
+        // Its ancestors lose its subtree and gain one leaf in its place
+        const NodePruningStats& weakest_stats = stats.at(weakest.node);
+        const size_t removed_errors = weakest.subtree_errors, removed_leaves = weakest.leaves;
+        const size_t removed_validation = weakest.validation_errors;
+        for (size_t i = top.second; i != root_index;) {
+            i = links[i].parent;
+            WeakestLink& ancestor = links[i];
+            ancestor.subtree_errors = ancestor.subtree_errors - removed_errors + weakest_stats.train_errors;
+            ancestor.leaves = ancestor.leaves - removed_leaves + 1;
+            ancestor.validation_errors = ancestor.validation_errors - removed_validation + weakest_stats.validation_errors;
+            ancestor.alpha = weakest_link_alpha(ancestor, stats.at(ancestor.node));
+            queue.push({ancestor.alpha, i});
+        }
+
+        size_t errors = top.second == root_index ? weakest_stats.validation_errors : links[root_index].validation_errors;
+        if (errors <= best_errors) {
+            best_errors = errors;
+            best_length = sequence.size();
+        }
+        if (top.second == root_index) break;
+    }
+
+    for (size_t step = 0; step < best_length; ++step) {
+        collapse_to_leaf(sequence[step], stats.at(sequence[step]).label);
+    }
+    return best_errors;
+}
+
+/**
+ * @brief Predicts the user action based on the trained tree
+ * 
+ * This function traverses the decision tree to predict the user action for a new example.
+ * Starting from the root, it checks the example’s feature values and moves down the tree
+ * until it reaches a leaf node, which holds the prediction.
+ * 
+ * @param root Pointer to the root of the decision tree.
+ * @param example New example to classify.
+ * @return string Predicted user action.
+ */
+inline string predict(TreeNode* root, const Example& example) {
+    if (root->children.empty()) return root->label;
+    const string& value = branch_value(root, example);
+    if (root->children.count(value)) {
+        return predict(root->children[value], example);
+    } else {
+        return "unknown"; // Handle unseen data
+    }
+}
+
+/**
+ * @brief Calculates accuracy of the model on the test dataset
+ * 
+ * This function compares the predicted labels to actual labels to measure
+ * the model's performance on the test dataset.
+ * 
+ * Accuracy Formula: (Number of Correct Predictions / Total Predictions)
+ * 
+ * @param root Pointer to the root of the decision tree.
+ * @param test_data Test dataset for evaluation.
+ * @return double Accuracy of the model.
+ */
+inline double calculate_accuracy(TreeNode* root, const vector<Example>& test_data) {
+    int correct = 0;
+    for (const auto& ex : test_data) {
+        if (predict(root, ex) == ex.user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / test_data.size();
+}
+
+/**
+ * @brief Accuracy of a tree on the examples `data[rows[i]]`
+ */
+inline double calculate_accuracy(TreeNode* root, const vector<Example>& data, const vector<size_t>& rows) {
+    int correct = 0;
+    for (size_t row : rows) {
+        if (predict(root, data[row]) == data[row].user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / rows.size();
+}
+
+/**
+ * @brief Predicts the label of row `row` of a Dataset (see predict above)
+ */
+inline string predict(const TreeNode* root, const Dataset& data, size_t row) {
+    while (!root->children.empty()) {
+        int c = data.feature_index(root->feature);
+        if (c < 0) return "unknown";
+        float value = data.value(row, c);
+        const string& key = root->numeric >= 0 ? (value <= root->threshold ? LEFT_BRANCH : RIGHT_BRANCH)
+                            : data.is_categorical(c) ? data.dictionary(c)[static_cast<size_t>(value)]
+                                                     : LEFT_BRANCH;
+        auto child = root->children.find(key);
+        if (child == root->children.end()) return "unknown";
+        root = child->second;
+    }
+    return root->label;
+}
+
+/**
+ * @brief Accuracy of a tree on the rows `rows` of a Dataset
+ */
+inline double calculate_accuracy(const TreeNode* root, const Dataset& data, const vector<size_t>& rows) {
+    int correct = 0;
+    for (size_t row : rows) {
+        if (predict(root, data, row) == data.label_names()[data.label(row)]) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / rows.size();
+}
+
+// Settings of a streaming Hoeffding tree
+struct HoeffdingOptions {
+    size_t grace_period = 200;   // Examples a leaf collects between split attempts
+    double delta = 1e-7;         // Chance that a split differs from the one infinite data would pick
+    double tie_threshold = 0.05; // Split on the best feature anyway once the bound falls below this
+    size_t max_depth = 0;        // Depth at which leaves stop splitting (0 = unlimited)
+};
+
+// Thresholds a Hoeffding leaf tries per numeric feature, evenly spaced between the observed min and max
+const size_t HOEFFDING_THRESHOLD_CANDIDATES = 10;
+
+/**
+ * @class HoeffdingTree
+ * @brief A decision tree that learns one example at a time (VFDT).
+ * 
+ * Every leaf keeps sufficient statistics instead of rows:
+ * - the count of each label,
+ * - for each categorical feature, the count of each (value, label) pair,
+ * - for each numeric feature, a running mean and variance per label (Welford)
+ *   plus the observed min and max.
+ * 
+ * learn() routes an example from the root to its leaf with branch_value and
+ * updates that leaf's statistics, so each example costs O(depth) and nothing is
+ * stored. Every `grace_period` examples the leaf scores each feature by
+ * information gain from its statistics (numeric features at
+ * HOEFFDING_THRESHOLD_CANDIDATES thresholds, with the class counts on each side
+ * estimated from a normal distribution per label) and splits on the best one
+ * when the Hoeffding bound
+ * 
+ *   epsilon = sqrt(R^2 ln(1/delta) / (2n)),  R = log2(number of labels)
+ * 
+ * says that, with probability 1 - delta, it is also the best on infinite data:
+ * best gain - second gain > epsilon (not splitting counts as a candidate with
+ * gain 0), or epsilon < tie_threshold when the two are too close to matter.
+ * 
+ * The nodes are ordinary TreeNodes in an arena, so root() works with predict
+ * and calculate_accuracy while the tree keeps learning. A leaf's label is the
+ * majority label it has seen; a new leaf starts with the label its parent
+ * expected on its side of the split and empty statistics. A categorical value
+ * first seen below an existing split gets a new leaf.
+ * 
+ * Example:
+ *   HoeffdingTree tree(NUMERIC_FEATURES);
+ *   for (const auto& flow : stream) tree.learn(flow);
+ *   string label = tree.predict(flow);
+ */
+class HoeffdingTree {
+public:
+    HoeffdingTree(const vector<string>& features, const HoeffdingOptions& options = HoeffdingOptions())
+        : features_(features), options_(options) {
+        for (const auto& feature : features_) numeric_.push_back(numeric_index(feature));
+        root_ = make_leaf("unknown", 0);
+    }
+
+    /**
+     * @brief Updates the tree with one labelled example
+     */
+    void learn(const Example& example) {
+        examples_seen_++;
+        const size_t label = label_id(example.user_action);
+
+        TreeNode* node = root_;
+        size_t depth = 0;
+        while (!node->children.empty()) {
+            const string& key = branch_value(node, example);
+            auto child = node->children.find(key);
+            if (child == node->children.end()) {
+                TreeNode* leaf = make_leaf(node->label, depth + 1);
+                node->children[key] = leaf;
+                node = leaf;
+                break;
+            }
+            node = child->second;
+            depth++;
+        }
+
+        LeafStatistics& stats = leaves_.at(node);
+        add_example(stats, example, label);
+        node->label = majority_label(stats.label_counts, node->label);
+        if (++stats.since_attempt >= options_.grace_period) {
+            stats.since_attempt = 0;
+            attempt_split(node, stats);
+        }
+    }
+
+    string predict(const Example& example) const { return pa4::predict(root_, example); }
+
+    TreeNode* root() const { return root_; }
+    size_t num_nodes() const { return arena_.num_nodes(); }
+    size_t num_leaves() const { return leaves_.size(); }
+    size_t examples_seen() const { return examples_seen_; }
+
+    /**
+     * @brief Length of the longest root-to-leaf path
+     */
+    size_t depth() const {
+        size_t deepest = 0;
+        for (const auto& leaf : leaves_) deepest = max(deepest, leaf.second.depth);
+        return deepest;
+    }
+
+private:
+    // Running mean and variance of one numeric feature among the examples of one label
+    struct GaussianEstimator {
+        double count = 0.0;
+        double mean = 0.0;
+        double m2 = 0.0; // Sum of squared deviations from the mean
+
+        void add(double x) {
+            count += 1.0;
+            double delta = x - mean;
+            mean += delta / count;
+            m2 += delta * (x - mean);
+        }
+
+        // Estimated share of the values that are <= threshold
+        double fraction_at_most(double threshold) const {
+            if (count == 0.0) return 0.0;
+            double stddev = count > 1.0 ? sqrt(m2 / (count - 1.0)) : 0.0;
+            if (stddev <= 0.0) return mean <= threshold ? 1.0 : 0.0;
+            return 0.5 * erfc((mean - threshold) / (stddev * sqrt(2.0)));
+        }
+    };
+
+    struct LeafStatistics {
+        size_t depth = 0;
+        size_t since_attempt = 0;
+        vector<double> label_counts;                     // By label id
+        vector<map<string, vector<double>>> categorical; // Per feature: value -> label counts
+        vector<vector<GaussianEstimator>> numeric;       // Per feature: one estimator per label id
+        vector<double> minimum, maximum;                 // Per feature, numeric features only
+    };
+
+    // Best split of one feature found by attempt_split
+    struct Candidate {
+        size_t feature = 0;
+        double gain = 0.0;
+        double threshold = 0.0;
+    };
+
+    vector<string> features_;
+    vector<int> numeric_; // numeric_index of each feature, -1 for categorical ones
+    HoeffdingOptions options_;
+    TreeArena arena_;
+    TreeNode* root_ = nullptr;
+    unordered_map<const TreeNode*, LeafStatistics> leaves_;
+    vector<string> labels_;
+    map<string, size_t> label_ids_;
+    size_t examples_seen_ = 0;
+
+    size_t label_id(const string& label) {
+        auto found = label_ids_.find(label);
+        if (found != label_ids_.end()) return found->second;
+        label_ids_[label] = labels_.size();
+        labels_.push_back(label);
+        return labels_.size() - 1;
+    }
+
+    TreeNode* make_leaf(const string& label, size_t depth) {
+        TreeNode* leaf = arena_.make_node();
+        leaf->label = label;
+        LeafStatistics& stats = leaves_[leaf];
+        stats.depth = depth;
+        stats.categorical.resize(features_.size());
+        stats.numeric.resize(features_.size());
+        stats.minimum.assign(features_.size(), numeric_limits<double>::infinity());
+        stats.maximum.assign(features_.size(), -numeric_limits<double>::infinity());
+        return leaf;
+    }
+
+    void add_example(LeafStatistics& stats, const Example& example, size_t label) {
+        const size_t num_labels = labels_.size();
+        if (stats.label_counts.size() < num_labels) stats.label_counts.resize(num_labels, 0.0);
+        stats.label_counts[label] += 1.0;
+        for (size_t f = 0; f < features_.size(); ++f) {
+            if (numeric_[f] < 0) {
+                vector<double>& counts = stats.categorical[f][feature_value(example, features_[f])];
+                if (counts.size() < num_labels) counts.resize(num_labels, 0.0);
+                counts[label] += 1.0;
+                continue;
+            }
+            double x = example.numeric[numeric_[f]];
+            if (stats.numeric[f].size() < num_labels) stats.numeric[f].resize(num_labels);
+            stats.numeric[f][label].add(x);
+            stats.minimum[f] = min(stats.minimum[f], x);
+            stats.maximum[f] = max(stats.maximum[f], x);
+        }
+    }
+
+    // Label counts on each side of `threshold`, estimated from the per-label normals
+    void estimate_sides(const LeafStatistics& stats, size_t f, double threshold, vector<double>& left,
+                        vector<double>& right) const {
+        const size_t num_labels = labels_.size();
+        left.assign(num_labels, 0.0);
+        right.assign(num_labels, 0.0);
+        for (size_t l = 0; l < stats.numeric[f].size(); ++l) {
+            const GaussianEstimator& estimator = stats.numeric[f][l];
+            left[l] = estimator.count * estimator.fraction_at_most(threshold);
+            right[l] = estimator.count - left[l];
+        }
+    }
+
+    Candidate score_feature(const LeafStatistics& stats, size_t f, double total, double base_entropy) const {
+        const size_t num_labels = labels_.size();
+        Candidate best;
+        best.feature = f;
+        if (numeric_[f] < 0) {
+            if (stats.categorical[f].size() < 2) return best;
+            double new_entropy = 0.0;
+            for (const auto& value : stats.categorical[f]) {
+                vector<double> counts = value.second;
+                counts.resize(num_labels, 0.0);
+                double count = 0.0;
+                for (double c : counts) count += c;
+                new_entropy += count / total * entropy_of_counts(counts.data(), num_labels, count);
+            }
+            best.gain = base_entropy - new_entropy;
+            return best;
+        }
+
+        const double low = stats.minimum[f], high = stats.maximum[f];
+        if (!(low < high)) return best;
+        vector<double> left, right;
+        for (size_t c = 1; c <= HOEFFDING_THRESHOLD_CANDIDATES; ++c) {
+            double threshold = low + (high - low) * c / (HOEFFDING_THRESHOLD_CANDIDATES + 1);
+            estimate_sides(stats, f, threshold, left, right);
+            double left_total = 0.0, right_total = 0.0;
+            for (size_t l = 0; l < num_labels; ++l) {
+                left_total += left[l];
+                right_total += right[l];
+            }
+            if (left_total <= 0.0 || right_total <= 0.0) continue;
+            double new_entropy = left_total / total * entropy_of_counts(left.data(), num_labels, left_total) +
+                                 right_total / total * entropy_of_counts(right.data(), num_labels, right_total);
+            if (base_entropy - new_entropy > best.gain) {
+                best.gain = base_entropy - new_entropy;
+                best.threshold = threshold;
+            }
+        }
+        return best;
+    }
+
+    string majority_label(const vector<double>& counts, const string& fallback) const {
+        size_t best = counts.size();
+        for (size_t l = 0; l < counts.size(); ++l) {
+            if (counts[l] > 0.0 && (best == counts.size() || counts[l] > counts[best])) best = l;
+        }
+        return best == counts.size() ? fallback : labels_[best];
+    }
+
+    /**
+     * @brief Splits a leaf if the Hoeffding bound separates its best feature from the rest
+     */
+    void attempt_split(TreeNode* leaf, LeafStatistics& stats) {
+        if (options_.max_depth > 0 && stats.depth >= options_.max_depth) return;
+        const size_t num_labels = labels_.size();
+        stats.label_counts.resize(num_labels, 0.0);
+        double total = 0.0;
+        size_t labels_present = 0;
+        for (double count : stats.label_counts) {
+            total += count;
+            if (count > 0.0) labels_present++;
+        }
+        if (labels_present < 2) return;
+
+        const double base_entropy = entropy_of_counts(stats.label_counts.data(), num_labels, total);
+        Candidate best, second; // `second` starts as not splitting at all, with gain 0
+        for (size_t f = 0; f < features_.size(); ++f) {
+            Candidate candidate = score_feature(stats, f, total, base_entropy);
+            if (candidate.gain > best.gain) {
+                second = best;
+                best = candidate;
+            } else if (candidate.gain > second.gain) {
+                second = candidate;
+            }
+        }
+        if (best.gain <= 0.0) return;
+
+        const double range = log2(static_cast<double>(num_labels));
+        const double epsilon = sqrt(range * range * log(1.0 / options_.delta) / (2.0 * total));
+        if (best.gain - second.gain <= epsilon && epsilon >= options_.tie_threshold) return;
+
+        // Turn the leaf into a split in place. Each child is labelled with the majority of the
+        // (estimated) label counts on its side, but gathers its own statistics from scratch
+        const size_t f = best.feature, depth = stats.depth;
+        const string fallback = leaf->label;
+        vector<pair<string, vector<double>>> children;
+        if (numeric_[f] >= 0) {
+            vector<double> left, right;
+            estimate_sides(stats, f, best.threshold, left, right);
+            children.emplace_back(LEFT_BRANCH, left);
+            children.emplace_back(RIGHT_BRANCH, right);
+        } else {
+            for (const auto& value : stats.categorical[f]) children.emplace_back(value.first, value.second);
+        }
+        leaves_.erase(leaf);
+
+        leaf->feature = features_[f];
+        leaf->numeric = numeric_[f];
+        leaf->threshold = best.threshold;
+        for (const auto& child : children) {
+            leaf->children[child.first] = make_leaf(majority_label(child.second, fallback), depth + 1);
+        }
+    }
+};
+
+// Kinds of FlatNode
+enum FlatNodeKind : uint16_t {
+    FLAT_LEAF = 0,
+    FLAT_CATEGORICAL = 1,
+    FLAT_NUMERIC = 2
+};
+
+/**
+ * @struct FlatNode
+ * @brief One node of a compiled tree, 16 bytes so four fit in a cache line.
+ *
+ * - `feature`: index into FlatTree::feature_names, or -1 for a leaf.
+ * - `kind`: FLAT_LEAF, FLAT_CATEGORICAL or FLAT_NUMERIC.
+ * - `child_base`: offset of this node's child table in FlatTree::child_index.
+ *   A categorical table has one entry per category code of the feature plus a
+ *   last entry for unseen values, so a child is found with one array read and no
+ *   string compares. A numeric table has two entries, LEFT_BRANCH then
+ *   RIGHT_BRANCH.
+ * - `label` (leaves): index into FlatTree::labels, or -1 for "unknown".
+ * - `threshold` (numeric nodes): index into FlatTree::thresholds[feature]; rows
+ *   whose value is <= that threshold go left.
+ * - `value`: raw node score (see TreeNode::value).
+ */
+struct FlatNode {
+    int16_t feature;
+    uint16_t kind;
+    uint32_t child_base;
+    union {
+        int32_t label;
+        uint32_t threshold;
+    };
+    float value;
+};
+
+/**
+ * @brief Returns a compiled leaf with the given label index
+ */
+inline FlatNode flat_leaf(int32_t label, float value) {
+    FlatNode node;
+    node.feature = -1;
+    node.kind = FLAT_LEAF;
+    node.child_base = 0;
+    node.label = label;
+    node.value = value;
+    return node;
+}
+
+/**
+ * @brief Encodes a numeric feature value as its rank among the feature's split thresholds
+ *
+ * The code is the number of thresholds below `value`, so value <= thresholds[j]
+ * exactly when code <= j: a FLAT_NUMERIC node compares two integers, and the
+ * outcome is the double comparison TreeNode makes, at any magnitude. NaN gets
+ * `count` and goes right everywhere, since NaN <= t is false.
+ *
+ * @param value The example's value of the feature.
+ * @param thresholds The feature's distinct thresholds in ascending order.
+ * @param count Number of thresholds.
+ */
+inline uint32_t encode_numeric(double value, const double* thresholds, size_t count) {
+    if (isnan(value)) return static_cast<uint32_t>(count);
+    return static_cast<uint32_t>(lower_bound(thresholds, thresholds + count, value) - thresholds);
+}
+
+/**
+ * @struct FlatTree
+ * @brief One or more decision trees compiled into contiguous arrays for fast inference.
+ *
+ * Numeric threshold splits compile to FLAT_NUMERIC nodes: `numeric[f]` is the
+ * NUMERIC_FEATURES index of feature f (-1 if categorical) and `thresholds[f]`
+ * holds the distinct thresholds its nodes split at, in ascending order. A node
+ * stores the index of its threshold, and encode_example stores the row's rank
+ * among those thresholds (see encode_numeric), so the compiled tree takes the
+ * same branch as the pointer tree without converting either value.
+ *
+ * Nodes of each tree are stored in breadth-first order starting at `roots[t]`, so
+ * the top levels that every row visits sit next to each other in memory. All trees
+ * share one shared "unknown" leaf (the last node) and one set of dictionaries.
+ * Categorical values are dictionary-encoded per feature: `categories[f][code]` is
+ * the value with that code, and `cardinality(f)` is the code used for unseen values.
+ *
+ * Example: a single tree whose root splits on "author" with children {"known",
+ * "unknown"} compiles to nodes[0] = {feature 0, child_base 0, ...} and
+ * child_index[0..2] = {node of "known", node of "unknown", unknown leaf}.
+ */
+struct FlatTree {
+    vector<string> feature_names;
+    vector<vector<string>> categories;
+    vector<int> numeric;
+    vector<vector<double>> thresholds;
+    vector<string> labels;
+    vector<FlatNode> nodes;
+    vector<uint32_t> child_index;
+    vector<uint32_t> roots;
+
+    uint32_t cardinality(size_t f) const { return static_cast<uint32_t>(categories[f].size()); }
+};
+
+/**
+ * @brief Compiles trained trees into the flat breadth-first layout
+ *
+ * Steps:
+ * 1. Walk all trees once to collect the categories each feature branches on, the
+ *    thresholds each numeric feature splits at and the set of leaf labels; build
+ *    the shared dictionaries from them.
+ * 2. Lay out each tree in breadth-first order with a queue, one tree after the
+ *    other. Each categorical node gets a dense child table of cardinality + 1
+ *    entries and each numeric node a table of two; missing branches and the
+ *    unseen slot point to the shared "unknown" leaf stored as the last node.
+ *
+ * @param trees Roots of the trained trees (entries may be nullptr).
+ * @param features Feature names, in the column order used by encode_example.
+ * @return FlatTree The compiled trees.
+ */
+inline FlatTree compile_trees(const vector<const TreeNode*>& trees, const vector<string>& features) {
+    FlatTree flat;
+    flat.feature_names = features;
+    flat.categories.resize(features.size());
+    flat.thresholds.resize(features.size());
+    for (const auto& feature : features) flat.numeric.push_back(numeric_index(feature));
+
+    map<string, int32_t> feature_ids;
+    for (size_t f = 0; f < features.size(); ++f) feature_ids[features[f]] = static_cast<int32_t>(f);
+
+    // Pass 1: dictionaries for categories and labels
+    vector<map<string, uint32_t>> category_codes(features.size());
+    map<string, int32_t> label_codes;
+    vector<const TreeNode*> stack;
+    for (const TreeNode* root : trees) {
+        if (root) stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        const TreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->children.empty()) {
+            label_codes[node->label] = 0;
+            continue;
+        }
+        int32_t f = feature_ids.at(node->feature);
+        if (node->numeric >= 0) flat.thresholds[f].push_back(node->threshold);
+        for (const auto& child : node->children) {
+            if (node->numeric < 0) category_codes[f][child.first] = 0;
+            if (child.second) stack.push_back(child.second);
+        }
+    }
+    for (size_t f = 0; f < features.size(); ++f) {
+        for (auto& entry : category_codes[f]) {
+            entry.second = static_cast<uint32_t>(flat.categories[f].size());
+            flat.categories[f].push_back(entry.first);
+        }
+        vector<double>& cuts = flat.thresholds[f];
+        sort(cuts.begin(), cuts.end());
+        cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+    }
+    for (auto& entry : label_codes) {
+        entry.second = static_cast<int32_t>(flat.labels.size());
+        flat.labels.push_back(entry.first);
+    }
+
+    // Pass 2: breadth-first order of every tree, one tree after the other
+    vector<const TreeNode*> order;
+    for (const TreeNode* root : trees) {
+        flat.roots.push_back(static_cast<uint32_t>(order.size()));
+        size_t head = order.size();
+        order.push_back(root);
+        for (; head < order.size(); ++head) {
+            if (!order[head]) continue;
+            for (const auto& child : order[head]->children) {
+                if (child.second) order.push_back(child.second);
+            }
+        }
+    }
+    const uint32_t unknown_leaf = static_cast<uint32_t>(order.size());
+
+    unordered_map<const TreeNode*, uint32_t> index_of;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i]) index_of[order[i]] = static_cast<uint32_t>(i);
+    }
+
+    for (const TreeNode* node : order) {
+        if (node == nullptr) {
+            flat.nodes.push_back(flat_leaf(-1, 0.0f)); // Empty tree: a single "unknown" leaf
+            continue;
+        }
+        if (node->children.empty()) {
+            flat.nodes.push_back(flat_leaf(label_codes.at(node->label), static_cast<float>(node->value)));
+            continue;
+        }
+
+        size_t f = static_cast<size_t>(feature_ids.at(node->feature));
+        FlatNode out;
+        out.feature = static_cast<int16_t>(f);
+        out.child_base = static_cast<uint32_t>(flat.child_index.size());
+        out.value = static_cast<float>(node->value);
+        if (node->numeric >= 0) {
+            out.kind = FLAT_NUMERIC;
+            const vector<double>& cuts = flat.thresholds[f];
+            out.threshold = static_cast<uint32_t>(lower_bound(cuts.begin(), cuts.end(), node->threshold) - cuts.begin());
+            flat.child_index.resize(flat.child_index.size() + 2, unknown_leaf);
+            for (const auto& child : node->children) {
+                if (!child.second) continue;
+                flat.child_index[out.child_base + (child.first == LEFT_BRANCH ? 0 : 1)] = index_of.at(child.second);
+            }
+        } else {
+            out.kind = FLAT_CATEGORICAL;
+            out.label = -1;
+            flat.child_index.resize(flat.child_index.size() + flat.cardinality(f) + 1, unknown_leaf);
+            for (const auto& child : node->children) {
+                if (!child.second) continue;
+                flat.child_index[out.child_base + category_codes[f].at(child.first)] = index_of.at(child.second);
+            }
+        }
+        flat.nodes.push_back(out);
+    }
+    flat.nodes.push_back(flat_leaf(-1, 0.0f));
+    return flat;
+}
+
+/**
+ * @brief Compiles the trees of a forest into one flat model with shared dictionaries
+ */
+inline FlatTree compile_forest(const vector<TreeNode*>& trees, const vector<string>& features) {
+    return compile_trees(vector<const TreeNode*>(trees.begin(), trees.end()), features);
+}
+
+/**
+ * @brief Compiles a single trained tree into the flat breadth-first layout
+ */
+inline FlatTree compile_tree(const TreeNode* root, const vector<string>& features) {
+    return compile_trees({root}, features);
+}
+
+/**
+ * @struct FlatModelView
+ * @brief Read-only pointers to compiled trees, wherever their arrays live.
+ *
+ * Both an in-memory FlatTree and a memory-mapped model file (MappedModel) expose
+ * this view, so the same inference kernel serves both.
+ */
+struct FlatModelView {
+    size_t num_features;
+    size_t num_labels;
+    size_t num_trees;
+    const FlatNode* nodes;
+    const uint32_t* child_index;
+    const uint32_t* roots;
+};
+
+/**
+ * @brief Returns the inference view of an in-memory compiled model
+ */
+inline FlatModelView model_view(const FlatTree& tree) {
+    return FlatModelView{tree.feature_names.size(), tree.labels.size(), tree.roots.size(),
+                         tree.nodes.data(), tree.child_index.data(), tree.roots.data()};
+}
+
+/**
+ * @brief Encodes an example's feature values into the codes of a compiled tree
+ *
+ * @param tree The compiled tree whose dictionaries are used.
+ * @param example Example to encode.
+ * @param out Receives one code per feature; unseen values get cardinality(f), and
+ *            numeric features their threshold rank (see encode_numeric).
+ */
+inline void encode_example(const FlatTree& tree, const Example& example, uint32_t* out) {
+    for (size_t f = 0; f < tree.feature_names.size(); ++f) {
+        if (tree.numeric[f] >= 0) {
+            const vector<double>& cuts = tree.thresholds[f];
+            out[f] = encode_numeric(example.numeric[tree.numeric[f]], cuts.data(), cuts.size());
+            continue;
+        }
+        const vector<string>& values = tree.categories[f];
+        const string& value = feature_value(example, tree.feature_names[f]);
+        auto it = lower_bound(values.begin(), values.end(), value);
+        out[f] = (it != values.end() && *it == value) ? static_cast<uint32_t>(it - values.begin())
+                                                      : tree.cardinality(f);
+    }
+}
+
+// Rows evaluated together by predict_many
+const size_t PREDICT_BLOCK_ROWS = 64;
+
+/**
+ * @brief Evaluates many encoded rows against one compiled tree
+ *
+ * Rows are processed in blocks of PREDICT_BLOCK_ROWS. Within a block, all rows
+ * take one step down the tree per sweep instead of one row going all the way
+ * down at a time. The loads of different rows are independent, so the CPU can
+ * overlap their cache misses, and the upper levels stay hot for the whole block.
+ *
+ * @param model The compiled trees.
+ * @param tree Which tree to evaluate.
+ * @param codes Row-major matrix of num_rows x num_features codes.
+ * @param num_rows Number of rows.
+ * @param labels Receives a label index per row (-1 for "unknown").
+ */
+inline void predict_tree_many(const FlatModelView& model, size_t tree, const uint32_t* codes, size_t num_rows,
+                              int32_t* labels) {
+    const size_t num_features = model.num_features;
+    const FlatNode* nodes = model.nodes;
+    const uint32_t* child_index = model.child_index;
+    const uint32_t root = model.roots[tree];
+
+    uint32_t cursor[PREDICT_BLOCK_ROWS];
+    for (size_t start = 0; start < num_rows; start += PREDICT_BLOCK_ROWS) {
+        size_t count = min(PREDICT_BLOCK_ROWS, num_rows - start);
+        const uint32_t* block = codes + start * num_features;
+        for (size_t r = 0; r < count; ++r) cursor[r] = root;
+
+        bool active = true;
+        while (active) {
+            active = false;
+            for (size_t r = 0; r < count; ++r) {
+                const FlatNode& node = nodes[cursor[r]];
+                if (node.kind == FLAT_LEAF) continue;
+                uint32_t code = block[r * num_features + node.feature];
+                if (node.kind == FLAT_NUMERIC) code = code <= node.threshold ? 0 : 1;
+                cursor[r] = child_index[node.child_base + code];
+                active = true;
+            }
+        }
+        for (size_t r = 0; r < count; ++r) labels[start + r] = nodes[cursor[r]].label;
+    }
+}
+
+/**
+ * @brief Evaluates many encoded rows, taking a majority vote if there are several trees
+ *
+ * With a single tree this is predict_tree_many. With a forest, every tree labels
+ * the same chunk of rows and the votes are tallied per row; "unknown" does not
+ * vote and ties go to the lowest label index (the alphabetically first label),
+ * matching predict(const RandomForest&, ...).
+ *
+ * @param model The compiled trees.
+ * @param codes Row-major matrix of num_rows x num_features codes.
+ * @param num_rows Number of rows.
+ * @param labels Receives a label index per row (-1 for "unknown").
+ */
+inline void predict_many(const FlatModelView& model, const uint32_t* codes, size_t num_rows, int32_t* labels) {
+    if (model.num_trees == 1) {
+        predict_tree_many(model, 0, codes, num_rows, labels);
+        return;
+    }
+
+    const size_t chunk_rows = 16 * PREDICT_BLOCK_ROWS;
+    vector<int32_t> tree_labels(chunk_rows);
+    vector<uint32_t> votes(chunk_rows * model.num_labels);
+    for (size_t start = 0; start < num_rows; start += chunk_rows) {
+        size_t count = min(chunk_rows, num_rows - start);
+        fill(votes.begin(), votes.end(), 0);
+        for (size_t t = 0; t < model.num_trees; ++t) {
+            predict_tree_many(model, t, codes + start * model.num_features, count, tree_labels.data());
+            for (size_t r = 0; r < count; ++r) {
+                if (tree_labels[r] >= 0) votes[r * model.num_labels + tree_labels[r]]++;
+            }
+        }
+        for (size_t r = 0; r < count; ++r) {
+            int32_t best = -1;
+            uint32_t best_votes = 0;
+            for (size_t l = 0; l < model.num_labels; ++l) {
+                if (votes[r * model.num_labels + l] > best_votes) {
+                    best_votes = votes[r * model.num_labels + l];
+                    best = static_cast<int32_t>(l);
+                }
+            }
+            labels[start + r] = best;
+        }
+    }
+}
+
+/**
+ * @brief Evaluates many encoded rows against an in-memory compiled model
+ */
+inline void predict_many(const FlatTree& tree, const uint32_t* codes, size_t num_rows, int32_t* labels) {
+    predict_many(model_view(tree), codes, num_rows, labels);
+}
+
+/**
+ * @brief Predicts the user action for one example with a compiled tree
+ */
+inline string predict(const FlatTree& tree, const Example& example) {
+    vector<uint32_t> codes(tree.feature_names.size());
+    encode_example(tree, example, codes.data());
+    int32_t label;
+    predict_many(tree, codes.data(), 1, &label);
+    return label < 0 ? "unknown" : tree.labels[label];
+}
+
+/**
+ * @brief Calculates accuracy of a compiled tree, scoring the test set in one batch
+ */
+inline double calculate_accuracy(const FlatTree& tree, const vector<Example>& test_data) {
+    size_t num_features = tree.feature_names.size();
+    vector<uint32_t> codes(test_data.size() * num_features);
+    for (size_t i = 0; i < test_data.size(); ++i) {
+        encode_example(tree, test_data[i], codes.data() + i * num_features);
+    }
+    vector<int32_t> labels(test_data.size());
+    predict_many(tree, codes.data(), test_data.size(), labels.data());
+
+    int correct = 0;
+    for (size_t i = 0; i < test_data.size(); ++i) {
+        if (labels[i] >= 0 && tree.labels[labels[i]] == test_data[i].user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / test_data.size();
+}
+
+/**
+ * @brief Binary model file format (version 3)
+ *
+ * A model file is a compiled FlatTree written so that it can be used straight
+ * from a read-only memory mapping, with no parsing or copying at load time:
+ *
+ *   ModelFileHeader                      magic "PA4MODEL", version, counts, section offsets
+ *   uint32_t roots[num_trees]            first node of every tree
+ *   FlatNode nodes[num_nodes]            all trees, breadth-first, unknown leaf last
+ *   uint32_t child_index[...]            dense child tables
+ *   uint32_t category_counts[num_features]   0 for numeric features
+ *   uint32_t threshold_counts[num_features]  0 for categorical features
+ *   double thresholds[num_thresholds]    each numeric feature's FlatTree::thresholds, in feature order
+ *   StringRef strings[...]               feature names, then each feature's categories, then labels
+ *   char string_data[...]                the bytes the StringRefs point into
+ *
+ * Every section starts at a multiple of MODEL_SECTION_ALIGN from the start of the
+ * file, and integers are stored in host byte order. Because the mapping is shared
+ * and read-only, processes that map the same file (for example, a 1,000-tree
+ * forest served by many workers) share its physical pages through the page cache.
+ *
+ * Version 2 added FLAT_NUMERIC nodes (FlatNode::kind). Version 3 made their
+ * thresholds indices into the thresholds section instead of floats; older files
+ * are rejected.
+ */
+const char MODEL_MAGIC[8] = {'P', 'A', '4', 'M', 'O', 'D', 'E', 'L'};
+const uint32_t MODEL_VERSION = 3;
+const uint64_t MODEL_SECTION_ALIGN = 64;
+
+struct ModelFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_features;
+    uint32_t num_labels;
+    uint32_t num_trees;
+    uint64_t num_nodes;
+    uint64_t num_child_index;
+    uint64_t num_thresholds;
+    uint64_t num_strings;
+    uint64_t string_bytes;
+    uint64_t roots_offset;
+    uint64_t nodes_offset;
+    uint64_t child_index_offset;
+    uint64_t category_counts_offset;
+    uint64_t threshold_counts_offset;
+    uint64_t thresholds_offset;
+    uint64_t strings_offset;
+    uint64_t string_data_offset;
+    uint64_t file_size;
+};
+
+// Location of one string inside the string_data section
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+static_assert(sizeof(FlatNode) == 16, "FlatNode is stored verbatim in model files");
+
+/**
+ * @brief Rounds a file offset up to the next section boundary
+ */
+inline uint64_t align_section(uint64_t offset) {
+    return (offset + MODEL_SECTION_ALIGN - 1) / MODEL_SECTION_ALIGN * MODEL_SECTION_ALIGN;
+}
+
+/**
+ * @brief Writes a compiled model to a binary model file
+ *
+ * @param tree The compiled model (single tree or forest).
+ * @param filename Path of the file to create or overwrite.
+ * @return bool true if the whole file was written.
+ */
+inline bool save_model(const FlatTree& tree, const string& filename) {
+    vector<const string*> strings;
+    for (const auto& name : tree.feature_names) strings.push_back(&name);
+    for (const auto& values : tree.categories) {
+        for (const auto& value : values) strings.push_back(&value);
+    }
+    for (const auto& label : tree.labels) strings.push_back(&label);
+
+    vector<StringRef> refs;
+    string string_data;
+    for (const string* s : strings) {
+        refs.push_back(StringRef{static_cast<uint32_t>(string_data.size()), static_cast<uint32_t>(s->size())});
+        string_data += *s;
+    }
+    vector<uint32_t> category_counts, threshold_counts;
+    for (size_t f = 0; f < tree.categories.size(); ++f) category_counts.push_back(tree.cardinality(f));
+    vector<double> thresholds;
+    for (const auto& cuts : tree.thresholds) {
+        threshold_counts.push_back(static_cast<uint32_t>(cuts.size()));
+        thresholds.insert(thresholds.end(), cuts.begin(), cuts.end());
+    }
+
+    ModelFileHeader header = {};
+    memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    header.version = MODEL_VERSION;
+    header.num_features = static_cast<uint32_t>(tree.feature_names.size());
+    header.num_labels = static_cast<uint32_t>(tree.labels.size());
+    header.num_trees = static_cast<uint32_t>(tree.roots.size());
+    header.num_nodes = tree.nodes.size();
+    header.num_child_index = tree.child_index.size();
+    header.num_thresholds = thresholds.size();
+    header.num_strings = refs.size();
+    header.string_bytes = string_data.size();
+    header.roots_offset = align_section(sizeof(ModelFileHeader));
+    header.nodes_offset = align_section(header.roots_offset + tree.roots.size() * sizeof(uint32_t));
+    header.child_index_offset = align_section(header.nodes_offset + tree.nodes.size() * sizeof(FlatNode));
+    header.category_counts_offset = align_section(header.child_index_offset + tree.child_index.size() * sizeof(uint32_t));
+    header.threshold_counts_offset =
+        align_section(header.category_counts_offset + category_counts.size() * sizeof(uint32_t));
+    header.thresholds_offset = align_section(header.threshold_counts_offset + threshold_counts.size() * sizeof(uint32_t));
+    header.strings_offset = align_section(header.thresholds_offset + thresholds.size() * sizeof(double));
+    header.string_data_offset = align_section(header.strings_offset + refs.size() * sizeof(StringRef));
+    header.file_size = header.string_data_offset + string_data.size();
+
+    vector<char> buffer(header.file_size, 0);
+    auto put = [&buffer](uint64_t offset, const void* src, size_t bytes) {
+        if (bytes) memcpy(buffer.data() + offset, src, bytes);
+    };
+    put(0, &header, sizeof(header));
+    put(header.roots_offset, tree.roots.data(), tree.roots.size() * sizeof(uint32_t));
+    put(header.nodes_offset, tree.nodes.data(), tree.nodes.size() * sizeof(FlatNode));
+    put(header.child_index_offset, tree.child_index.data(), tree.child_index.size() * sizeof(uint32_t));
+    put(header.category_counts_offset, category_counts.data(), category_counts.size() * sizeof(uint32_t));
+    put(header.threshold_counts_offset, threshold_counts.data(), threshold_counts.size() * sizeof(uint32_t));
+    put(header.thresholds_offset, thresholds.data(), thresholds.size() * sizeof(double));
+    put(header.strings_offset, refs.data(), refs.size() * sizeof(StringRef));
+    put(header.string_data_offset, string_data.data(), string_data.size());
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @class MappedModel
+ * @brief A model file mapped read-only into memory and used in place.
+ *
+ * open() maps the file, checks the header and that every section lies inside the
+ * file, and then points straight into the mapping; nothing is copied, so loading
+ * takes microseconds regardless of model size and pages are read on first use.
+ * Every node is checked once at open() (see validate), so a truncated or corrupt
+ * file is rejected instead of sending predict_many outside the mapping.
+ */
+class MappedModel {
+public:
+    MappedModel() = default;
+    ~MappedModel() { close(); }
+    MappedModel(const MappedModel&) = delete;
+    MappedModel& operator=(const MappedModel&) = delete;
+
+    /**
+     * @brief Maps and validates a model file
+     *
+     * @param filename Path of a file written by save_model.
+     * @return bool true on success; on failure an error is printed and the model is empty.
+     */
+    bool open(const string& filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "Cannot open model file " << filename << endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ModelFileHeader)) {
+            cerr << "Model file " << filename << " is too small" << endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        base_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base_ == MAP_FAILED) {
+            base_ = nullptr;
+            cerr << "Cannot map model file " << filename << endl;
+            return false;
+        }
+        if (!validate()) {
+            cerr << "Model file " << filename << " is corrupt or has an unsupported version" << endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Unmaps the file
+     */
+    void close() {
+        if (base_) munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+        header_ = nullptr;
+    }
+
+    const ModelFileHeader& header() const { return *header_; }
+
+    /**
+     * @brief Returns the inference view pointing into the mapping
+     */
+    FlatModelView view() const {
+        return FlatModelView{header_->num_features, header_->num_labels, header_->num_trees,
+                             at<FlatNode>(header_->nodes_offset), at<uint32_t>(header_->child_index_offset),
+                             at<uint32_t>(header_->roots_offset)};
+    }
+
+    uint32_t cardinality(size_t f) const { return at<uint32_t>(header_->category_counts_offset)[f]; }
+
+    // Split thresholds of numeric feature f, ascending (see FlatTree::thresholds)
+    uint32_t threshold_count(size_t f) const { return at<uint32_t>(header_->threshold_counts_offset)[f]; }
+    const double* thresholds(size_t f) const { return at<double>(header_->thresholds_offset) + threshold_start_[f]; }
+
+    string_view feature_name(size_t f) const { return string_at(f); }
+
+    string_view category(size_t f, uint32_t code) const {
+        return string_at(header_->num_features + category_start_[f] + code);
+    }
+
+    string_view label(int32_t l) const {
+        return l < 0 ? string_view("unknown") : string_at(header_->num_features + category_start_.back() + l);
+    }
+
+    // NUMERIC_FEATURES index of feature f, or -1 if it is categorical
+    int numeric(size_t f) const { return numeric_[f]; }
+
+private:
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    const ModelFileHeader* header_ = nullptr;
+    vector<uint64_t> category_start_;  // Prefix sums of category_counts
+    vector<uint64_t> threshold_start_; // Prefix sums of threshold_counts
+    vector<int> numeric_;
+
+    template <typename T>
+    const T* at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(base_) + offset);
+    }
+
+    string_view string_at(size_t i) const {
+        const StringRef& ref = at<StringRef>(header_->strings_offset)[i];
+        return string_view(at<char>(header_->string_data_offset) + ref.offset, ref.length);
+    }
+
+    bool section_fits(uint64_t offset, uint64_t count, uint64_t item_size) const {
+        return offset % MODEL_SECTION_ALIGN == 0 && offset <= size_ && count <= (size_ - offset) / item_size;
+    }
+
+    bool validate() {
+        header_ = at<ModelFileHeader>(0);
+        const ModelFileHeader& h = *header_;
+        if (memcmp(h.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0 || h.version != MODEL_VERSION) return false;
+        if (h.file_size != size_ || h.num_trees == 0 || h.num_nodes == 0) return false;
+        if (!section_fits(h.roots_offset, h.num_trees, sizeof(uint32_t)) ||
+            !section_fits(h.nodes_offset, h.num_nodes, sizeof(FlatNode)) ||
+            !section_fits(h.child_index_offset, h.num_child_index, sizeof(uint32_t)) ||
+            !section_fits(h.category_counts_offset, h.num_features, sizeof(uint32_t)) ||
+            !section_fits(h.threshold_counts_offset, h.num_features, sizeof(uint32_t)) ||
+            !section_fits(h.thresholds_offset, h.num_thresholds, sizeof(double)) ||
+            !section_fits(h.strings_offset, h.num_strings, sizeof(StringRef)) ||
+            !section_fits(h.string_data_offset, h.string_bytes, 1)) {
+            return false;
+        }
+
+        category_start_.assign(1, 0);
+        for (size_t f = 0; f < h.num_features; ++f) category_start_.push_back(category_start_.back() + cardinality(f));
+        if (h.num_features + category_start_.back() + h.num_labels != h.num_strings) return false;
+        if (h.num_features > static_cast<uint32_t>(numeric_limits<int16_t>::max())) return false;
+
+        const StringRef* refs = at<StringRef>(h.strings_offset);
+        for (size_t i = 0; i < h.num_strings; ++i) {
+            if (static_cast<uint64_t>(refs[i].offset) + refs[i].length > h.string_bytes) return false;
+        }
+        const uint32_t* roots = at<uint32_t>(h.roots_offset);
+        for (size_t t = 0; t < h.num_trees; ++t) {
+            if (roots[t] >= h.num_nodes) return false;
+        }
+
+        // Every feature must be one encode_example can read: a NUMERIC_FEATURES column or a feature_value name
+        numeric_.clear();
+        const Example probe;
+        for (size_t f = 0; f < h.num_features; ++f) {
+            const string name(feature_name(f));
+            numeric_.push_back(numeric_index(name));
+            if (numeric_.back() >= 0) continue;
+            try {
+                feature_value(probe, name);
+            } catch (const invalid_argument&) {
+                return false;
+            }
+        }
+
+        // Thresholds must be ascending for encode_numeric's binary search
+        threshold_start_.assign(1, 0);
+        for (size_t f = 0; f < h.num_features; ++f) {
+            if (numeric_[f] < 0 && threshold_count(f) != 0) return false;
+            threshold_start_.push_back(threshold_start_.back() + threshold_count(f));
+        }
+        if (threshold_start_.back() != h.num_thresholds) return false;
+        for (size_t f = 0; f < h.num_features; ++f) {
+            const double* cuts = thresholds(f);
+            for (uint32_t j = 0; j < threshold_count(f); ++j) {
+                if (isnan(cuts[j]) || (j > 0 && !(cuts[j - 1] < cuts[j]))) return false;
+            }
+        }
+        return validate_nodes();
+    }
+
+    /**
+     * @brief Checks every node against the header, as compile_trees lays them out
+     *
+     * Leaves need a label in [-1, num_labels). Split nodes need a feature of the
+     * matching kind, numeric ones a threshold index below the feature's threshold
+     * count, and all of them a child table inside child_index whose entries come later
+     * in the node array (nodes are breadth-first), so every walk stays in bounds
+     * and ends at a leaf.
+     */
+    bool validate_nodes() const {
+        const ModelFileHeader& h = *header_;
+        const FlatNode* nodes = at<FlatNode>(h.nodes_offset);
+        const uint32_t* child_index = at<uint32_t>(h.child_index_offset);
+        for (size_t i = 0; i < h.num_nodes; ++i) {
+            const FlatNode& node = nodes[i];
+            if (node.kind == FLAT_LEAF) {
+                if (node.label < -1 || node.label >= static_cast<int64_t>(h.num_labels)) return false;
+                continue;
+            }
+            if (node.kind != FLAT_CATEGORICAL && node.kind != FLAT_NUMERIC) return false;
+            if (node.feature < 0 || static_cast<uint32_t>(node.feature) >= h.num_features) return false;
+            const bool numeric = numeric_[node.feature] >= 0;
+            if (numeric != (node.kind == FLAT_NUMERIC)) return false;
+            if (numeric && node.threshold >= threshold_count(node.feature)) return false;
+
+            const uint64_t arity = numeric ? 2 : uint64_t(cardinality(node.feature)) + 1;
+            if (node.child_base > h.num_child_index || arity > h.num_child_index - node.child_base) return false;
+            for (uint64_t c = 0; c < arity; ++c) {
+                const uint32_t child = child_index[node.child_base + c];
+                if (child <= i || child >= h.num_nodes) return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Encodes an example's feature values with the dictionaries of a mapped model
+ */
+inline void encode_example(const MappedModel& model, const Example& example, uint32_t* out) {
+    for (size_t f = 0; f < model.header().num_features; ++f) {
+        if (model.numeric(f) >= 0) {
+            out[f] = encode_numeric(example.numeric[model.numeric(f)], model.thresholds(f), model.threshold_count(f));
+            continue;
+        }
+        const string& value = feature_value(example, string(model.feature_name(f)));
+        uint32_t low = 0, high = model.cardinality(f);
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if (model.category(f, mid) < value) low = mid + 1;
+            else high = mid;
+        }
+        out[f] = (low < model.cardinality(f) && model.category(f, low) == value) ? low : model.cardinality(f);
+    }
+}
+
+/**
+ * @brief Calculates accuracy of a mapped model, scoring the test set in one batch
+ */
+inline double calculate_accuracy(const MappedModel& model, const vector<Example>& test_data) {
+    size_t num_features = model.header().num_features;
+    vector<uint32_t> codes(test_data.size() * num_features);
+    for (size_t i = 0; i < test_data.size(); ++i) {
+        encode_example(model, test_data[i], codes.data() + i * num_features);
+    }
+    vector<int32_t> labels(test_data.size());
+    predict_many(model.view(), codes.data(), test_data.size(), labels.data());
+
+    int correct = 0;
+    for (size_t i = 0; i < test_data.size(); ++i) {
+        if (labels[i] >= 0 && model.label(labels[i]) == test_data[i].user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / test_data.size();
+}
+
+// Settings for bagged random forests
+struct ForestOptions {
+    size_t num_trees = 25;    // Number of trees in the forest
+    size_t max_features = 2;  // Features sampled at every node (0 = all)
+    unsigned seed = 42;       // Base seed; tree t uses seed + t
+};
+
+// A bagged ensemble of ID3 trees that predicts by majority vote
+struct RandomForest {
+    unique_ptr<TreeArena> arena = make_unique<TreeArena>(); // Owns the nodes of every tree
+    vector<TreeNode*> trees;
+};
+
+/**
+ * @brief Draws a bootstrap sample of row indices
+ * 
+ * Samples as many indices as `rows` holds, with replacement, from `rows`. Only the
+ * indices are stored; the examples themselves are never copied. The sample is
+ * sorted so that the tree builder walks the dataset in memory order.
+ * 
+ * @param rows Rows of the training set (all_rows for the whole dataset).
+ * @param rng Random generator of the tree being trained.
+ * @return vector<size_t> Bootstrap row indices.
+ */
+inline vector<size_t> bootstrap_rows(const vector<size_t>& rows, mt19937& rng) {
+    const size_t n = rows.size();
+    uniform_int_distribution<size_t> pick(0, n - 1);
+    vector<size_t> sample(n);
+    for (size_t i = 0; i < n; ++i) sample[i] = rows[pick(rng)];
+    sort(sample.begin(), sample.end());
+    return sample;
+}
+
+/**
+ * @brief Trains a random forest on the task scheduler
+ * 
+ * Each tree is an independent task that:
+ * 1. Draws a bootstrap sample of row indices (see bootstrap_rows).
+ * 2. Grows a tree with build_tree, sampling `max_features` candidate features
+ *    at every node.
+ * 
+ * Every tree seeds its own generator with `seed + t`, so the forest is the same
+ * no matter how many threads train it or in which order the tasks run.
+ * 
+ * @param data The dataset.
+ * @param rows Indices of the training examples in `data`.
+ * @param features List of features to consider for splits.
+ * @param options Forest size, feature sampling and seed.
+ * @param scheduler Scheduler that trains the trees.
+ * @return RandomForest The trained forest.
+ */
+inline RandomForest train_random_forest(const vector<Example>& data, const vector<size_t>& rows,
+                                        const vector<string>& features, const ForestOptions& options,
+                                        TaskScheduler& scheduler) {
+    RandomForest forest;
+    forest.trees.assign(options.num_trees, nullptr);
+    if (rows.empty()) return forest;
+
+    // Bootstrap samples index the original rows, so one binning serves every tree
+    NumericColumns columns = build_numeric_columns(data, features);
+    scheduler.parallel_for(0, options.num_trees, [&](size_t t) {
+        mt19937 rng(options.seed + static_cast<unsigned>(t));
+        vector<size_t> sample = bootstrap_rows(rows, rng);
+        forest.trees[t] = build_tree(data, sample, features, options.max_features, &rng, columns, *forest.arena);
+    });
+    return forest;
+}
+
+/**
+ * @brief Trains a random forest on the whole dataset
+ */
+inline RandomForest train_random_forest(const vector<Example>& data, const vector<string>& features,
+                                        const ForestOptions& options, TaskScheduler& scheduler) {
+    return train_random_forest(data, all_rows(data), features, options, scheduler);
+}
+
+/**
+ * @brief Predicts by majority vote over the trees of a forest
+ * 
+ * Trees that cannot classify the example ("unknown") do not vote. Ties go to
+ * the alphabetically first label.
+ * 
+ * @param forest The trained forest.
+ * @param example New example to classify.
+ * @return string Predicted user action, or "unknown" if no tree voted.
+ */
+inline string predict(const RandomForest& forest, const Example& example) {
+    map<string, int> votes;
+    for (TreeNode* tree : forest.trees) {
+        string vote = predict(tree, example);
+        if (vote != "unknown") votes[vote]++;
+    }
+    string best = "unknown";
+    int best_votes = 0;
+    for (const auto& pair : votes) {
+        if (pair.second > best_votes) {
+            best = pair.first;
+            best_votes = pair.second;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Calculates accuracy of a random forest on the test dataset
+ */
+inline double calculate_accuracy(const RandomForest& forest, const vector<Example>& test_data) {
+    int correct = 0;
+    for (const auto& ex : test_data) {
+        if (predict(forest, ex) == ex.user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / test_data.size();
+}
+
+/**
+ * @brief Accuracy of a forest on the examples `data[rows[i]]`
+ */
+inline double calculate_accuracy(const RandomForest& forest, const vector<Example>& data, const vector<size_t>& rows) {
+    int correct = 0;
+    for (size_t row : rows) {
+        if (predict(forest, data[row]) == data[row].user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / rows.size();
+}
+
+/**
+ * @struct BinnedFeatures
+ * @brief Column-wise bin codes of the features, used by boosting.
+ * 
+ * `codes[f][row]` is the bin of feature f for a row.
+ * 
+ * Categorical features: every distinct value becomes one bin and
+ * `bin_values[f][bin]` is the value it stands for. Bins are numbered in sorted
+ * value order, the same order `TreeNode::children` uses. For example, "length"
+ * with values {"long", "short"} gets bins 0 and 1.
+ * 
+ * Numeric features (`numeric[f] >= 0`, the index into NUMERIC_FEATURES): the
+ * quantile bins of build_numeric_columns, so bin b holds the values in
+ * (edges[f][b - 1], edges[f][b]].
+ */
+struct BinnedFeatures {
+    vector<string> names;
+    vector<int> numeric;
+    vector<vector<string>> bin_values;
+    vector<vector<double>> edges;
+    vector<vector<uint16_t>> codes;
+
+    size_t num_bins(size_t f) const {
+        return numeric[f] >= 0 ? edges[f].size() + 1 : bin_values[f].size();
+    }
+};
+
+/**
+ * @brief Encodes each feature column into bin codes in one pass per feature
+ * 
+ * @param data The training dataset.
+ * @param features Features to encode, categorical or NUMERIC_FEATURES.
+ * @return BinnedFeatures The encoded columns.
+ */
+inline BinnedFeatures bin_features(const vector<Example>& data, const vector<string>& features) {
+    BinnedFeatures binned;
+    binned.names = features;
+    NumericColumns columns = build_numeric_columns(data, features);
+    for (const auto& feature : features) {
+        int numeric = numeric_index(feature);
+        binned.numeric.push_back(numeric);
+        if (numeric >= 0) {
+            const vector<uint8_t>& column = columns.codes[numeric];
+            binned.bin_values.emplace_back();
+            binned.edges.push_back(columns.edges[numeric]);
+            binned.codes.emplace_back(column.begin(), column.end());
+            continue;
+        }
+
+        map<string, uint16_t> dictionary;
+        for (const auto& ex : data) dictionary[feature_value(ex, feature)] = 0;
+
+        vector<string> values;
+        for (auto& entry : dictionary) {
+            entry.second = static_cast<uint16_t>(values.size());
+            values.push_back(entry.first);
+        }
+
+        vector<uint16_t> column(data.size());
+        for (size_t row = 0; row < data.size(); ++row) {
+            column[row] = dictionary[feature_value(data[row], feature)];
+        }
+        binned.bin_values.push_back(move(values));
+        binned.edges.emplace_back();
+        binned.codes.push_back(move(column));
+    }
+    return binned;
+}
+
+// Settings for histogram gradient boosting
+struct BoostingOptions {
+    int num_rounds = 50;          // Number of trees
+    double learning_rate = 0.3;   // Shrinkage applied to every leaf value
+    int max_depth = 3;            // Depth limit of each tree
+    double l2 = 1.0;              // L2 regularisation of leaf values
+    size_t min_rows = 2;          // Nodes with fewer rows become leaves
+    string positive_label = "reads";
+};
+
+// Binary gradient-boosted trees on the log-odds of `positive_label`
+struct GradientBoostedTrees {
+    string positive_label;
+    string negative_label;
+    double base_score = 0.0;
+    unique_ptr<TreeArena> arena = make_unique<TreeArena>(); // Owns the nodes of every tree
+    vector<TreeNode*> trees;
+};
+
+// Sum of gradients, hessians and rows that fell into one histogram bin
+struct GradientBin {
+    double grad = 0.0;
+    double hess = 0.0;
+    size_t count = 0;
+};
+
+/**
+ * @brief Builds the gradient histogram of one feature over a node's rows
+ */
+inline vector<GradientBin> build_histogram(const BinnedFeatures& binned, size_t f, const vector<size_t>& rows,
+                                           const vector<double>& grad, const vector<double>& hess) {
+    vector<GradientBin> histogram(binned.num_bins(f));
+    const vector<uint16_t>& column = binned.codes[f];
+    for (size_t row : rows) {
+        GradientBin& bin = histogram[column[row]];
+        bin.grad += grad[row];
+        bin.hess += hess[row];
+        bin.count++;
+    }
+    return histogram;
+}
+
+/**
+ * @brief Grows one regression tree of the boosted ensemble from gradient histograms
+ * 
+ * Mirrors build_tree: the same TreeNode layout, one child per category of a
+ * categorical split (the feature is not reused below it), and LEFT_BRANCH /
+ * RIGHT_BRANCH children at a quantile-bin edge for a numeric split. Instead of
+ * entropy, a split is scored from per-bin gradient sums G and hessian sums H
+ * (XGBoost-style gain):
+ * 
+ *   categorical: gain = Σ_bins G_b² / (H_b + λ) - G² / (H + λ)
+ *   numeric:     gain = G_L² / (H_L + λ) + G_R² / (H_R + λ) - G² / (H + λ),
+ *                scanning the bins in order as best_histogram_split does
+ * 
+ * Each node stores its own value -G / (H + λ) (times the learning rate), which is
+ * the prediction at leaves and the fallback for categories unseen in training.
+ * Histograms of large nodes are built in parallel, one task per feature.
+ */
+inline TreeNode* build_boosted_tree(const BinnedFeatures& binned, const vector<size_t>& rows,
+                                    const vector<size_t>& features, const vector<double>& grad,
+                                    const vector<double>& hess, int depth, const BoostingOptions& options,
+                                    TaskScheduler& scheduler, TreeArena& arena) {
+    double total_grad = 0.0, total_hess = 0.0;
+    for (size_t row : rows) {
+        total_grad += grad[row];
+        total_hess += hess[row];
+    }
+
+    TreeNode* node = arena.make_node();
+    node->value = -options.learning_rate * total_grad / (total_hess + options.l2);
+    if (depth >= options.max_depth || rows.size() < options.min_rows || features.empty()) return node;
+
+    vector<vector<GradientBin>> histograms(features.size());
+    auto fill = [&](size_t i) {
+        histograms[i] = build_histogram(binned, features[i], rows, grad, hess);
+    };
+    if (rows.size() >= PARALLEL_SCORING_MIN_ROWS && features.size() > 1) {
+        scheduler.parallel_for(0, features.size(), fill);
+    } else {
+        for (size_t i = 0; i < features.size(); ++i) fill(i);
+    }
+
+    double parent_score = total_grad * total_grad / (total_hess + options.l2);
+    double best_gain = 1e-9;
+    size_t best = features.size();
+    size_t best_bin = 0; // Last bin on the left of the best numeric split
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (binned.numeric[features[i]] >= 0) {
+            double left_grad = 0.0, left_hess = 0.0;
+            size_t left_count = 0;
+            for (size_t bin = 0; bin + 1 < histograms[i].size(); ++bin) {
+                const GradientBin& current = histograms[i][bin];
+                left_grad += current.grad;
+                left_hess += current.hess;
+                left_count += current.count;
+                if (current.count == 0 || left_count == rows.size()) continue;
+                double right_grad = total_grad - left_grad, right_hess = total_hess - left_hess;
+                double gain = left_grad * left_grad / (left_hess + options.l2) +
+                              right_grad * right_grad / (right_hess + options.l2) - parent_score;
+                if (gain > best_gain) {
+                    best_gain = gain;
+                    best = i;
+                    best_bin = bin;
+                }
+            }
+            continue;
+        }
+
+        double score = 0.0;
+        size_t used_bins = 0;
+        for (const GradientBin& bin : histograms[i]) {
+            if (bin.count == 0) continue;
+            score += bin.grad * bin.grad / (bin.hess + options.l2);
+            used_bins++;
+        }
+        if (used_bins > 1 && score - parent_score > best_gain) {
+            best_gain = score - parent_score;
+            best = i;
+        }
+    }
+    if (best == features.size()) return node;
+
+    size_t f = features[best];
+    node->feature = binned.names[f];
+    if (binned.numeric[f] >= 0) {
+        vector<size_t> left_rows, right_rows;
+        for (size_t row : rows) (binned.codes[f][row] <= best_bin ? left_rows : right_rows).push_back(row);
+        node->numeric = binned.numeric[f];
+        node->threshold = binned.edges[f][best_bin];
+        node->children[LEFT_BRANCH] = build_boosted_tree(binned, left_rows, features, grad, hess, depth + 1,
+                                                         options, scheduler, arena);
+        node->children[RIGHT_BRANCH] = build_boosted_tree(binned, right_rows, features, grad, hess, depth + 1,
+                                                          options, scheduler, arena);
+        return node;
+    }
+
+    vector<vector<size_t>> child_rows(binned.bin_values[f].size());
+    for (size_t row : rows) child_rows[binned.codes[f][row]].push_back(row);
+
+    vector<size_t> remaining_features;
+    for (size_t other : features) {
+        if (other != f) remaining_features.push_back(other);
+    }
+
+    for (size_t bin = 0; bin < child_rows.size(); ++bin) {
+        if (child_rows[bin].empty()) continue;
+        node->children[binned.bin_values[f][bin]] =
+            build_boosted_tree(binned, child_rows[bin], remaining_features, grad, hess, depth + 1, options,
+                               scheduler, arena);
+    }
+    return node;
+}
+
+/**
+ * @brief Returns the raw score a boosted tree assigns to an example
+ */
+inline double predict_value(const TreeNode* root, const Example& example) {
+    while (!root->children.empty()) {
+        auto child = root->children.find(branch_value(root, example));
+        if (child == root->children.end()) break; // Unseen category: stop at this node
+        root = child->second;
+    }
+    return root->value;
+}
+
+/**
+ * @brief Probability of the positive label under the boosted ensemble
+ */
+inline double predict_probability(const GradientBoostedTrees& model, const Example& example) {
+    double score = model.base_score;
+    for (const TreeNode* tree : model.trees) score += predict_value(tree, example);
+    return 1.0 / (1.0 + exp(-score));
+}
+
+/**
+ * @brief Trains binary histogram gradient-boosted trees with logistic loss
+ * 
+ * Features are binned once (bin_features). Every round:
+ * 1. Computes the gradient p - y and hessian p(1 - p) of the logistic loss for
+ *    every row from the current scores.
+ * 2. Grows one tree from gradient histograms (build_boosted_tree).
+ * 3. Adds the tree's leaf values to the running scores.
+ * 
+ * The label is `positive_label` versus everything else; the most frequent other
+ * label is what the model predicts for the negative class. NUMERIC_FEATURES
+ * share the quantile bins of the decision trees and split at a threshold.
+ * 
+ * @param data The training dataset.
+ * @param features List of features to consider for splits.
+ * @param options Number of rounds, learning rate, depth and regularisation.
+ * @param scheduler Scheduler used for the per-feature histograms.
+ * @return GradientBoostedTrees The trained model.
+ */
+inline GradientBoostedTrees train_gradient_boosting(const vector<Example>& data, const vector<string>& features,
+                                                    const BoostingOptions& options, TaskScheduler& scheduler) {
+    GradientBoostedTrees model;
+    model.positive_label = options.positive_label;
+    model.negative_label = "unknown";
+    if (data.empty()) return model;
+
+    map<string, int> label_counts;
+    for (const auto& ex : data) label_counts[ex.user_action]++;
+    int negative_count = 0;
+    for (const auto& pair : label_counts) {
+        if (pair.first != options.positive_label && pair.second > negative_count) {
+            model.negative_label = pair.first;
+            negative_count = pair.second;
+        }
+    }
+
+    size_t n = data.size();
+    vector<double> target(n);
+    for (size_t row = 0; row < n; ++row) target[row] = data[row].user_action == options.positive_label ? 1.0 : 0.0;
+
+    // Start from the log-odds of the positive label, clamped away from 0 and 1
+    double positive_rate = static_cast<double>(label_counts[options.positive_label]) / n;
+    positive_rate = min(max(positive_rate, 1e-6), 1.0 - 1e-6);
+    model.base_score = log(positive_rate / (1.0 - positive_rate));
+
+    BinnedFeatures binned = bin_features(data, features);
+    vector<size_t> rows = all_rows(data);
+    vector<size_t> feature_ids(features.size());
+    for (size_t i = 0; i < feature_ids.size(); ++i) feature_ids[i] = i;
+
+    vector<double> score(n, model.base_score), grad(n), hess(n);
+    for (int round = 0; round < options.num_rounds; ++round) {
+        for (size_t row = 0; row < n; ++row) {
+            double p = 1.0 / (1.0 + exp(-score[row]));
+            grad[row] = p - target[row];
+            hess[row] = max(p * (1.0 - p), 1e-12);
+        }
+
+        TreeNode* tree = build_boosted_tree(binned, rows, feature_ids, grad, hess, 0, options, scheduler,
+                                            *model.arena);
+        model.trees.push_back(tree);
+        for (size_t row = 0; row < n; ++row) score[row] += predict_value(tree, data[row]);
+    }
+    return model;
+}
+
+/**
+ * @brief Predicts the user action with the boosted ensemble
+ */
+inline string predict(const GradientBoostedTrees& model, const Example& example) {
+    return predict_probability(model, example) >= 0.5 ? model.positive_label : model.negative_label;
+}
+
+/**
+ * @brief Calculates accuracy of the boosted ensemble on the test dataset
+ */
+inline double calculate_accuracy(const GradientBoostedTrees& model, const vector<Example>& test_data) {
+    int correct = 0;
+    for (const auto& ex : test_data) {
+        if (predict(model, ex) == ex.user_action) {
+            correct++;
+        }
+    }
+    return static_cast<double>(correct) / test_data.size();
+}
+
+/**
+ * @struct ModelConfig
+ * @brief One candidate of the cross-validated model selection: a single tree or a forest
+ */
+struct ModelConfig {
+    bool forest = false;
+    ForestOptions options;
+};
+
+/**
+ * @brief Label id of every example (labels numbered in sorted order), for stratified folds
+ */
+inline vector<int> label_ids(const vector<Example>& data) {
+    map<string, int> ids;
+    for (const auto& ex : data) ids[ex.user_action] = 0;
+    int next = 0;
+    for (auto& entry : ids) entry.second = next++;
+    vector<int> labels;
+    for (const auto& ex : data) labels.push_back(ids[ex.user_action]);
+    return labels;
+}
+
+} // namespace pa4
+
+#endif // FAI_PA4_NAVEEN_KARASU_H
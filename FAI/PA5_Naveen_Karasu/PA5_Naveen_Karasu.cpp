@@ -1,314 +1,376 @@
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <map>
-#include <cmath>
-#include <cstdlib>
-#include <ctime>
+#include "PA5_Naveen_Karasu.h"
 
 using namespace std;
+using namespace pa5;
 
-/**
- * @struct Example
- * @brief Stores each example's encoded features and label.
- *
- * This structure represents each individual data point in the dataset.
- * - `features`: A vector that holds the encoded values for each categorical feature.
- * - `label`: A binary outcome representing the user action (0 = "skips", 1 = "reads").
- * 
- * For example, a user who is "unknown", views a "new" thread of "long" length at "work"
- * could be represented as:
- * - features: {0.0, 1.0, 1.0, 0.0} (encoded values for categorical features)
- * - label: 1 (assume "reads")
- */
-struct Example {
-    vector<double> features; // Encoded values for input features
-    int label;               // 0 for "skips" and 1 for "reads"
-};
+int main() {
+    FAI_PROFILE_SESSION();
+    string filename = "dataset.csv"; // Dataset file path
+    vector<Example> data = load_data(filename);
 
-/**
- * @class NeuralNetwork
- * @brief Implements a neural network with a single hidden layer for binary classification.
- *
- * This class represents a simple feed-forward neural network with:
- * - An input layer (4 features)
- * - A single hidden layer (2 units)
- * - An output layer (1 output for binary classification)
- * 
- * The network uses sigmoid activation functions and trains with gradient descent.
- */
-class NeuralNetwork {
-private:
-    // Member Variables
-    double weightsInputHidden[4][2]; // Weights from input to hidden layer
-    double weightsHiddenOutput[2];   // Weights from hidden to output layer
-    double hiddenBias[2], outputBias; // Biases for hidden and output layers
-    double learningRate;             // Step size for weight updates
+    vector<float> ratios = {0.8, 0.7, 0.5}; // Different train-test split ratios
 
-    /**
-     * @brief Sigmoid activation function
-     * 
-     * @param x Input value
-     * @return Sigmoid of x, a value between 0 and 1
-     * 
-     * Example:
-     * If `x` = 0, then `sigmoid(0)` = 0.5.
-     */
-    double sigmoid(double x) {
-        return 1.0 / (1.0 + exp(-x));
-    }
+    for (float ratio : ratios) {
+        vector<Example> train_data, test_data;
+        split_data(data, train_data, test_data, ratio);
 
-public:
-    /**
-     * @brief Constructor to initialize weights and biases.
-     * 
-     * Initializes weights and biases with small random values for symmetry breaking.
-     * Uses a fixed seed for reproducibility and sets the learning rate.
-     * 
-     * @param lr Learning rate for training (e.g., 0.1)
-     */
-    NeuralNetwork(double lr) : learningRate(lr) {
-        srand(42); // Fixed seed for reproducibility
-        for (int i = 0; i < 4; ++i)
-            for (int j = 0; j < 2; ++j)
-                weightsInputHidden[i][j] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+        NeuralNetwork nn(0.7); // Initialize network with a learning rate of 0.7
+        nn.train(train_data, 80); // Train the network for 80 epochs
 
-        for (int j = 0; j < 2; ++j)
-            weightsHiddenOutput[j] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+        // One evaluation pass gives the misclassified count, accuracy and the other metrics
+        BinaryMetrics metrics = nn.evaluate(test_data);
 
-        hiddenBias[0] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
-        hiddenBias[1] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
-        outputBias = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
-    }
+        cout << "Test Misclassified = " << metrics.misclassified() << "\n";
+        cout << "Accuracy for train:test ratio " << ratio << ":" << (1 - ratio) << " is " << metrics.accuracy << endl;
+        cout << "Test metrics: ";
+        print_binary_metrics(metrics, cout);
 
-    /**
-     * @brief Forward propagation through the network
-     * 
-     * Computes the activations for the hidden layer and output layer.
-     * 
-     * @param example The input example with features
-     * @param hiddenLayer Array to store hidden layer activations
-     * @return Output activation (prediction) for the given example
-     * 
-     * Example:
-     * Suppose `example.features` is {0.0, 1.0, 1.0, 0.0}, and initial weights and biases
-     * are small random values. This function computes hidden layer activations and a final
-     * output activation (e.g., 0.72), which can be interpreted as the probability of "reads".
-     */
-    double forward(const Example& example, double hiddenLayer[2]) {
-        // Compute activations for hidden layer neurons
-        for (int i = 0; i < 2; ++i) {
-            hiddenLayer[i] = hiddenBias[i];
-            for (int j = 0; j < 4; ++j) {
-                hiddenLayer[i] += example.features[j] * weightsInputHidden[j][i];
-            }
-            hiddenLayer[i] = sigmoid(hiddenLayer[i]); // Activation for hidden neuron
-        }
+        // Predictions for specific examples (e19 and e20)
+        Example e19 = {{0.0, 1.0, 1.0, 0.0}, -1}; // Encoded for "unknown", "new", "long", "work"
+        Example e20 = {{0.0, 0.0, 0.0, 1.0}, -1}; // Encoded for "unknown", "followup", "short", "home"
 
-        // Compute activation for output layer neuron
-        double output = outputBias;
-        for (int i = 0; i < 2; ++i) {
-            output += hiddenLayer[i] * weightsHiddenOutput[i];
-        }
-        return sigmoid(output); // Final output prediction
+        float hiddenLayer[2];
+        cout << "Prediction for e19: " << (nn.forward(e19, hiddenLayer) >= 0.5 ? "reads" : "skips") << endl;
+        cout << "Prediction for e20: " << (nn.forward(e20, hiddenLayer) >= 0.5 ? "reads" : "skips") << endl;
     }
 
-    /**
-     * @brief Backward propagation for weight updates
-     * 
-     * Computes gradients for output and hidden layers, then updates weights and biases
-     * using the gradient descent algorithm.
-     * 
-     * @param example The input example (features and label)
-     * @param output The computed output from forward propagation
-     * @param hiddenLayer Hidden layer activations
-     * 
-     * Example:
-     * Given `output` = 0.72 and `example.label` = 1, this function calculates the error and
-     * adjusts weights and biases to reduce the error in subsequent iterations.
-     */
-    void backward(const Example& example, double output, double hiddenLayer[2]) {
-        // Calculate error and delta for output layer
-        double outputError = example.label - output;
-        double outputDelta = outputError * output * (1 - output); // Gradient for output
-
-        // Calculate errors and deltas for hidden layer
-        double hiddenError[2];
-        double hiddenDelta[2];
-        for (int i = 0; i < 2; ++i) {
-            hiddenError[i] = outputDelta * weightsHiddenOutput[i];
-            hiddenDelta[i] = hiddenError[i] * hiddenLayer[i] * (1 - hiddenLayer[i]);
+    // Model selection: every (learning rate, epochs, fold) combination trains concurrently
+    TaskScheduler scheduler;
+    vector<pair<double, int>> configs;
+    vector<string> config_names;
+    for (double rate : {0.1, 0.3, 0.7}) {
+        for (int epochs : {40, 80}) {
+            configs.push_back({rate, epochs});
+            config_names.push_back("lr " + to_string(rate).substr(0, 3) + ", " + to_string(epochs) + " epochs");
         }
+    }
+    vector<int> labels;
+    for (const auto& example : data) labels.push_back(example.label);
+    vector<Fold> folds = stratified_k_fold(labels, 3, 7);
+    CrossValidationReport report = cross_validate(configs, config_names, folds,
+        [&](const pair<double, int>& config, const Fold& fold) {
+            NeuralNetwork nn(config.first);
+            nn.train(data, fold.train, config.second);
+            return nn.calculate_accuracy(data, fold.test);
+        }, scheduler);
+    cout << "3-fold stratified cross-validation:" << endl;
+    print_cross_validation_report(report, cout);
+
+    // Mini-batch training streamed from an on-disk column file
+    ColumnFile columns;
+    if (convert_csv_to_column_file(filename, "dataset.cols") && columns.open("dataset.cols")) {
+        NeuralNetwork nn(0.7);
+        train_streaming(nn, columns, 80, 2);
+        cout << "Streaming accuracy on the full dataset: " << nn.calculate_accuracy(data) << endl;
+    }
 
-        // Update weights and biases for output layer
-        for (int i = 0; i < 2; ++i) {
-            weightsHiddenOutput[i] += learningRate * outputDelta * hiddenLayer[i];
-        }
-        outputBias += learningRate * outputDelta;
+    // The same mini-batch training in double, float and float with bfloat16 activations
+    {
+        Fold fold = shuffle_split(data.size(), 0.8, 7);
+        auto parity = [&](auto nn, const string& name) {
+            nn.train_minibatch(data, fold.train, 80, 2);
+            cout << name << " accuracy on dataset.csv: " << nn.evaluate(data, fold.test).accuracy << endl;
+        };
+        parity(NeuralNetwork<double>(0.7), "NeuralNetwork<double>");
+        parity(NeuralNetwork<float>(0.7), "NeuralNetwork<float>");
+        parity(NeuralNetwork<float, bfloat16>(0.7), "NeuralNetwork<float, bfloat16>");
+    }
 
-        // Update weights and biases for hidden layer
-        for (int i = 0; i < 2; ++i) {
-            for (int j = 0; j < 4; ++j) {
-                weightsInputHidden[j][i] += learningRate * hiddenDelta[i] * example.features[j];
-            }
-            hiddenBias[i] += learningRate * hiddenDelta[i];
+    // Speed and memory of each precision on a large synthetic set: 2^20 rows whose
+    // label is a noisy linear rule of four uniform features
+    {
+        const size_t rows = 1 << 20, test_rows = rows / 8, batch_size = 1 << 14;
+        const int synthetic_epochs = 5;
+        mt19937 rng(7);
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        normal_distribution<double> noise(0.0, 0.1);
+        vector<double> features(rows * 4);
+        vector<int> synthetic_labels(rows);
+        for (size_t r = 0; r < rows; ++r) {
+            double* x = &features[r * 4];
+            for (int j = 0; j < 4; ++j) x[j] = uniform(rng);
+            synthetic_labels[r] = 2 * x[0] - x[1] + x[2] - 1.5 * x[3] + noise(rng) > 0.25;
         }
-    }
 
-    /**
-     * @brief Train the neural network on a given dataset
-     * 
-     * Runs forward and backward propagation for each example in the dataset over multiple epochs.
-     * Reports misclassified examples after each epoch for monitoring learning progress.
-     * 
-     * @param train_data Training dataset of examples
-     * @param epochs Number of training epochs (e.g., 80)
-     */
-    void train(vector<Example>& train_data, int epochs) {
-        for (int epoch = 0; epoch < epochs; ++epoch) {
-            int misclassified = 0;
-            for (auto& example : train_data) {
-                double hiddenLayer[2];
-                double output = forward(example, hiddenLayer);
-                backward(example, output, hiddenLayer);
-                
-                // Count misclassifications
-                if ((output >= 0.5) != example.label) {
-                    misclassified++;
+        auto benchmark = [&](auto nn, const string& name) {
+            using Scalar = typename decltype(nn)::scalar_type;
+            vector<Scalar> matrix(features.begin(), features.end());
+            const size_t train_rows = rows - test_rows;
+            // The fastest epoch is reported, so one slow epoch on a busy machine does not skew the comparison
+            double fastest = numeric_limits<double>::infinity();
+            for (int epoch = 0; epoch < synthetic_epochs; ++epoch) {
+                auto start = chrono::steady_clock::now();
+                for (size_t begin = 0; begin < train_rows; begin += batch_size) {
+                    nn.train_matrix(matrix.data() + begin * 4, synthetic_labels.data() + begin,
+                                    min(batch_size, train_rows - begin));
                 }
+                chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                fastest = min(fastest, elapsed.count());
             }
-            cout << "Epoch " << epoch + 1 << ": Misclassified = " << misclassified << "\n";
-        }
-    }
 
-    /**
-     * @brief Test the neural network on a test dataset
-     * 
-     * Computes the number of misclassified examples for evaluating the network's performance.
-     * 
-     * @param test_data Testing dataset of examples
-     * @return Number of misclassified examples in the test dataset
-     */
-    int test(const vector<Example>& test_data) {
-        int misclassified = 0;
-        for (const auto& example : test_data) {
-            double hiddenLayer[2];
-            double output = forward(example, hiddenLayer);
-            if ((output >= 0.5) != example.label) {
-                misclassified++;
-            }
-        }
-        return misclassified;
+            vector<float> test_matrix(features.end() - test_rows * 4, features.end()), scores(test_rows);
+            nn.predict_batch(test_matrix.data(), test_rows, scores.data());
+            size_t correct = 0;
+            for (size_t r = 0; r < test_rows; ++r) correct += (scores[r] >= 0.5f) == synthetic_labels[train_rows + r];
+            cout << name << ": " << train_rows / fastest << " examples/sec, accuracy "
+                 << static_cast<double>(correct) / test_rows << ", features " << matrix.size() * sizeof(Scalar)
+                 << " bytes, activations " << nn.activation_bytes() << " bytes" << endl;
+        };
+        benchmark(NeuralNetwork<double>(5.0), "Synthetic NeuralNetwork<double>");
+        benchmark(NeuralNetwork<float>(5.0), "Synthetic NeuralNetwork<float>");
+        benchmark(NeuralNetwork<float, bfloat16>(5.0), "Synthetic NeuralNetwork<float, bfloat16>");
     }
 
-    /**
-     * @brief Calculate accuracy on the test dataset
-     * 
-     * Computes accuracy as the percentage of correctly classified examples.
-     * 
-     * @param test_data Testing dataset of examples
-     * @return Accuracy as a percentage of correct predictions
-     */
-    double calculate_accuracy(const vector<Example>& test_data) {
-        int correct = 0;
-        for (const auto& example : test_data) {
-            double hiddenLayer[2];
-            double output = forward(example, hiddenLayer);
-            if ((output >= 0.5) == example.label) {
-                correct++;
-            }
+    // Train on a real CTU-13 capture, decoded straight from the project's Parquet file
+    vector<Example> flows = load_flow_data("../Final project_Group_2/data/11-Rbot-20110818-2.binetflow.parquet");
+    if (!flows.empty()) {
+        vector<Example> train_flows, test_flows;
+        split_data(flows, train_flows, test_flows, 0.8);
+        vector<double> train_maxima = feature_maxima(train_flows);
+        scale_features(train_flows, train_maxima);
+        scale_features(test_flows, train_maxima);
+
+        NeuralNetwork nn(0.7);
+        nn.train(train_flows, 5);
+        cout << "Capture flows: " << flows.size() << endl;
+        cout << "Capture accuracy: " << nn.calculate_accuracy(test_flows) << endl;
+
+        // Throughput of per-example SGD against the matrix mini-batch mode
+        // From here on the flows are scaled by the maxima of the shuffled split's training rows
+        Fold fold = shuffle_split(flows.size(), 0.8, 7);
+        scale_features(flows, feature_maxima(flows, fold.train));
+        const int epochs = 5;
+        auto examples_per_second = [&](auto train_fn) {
+            auto start = chrono::steady_clock::now();
+            train_fn();
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            return fold.train.size() * epochs / elapsed.count();
+        };
+        NeuralNetwork per_example(0.7), minibatch(0.7);
+        double sgd_rate = examples_per_second([&] { per_example.train(flows, fold.train, epochs); });
+        double batch_rate = examples_per_second([&] { minibatch.train_minibatch(flows, fold.train, epochs, 256); });
+        cout << "Per-example SGD: " << sgd_rate << " examples/sec, accuracy "
+             << per_example.calculate_accuracy(flows, fold.test) << endl;
+        cout << "Mini-batch (256): " << batch_rate << " examples/sec, accuracy "
+             << minibatch.calculate_accuracy(flows, fold.test) << endl;
+
+        // The 4-2-1 shape as a run-time layer stack and as a compile-time network
+        LayerStack stack_421({4, 2, 1}, 0.7);
+        FixedNetwork<4, 2, 1> fixed_421(0.7);
+        double stack_rate = examples_per_second([&] { stack_421.train(flows, fold.train, epochs, 1); });
+        double fixed_rate = examples_per_second([&] { fixed_421.train(flows, fold.train, epochs); });
+        cout << "LayerStack 4-2-1: " << stack_rate << " examples/sec, accuracy "
+             << stack_421.calculate_accuracy(flows, fold.test) << endl;
+        cout << "FixedNetwork<4, 2, 1>: " << fixed_rate << " examples/sec, accuracy "
+             << fixed_421.calculate_accuracy(flows, fold.test) << endl;
+        bool same = true;
+        for (size_t row : fold.test) same = same && stack_421.predict(flows[row]) == fixed_421.predict(flows[row]);
+        cout << "FixedNetwork matches LayerStack: " << (same ? "yes" : "no") << endl;
+
+        // Multi-threaded SGD against the sequential train() on the same rows. The
+        // synchronous mode averages 64 gradients per step, so it takes a larger rate.
+        const size_t workers = 4;
+        const int parallel_epochs = 20;
+        auto parallel_rate = [&](auto train_fn) {
+            auto start = chrono::steady_clock::now();
+            train_fn();
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            return fold.train.size() * parallel_epochs / elapsed.count();
+        };
+        NeuralNetwork sequential(3.0), hogwild(3.0), synchronous(30.0);
+        int sequential_missed = 0, hogwild_missed = 0, synchronous_missed = 0;
+        double sequential_rate = parallel_rate([&] {
+            sequential_missed = sequential.train(flows, fold.train, parallel_epochs);
+        });
+        double hogwild_rate = parallel_rate([&] {
+            hogwild_missed = hogwild.train_hogwild(flows, fold.train, parallel_epochs, workers, scheduler);
+        });
+        double synchronous_rate = parallel_rate([&] {
+            synchronous_missed = synchronous.train_synchronous(flows, fold.train, parallel_epochs, 16, workers, scheduler);
+        });
+        cout << "Sequential SGD: " << sequential_rate << " examples/sec, last epoch misclassified "
+             << sequential_missed << ", accuracy " << sequential.calculate_accuracy(flows, fold.test) << endl;
+        cout << "Hogwild (" << workers << " workers): " << hogwild_rate << " examples/sec, last epoch misclassified "
+             << hogwild_missed << ", accuracy " << hogwild.calculate_accuracy(flows, fold.test) << endl;
+        cout << "Synchronous (" << workers << " x 16): " << synchronous_rate
+             << " examples/sec, last epoch misclassified " << synchronous_missed << ", accuracy "
+             << synchronous.calculate_accuracy(flows, fold.test) << endl;
+
+        // All test metrics of the sequential model in one sweep over 4 parallel shards
+        cout << "Capture test metrics: ";
+        print_binary_metrics(sequential.evaluate(flows, fold.test, &scheduler, 4), cout);
+
+        // Scoring the test rows one Example at a time against one predict_batch call
+        vector<float> test_matrix = feature_matrix(flows, fold.test);
+        vector<float> scores(fold.test.size());
+        size_t forward_positive = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t row : fold.test) {
+            float hiddenLayer[2];
+            forward_positive += sequential.forward(flows[row], hiddenLayer) >= 0.5;
+        }
+        chrono::duration<double> forward_time = chrono::steady_clock::now() - start;
+        start = chrono::steady_clock::now();
+        sequential.predict_batch(test_matrix.data(), fold.test.size(), scores.data());
+        chrono::duration<double> batch_time = chrono::steady_clock::now() - start;
+        size_t batch_positive = 0;
+        for (float score : scores) batch_positive += score >= 0.5f;
+        cout << "forward: " << fold.test.size() / forward_time.count() << " predictions/sec, predict_batch: "
+             << fold.test.size() / batch_time.count() << " predictions/sec, positives " << forward_positive
+             << " vs " << batch_positive << endl;
+
+        // The same flows as float32 columns, trained and scored through index views
+        Dataset flow_columns = load_flow_dataset("../Final project_Group_2/data/11-Rbot-20110818-2.binetflow.parquet");
+        Dataset prefix_columns = flow_columns;  // Scaled by its own 80:20 split further down
+        scale_features(flow_columns, feature_maxima(flow_columns, fold.train));
+        size_t example_bytes = flows.capacity() * sizeof(Example);
+        for (const auto& example : flows) example_bytes += example.features.capacity() * sizeof(double);
+        cout << "Capture memory: Examples " << example_bytes << " bytes, Dataset " << flow_columns.memory_bytes()
+             << " bytes" << endl;
+        NeuralNetwork example_minibatch(20.0), column_minibatch(20.0);
+        double example_rate = examples_per_second([&] { example_minibatch.train_minibatch(flows, fold.train, epochs, 16); });
+        double column_rate = examples_per_second([&] {
+            column_minibatch.train_minibatch(flow_columns, fold.train, epochs, 16);
+        });
+        cout << "Mini-batch (16) on Examples: " << example_rate << " examples/sec, test metrics: ";
+        print_binary_metrics(example_minibatch.evaluate(flows, fold.test), cout);
+        cout << "Mini-batch (16) on Dataset: " << column_rate << " examples/sec, test metrics: ";
+        print_binary_metrics(column_minibatch.evaluate(flow_columns, fold.test), cout);
+        vector<size_t> train_rows, test_rows;
+        split_data(prefix_columns, train_rows, test_rows, 0.8);
+        scale_features(prefix_columns, feature_maxima(prefix_columns, train_rows));
+        LayerStack column_stack({4, 2, 1}, 0.7);
+        column_stack.train(prefix_columns, train_rows, epochs, 1);
+        cout << "LayerStack 4-2-1 on Dataset, 80:20 split accuracy: "
+             << column_stack.calculate_accuracy(prefix_columns, test_rows) << endl;
+
+        // Convergence-aware training: the last tenth of the training rows validates,
+        // and each run stops once the validation loss has not improved for 3 epochs
+        const size_t fit_size = fold.train.size() * 9 / 10;
+        vector<size_t> fit_rows(fold.train.begin(), fold.train.begin() + fit_size);
+        vector<size_t> validation_rows(fold.train.begin() + fit_size, fold.train.end());
+        struct FitConfig {
+            string name;
+            double rate;
+            LearningRateSchedule schedule;
+            OptimizerKind optimizer;
+        };
+        const vector<FitConfig> fit_configs = {
+            {"SGD, constant rate", 20.0, LearningRateSchedule::constant(), OptimizerKind::SGD},
+            {"Momentum, step decay", 2.0, LearningRateSchedule::step(10, 0.5), OptimizerKind::Momentum},
+            {"Adam, cosine decay", 0.05, LearningRateSchedule::cosine(80, 0.01), OptimizerKind::Adam}};
+        TrainingOptions options;
+        options.batch_size = 16;
+        options.patience = 3;
+        options.min_delta = 1e-5;
+        for (const auto& config : fit_configs) {
+            NeuralNetwork nn(config.rate);
+            options.schedule = config.schedule;
+            options.optimizer.kind = config.optimizer;
+            TrainingReport report = nn.fit(flows, fit_rows, validation_rows, options);
+            cout << config.name << ": " << report.epochs_run << " of " << options.max_epochs
+                 << " epochs, best epoch " << report.best_epoch << ", validation loss " << report.best_loss
+                 << ", test accuracy " << nn.evaluate(flows, fold.test).accuracy << endl;
         }
-        return static_cast<double>(correct) / test_data.size();
-    }
-};
-
-/**
- * @brief Load data from a CSV file and encode categorical features.
- * 
- * Reads CSV data, converts categorical features to numerical values, and creates
- * examples with features and labels.
- * 
- * @param filename Path to the CSV file (e.g., "dataset.csv")
- * @return Encoded dataset
- */
-vector<Example> load_data(const string &filename) {
-    vector<Example> data;
-    ifstream file(filename);
-    string line;
-
-    // Skip header line
-    getline(file, line);
-
-    // Load data from file and encode each example
-    while (getline(file, line)) {
-        stringstream ss(line);
-        Example example;
-        string word;
-
-        // Encode each feature as a numeric value (1.0 for specific values, 0.0 otherwise)
-        getline(ss, word, ','); // Author
-        example.features.push_back(word == "known" ? 1.0 : 0.0);
-
-        getline(ss, word, ','); // Thread
-        example.features.push_back(word == "new" ? 1.0 : 0.0);
-
-        getline(ss, word, ','); // Length
-        example.features.push_back(word == "long" ? 1.0 : 0.0);
-
-        getline(ss, word, ','); // Where_read
-        example.features.push_back(word == "home" ? 1.0 : 0.0);
-
-        getline(ss, word, ','); // User_action
-        example.label = (word == "reads") ? 1 : 0;
 
-        data.push_back(example);
+        // A run interrupted after 8 epochs and resumed from its checkpoint ends where an uninterrupted run ends
+        const string checkpoint = "capture_fit.ckpt";
+        remove(checkpoint.c_str());
+        options.schedule = LearningRateSchedule::cosine(20, 0.01);
+        options.optimizer.kind = OptimizerKind::Adam;
+        options.patience = 0;
+        options.max_epochs = 20;
+        NeuralNetwork uninterrupted(0.05), interrupted(0.05), resumed(0.05);
+        uninterrupted.fit(flows, fit_rows, validation_rows, options);
+        options.checkpoint = checkpoint;
+        options.max_epochs = 8;
+        interrupted.fit(flows, fit_rows, validation_rows, options);
+        options.max_epochs = 20;
+        options.resume = true;
+        TrainingReport resumed_report = resumed.fit(flows, fit_rows, validation_rows, options);
+        const size_t num_parameters = NeuralNetwork<>::NUM_PARAMETERS;
+        float expected[num_parameters], actual[num_parameters];
+        uninterrupted.get_parameters(expected);
+        resumed.get_parameters(actual);
+        NeuralNetwork reloaded(0.05);
+        reloaded.load_weights(checkpoint);
+        cout << "Resumed at epoch " << resumed_report.resumed_from << " of " << resumed_report.epochs_run
+             << ", matches uninterrupted run: " << (equal(expected, expected + num_parameters, actual) ? "yes" : "no")
+             << ", reloaded checkpoint accuracy " << reloaded.evaluate(flows, fold.test).accuracy << endl;
+
+        // The same checkpoint with a different batch size belongs to another run, so it is not resumed
+        options.batch_size *= 2;
+        options.max_epochs = 1;
+        NeuralNetwork mismatched(0.05);
+        TrainingReport mismatched_report = mismatched.fit(flows, fit_rows, validation_rows, options);
+        cout << "Resumed with a different batch size at epoch " << mismatched_report.resumed_from << endl;
     }
-    return data;
-}
 
-/**
- * @brief Split dataset into training and testing sets based on a specified ratio.
- * 
- * Divides the dataset into two parts based on a given training ratio (e.g., 0.8 for 80% train).
- * 
- * @param data Full dataset
- * @param train Vector to store training set examples
- * @param test Vector to store testing set examples
- * @param train_ratio Proportion of examples for training (0.8 means 80% train, 20% test)
- */
-void split_data(const vector<Example>& data, vector<Example>& train, vector<Example>& test, float train_ratio) {
-    int train_size = static_cast<int>(data.size() * train_ratio);
-    train.assign(data.begin(), data.begin() + train_size);
-    test.assign(data.begin() + train_size, data.end());
-}
-
-int main() {
-    string filename = "dataset.csv"; // Dataset file path
-    vector<Example> data = load_data(filename);
-
-    vector<float> ratios = {0.8, 0.7, 0.5}; // Different train-test split ratios
-
-    for (float ratio : ratios) {
-        vector<Example> train_data, test_data;
-        split_data(data, train_data, test_data, ratio);
-
-        NeuralNetwork nn(0.7); // Initialize network with a learning rate of 0.7
-        nn.train(train_data, 80); // Train the network for 80 epochs
-
-        int testMisclassified = nn.test(test_data);
-        double accuracy = nn.calculate_accuracy(test_data);
-
-        cout << "Test Misclassified = " << testMisclassified << "\n";
-        cout << "Accuracy for train:test ratio " << ratio << ":" << (1 - ratio) << " is " << accuracy << endl;
-
-        // Predictions for specific examples (e19 and e20)
-        Example e19 = {{0.0, 1.0, 1.0, 0.0}, -1}; // Encoded for "unknown", "new", "long", "work"
-        Example e20 = {{0.0, 0.0, 0.0, 1.0}, -1}; // Encoded for "unknown", "followup", "short", "home"
-
-        double hiddenLayer[2];
-        cout << "Prediction for e19: " << (nn.forward(e19, hiddenLayer) >= 0.5 ? "reads" : "skips") << endl;
-        cout << "Prediction for e20: " << (nn.forward(e20, hiddenLayer) >= 0.5 ? "reads" : "skips") << endl;
+    // Deeper and wider networks on 25-input flow vectors
+    vector<Example> wide_flows = load_wide_flow_data("../Final project_Group_2/data/11-Rbot-20110818-2.binetflow.parquet");
+    if (!wide_flows.empty()) {
+        Fold fold = shuffle_split(wide_flows.size(), 0.8, 7);
+        scale_features(wide_flows, feature_maxima(wide_flows, fold.train));
+        LayerStack deep({25, 16, 8, 1}, 2.0);
+        deep.train(wide_flows, fold.train, 5, 4);
+        cout << "Wide flow inputs: " << wide_flows[0].features.size() << endl;
+        cout << "LayerStack 25-16-8-1 (" << deep.num_parameters() << " parameters) accuracy: "
+             << deep.calculate_accuracy(wide_flows, fold.test) << endl;
+        FixedNetwork<25, 16, 1> fixed(0.7);
+        fixed.train(wide_flows, fold.train, 5);
+        cout << "FixedNetwork<25, 16, 1> accuracy: " << fixed.calculate_accuracy(wide_flows, fold.test) << endl;
+
+        // Inference with each sigmoid approximation tier, and the tier's worst-case error
+        const vector<pair<ActivationPrecision, string>> tiers = {{ActivationPrecision::Exact, "Exact"},
+            {ActivationPrecision::High, "High"}, {ActivationPrecision::Medium, "Medium"}, {ActivationPrecision::Low, "Low"}};
+        for (const auto& tier : tiers) {
+            ApproximationError error = measure_approximation_error(tier.first);
+            deep.set_activation_precision(tier.first);
+            const int repeats = 20;
+            double accuracy = 0.0;
+            auto start = chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) accuracy = deep.calculate_accuracy(wide_flows, fold.test);
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            cout << "Sigmoid " << tier.second << ": max exp error " << error.exp_relative << ", max sigmoid error "
+                 << error.sigmoid_absolute << ", " << fold.test.size() * repeats / elapsed.count()
+                 << " predictions/sec, accuracy " << accuracy << endl;
+        }
+        deep.set_activation_precision(ActivationPrecision::Exact);
+
+        // Batched float32 scoring against the same model quantised to int8
+        const size_t test_rows = fold.test.size();
+        vector<float> test_matrix = feature_matrix(wide_flows, fold.test);
+        vector<size_t> calibration_rows(fold.train.begin(), fold.train.begin() + min<size_t>(1024, fold.train.size()));
+        vector<float> calibration = feature_matrix(wide_flows, calibration_rows);
+        QuantizedNetwork int8_model(deep, calibration.data(), calibration_rows.size());
+        vector<int8_t> quantized(test_matrix.size());
+        int8_model.quantize_inputs(test_matrix.data(), test_rows, quantized.data());
+
+        vector<float> float_scores(test_rows), int8_scores(test_rows);
+        auto predictions_per_second = [&](auto score_fn) {
+            const int repeats = 20;
+            auto start = chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) score_fn();
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            return test_rows * repeats / elapsed.count();
+        };
+        double float_rate = predictions_per_second([&] { deep.predict_batch(test_matrix.data(), test_rows, float_scores.data()); });
+        double int8_rate = predictions_per_second([&] { int8_model.predict_batch(quantized.data(), test_rows, int8_scores.data()); });
+        size_t float_correct = 0, int8_correct = 0, agree = 0;
+        float largest_difference = 0.0f;
+        for (size_t r = 0; r < test_rows; ++r) {
+            const int label = wide_flows[fold.test[r]].label;
+            float_correct += (float_scores[r] >= 0.5f) == label;
+            int8_correct += (int8_scores[r] >= 0.5f) == label;
+            agree += (float_scores[r] >= 0.5f) == (int8_scores[r] >= 0.5f);
+            largest_difference = max(largest_difference, fabs(float_scores[r] - int8_scores[r]));
+        }
+        cout << "predict_batch float32: " << float_rate << " predictions/sec, accuracy "
+             << static_cast<double>(float_correct) / test_rows << ", weights " << deep.num_parameters() * 8 << " bytes" << endl;
+        cout << "predict_batch int8: " << int8_rate << " predictions/sec, accuracy "
+             << static_cast<double>(int8_correct) / test_rows << ", weights " << int8_model.weight_bytes()
+             << " bytes, agrees with float32 on " << agree << "/" << test_rows << " rows, max score difference "
+             << largest_difference << endl;
     }
 
     return 0;
@@ -0,0 +1,1874 @@
+#ifndef FAI_PA5_NAVEEN_KARASU_H
+#define FAI_PA5_NAVEEN_KARASU_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <atomic>
+#include <mutex>
+#include <random>
+
+#include "../common/bfloat16.h"
+#include "../common/column_file.h"
+#include "../common/cross_validation.h"
+#include "../common/csv_reader.h"
+#include "../common/dataset.h"
+#include "../common/fast_math.h"
+#include "../common/gemm.h"
+#include "../common/metrics.h"
+#include "../common/parquet_reader.h"
+#include "../common/profiling.h"
+#include "../common/quantize.h"
+#include "../common/training.h"
+
+/**
+ * The neural network of PA5: the NeuralNetwork template with its layer stacks,
+ * mini-batch, multi-threaded and early-stopping training, quantised and float32
+ * batched inference, and the loaders for the categorical and netflow data.
+ *
+ * Everything lives in namespace pa5. PA5_Naveen_Karasu.cpp is the demo program;
+ * the benchmarks build against the same header through the fai_pa5 target.
+ */
+
+namespace pa5 {
+
+using namespace std;
+
+/**
+ * @struct Example
+ * @brief Stores each example's encoded features and label.
+ *
+ * This structure represents each individual data point in the dataset.
+ * - `features`: A vector that holds the encoded values for each categorical feature.
+ * - `label`: A binary outcome representing the user action (0 = "skips", 1 = "reads").
+ * 
+ * For example, a user who is "unknown", views a "new" thread of "long" length at "work"
+ * could be represented as:
+ * - features: {0.0, 1.0, 1.0, 0.0} (encoded values for categorical features)
+ * - label: 1 (assume "reads")
+ */
+struct Example {
+    vector<double> features; // Encoded values for input features
+    int label;               // 0 for "skips" and 1 for "reads"
+};
+
+// Feature values encoded as 1.0, one per input column (Author, Thread, Length, Where_read)
+const vector<string> POSITIVE_VALUES = {"known", "new", "long", "home"};
+
+// User_action value encoded as label 1
+const string POSITIVE_LABEL = "reads";
+
+/**
+ * @class NeuralNetwork
+ * @brief Implements a neural network with a single hidden layer for binary classification.
+ *
+ * This class represents a simple feed-forward neural network with:
+ * - An input layer (4 features)
+ * - A single hidden layer (2 units)
+ * - An output layer (1 output for binary classification)
+ * 
+ * The network uses sigmoid activation functions and trains with gradient descent.
+ * 
+ * `Scalar` is the type of the weights, biases and all arithmetic: float by
+ * default, or double. `Storage` is the type the mini-batch mode keeps the
+ * hidden and output activations in between the forward and the backward pass;
+ * with bfloat16 they take 2 bytes each while every product and sum is still
+ * computed in Scalar (bfloat16 storage, float32 accumulation).
+ * 
+ * Example:
+ *   NeuralNetwork nn(0.7);                        // float weights and activations
+ *   NeuralNetwork<double> reference(0.7);         // double precision throughout
+ *   NeuralNetwork<float, bfloat16> compact(0.7);  // bfloat16 activations in train_matrix
+ */
+template <typename Scalar = float, typename Storage = Scalar>
+class NeuralNetwork {
+private:
+    // Member Variables
+    Scalar weightsInputHidden[4][2]; // Weights from input to hidden layer
+    Scalar weightsHiddenOutput[2];   // Weights from hidden to output layer
+    Scalar hiddenBias[2], outputBias; // Biases for hidden and output layers
+    Scalar learningRate;             // Step size for weight updates
+
+    // Activations kept by the mini-batch mode for the backward pass, reused from batch to batch
+    vector<Storage> batchHidden, batchOutput;
+
+    // Scratch of the mini-batch mode: the forward pass of one chunk, and the hidden deltas
+    vector<Scalar> chunkHidden, chunkOutput, batchHiddenDelta;
+
+    // Accuracy of the vectorised sigmoid used by the mini-batch mode
+    ActivationPrecision activationPrecision = ActivationPrecision::Exact;
+
+    /**
+     * @brief Sigmoid activation function
+     * 
+     * @param x Input value
+     * @return Sigmoid of x, a value between 0 and 1
+     * 
+     * Example:
+     * If `x` = 0, then `sigmoid(0)` = 0.5.
+     */
+    static Scalar sigmoid(Scalar x) {
+        return Scalar(1) / (Scalar(1) + exp(-x));
+    }
+
+    /**
+     * @brief Adds one example's gradient step direction (the terms backward() scales by the learning rate) to `grad`
+     * 
+     * Works on a flat parameter array (see get_parameters) instead of the members,
+     * so worker threads can evaluate it against shared or snapshotted weights.
+     * 
+     * @param params Parameters to evaluate the example with
+     * @param example Training example
+     * @param grad NUM_PARAMETERS accumulators, in the layout of get_parameters
+     * @return 1 if the example is misclassified, else 0
+     */
+    static int example_gradient(const Scalar* params, const Example& example, Scalar* grad) {
+        const Scalar* w1 = params;
+        const Scalar* w2 = params + 8;
+        const Scalar* b1 = params + 10;
+        Scalar hiddenLayer[2];
+        for (int i = 0; i < 2; ++i) {
+            Scalar sum = b1[i];
+            for (int j = 0; j < 4; ++j) sum += Scalar(example.features[j]) * w1[j * 2 + i];
+            hiddenLayer[i] = sigmoid(sum);
+        }
+        Scalar output = sigmoid(params[12] + hiddenLayer[0] * w2[0] + hiddenLayer[1] * w2[1]);
+
+        Scalar outputDelta = (example.label - output) * output * (1 - output);
+        for (int i = 0; i < 2; ++i) {
+            Scalar hiddenDelta = outputDelta * w2[i] * hiddenLayer[i] * (1 - hiddenLayer[i]);
+            grad[8 + i] += outputDelta * hiddenLayer[i];
+            for (int j = 0; j < 4; ++j) grad[j * 2 + i] += hiddenDelta * Scalar(example.features[j]);
+            grad[10 + i] += hiddenDelta;
+        }
+        grad[12] += outputDelta;
+        return (output >= Scalar(0.5)) != example.label;
+    }
+
+    /**
+     * @brief Forward pass of a row-major `rows` x 4 batch into H (rows x 2) and O (rows)
+     * 
+     * Only reads the network, so concurrent calls with their own H and O are safe.
+     */
+    void forward_matrix(const Scalar* inputs, size_t rows, Scalar* H, Scalar* O) const {
+        FAI_COUNT_N(FORWARD_PASSES, rows);
+        // Biases first, then accumulated into by the products
+        for (size_t r = 0; r < rows; ++r) {
+            H[2 * r] = hiddenBias[0];
+            H[2 * r + 1] = hiddenBias[1];
+            O[r] = outputBias;
+        }
+        gemm(false, false, rows, 2, 4, 1.0, inputs, 4, &weightsInputHidden[0][0], 2, 1.0, H, 2);
+        sigmoid_array(H, H, rows * 2, activationPrecision);
+        gemm(false, false, rows, 1, 2, 1.0, H, 2, weightsHiddenOutput, 1, 1.0, O, 1);
+        sigmoid_array(O, O, rows, activationPrecision);
+    }
+
+public:
+    using scalar_type = Scalar;
+
+    // Weights and biases of the 4-2-1 network
+    static const size_t NUM_PARAMETERS = 13;
+
+    /**
+     * @brief Constructor to initialize weights and biases.
+     * 
+     * Initializes weights and biases with small random values for symmetry breaking.
+     * Uses a fixed seed for reproducibility and sets the learning rate.
+     * 
+     * rand() has one global state, so construction is serialised: networks built
+     * concurrently (e.g. by cross-validation tasks) all get the same initial weights.
+     * 
+     * @param lr Learning rate for training (e.g., 0.1)
+     */
+    NeuralNetwork(double lr) : learningRate(lr) {
+        static mutex init_mutex;
+        lock_guard<mutex> lock(init_mutex);
+        srand(42); // Fixed seed for reproducibility
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 2; ++j)
+                weightsInputHidden[i][j] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+
+        for (int j = 0; j < 2; ++j)
+            weightsHiddenOutput[j] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+
+        hiddenBias[0] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+        hiddenBias[1] = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+        outputBias = (rand() / double(RAND_MAX)) * 0.1 - 0.05;
+    }
+
+    /**
+     * @brief One mini-batch gradient descent step on a row-major batch matrix
+     * 
+     * The batch is an `rows` x 4 matrix (one example per row), so each layer is a
+     * single matrix product (see gemm):
+     * - Forward:  H = sigmoid(X * W1 + b1), O = sigmoid(H * W2 + b2)
+     * - Backward: dO = (y - O) * O * (1 - O), dH = (dO * W2^T) * H * (1 - H)
+     * - Update:   W2 += step * H^T * dO, W1 += step * X^T * dH, with step = learningRate / rows
+     * 
+     * Gradients are taken with the weights fixed and applied once, i.e. the
+     * learning rate times the average gradient.
+     * 
+     * The forward pass runs in chunks of 256 rows; each chunk's activations are
+     * stored as Storage and read back as Scalar by the backward pass, so with
+     * bfloat16 storage the gradients see the rounded activations, as they would
+     * on hardware that keeps activations in bfloat16.
+     * 
+     * @param inputs Row-major `rows` x 4 feature matrix
+     * @param labels Label (0 or 1) of each row
+     * @param rows Number of examples in the batch
+     * @return Number of examples misclassified before the step
+     */
+    int train_matrix(const Scalar* inputs, const int* labels, size_t rows) {
+        if (rows == 0) return 0;
+        FAI_COUNT_N(BACKWARD_PASSES, rows);
+        const size_t chunk = 256;
+        batchHidden.resize(rows * 2);
+        batchOutput.resize(rows);
+        chunkHidden.resize(chunk * 2);
+        chunkOutput.resize(chunk);
+        for (size_t start = 0; start < rows; start += chunk) {
+            const size_t count = min(chunk, rows - start);
+            forward_matrix(inputs + start * 4, count, chunkHidden.data(), chunkOutput.data());
+            for (size_t i = 0; i < count * 2; ++i) batchHidden[start * 2 + i] = Storage(chunkHidden[i]);
+            for (size_t r = 0; r < count; ++r) batchOutput[start + r] = Storage(chunkOutput[r]);
+        }
+
+        // Backward pass with the current weights: dO, dH and the hidden-output gradient in one sweep
+        batchHiddenDelta.resize(rows * 2);
+        Scalar* dH = batchHiddenDelta.data();
+        Scalar outputGradient[2] = {}, hiddenBiasGradient[2] = {}, outputBiasGradient = 0;
+        int misclassified = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            const Scalar O = Scalar(batchOutput[r]);
+            if ((O >= Scalar(0.5)) != labels[r]) misclassified++;
+            const Scalar dO = (labels[r] - O) * O * (1 - O);
+            outputBiasGradient += dO;
+            for (int i = 0; i < 2; ++i) {
+                const Scalar H = Scalar(batchHidden[2 * r + i]);
+                outputGradient[i] += H * dO;
+                dH[2 * r + i] = dO * weightsHiddenOutput[i] * H * (1 - H);
+                hiddenBiasGradient[i] += dH[2 * r + i];
+            }
+        }
+
+        // One update per layer
+        const Scalar step = learningRate / rows;
+        gemm(true, false, 4, 2, rows, step, inputs, 4, dH, 2, Scalar(1), &weightsInputHidden[0][0], 2);
+        for (int i = 0; i < 2; ++i) {
+            weightsHiddenOutput[i] += step * outputGradient[i];
+            hiddenBias[i] += step * hiddenBiasGradient[i];
+        }
+        outputBias += step * outputBiasGradient;
+        return misclassified;
+    }
+
+    /**
+     * @brief Bytes held by the mini-batch mode's activation and scratch buffers
+     */
+    size_t activation_bytes() const {
+        return (batchHidden.capacity() + batchOutput.capacity()) * sizeof(Storage) +
+               (chunkHidden.capacity() + chunkOutput.capacity() + batchHiddenDelta.capacity()) * sizeof(Scalar);
+    }
+
+    /**
+     * @brief One mini-batch gradient descent step on a list of examples
+     * 
+     * Copies the batch into a row-major matrix and calls train_matrix.
+     * 
+     * @param batch Examples of the mini-batch
+     * @return Number of examples misclassified before the step
+     */
+    int train_batch(const vector<Example>& batch) {
+        vector<Scalar> inputs(batch.size() * 4);
+        vector<int> labels(batch.size());
+        for (size_t r = 0; r < batch.size(); ++r) {
+            copy(batch[r].features.begin(), batch[r].features.begin() + 4, inputs.begin() + 4 * r);
+            labels[r] = batch[r].label;
+        }
+        return train_matrix(inputs.data(), labels.data(), batch.size());
+    }
+
+    /**
+     * @brief Mini-batch training over the examples `data[rows[i]]`
+     * 
+     * Each batch of `batch_size` consecutive rows is gathered into one row-major
+     * matrix (reused across batches) and trained with train_matrix. Prints nothing.
+     * 
+     * @param data Full dataset
+     * @param rows Indices of the training examples, in training order
+     * @param epochs Number of passes over `rows`
+     * @param batch_size Examples per gradient step
+     * @return Misclassified examples in the last epoch
+     */
+    int train_minibatch(const vector<Example>& data, const vector<size_t>& rows, int epochs, size_t batch_size) {
+        if (batch_size == 0) return 0;
+        FAI_SCOPED_TIMER("pa5::NeuralNetwork::train_minibatch");
+        vector<Scalar> inputs(batch_size * 4);
+        vector<int> labels(batch_size);
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t start = 0; start < rows.size(); start += batch_size) {
+                const size_t count = min(batch_size, rows.size() - start);
+                for (size_t r = 0; r < count; ++r) {
+                    const Example& example = data[rows[start + r]];
+                    copy(example.features.begin(), example.features.begin() + 4, inputs.begin() + 4 * r);
+                    labels[r] = example.label;
+                }
+                misclassified += train_matrix(inputs.data(), labels.data(), count);
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief train_minibatch over the rows `rows` of a column Dataset
+     * 
+     * Each batch is gathered straight from the float32 columns (Dataset::gather)
+     * and the int32 labels, with no Example in between.
+     * 
+     * @param data Dataset with 4 features and labels 0 / 1
+     * @param rows Indices of the training rows, in training order
+     * @param epochs Number of passes over `rows`
+     * @param batch_size Examples per gradient step
+     * @return Misclassified examples in the last epoch
+     */
+    int train_minibatch(const Dataset& data, const vector<size_t>& rows, int epochs, size_t batch_size) {
+        if (batch_size == 0) return 0;
+        FAI_SCOPED_TIMER("pa5::NeuralNetwork::train_minibatch");
+        vector<Scalar> inputs(batch_size * 4);
+        vector<int> labels(batch_size);
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t start = 0; start < rows.size(); start += batch_size) {
+                const size_t count = min(batch_size, rows.size() - start);
+                data.gather(&rows[start], count, inputs.data());
+                for (size_t r = 0; r < count; ++r) labels[r] = data.label(rows[start + r]);
+                misclassified += train_matrix(inputs.data(), labels.data(), count);
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Selects the sigmoid approximation of the mini-batch mode (see fast_math.h)
+     */
+    void set_activation_precision(ActivationPrecision precision) {
+        activationPrecision = precision;
+    }
+
+    /**
+     * @brief Copies the parameters into `params`: input-hidden weights row by row, hidden-output weights, hidden biases, output bias
+     */
+    void get_parameters(Scalar* params) const {
+        for (int j = 0; j < 4; ++j)
+            for (int i = 0; i < 2; ++i) params[j * 2 + i] = weightsInputHidden[j][i];
+        for (int i = 0; i < 2; ++i) {
+            params[8 + i] = weightsHiddenOutput[i];
+            params[10 + i] = hiddenBias[i];
+        }
+        params[12] = outputBias;
+    }
+
+    /**
+     * @brief Inverse of get_parameters
+     */
+    void set_parameters(const Scalar* params) {
+        for (int j = 0; j < 4; ++j)
+            for (int i = 0; i < 2; ++i) weightsInputHidden[j][i] = params[j * 2 + i];
+        for (int i = 0; i < 2; ++i) {
+            weightsHiddenOutput[i] = params[8 + i];
+            hiddenBias[i] = params[10 + i];
+        }
+        outputBias = params[12];
+    }
+
+    /**
+     * @brief Forward propagation through the network
+     * 
+     * Computes the activations for the hidden layer and output layer.
+     * 
+     * @param example The input example with features
+     * @param hiddenLayer Array to store hidden layer activations
+     * @return Output activation (prediction) for the given example
+     * 
+     * Example:
+     * Suppose `example.features` is {0.0, 1.0, 1.0, 0.0}, and initial weights and biases
+     * are small random values. This function computes hidden layer activations and a final
+     * output activation (e.g., 0.72), which can be interpreted as the probability of "reads".
+     */
+    Scalar forward(const Example& example, Scalar hiddenLayer[2]) {
+        FAI_COUNT(FORWARD_PASSES);
+        // Compute activations for hidden layer neurons
+        for (int i = 0; i < 2; ++i) {
+            hiddenLayer[i] = hiddenBias[i];
+            for (int j = 0; j < 4; ++j) {
+                hiddenLayer[i] += Scalar(example.features[j]) * weightsInputHidden[j][i];
+            }
+            hiddenLayer[i] = sigmoid(hiddenLayer[i]); // Activation for hidden neuron
+        }
+
+        // Compute activation for output layer neuron
+        Scalar output = outputBias;
+        for (int i = 0; i < 2; ++i) {
+            output += hiddenLayer[i] * weightsHiddenOutput[i];
+        }
+        return sigmoid(output); // Final output prediction
+    }
+
+    /**
+     * @brief Backward propagation for weight updates
+     * 
+     * Computes gradients for output and hidden layers, then updates weights and biases
+     * using the gradient descent algorithm.
+     * 
+     * @param example The input example (features and label)
+     * @param output The computed output from forward propagation
+     * @param hiddenLayer Hidden layer activations
+     * 
+     * Example:
+     * Given `output` = 0.72 and `example.label` = 1, this function calculates the error and
+     * adjusts weights and biases to reduce the error in subsequent iterations.
+     */
+    void backward(const Example& example, Scalar output, Scalar hiddenLayer[2]) {
+        FAI_COUNT(BACKWARD_PASSES);
+        // Calculate error and delta for output layer
+        Scalar outputError = example.label - output;
+        Scalar outputDelta = outputError * output * (1 - output); // Gradient for output
+
+        // Calculate errors and deltas for hidden layer
+        Scalar hiddenError[2];
+        Scalar hiddenDelta[2];
+        for (int i = 0; i < 2; ++i) {
+            hiddenError[i] = outputDelta * weightsHiddenOutput[i];
+            hiddenDelta[i] = hiddenError[i] * hiddenLayer[i] * (1 - hiddenLayer[i]);
+        }
+
+        // Update weights and biases for output layer
+        for (int i = 0; i < 2; ++i) {
+            weightsHiddenOutput[i] += learningRate * outputDelta * hiddenLayer[i];
+        }
+        outputBias += learningRate * outputDelta;
+
+        // Update weights and biases for hidden layer
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                weightsInputHidden[j][i] += learningRate * hiddenDelta[i] * Scalar(example.features[j]);
+            }
+            hiddenBias[i] += learningRate * hiddenDelta[i];
+        }
+    }
+
+    /**
+     * @brief Train the neural network on a given dataset
+     * 
+     * Runs forward and backward propagation for each example in the dataset over multiple epochs.
+     * Reports misclassified examples after each epoch for monitoring learning progress.
+     * 
+     * @param train_data Training dataset of examples
+     * @param epochs Number of training epochs (e.g., 80)
+     */
+    void train(vector<Example>& train_data, int epochs) {
+        FAI_SCOPED_TIMER("pa5::NeuralNetwork::train");
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            int misclassified = 0;
+            for (auto& example : train_data) {
+                Scalar hiddenLayer[2];
+                Scalar output = forward(example, hiddenLayer);
+                backward(example, output, hiddenLayer);
+                
+                // Count misclassifications
+                if ((output >= Scalar(0.5)) != example.label) {
+                    misclassified++;
+                }
+            }
+            cout << "Epoch " << epoch + 1 << ": Misclassified = " << misclassified << "\n";
+        }
+    }
+
+    /**
+     * @brief Train on the examples `data[rows[i]]`, in the order given by `rows`
+     * 
+     * Same per-example SGD as train(), but reads the examples through row indices
+     * (no copies) and prints nothing, so several networks can train at once.
+     * 
+     * @param data Full dataset
+     * @param rows Indices of the training examples
+     * @param epochs Number of training epochs
+     * @return Misclassified examples in the last epoch
+     */
+    int train(const vector<Example>& data, const vector<size_t>& rows, int epochs) {
+        FAI_SCOPED_TIMER("pa5::NeuralNetwork::train");
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t row : rows) {
+                Scalar hiddenLayer[2];
+                Scalar output = forward(data[row], hiddenLayer);
+                backward(data[row], output, hiddenLayer);
+                if ((output >= Scalar(0.5)) != data[row].label) {
+                    misclassified++;
+                }
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Hogwild training: workers run per-example SGD on shared weights without locks
+     * 
+     * The weights live in relaxed atomics. Each worker takes every num_workers-th
+     * row, reads the current weights, and adds its step to each weight with a
+     * plain load and store, so concurrent steps can overwrite one another. The
+     * lost updates are rare and cost little accuracy, while no worker ever waits
+     * on another. Results vary slightly from run to run.
+     * 
+     * @param data Full dataset
+     * @param rows Indices of the training examples
+     * @param epochs Number of passes over `rows`
+     * @param num_workers Concurrent workers (tasks on `scheduler`)
+     * @param scheduler Scheduler that runs the workers
+     * @return Misclassified examples in the last epoch
+     */
+    int train_hogwild(const vector<Example>& data, const vector<size_t>& rows, int epochs, size_t num_workers,
+                      TaskScheduler& scheduler) {
+        Scalar initial[NUM_PARAMETERS];
+        get_parameters(initial);
+        vector<atomic<Scalar>> shared(NUM_PARAMETERS);
+        for (size_t k = 0; k < NUM_PARAMETERS; ++k) shared[k].store(initial[k], memory_order_relaxed);
+
+        vector<int> missed(num_workers, 0);
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            scheduler.parallel_for(0, num_workers, [&](size_t worker) {
+                int local = 0;
+                for (size_t i = worker; i < rows.size(); i += num_workers) {
+                    Scalar params[NUM_PARAMETERS], grad[NUM_PARAMETERS] = {};
+                    for (size_t k = 0; k < NUM_PARAMETERS; ++k) params[k] = shared[k].load(memory_order_relaxed);
+                    local += example_gradient(params, data[rows[i]], grad);
+                    for (size_t k = 0; k < NUM_PARAMETERS; ++k) {
+                        shared[k].store(shared[k].load(memory_order_relaxed) + learningRate * grad[k],
+                                        memory_order_relaxed);
+                    }
+                }
+                missed[worker] = local;
+            });
+            misclassified = 0;
+            for (int count : missed) misclassified += count;
+        }
+
+        Scalar final_params[NUM_PARAMETERS];
+        for (size_t k = 0; k < NUM_PARAMETERS; ++k) final_params[k] = shared[k].load(memory_order_relaxed);
+        set_parameters(final_params);
+        return misclassified;
+    }
+
+    /**
+     * @brief Synchronous data-parallel training: each step averages the gradients of all workers
+     * 
+     * A step covers num_workers * batch_per_worker rows. Every worker sums the
+     * gradients of its share into its own cache-line-aligned buffer, using a
+     * snapshot of the weights. The buffers are then reduced pairwise in a tree
+     * (log2(num_workers) rounds, the additions of each round in parallel) and the
+     * weights move once by the learning rate times the average. This is
+     * mini-batch descent with batch size num_workers * batch_per_worker, and the
+     * result does not depend on thread timing.
+     * 
+     * @param data Full dataset
+     * @param rows Indices of the training examples, in training order
+     * @param epochs Number of passes over `rows`
+     * @param batch_per_worker Rows per worker and step
+     * @param num_workers Workers per step (tasks on `scheduler`)
+     * @param scheduler Scheduler that runs the workers
+     * @return Misclassified examples in the last epoch
+     */
+    int train_synchronous(const vector<Example>& data, const vector<size_t>& rows, int epochs, size_t batch_per_worker,
+                          size_t num_workers, TaskScheduler& scheduler) {
+        struct alignas(64) Gradient {
+            Scalar values[NUM_PARAMETERS];
+            int misclassified;
+        };
+        if (num_workers == 0 || batch_per_worker == 0) return 0;
+        vector<Gradient> gradients(num_workers);
+        const size_t step_rows = num_workers * batch_per_worker;
+        Scalar params[NUM_PARAMETERS];
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t start = 0; start < rows.size(); start += step_rows) {
+                const size_t count = min(step_rows, rows.size() - start);
+                get_parameters(params);
+                scheduler.parallel_for(0, num_workers, [&](size_t worker) {
+                    Gradient& gradient = gradients[worker];
+                    fill(gradient.values, gradient.values + NUM_PARAMETERS, Scalar(0));
+                    gradient.misclassified = 0;
+                    const size_t end = start + min(count, (worker + 1) * batch_per_worker);
+                    for (size_t r = start + min(count, worker * batch_per_worker); r < end; ++r) {
+                        gradient.misclassified += example_gradient(params, data[rows[r]], gradient.values);
+                    }
+                });
+
+                // Tree reduction into gradients[0]
+                for (size_t stride = 1; stride < num_workers; stride *= 2) {
+                    scheduler.parallel_for(0, (num_workers + 2 * stride - 1) / (2 * stride), [&](size_t pair) {
+                        const size_t into = pair * 2 * stride, from = into + stride;
+                        if (from >= num_workers) return;
+                        for (size_t k = 0; k < NUM_PARAMETERS; ++k) gradients[into].values[k] += gradients[from].values[k];
+                        gradients[into].misclassified += gradients[from].misclassified;
+                    });
+                }
+
+                const Scalar step = learningRate / count;
+                for (size_t k = 0; k < NUM_PARAMETERS; ++k) params[k] += step * gradients[0].values[k];
+                set_parameters(params);
+                misclassified += gradients[0].misclassified;
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Convergence-aware training over the examples `data[train_rows[i]]`
+     * 
+     * Each epoch runs with the rate options.schedule gives for it (the constructor's
+     * learning rate is the base rate). Every batch of options.batch_size rows is
+     * reduced to its average descent direction with example_gradient and applied
+     * by the chosen optimiser (SGD, momentum or Adam, see training.h). After each
+     * epoch:
+     * - the loss on `validation_rows` is measured with evaluate(), and training
+     *   stops once it has not improved for options.patience epochs; the weights
+     *   of the best epoch are kept;
+     * - if options.checkpoint names a file, the whole state (weights, best
+     *   weights, optimiser moments, early-stopping counters) is saved to it.
+     * 
+     * With options.resume set and the checkpoint file present, the run continues
+     * from it and finishes exactly as the uninterrupted run would have. The
+     * checkpoint carries a fingerprint of the options (see run_fingerprint) and
+     * of the training and validation examples; if it does not match this call,
+     * the run starts over and says so on cerr. Prints nothing otherwise.
+     * 
+     * Example:
+     *   TrainingOptions options;
+     *   options.schedule = LearningRateSchedule::cosine(40);
+     *   options.optimizer.kind = OptimizerKind::Adam;
+     *   options.patience = 3;
+     *   TrainingReport report = nn.fit(data, fold.train, validation, options);
+     * 
+     * @param data Full dataset
+     * @param train_rows Indices of the training examples, in training order
+     * @param validation_rows Indices of the validation examples (empty: no early stopping)
+     * @param options Epochs, batch size, schedule, optimiser, patience, checkpoint file and resume flag
+     * @return TrainingReport Epochs run, best epoch and its validation loss
+     */
+    TrainingReport fit(const vector<Example>& data, const vector<size_t>& train_rows,
+                       const vector<size_t>& validation_rows, const TrainingOptions& options) {
+        Scalar params[NUM_PARAMETERS], best[NUM_PARAMETERS];
+        get_parameters(params);
+        copy(params, params + NUM_PARAMETERS, best);
+        Optimizer optimizer(options.optimizer, NUM_PARAMETERS);
+        EarlyStopping stopping;
+        stopping.patience = options.patience;
+        stopping.min_delta = options.min_delta;
+
+        TrainingReport report;
+        TrainingCheckpoint checkpoint;
+        uint64_t fingerprint = 0;
+        if (!options.checkpoint.empty()) {
+            fingerprint = fingerprint_value(run_fingerprint(options, learningRate), static_cast<uint32_t>(sizeof(Scalar)));
+            for (const vector<size_t>* rows : {&train_rows, &validation_rows}) {
+                fingerprint = fingerprint_value(fingerprint, static_cast<uint64_t>(rows->size()));
+                for (size_t row : *rows) {
+                    const Example& example = data[row];
+                    fingerprint = fingerprint_bytes(fingerprint, example.features.data(),
+                                                    example.features.size() * sizeof(double));
+                    fingerprint = fingerprint_value(fingerprint, example.label);
+                }
+            }
+        }
+        if (options.resume && !options.checkpoint.empty() && load_checkpoint(options.checkpoint, checkpoint) &&
+            checkpoint.parameters.size() == NUM_PARAMETERS && checkpoint.best_parameters.size() == NUM_PARAMETERS) {
+            if (checkpoint.fingerprint != fingerprint) {
+                cerr << "Checkpoint " << options.checkpoint << " was written by a different configuration or data; "
+                     << "starting over" << endl;
+            } else if (optimizer.restore(checkpoint.optimizer_steps, checkpoint.first_moment,
+                                         checkpoint.second_moment)) {
+                copy(checkpoint.parameters.begin(), checkpoint.parameters.end(), params);
+                copy(checkpoint.best_parameters.begin(), checkpoint.best_parameters.end(), best);
+                stopping.best_loss = checkpoint.best_loss;
+                stopping.best_epoch = checkpoint.best_epoch;
+                stopping.stale_epochs = checkpoint.stale_epochs;
+                report.resumed_from = report.epochs_run = checkpoint.epoch;
+            }
+        }
+
+        const size_t batch_size = max<size_t>(1, options.batch_size);
+        for (int epoch = report.epochs_run; epoch < options.max_epochs && !stopping.should_stop(); ++epoch) {
+            const double rate = options.schedule.rate(learningRate, epoch);
+            for (size_t start = 0; start < train_rows.size(); start += batch_size) {
+                const size_t count = min(batch_size, train_rows.size() - start);
+                Scalar direction[NUM_PARAMETERS] = {};
+                for (size_t r = start; r < start + count; ++r) example_gradient(params, data[train_rows[r]], direction);
+                for (Scalar& d : direction) d /= count;
+                optimizer.step(params, direction, rate);
+            }
+            report.epochs_run = epoch + 1;
+
+            if (!validation_rows.empty()) {
+                set_parameters(params);
+                if (stopping.update(evaluate(data, validation_rows).loss, epoch + 1)) {
+                    copy(params, params + NUM_PARAMETERS, best);
+                }
+            }
+            if (!options.checkpoint.empty()) {
+                checkpoint.epoch = epoch + 1;
+                checkpoint.parameters.assign(params, params + NUM_PARAMETERS);
+                checkpoint.best_parameters.assign(best, best + NUM_PARAMETERS);
+                checkpoint.first_moment = optimizer.first_moment();
+                checkpoint.second_moment = optimizer.second_moment();
+                checkpoint.optimizer_steps = optimizer.steps();
+                checkpoint.best_loss = stopping.best_loss;
+                checkpoint.best_epoch = stopping.best_epoch;
+                checkpoint.stale_epochs = stopping.stale_epochs;
+                checkpoint.fingerprint = fingerprint;
+                save_checkpoint(checkpoint, options.checkpoint);
+            }
+        }
+
+        set_parameters(validation_rows.empty() ? params : best);
+        report.best_epoch = validation_rows.empty() ? report.epochs_run : stopping.best_epoch;
+        report.best_loss = stopping.best_loss;
+        report.stopped_early = stopping.should_stop() && report.epochs_run < options.max_epochs;
+        return report;
+    }
+
+    /**
+     * @brief Saves the weights as a binary checkpoint (see save_checkpoint in training.h)
+     */
+    bool save_weights(const string& filename) const {
+        TrainingCheckpoint checkpoint;
+        Scalar params[NUM_PARAMETERS];
+        get_parameters(params);
+        checkpoint.parameters.assign(params, params + NUM_PARAMETERS);
+        checkpoint.best_parameters = checkpoint.parameters;
+        return save_checkpoint(checkpoint, filename);
+    }
+
+    /**
+     * @brief Loads weights saved by save_weights or by fit(); false (weights unchanged) if the file does not fit
+     */
+    bool load_weights(const string& filename) {
+        TrainingCheckpoint checkpoint;
+        if (!load_checkpoint(filename, checkpoint) || checkpoint.parameters.size() != NUM_PARAMETERS) return false;
+        Scalar params[NUM_PARAMETERS];
+        copy(checkpoint.parameters.begin(), checkpoint.parameters.end(), params);
+        set_parameters(params);
+        return true;
+    }
+
+    /**
+     * @brief Scores a contiguous float32 feature matrix in one call
+     * 
+     * Rows are converted to Scalar in chunks of 256 and run through the gemm
+     * forward pass of the mini-batch mode, so no Example is built per row.
+     * 
+     * @param features Row-major `rows` x 4 matrix
+     * @param rows Number of rows
+     * @param scores Output probability of label 1 for each row
+     */
+    void predict_batch(const float* features, size_t rows, float* scores) const {
+        FAI_SCOPED_TIMER("pa5::NeuralNetwork::predict_batch");
+        const size_t chunk = 256;
+        vector<Scalar> inputs(chunk * 4), hidden(chunk * 2), output(chunk);
+        for (size_t start = 0; start < rows; start += chunk) {
+            const size_t count = min(chunk, rows - start);
+            copy(features + start * 4, features + (start + count) * 4, inputs.begin());
+            forward_matrix(inputs.data(), count, hidden.data(), output.data());
+            copy(output.begin(), output.begin() + count, scores + start);
+        }
+    }
+
+    /**
+     * @brief Loss, accuracy, confusion matrix and AUC of the examples `data[rows[i]]` in one pass
+     * 
+     * Replaces calling test() and calculate_accuracy() on the same set (two full
+     * forward sweeps). Rows are scored in batches of 256 through the gemm forward
+     * pass with the weights fixed, so unlike the running count printed by train()
+     * the numbers describe one set of weights. With a scheduler, the shards are
+     * scored in parallel (see evaluate_binary).
+     * 
+     * @param data Full dataset
+     * @param rows Indices of the examples to evaluate
+     * @param scheduler Scheduler for the shards, or nullptr to run them inline
+     * @param num_shards Number of shards
+     * @return BinaryMetrics The metrics of the evaluated rows
+     */
+    BinaryMetrics evaluate(const vector<Example>& data, const vector<size_t>& rows, TaskScheduler* scheduler = nullptr,
+                           size_t num_shards = 1) const {
+        return evaluate_binary(rows.size(), num_shards, scheduler,
+            [&](size_t begin, size_t end, double* scores, int* labels) {
+                const size_t chunk = 256;
+                vector<Scalar> inputs(chunk * 4), hidden(chunk * 2), output(chunk);
+                for (size_t start = begin; start < end; start += chunk) {
+                    const size_t count = min(chunk, end - start);
+                    for (size_t r = 0; r < count; ++r) {
+                        const Example& example = data[rows[start + r]];
+                        copy(example.features.begin(), example.features.begin() + 4, inputs.begin() + 4 * r);
+                        labels[start - begin + r] = example.label;
+                    }
+                    forward_matrix(inputs.data(), count, hidden.data(), output.data());
+                    copy(output.begin(), output.begin() + count, scores + (start - begin));
+                }
+            });
+    }
+
+    /**
+     * @brief evaluate() over the rows `rows` of a column Dataset
+     */
+    BinaryMetrics evaluate(const Dataset& data, const vector<size_t>& rows, TaskScheduler* scheduler = nullptr,
+                           size_t num_shards = 1) const {
+        return evaluate_binary(rows.size(), num_shards, scheduler,
+            [&](size_t begin, size_t end, double* scores, int* labels) {
+                const size_t chunk = 256;
+                vector<Scalar> inputs(chunk * 4), hidden(chunk * 2), output(chunk);
+                for (size_t start = begin; start < end; start += chunk) {
+                    const size_t count = min(chunk, end - start);
+                    data.gather(&rows[start], count, inputs.data());
+                    for (size_t r = 0; r < count; ++r) labels[start - begin + r] = data.label(rows[start + r]);
+                    forward_matrix(inputs.data(), count, hidden.data(), output.data());
+                    copy(output.begin(), output.begin() + count, scores + (start - begin));
+                }
+            });
+    }
+
+    /**
+     * @brief evaluate() over every example of `data`
+     */
+    BinaryMetrics evaluate(const vector<Example>& data, TaskScheduler* scheduler = nullptr, size_t num_shards = 1) const {
+        vector<size_t> rows(data.size());
+        for (size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+        return evaluate(data, rows, scheduler, num_shards);
+    }
+
+    /**
+     * @brief Test the neural network on a test dataset
+     * 
+     * Computes the number of misclassified examples for evaluating the network's performance.
+     * 
+     * @param test_data Testing dataset of examples
+     * @return Number of misclassified examples in the test dataset
+     */
+    int test(const vector<Example>& test_data) {
+        int misclassified = 0;
+        for (const auto& example : test_data) {
+            Scalar hiddenLayer[2];
+            Scalar output = forward(example, hiddenLayer);
+            if ((output >= Scalar(0.5)) != example.label) {
+                misclassified++;
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Calculate accuracy on the test dataset
+     * 
+     * Computes accuracy as the percentage of correctly classified examples.
+     * 
+     * @param test_data Testing dataset of examples
+     * @return Accuracy as a percentage of correct predictions
+     */
+    double calculate_accuracy(const vector<Example>& test_data) {
+        int correct = 0;
+        for (const auto& example : test_data) {
+            Scalar hiddenLayer[2];
+            Scalar output = forward(example, hiddenLayer);
+            if ((output >= Scalar(0.5)) == example.label) {
+                correct++;
+            }
+        }
+        return static_cast<double>(correct) / test_data.size();
+    }
+
+    /**
+     * @brief Accuracy on the examples `data[rows[i]]`
+     */
+    double calculate_accuracy(const vector<Example>& data, const vector<size_t>& rows) {
+        int correct = 0;
+        for (size_t row : rows) {
+            Scalar hiddenLayer[2];
+            Scalar output = forward(data[row], hiddenLayer);
+            if ((output >= Scalar(0.5)) == data[row].label) {
+                correct++;
+            }
+        }
+        return static_cast<double>(correct) / rows.size();
+    }
+};
+
+/**
+ * @brief Predicted label of a network output: output >= 0.5 for one unit, else the largest unit
+ */
+inline int output_label(const double* output, size_t num_outputs) {
+    if (num_outputs == 1) return output[0] >= 0.5 ? 1 : 0;
+    return static_cast<int>(max_element(output, output + num_outputs) - output);
+}
+
+/**
+ * @brief Training target of a label: the label itself for one output unit, one-hot otherwise
+ */
+inline void label_target(int label, double* target, size_t num_outputs) {
+    if (num_outputs == 1) {
+        target[0] = label;
+        return;
+    }
+    for (size_t o = 0; o < num_outputs; ++o) target[o] = static_cast<int>(o) == label ? 1.0 : 0.0;
+}
+
+class QuantizedNetwork;
+
+/**
+ * @class LayerStack
+ * @brief A fully connected sigmoid network of any depth and width, sized at run time.
+ *
+ * `sizes` lists the width of every layer, inputs first: {4, 2, 1} is the network
+ * of NeuralNetwork, and {25, 16, 8, 1} a two-hidden-layer flow classifier. With
+ * one output unit the prediction is label 1 when the output is at least 0.5; with
+ * several, it is the index of the largest output (trained on one-hot targets).
+ *
+ * Training is mini-batch gradient descent on a row-major batch matrix, where each
+ * layer's forward pass, error propagation and weight update is one gemm call.
+ * With a batch size of 1 it is exactly the per-example SGD of NeuralNetwork.
+ */
+class LayerStack {
+private:
+    friend class QuantizedNetwork;
+
+    struct Layer {
+        size_t inputs, outputs;
+        vector<double> weights; // inputs x outputs, row-major
+        vector<double> bias;
+    };
+
+    vector<Layer> layers;
+    double learningRate;
+
+    // Per-layer batch activations and deltas (rows x layer width), reused from batch to batch
+    vector<vector<double>> activations, deltas;
+
+    ActivationPrecision activationPrecision = ActivationPrecision::Exact;
+
+    /**
+     * @brief Runs a batch forward into `outputs` (one matrix per layer); outputs.back() then holds the outputs
+     */
+    void forward_batch(const double* inputs, size_t rows, vector<vector<double>>& outputs) const {
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const Layer& layer = layers[l];
+            vector<double>& out = outputs[l];
+            out.resize(rows * layer.outputs);
+            for (size_t r = 0; r < rows; ++r) copy(layer.bias.begin(), layer.bias.end(), out.begin() + r * layer.outputs);
+            const double* in = l == 0 ? inputs : outputs[l - 1].data();
+            gemm(false, false, rows, layer.outputs, layer.inputs, 1.0, in, layer.inputs, layer.weights.data(),
+                 layer.outputs, 1.0, out.data(), layer.outputs);
+            sigmoid_array(out.data(), out.data(), out.size(), activationPrecision);
+        }
+    }
+
+    /**
+     * @brief Runs a batch forward; activations.back() then holds the outputs
+     */
+    void forward_batch(const double* inputs, size_t rows) { forward_batch(inputs, rows, activations); }
+
+public:
+    /**
+     * @brief Builds the layers with small random weights and biases
+     * 
+     * Every weight and bias is drawn uniformly from [-0.05, 0.05], layer by layer
+     * (weights row-major, then biases), from a generator seeded with `seed`.
+     * 
+     * @param sizes Width of each layer, inputs first (at least two entries)
+     * @param lr Learning rate
+     * @param seed Seed of the initial weights
+     */
+    LayerStack(const vector<size_t>& sizes, double lr, uint32_t seed = 42) : learningRate(lr) {
+        mt19937 rng(seed);
+        uniform_real_distribution<double> initial(-0.05, 0.05);
+        for (size_t l = 0; l + 1 < sizes.size(); ++l) {
+            Layer layer{sizes[l], sizes[l + 1], vector<double>(sizes[l] * sizes[l + 1]), vector<double>(sizes[l + 1])};
+            for (double& weight : layer.weights) weight = initial(rng);
+            for (double& bias : layer.bias) bias = initial(rng);
+            layers.push_back(layer);
+        }
+        activations.resize(layers.size());
+        deltas.resize(layers.size());
+    }
+
+    /**
+     * @brief Selects the sigmoid approximation of every layer (see fast_math.h)
+     */
+    void set_activation_precision(ActivationPrecision precision) {
+        activationPrecision = precision;
+    }
+
+    size_t num_inputs() const { return layers.empty() ? 0 : layers.front().inputs; }
+    size_t num_outputs() const { return layers.empty() ? 0 : layers.back().outputs; }
+
+    /**
+     * @brief Number of trainable weights and biases
+     */
+    size_t num_parameters() const {
+        size_t total = 0;
+        for (const auto& layer : layers) total += layer.weights.size() + layer.bias.size();
+        return total;
+    }
+
+    /**
+     * @brief One gradient descent step on a row-major `rows` x num_inputs() batch
+     * 
+     * For layers l = L..1 with inputs A(l-1), outputs A(l) and weights W(l):
+     * - Output delta: D(L) = (T - A(L)) * A(L) * (1 - A(L)), T the targets of `labels`
+     * - Hidden delta: D(l-1) = (D(l) * W(l)^T) * A(l-1) * (1 - A(l-1)), with W(l) not yet updated
+     * - Update:       W(l) += step * A(l-1)^T * D(l), with step = learningRate / rows
+     * 
+     * @param inputs Row-major batch matrix
+     * @param labels Label of each row
+     * @param rows Number of examples in the batch
+     * @return Number of examples misclassified before the step
+     */
+    int train_matrix(const double* inputs, const int* labels, size_t rows) {
+        if (rows == 0 || layers.empty()) return 0;
+        forward_batch(inputs, rows);
+
+        const size_t num_out = num_outputs();
+        const vector<double>& output = activations.back();
+        vector<double>& top = deltas.back();
+        top.resize(rows * num_out);
+        int misclassified = 0;
+        vector<double> target(num_out);
+        double* t = target.data();
+        for (size_t r = 0; r < rows; ++r) {
+            const double* y = &output[r * num_out];
+            if (output_label(y, num_out) != labels[r]) misclassified++;
+            label_target(labels[r], t, num_out);
+            for (size_t o = 0; o < num_out; ++o) top[r * num_out + o] = (t[o] - y[o]) * y[o] * (1 - y[o]);
+        }
+
+        const double step = learningRate / rows;
+        for (size_t l = layers.size(); l-- > 0;) {
+            Layer& layer = layers[l];
+            const double* in = l == 0 ? inputs : activations[l - 1].data();
+            const double* delta = deltas[l].data();
+            if (l > 0) {
+                vector<double>& below = deltas[l - 1];
+                below.resize(rows * layer.inputs);
+                gemm(false, true, rows, layer.inputs, layer.outputs, 1.0, delta, layer.outputs, layer.weights.data(),
+                     layer.outputs, 0.0, below.data(), layer.inputs);
+                for (size_t i = 0; i < below.size(); ++i) below[i] *= in[i] * (1 - in[i]);
+            }
+            gemm(true, false, layer.inputs, layer.outputs, rows, step, in, layer.inputs, delta, layer.outputs, 1.0,
+                 layer.weights.data(), layer.outputs);
+            for (size_t r = 0; r < rows; ++r) {
+                for (size_t o = 0; o < layer.outputs; ++o) layer.bias[o] += step * delta[r * layer.outputs + o];
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Mini-batch training over the examples `data[rows[i]]`
+     * 
+     * @param data Full dataset (each example has at least num_inputs() features)
+     * @param rows Indices of the training examples, in training order
+     * @param epochs Number of passes over `rows`
+     * @param batch_size Examples per gradient step (1 gives per-example SGD)
+     * @return Misclassified examples in the last epoch
+     */
+    int train(const vector<Example>& data, const vector<size_t>& rows, int epochs, size_t batch_size) {
+        if (batch_size == 0) return 0;
+        const size_t num_in = num_inputs();
+        vector<double> inputs(batch_size * num_in);
+        vector<int> labels(batch_size);
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t start = 0; start < rows.size(); start += batch_size) {
+                const size_t count = min(batch_size, rows.size() - start);
+                for (size_t r = 0; r < count; ++r) {
+                    const Example& example = data[rows[start + r]];
+                    copy(example.features.begin(), example.features.begin() + num_in, inputs.begin() + r * num_in);
+                    labels[r] = example.label;
+                }
+                misclassified += train_matrix(inputs.data(), labels.data(), count);
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Mini-batch training over the rows `rows` of a column Dataset
+     * 
+     * Same as train() above, with each batch gathered from the dataset's float32
+     * columns; the dataset has num_inputs() features and labels as in label_target.
+     */
+    int train(const Dataset& data, const vector<size_t>& rows, int epochs, size_t batch_size) {
+        if (batch_size == 0) return 0;
+        vector<double> inputs(batch_size * num_inputs());
+        vector<int> labels(batch_size);
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t start = 0; start < rows.size(); start += batch_size) {
+                const size_t count = min(batch_size, rows.size() - start);
+                data.gather(&rows[start], count, inputs.data());
+                for (size_t r = 0; r < count; ++r) labels[r] = data.label(rows[start + r]);
+                misclassified += train_matrix(inputs.data(), labels.data(), count);
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Predicted label of one example
+     */
+    int predict(const Example& example) {
+        forward_batch(example.features.data(), 1);
+        return output_label(activations.back().data(), num_outputs());
+    }
+
+    /**
+     * @brief Scores a contiguous float32 feature matrix in one call
+     * 
+     * Activations go to buffers local to the call, so the training state is left
+     * alone and several threads may score with one network at once.
+     * 
+     * @param features Row-major `rows` x num_inputs() matrix
+     * @param rows Number of rows
+     * @param scores Output rows x num_outputs() matrix of output activations
+     */
+    void predict_batch(const float* features, size_t rows, float* scores) const {
+        const size_t num_in = num_inputs(), num_out = num_outputs(), chunk = 256;
+        vector<double> inputs(chunk * num_in);
+        vector<vector<double>> outputs(layers.size());
+        for (size_t start = 0; start < rows; start += chunk) {
+            const size_t count = min(chunk, rows - start);
+            copy(features + start * num_in, features + (start + count) * num_in, inputs.begin());
+            forward_batch(inputs.data(), count, outputs);
+            copy(outputs.back().begin(), outputs.back().begin() + count * num_out, scores + start * num_out);
+        }
+    }
+
+    /**
+     * @brief Accuracy on the examples `data[rows[i]]`, evaluated in batches of 256
+     */
+    double calculate_accuracy(const vector<Example>& data, const vector<size_t>& rows) {
+        const size_t num_in = num_inputs(), num_out = num_outputs(), batch_size = 256;
+        vector<double> inputs(batch_size * num_in);
+        int correct = 0;
+        for (size_t start = 0; start < rows.size(); start += batch_size) {
+            const size_t count = min(batch_size, rows.size() - start);
+            for (size_t r = 0; r < count; ++r) {
+                const Example& example = data[rows[start + r]];
+                copy(example.features.begin(), example.features.begin() + num_in, inputs.begin() + r * num_in);
+            }
+            forward_batch(inputs.data(), count);
+            for (size_t r = 0; r < count; ++r) {
+                if (output_label(&activations.back()[r * num_out], num_out) == data[rows[start + r]].label) correct++;
+            }
+        }
+        return static_cast<double>(correct) / rows.size();
+    }
+
+    /**
+     * @brief Accuracy on the rows `rows` of a column Dataset, evaluated in batches of 256
+     */
+    double calculate_accuracy(const Dataset& data, const vector<size_t>& rows) {
+        const size_t num_out = num_outputs(), batch_size = 256;
+        vector<double> inputs(batch_size * num_inputs());
+        int correct = 0;
+        for (size_t start = 0; start < rows.size(); start += batch_size) {
+            const size_t count = min(batch_size, rows.size() - start);
+            data.gather(&rows[start], count, inputs.data());
+            forward_batch(inputs.data(), count);
+            for (size_t r = 0; r < count; ++r) {
+                if (output_label(&activations.back()[r * num_out], num_out) == data.label(rows[start + r])) correct++;
+            }
+        }
+        return static_cast<double>(correct) / rows.size();
+    }
+};
+
+/**
+ * @struct FixedLayer
+ * @brief A sigmoid layer whose dimensions are compile-time constants.
+ *
+ * The weights are plain arrays and every loop has a constant trip count, so for
+ * small layers the compiler unrolls the loops and keeps the activations in
+ * registers; nothing is allocated.
+ */
+template <size_t In, size_t Out>
+struct FixedLayer {
+    double weights[In][Out];
+    double bias[Out];
+
+    /**
+     * @brief y = sigmoid(x * W + b)
+     */
+    void forward(const double* x, double* y) const {
+        for (size_t o = 0; o < Out; ++o) y[o] = bias[o];
+        for (size_t i = 0; i < In; ++i) {
+            for (size_t o = 0; o < Out; ++o) y[o] += x[i] * weights[i][o];
+        }
+        for (size_t o = 0; o < Out; ++o) y[o] = 1.0 / (1.0 + exp(-y[o]));
+    }
+
+    /**
+     * @brief Writes the error reaching the inputs (W * delta, if `error` is set), then updates W and b
+     */
+    void backward(const double* x, const double* delta, double rate, double* error) {
+        if (error) {
+            for (size_t i = 0; i < In; ++i) {
+                error[i] = 0.0;
+                for (size_t o = 0; o < Out; ++o) error[i] += weights[i][o] * delta[o];
+            }
+        }
+        for (size_t i = 0; i < In; ++i) {
+            for (size_t o = 0; o < Out; ++o) weights[i][o] += rate * x[i] * delta[o];
+        }
+        for (size_t o = 0; o < Out; ++o) bias[o] += rate * delta[o];
+    }
+
+    template <typename Rng>
+    void init(Rng& rng) {
+        uniform_real_distribution<double> initial(-0.05, 0.05);
+        for (auto& row : weights)
+            for (double& weight : row) weight = initial(rng);
+        for (double& b : bias) b = initial(rng);
+    }
+};
+
+/**
+ * @struct FixedStack
+ * @brief The layers In -> Out -> Rest... as nested FixedLayers; the activations live on the stack.
+ */
+template <size_t In, size_t Out, size_t... Rest>
+struct FixedStack {
+    static constexpr size_t inputs = In;
+    static constexpr size_t outputs = FixedStack<Out, Rest...>::outputs;
+    FixedLayer<In, Out> layer;
+    FixedStack<Out, Rest...> next;
+
+    template <typename Rng>
+    void init(Rng& rng) {
+        layer.init(rng);
+        next.init(rng);
+    }
+
+    void predict(const double* x, double* y) const {
+        double hidden[Out];
+        layer.forward(x, hidden);
+        next.predict(hidden, y);
+    }
+
+    /**
+     * @brief One SGD step: outputs into `y`, and the error reaching the inputs into `error` (may be null)
+     */
+    void train(const double* x, const double* target, double rate, double* y, double* error) {
+        double hidden[Out], delta[Out];
+        layer.forward(x, hidden);
+        next.train(hidden, target, rate, y, delta);
+        for (size_t o = 0; o < Out; ++o) delta[o] *= hidden[o] * (1 - hidden[o]);
+        layer.backward(x, delta, rate, error);
+    }
+};
+
+template <size_t In, size_t Out>
+struct FixedStack<In, Out> {
+    static constexpr size_t inputs = In;
+    static constexpr size_t outputs = Out;
+    FixedLayer<In, Out> layer;
+
+    template <typename Rng>
+    void init(Rng& rng) {
+        layer.init(rng);
+    }
+
+    void predict(const double* x, double* y) const {
+        layer.forward(x, y);
+    }
+
+    void train(const double* x, const double* target, double rate, double* y, double* error) {
+        double delta[Out];
+        layer.forward(x, y);
+        for (size_t o = 0; o < Out; ++o) delta[o] = (target[o] - y[o]) * y[o] * (1 - y[o]);
+        layer.backward(x, delta, rate, error);
+    }
+};
+
+/**
+ * @class FixedNetwork
+ * @brief Compile-time counterpart of LayerStack: FixedNetwork<4, 2, 1> is the NeuralNetwork shape.
+ *
+ * Trains with per-example SGD. For the same sizes and seed it starts from the
+ * same weights as LayerStack and follows LayerStack with a batch size of 1, but
+ * without the run-time loop bounds, heap buffers and gemm calls that dominate
+ * such tiny layers.
+ */
+template <size_t... Sizes>
+class FixedNetwork {
+private:
+    using Stack = FixedStack<Sizes...>;
+    Stack stack;
+    double learningRate;
+
+public:
+    static constexpr size_t num_inputs = Stack::inputs;
+    static constexpr size_t num_outputs = Stack::outputs;
+
+    FixedNetwork(double lr, uint32_t seed = 42) : learningRate(lr) {
+        mt19937 rng(seed);
+        stack.init(rng);
+    }
+
+    /**
+     * @brief Predicted label of one example
+     */
+    int predict(const Example& example) const {
+        double output[num_outputs];
+        stack.predict(example.features.data(), output);
+        return output_label(output, num_outputs);
+    }
+
+    /**
+     * @brief Per-example SGD over the examples `data[rows[i]]`
+     * 
+     * @return Misclassified examples in the last epoch
+     */
+    int train(const vector<Example>& data, const vector<size_t>& rows, int epochs) {
+        int misclassified = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            misclassified = 0;
+            for (size_t row : rows) {
+                double target[num_outputs], output[num_outputs];
+                label_target(data[row].label, target, num_outputs);
+                stack.train(data[row].features.data(), target, learningRate, output, nullptr);
+                if (output_label(output, num_outputs) != data[row].label) misclassified++;
+            }
+        }
+        return misclassified;
+    }
+
+    /**
+     * @brief Accuracy on the examples `data[rows[i]]`
+     */
+    double calculate_accuracy(const vector<Example>& data, const vector<size_t>& rows) const {
+        int correct = 0;
+        for (size_t row : rows) {
+            if (predict(data[row]) == data[row].label) correct++;
+        }
+        return static_cast<double>(correct) / rows.size();
+    }
+};
+
+/**
+ * @brief Packs the features of `data[rows[i]]` into a contiguous row-major float32 matrix
+ */
+inline vector<float> feature_matrix(const vector<Example>& data, const vector<size_t>& rows) {
+    const size_t width = rows.empty() ? 0 : data[rows[0]].features.size();
+    vector<float> matrix(rows.size() * width);
+    for (size_t r = 0; r < rows.size(); ++r) {
+        copy(data[rows[r]].features.begin(), data[rows[r]].features.end(), matrix.begin() + r * width);
+    }
+    return matrix;
+}
+
+/**
+ * @class QuantizedNetwork
+ * @brief Post-training int8 quantisation of a trained LayerStack, for batched scoring.
+ *
+ * Weights are quantised per output unit with symmetric scales (see quantize.h)
+ * and stored transposed, so every unit is one contiguous int8 row. The input of
+ * each layer is quantised with one scale per layer, calibrated by running the
+ * float network over a calibration batch and taking the largest absolute value
+ * each layer receives. A unit's pre-activation is then an exact int32 dot
+ * product, dequantised once and biased in float:
+ *
+ *   z[o] = dot(q_x, q_w[o]) * input_scale * weight_scale[o] + bias[o]
+ *
+ * and the sigmoid output is quantised again for the next layer. Weights take a
+ * byte each instead of eight.
+ *
+ * Example:
+ *   QuantizedNetwork int8_model(model, calibration.data(), 1024);
+ *   int8_model.predict_batch(features.data(), rows, scores.data());
+ */
+class QuantizedNetwork {
+private:
+    struct Layer {
+        size_t inputs, outputs;
+        vector<int8_t> weights;     // outputs x inputs, row per output unit
+        vector<float> weightScales; // per output unit
+        vector<float> bias;
+        float inputScale;           // calibrated scale of this layer's input
+    };
+
+    vector<Layer> layers;
+    ActivationPrecision activationPrecision = ActivationPrecision::Medium;
+
+    // Scratch of one chunk of rows: quantised layer inputs and the float activations of a layer
+    vector<int8_t> quantizedInputs;
+    vector<double> preActivation;
+    vector<float> activation;
+
+public:
+    /**
+     * @brief Quantises `network`, calibrating activation scales on `rows` rows of `calibration`
+     * 
+     * @param network Trained float network
+     * @param calibration Row-major `rows` x num_inputs() float32 matrix of representative inputs
+     * @param rows Number of calibration rows
+     */
+    QuantizedNetwork(const LayerStack& network, const float* calibration, size_t rows) {
+        // Largest absolute input of every layer over the calibration batch, run through
+        // a copy of the float network (forward_batch writes its scratch buffers)
+        const size_t num_in = network.num_inputs(), chunk = 256;
+        vector<float> input_max(network.layers.size(), 0.0f);
+        input_max[0] = max_abs(calibration, rows * num_in);
+        LayerStack float_network = network;
+        vector<double> inputs(chunk * num_in);
+        for (size_t start = 0; start < rows; start += chunk) {
+            const size_t count = min(chunk, rows - start);
+            copy(calibration + start * num_in, calibration + (start + count) * num_in, inputs.begin());
+            float_network.forward_batch(inputs.data(), count);
+            for (size_t l = 1; l < network.layers.size(); ++l) {
+                for (double value : float_network.activations[l - 1]) {
+                    input_max[l] = max(input_max[l], static_cast<float>(fabs(value)));
+                }
+            }
+        }
+
+        for (size_t l = 0; l < network.layers.size(); ++l) {
+            const auto& source = network.layers[l];
+            Layer layer{source.inputs, source.outputs, vector<int8_t>(source.inputs * source.outputs),
+                        vector<float>(source.outputs), vector<float>(source.bias.begin(), source.bias.end()),
+                        symmetric_scale(input_max[l])};
+            vector<float> column(source.inputs);
+            for (size_t o = 0; o < source.outputs; ++o) {
+                for (size_t i = 0; i < source.inputs; ++i) column[i] = static_cast<float>(source.weights[i * source.outputs + o]);
+                layer.weightScales[o] = symmetric_scale(max_abs(column.data(), column.size()));
+                quantize_symmetric(column.data(), column.size(), layer.weightScales[o], &layer.weights[o * source.inputs]);
+            }
+            layers.push_back(layer);
+        }
+    }
+
+    size_t num_inputs() const { return layers.empty() ? 0 : layers.front().inputs; }
+    size_t num_outputs() const { return layers.empty() ? 0 : layers.back().outputs; }
+
+    /**
+     * @brief Scale of the int8 input matrix accepted by predict_batch (see quantize_inputs)
+     */
+    float input_scale() const { return layers.empty() ? 1.0f : layers.front().inputScale; }
+
+    /**
+     * @brief Quantises a float32 feature matrix with the calibrated input scale, for the int8 predict_batch
+     */
+    void quantize_inputs(const float* features, size_t rows, int8_t* out) const {
+        quantize_symmetric(features, rows * num_inputs(), input_scale(), out);
+    }
+
+    /**
+     * @brief Bytes of quantised weights (the float network uses 8 per weight)
+     */
+    size_t weight_bytes() const {
+        size_t total = 0;
+        for (const auto& layer : layers) total += layer.weights.size();
+        return total;
+    }
+
+    /**
+     * @brief Selects the sigmoid approximation (Medium by default: int8 rounding dominates its error)
+     */
+    void set_activation_precision(ActivationPrecision precision) {
+        activationPrecision = precision;
+    }
+
+    /**
+     * @brief Scores a row-major `rows` x num_inputs() int8 matrix, quantised with input_scale()
+     * 
+     * @param features Quantised feature matrix
+     * @param rows Number of rows
+     * @param scores Output rows x num_outputs() matrix of output activations
+     */
+    void predict_batch(const int8_t* features, size_t rows, float* scores) {
+        const size_t chunk = 256;
+        for (size_t start = 0; start < rows; start += chunk) {
+            const size_t count = min(chunk, rows - start);
+            const int8_t* x = features + start * num_inputs();
+            for (size_t l = 0; l < layers.size(); ++l) {
+                const Layer& layer = layers[l];
+                preActivation.resize(count * layer.outputs);
+                for (size_t r = 0; r < count; ++r) {
+                    for (size_t o = 0; o < layer.outputs; ++o) {
+                        int32_t dot = dot_int8(x + r * layer.inputs, &layer.weights[o * layer.inputs], layer.inputs);
+                        preActivation[r * layer.outputs + o] = dot * (layer.inputScale * layer.weightScales[o]) + layer.bias[o];
+                    }
+                }
+                sigmoid_array(preActivation.data(), preActivation.data(), preActivation.size(), activationPrecision);
+
+                if (l + 1 == layers.size()) {
+                    copy(preActivation.begin(), preActivation.end(), scores + start * layer.outputs);
+                } else {
+                    activation.assign(preActivation.begin(), preActivation.end());
+                    quantizedInputs.resize(activation.size());
+                    quantize_symmetric(activation.data(), activation.size(), layers[l + 1].inputScale, quantizedInputs.data());
+                    x = quantizedInputs.data();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Scores a float32 feature matrix: quantises it with input_scale(), then runs the int8 path
+     */
+    void predict_batch(const float* features, size_t rows, float* scores) {
+        vector<int8_t> quantized(rows * num_inputs());
+        quantize_inputs(features, rows, quantized.data());
+        predict_batch(quantized.data(), rows, scores);
+    }
+};
+
+/**
+ * @brief Encodes each value of a column dictionary as 1.0 if it equals `positive`, else 0.0
+ */
+inline vector<double> encode_dictionary(const vector<string>& dictionary, const string& positive) {
+    vector<double> encoded;
+    for (const auto& value : dictionary) encoded.push_back(value == positive ? 1.0 : 0.0);
+    return encoded;
+}
+
+/**
+ * @brief Load data from a CSV file and encode categorical features.
+ * 
+ * Reads CSV data, converts categorical features to numerical values, and creates
+ * examples with features and labels.
+ * 
+ * The file is memory-mapped and dictionary-encoded per column by read_csv_columns.
+ * Each distinct value is then encoded once (e.g., "known" -> 1.0), and rows look
+ * their encoding up by dictionary code instead of comparing strings per cell.
+ * 
+ * @param filename Path to the CSV file (e.g., "dataset.csv")
+ * @return Encoded dataset
+ */
+inline vector<Example> load_data(const string &filename) {
+    CsvColumns columns = read_csv_columns(filename);
+    vector<Example> data(columns.num_rows);
+
+    // Encode each feature as a numeric value (1.0 for specific values, 0.0 otherwise):
+    // Author = "known", Thread = "new", Length = "long", Where_read = "home"
+    for (auto& example : data) example.features.assign(POSITIVE_VALUES.size(), 0.0);
+    for (size_t c = 0; c < POSITIVE_VALUES.size() && c < columns.names.size(); ++c) {
+        vector<double> encoded = encode_dictionary(columns.dictionaries[c], POSITIVE_VALUES[c]);
+        for (size_t row = 0; row < data.size(); ++row) data[row].features[c] = encoded[columns.codes[c][row]];
+    }
+
+    // User_action: 1 for "reads", 0 otherwise
+    const size_t label_column = POSITIVE_VALUES.size();
+    for (size_t row = 0; row < data.size(); ++row) {
+        data[row].label = label_column < columns.names.size() && columns.value(label_column, row) == POSITIVE_LABEL ? 1 : 0;
+    }
+    return data;
+}
+
+/**
+ * @brief log(1 + x) of every value, with negatives read as 0
+ */
+inline vector<double> log_compressed(const vector<double>& values) {
+    vector<double> compressed(values.size());
+    for (size_t row = 0; row < values.size(); ++row) compressed[row] = log1p(max(values[row], 0.0));
+    return compressed;
+}
+
+/**
+ * @brief Largest value of each feature over the given rows (0 for a feature that is never positive)
+ * 
+ * Taken over the training rows only, so that nothing about the test rows leaks
+ * into the inputs; scale_features then applies it to every split.
+ */
+inline vector<double> feature_maxima(const vector<Example>& data, const vector<size_t>& rows) {
+    vector<double> maxima(data.empty() ? 0 : data[0].features.size(), 0.0);
+    for (size_t row : rows) {
+        for (size_t f = 0; f < maxima.size(); ++f) maxima[f] = max(maxima[f], data[row].features[f]);
+    }
+    return maxima;
+}
+
+/**
+ * @brief Same maxima over every example, for a training set that is already a copy
+ */
+inline vector<double> feature_maxima(const vector<Example>& data) {
+    vector<double> maxima(data.empty() ? 0 : data[0].features.size(), 0.0);
+    for (const auto& example : data) {
+        for (size_t f = 0; f < maxima.size(); ++f) maxima[f] = max(maxima[f], example.features[f]);
+    }
+    return maxima;
+}
+
+/**
+ * @brief Same maxima for a column Dataset
+ */
+inline vector<double> feature_maxima(const Dataset& data, const vector<size_t>& rows) {
+    vector<double> maxima(data.num_features(), 0.0);
+    for (size_t f = 0; f < maxima.size(); ++f) {
+        const float* values = data.column(f);
+        for (size_t row : rows) maxima[f] = max(maxima[f], static_cast<double>(values[row]));
+    }
+    return maxima;
+}
+
+/**
+ * @brief Divides each feature by its maximum from feature_maxima (features with a 0 maximum are left as they are)
+ * 
+ * Training rows then lie in [0, 1]; a held-out row above the training maximum
+ * keeps its larger value rather than being clipped.
+ */
+inline void scale_features(vector<Example>& data, const vector<double>& maxima) {
+    for (auto& example : data) {
+        for (size_t f = 0; f < maxima.size(); ++f) {
+            if (maxima[f] > 0) example.features[f] /= maxima[f];
+        }
+    }
+}
+
+/**
+ * @brief Same scaling for a column Dataset
+ */
+inline void scale_features(Dataset& data, const vector<double>& maxima) {
+    for (size_t f = 0; f < maxima.size(); ++f) {
+        if (maxima[f] <= 0) continue;
+        const float scale = static_cast<float>(1.0 / maxima[f]);
+        float* values = data.column(f);
+        for (size_t row = 0; row < data.num_rows(); ++row) values[row] *= scale;
+    }
+}
+
+/**
+ * @brief Load netflow records from one of the final project's Parquet captures.
+ * 
+ * The four inputs are the flow's dur, tot_pkts, tot_bytes and src_bytes, read
+ * natively by read_parquet_columns. Each is compressed with log(1 + x) but not
+ * yet scaled: once the rows are split, divide every split by the training rows'
+ * feature_maxima (see scale_features). The label is 1 for botnet flows
+ * ("flow=From-Botnet-...") and 0 for everything else.
+ * 
+ * @param filename Path to a .binetflow.parquet file
+ * @return Encoded dataset, or an empty one if the file cannot be read
+ */
+inline vector<Example> load_flow_data(const string &filename) {
+    const vector<string> inputs = {"dur", "tot_pkts", "tot_bytes", "src_bytes"};
+    vector<string> wanted = inputs;
+    wanted.push_back("label");
+    string error;
+    CsvColumns columns = read_parquet_columns(filename, wanted, nullptr, &error);
+    if (!error.empty()) cerr << error << endl;
+    vector<Example> data(columns.num_rows);
+    if (data.empty()) return data;
+
+    for (auto& example : data) example.features.assign(inputs.size(), 0.0);
+    for (size_t c = 0; c < inputs.size(); ++c) {
+        vector<double> compressed = log_compressed(columns.numbers[c]);
+        for (size_t row = 0; row < data.size(); ++row) data[row].features[c] = compressed[row];
+    }
+
+    const size_t label_column = inputs.size();
+    vector<int> botnet;
+    for (const auto& value : columns.dictionaries[label_column]) botnet.push_back(value.find("Botnet") != string::npos);
+    for (size_t row = 0; row < data.size(); ++row) data[row].label = botnet[columns.codes[label_column][row]];
+    return data;
+}
+
+/**
+ * @brief Load the same flows as load_flow_data into a float32 column Dataset.
+ * 
+ * The features are the four log-compressed inputs of load_flow_data, narrowed
+ * to float32 and likewise left for scale_features, and the labels are 1 ("botnet") or 0 ("other"). Learners read it
+ * through index views (see split_data and shuffle_split).
+ * 
+ * @param filename Path to a .binetflow.parquet file
+ * @return Column dataset, or an empty one if the file cannot be read
+ */
+inline Dataset load_flow_dataset(const string &filename) {
+    const vector<string> inputs = {"dur", "tot_pkts", "tot_bytes", "src_bytes"};
+    vector<string> wanted = inputs;
+    wanted.push_back("label");
+    string error;
+    CsvColumns columns = read_parquet_columns(filename, wanted, nullptr, &error);
+    if (!error.empty()) cerr << error << endl;
+    Dataset data(inputs, columns.num_rows);
+    data.set_label_names({"other", "botnet"});
+    if (columns.num_rows == 0) return data;
+
+    for (size_t c = 0; c < inputs.size(); ++c) {
+        vector<double> compressed = log_compressed(columns.numbers[c]);
+        copy(compressed.begin(), compressed.end(), data.column(c));
+    }
+
+    const size_t label_column = inputs.size();
+    vector<int32_t> botnet;
+    for (const auto& value : columns.dictionaries[label_column]) botnet.push_back(value.find("Botnet") != string::npos);
+    for (size_t row = 0; row < data.num_rows(); ++row) data.labels()[row] = botnet[columns.codes[label_column][row]];
+    return data;
+}
+
+// Numeric netflow columns of the wide flow vectors, log-compressed like load_flow_data
+const vector<string> FLOW_NUMERIC_INPUTS = {"dur", "stos", "dtos", "tot_pkts", "tot_bytes", "src_bytes"};
+
+// Categorical netflow columns of the wide flow vectors and how many of their most frequent values get a one-hot input
+const vector<pair<string, size_t>> FLOW_ONE_HOT_INPUTS = {{"proto", 3}, {"dir", 5}, {"state", 8}};
+
+/**
+ * @brief Load netflow records as wide feature vectors for LayerStack / FixedNetwork.
+ * 
+ * Besides the log-compressed numeric columns of FLOW_NUMERIC_INPUTS (to be
+ * scaled by the training rows' feature_maxima, as in load_flow_data), each column of
+ * FLOW_ONE_HOT_INPUTS is one-hot encoded over its most frequent values in the
+ * capture, plus one shared input for all other values: 6 + 4 + 6 + 9 = 25
+ * inputs. Labels are as in load_flow_data.
+ * 
+ * Example: a UDP flow in state "CON" has 1.0 in the "udp" and "CON" inputs and
+ * 0.0 in the other proto and state inputs.
+ * 
+ * @param filename Path to a .binetflow.parquet file
+ * @return Encoded dataset, or an empty one if the file cannot be read
+ */
+inline vector<Example> load_wide_flow_data(const string &filename) {
+    vector<string> wanted = FLOW_NUMERIC_INPUTS;
+    for (const auto& one_hot : FLOW_ONE_HOT_INPUTS) wanted.push_back(one_hot.first);
+    wanted.push_back("label");
+    string error;
+    CsvColumns columns = read_parquet_columns(filename, wanted, nullptr, &error);
+    if (!error.empty()) cerr << error << endl;
+    vector<Example> data(columns.num_rows);
+    if (data.empty()) return data;
+
+    size_t width = FLOW_NUMERIC_INPUTS.size();
+    for (const auto& one_hot : FLOW_ONE_HOT_INPUTS) width += one_hot.second + 1;
+    for (auto& example : data) example.features.assign(width, 0.0);
+
+    size_t input = 0;
+    for (size_t c = 0; c < FLOW_NUMERIC_INPUTS.size(); ++c, ++input) {
+        vector<double> compressed = log_compressed(columns.numbers[c]);
+        for (size_t row = 0; row < data.size(); ++row) data[row].features[input] = compressed[row];
+    }
+    for (size_t k = 0; k < FLOW_ONE_HOT_INPUTS.size(); ++k) {
+        const size_t c = FLOW_NUMERIC_INPUTS.size() + k, kept = FLOW_ONE_HOT_INPUTS[k].second;
+        const vector<uint32_t>& codes = columns.codes[c];
+
+        // Rank the dictionary by frequency; the top `kept` codes get their own input, the rest share one
+        vector<size_t> counts(columns.dictionaries[c].size(), 0);
+        for (uint32_t code : codes) counts[code]++;
+        vector<uint32_t> by_count(counts.size());
+        for (size_t code = 0; code < by_count.size(); ++code) by_count[code] = static_cast<uint32_t>(code);
+        stable_sort(by_count.begin(), by_count.end(), [&](uint32_t a, uint32_t b) { return counts[a] > counts[b]; });
+        vector<size_t> slot(counts.size(), kept);
+        for (size_t rank = 0; rank < kept && rank < by_count.size(); ++rank) slot[by_count[rank]] = rank;
+
+        for (size_t row = 0; row < data.size(); ++row) data[row].features[input + slot[codes[row]]] = 1.0;
+        input += kept + 1;
+    }
+
+    const size_t label_column = wanted.size() - 1;
+    vector<int> botnet;
+    for (const auto& value : columns.dictionaries[label_column]) botnet.push_back(value.find("Botnet") != string::npos);
+    for (size_t row = 0; row < data.size(); ++row) data[row].label = botnet[columns.codes[label_column][row]];
+    return data;
+}
+
+/**
+ * @brief Trains the network with mini-batch SGD straight from a column file
+ * 
+ * The file is read one row group at a time with for_each_column_group, which
+ * loads the next group in the background while the current one is trained on,
+ * so I/O overlaps with compute and memory stays at two row groups plus one batch
+ * no matter how large the file is. Rows are encoded with the same tables as
+ * load_data (one lookup per cell by dictionary code) straight into one reused
+ * feature matrix and label array, which go to train_matrix in file order; a
+ * batch may span two row groups.
+ * 
+ * @param nn Network to train
+ * @param file An open column file with the columns of dataset.csv
+ * @param epochs Number of passes over the file
+ * @param batch_size Examples per gradient step
+ * @return Misclassified examples in the last epoch
+ */
+template <typename Scalar, typename Storage>
+int train_streaming(NeuralNetwork<Scalar, Storage>& nn, const ColumnFile& file, int epochs, size_t batch_size) {
+    const size_t label_column = POSITIVE_VALUES.size();
+    if (file.num_columns() <= label_column || batch_size == 0) return 0;
+    const size_t width = POSITIVE_VALUES.size();
+    vector<vector<Scalar>> encoded;
+    for (size_t c = 0; c < width; ++c) {
+        vector<double> values = encode_dictionary(file.dictionary(c), POSITIVE_VALUES[c]);
+        encoded.emplace_back(values.begin(), values.end());
+    }
+    vector<double> label_values = encode_dictionary(file.dictionary(label_column), POSITIVE_LABEL);
+    vector<int> labels(label_values.begin(), label_values.end());
+
+    vector<Scalar> inputs(batch_size * width);
+    vector<int> batch_labels(batch_size);
+    int misclassified = 0;
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        misclassified = 0;
+        size_t filled = 0;
+        for_each_column_group(file, {}, [&](const ColumnGroup& group) {
+            for (size_t row = 0; row < group.num_rows; ++row) {
+                Scalar* x = &inputs[filled * width];
+                for (size_t c = 0; c < width; ++c) x[c] = encoded[c][group.codes[c][row]];
+                batch_labels[filled] = labels[group.codes[label_column][row]];
+                if (++filled == batch_size) {
+                    misclassified += nn.train_matrix(inputs.data(), batch_labels.data(), batch_size);
+                    filled = 0;
+                }
+            }
+        });
+        if (filled > 0) misclassified += nn.train_matrix(inputs.data(), batch_labels.data(), filled);
+        cout << "Streaming epoch " << epoch + 1 << ": Misclassified = " << misclassified << "\n";
+    }
+    return misclassified;
+}
+
+/**
+ * @brief Split dataset into training and testing sets based on a specified ratio.
+ * 
+ * Divides the dataset into two parts based on a given training ratio (e.g., 0.8 for 80% train).
+ * 
+ * @param data Full dataset
+ * @param train Vector to store training set examples
+ * @param test Vector to store testing set examples
+ * @param train_ratio Proportion of examples for training (0.8 means 80% train, 20% test)
+ */
+inline void split_data(const vector<Example>& data, vector<Example>& train, vector<Example>& test, float train_ratio) {
+    int train_size = static_cast<int>(data.size() * train_ratio);
+    train.assign(data.begin(), data.begin() + train_size);
+    test.assign(data.begin() + train_size, data.end());
+}
+
+/**
+ * @brief Same split for a column Dataset, as index views instead of copies
+ */
+inline void split_data(const Dataset& data, vector<size_t>& train, vector<size_t>& test, float train_ratio) {
+    vector<size_t> rows = all_rows(data);
+    size_t train_size = static_cast<size_t>(data.num_rows() * train_ratio);
+    train.assign(rows.begin(), rows.begin() + train_size);
+    test.assign(rows.begin() + train_size, rows.end());
+}
+
+} // namespace pa5
+
+#endif // FAI_PA5_NAVEEN_KARASU_H
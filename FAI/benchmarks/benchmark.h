@@ -0,0 +1,250 @@
+#ifndef FAI_BENCHMARKS_BENCHMARK_H
+#define FAI_BENCHMARKS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "profiling.h"
+
+/**
+ * A small microbenchmark harness in the style of Google Benchmark, so the
+ * benchmarks build with nothing but the standard library:
+ *
+ *   void lowest_cost_path_benchmark(fai_benchmark::State& state) {
+ *       auto graph = make_graph(state.size());      // not timed
+ *       for (auto _ : state) {
+ *           fai_benchmark::do_not_optimize(lowest_cost_path(graph, 0, last));
+ *       }
+ *       state.set_items_processed(state.iterations() * num_edges);
+ *   }
+ *
+ *   const bool registered = fai_benchmark::register_benchmarks({
+ *       {"search/lowest_cost_path", lowest_cost_path_benchmark, {1 << 10, 1 << 16}},
+ *   });
+ *
+ * Each benchmark runs once per problem size. The harness repeats the body with
+ * growing iteration counts until one run takes at least the minimum time, then
+ * reports the time per iteration. Results are written as Google Benchmark JSON,
+ * so two runs can be compared with compare_results.py (or Google's compare.py).
+ *
+ * In a FAI_PROFILING build every result also carries the profile counters
+ * (heap_pushes, split_evaluations, ...) per iteration of its final run, set-up
+ * outside the timed loop included.
+ */
+
+namespace fai_benchmark {
+
+/**
+ * @brief Keeps the compiler from optimising away a value the benchmark computes
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @class State
+ * @brief The problem size of one run, its timed loop, and what it reports.
+ */
+class State {
+public:
+    State(size_t size, size_t iterations) : size_(size), iterations_(iterations) {}
+
+    size_t size() const { return size_; }
+    size_t iterations() const { return iterations_; }
+
+    struct __attribute__((unused)) Value {}; // Unused loop variable of `for (auto _ : state)`
+
+    // `for (auto _ : state)` runs the body iterations() times, timing only the loop
+    class Iterator {
+    public:
+        Iterator(State* state, size_t remaining) : state_(state), remaining_(remaining) {}
+        Value operator*() const { return Value(); }
+        Iterator& operator++() {
+            --remaining_;
+            return *this;
+        }
+        bool operator!=(const Iterator&) const {
+            if (remaining_ > 0) return true;
+            state_->pause_timing();
+            return false;
+        }
+
+    private:
+        State* state_;
+        size_t remaining_;
+    };
+
+    Iterator begin() {
+        resume_timing();
+        return Iterator(this, iterations_);
+    }
+    Iterator end() { return Iterator(this, 0); }
+
+    /**
+     * @brief Stops the clocks, e.g. around per-iteration setup inside the loop
+     */
+    void pause_timing() {
+        if (!running_) return;
+        real_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start_).count();
+        cpu_seconds_ += static_cast<double>(std::clock() - cpu_start_) / CLOCKS_PER_SEC;
+        running_ = false;
+    }
+
+    void resume_timing() {
+        if (running_) return;
+        real_start_ = std::chrono::steady_clock::now();
+        cpu_start_ = std::clock();
+        running_ = true;
+    }
+
+    /**
+     * @brief Items (examples, edges, rules, ...) handled over all iterations, reported per second
+     */
+    void set_items_processed(double items) { items_processed_ = items; }
+
+    /**
+     * @brief A named figure reported as is, e.g. the size of the trained model
+     */
+    void set_counter(const std::string& name, double value) { counters_[name] = value; }
+
+    double real_seconds() const { return real_seconds_; }
+    double cpu_seconds() const { return cpu_seconds_; }
+    double items_processed() const { return items_processed_; }
+    const std::map<std::string, double>& counters() const { return counters_; }
+
+private:
+    size_t size_;
+    size_t iterations_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point real_start_;
+    std::clock_t cpu_start_ = 0;
+    double real_seconds_ = 0.0, cpu_seconds_ = 0.0; // CPU time is of the whole process, all threads
+    double items_processed_ = 0.0;
+    std::map<std::string, double> counters_;
+};
+
+/**
+ * @struct Benchmark
+ * @brief A registered benchmark and the problem sizes it runs at.
+ */
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> function;
+    std::vector<size_t> sizes;
+};
+
+inline std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+/**
+ * @brief Adds benchmarks to the registry; call it from a namespace-scope initialiser
+ */
+inline bool register_benchmarks(const std::vector<Benchmark>& benchmarks) {
+    registry().insert(registry().end(), benchmarks.begin(), benchmarks.end());
+    return true;
+}
+
+/**
+ * @struct Result
+ * @brief One benchmark at one size: times per iteration and throughput.
+ */
+struct Result {
+    std::string name; // "<benchmark>/<size>"
+    size_t size = 0;
+    size_t iterations = 0;
+    double real_ns = 0.0;
+    double cpu_ns = 0.0;
+    double items_per_second = 0.0;
+    std::map<std::string, double> counters;
+};
+
+/**
+ * @brief Runs a benchmark at one size, growing the iteration count until a run takes `min_seconds`
+ */
+inline Result run_benchmark(const Benchmark& benchmark, size_t size, double min_seconds) {
+    size_t iterations = 1;
+    for (;;) {
+        State state(size, iterations);
+#if defined(FAI_PROFILING) && FAI_PROFILING
+        const std::array<uint64_t, NUM_PROFILE_COUNTERS> counts_before = profile_totals();
+#endif
+        benchmark.function(state);
+        const double seconds = state.real_seconds();
+        if (seconds >= min_seconds || iterations >= 1000000000) {
+            Result result;
+            result.name = benchmark.name + "/" + std::to_string(size);
+            result.size = size;
+            result.iterations = iterations;
+            result.real_ns = seconds * 1e9 / iterations;
+            result.cpu_ns = state.cpu_seconds() * 1e9 / iterations;
+            result.items_per_second = seconds > 0.0 ? state.items_processed() / seconds : 0.0;
+            result.counters = state.counters();
+#if defined(FAI_PROFILING) && FAI_PROFILING
+            const std::array<uint64_t, NUM_PROFILE_COUNTERS> counts_after = profile_totals();
+            for (int c = 0; c < NUM_PROFILE_COUNTERS; ++c) {
+                if (counts_after[c] == counts_before[c]) continue;
+                result.counters[profile_counter_name(c)] =
+                    static_cast<double>(counts_after[c] - counts_before[c]) / iterations;
+            }
+#endif
+            return result;
+        }
+        // Aim 40% past the minimum, growing by at most 10x per step like Google Benchmark
+        double factor = seconds > 0.0 ? min_seconds * 1.4 / seconds : 10.0;
+        factor = std::min(10.0, std::max(2.0, factor));
+        iterations = static_cast<size_t>(iterations * factor);
+    }
+}
+
+inline std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+            continue;
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Writes the results in Google Benchmark's JSON format
+ *
+ * @param context Extra fields of the "context" object (build settings, scale, ...), written as strings.
+ */
+inline void write_json(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& context,
+                       const std::vector<Result>& results) {
+    out.precision(10);
+    out << "{\n  \"context\": {\n";
+    for (size_t i = 0; i < context.size(); ++i) {
+        out << "    " << json_string(context[i].first) << ": " << json_string(context[i].second)
+            << (i + 1 < context.size() ? ",\n" : "\n");
+    }
+    out << "  },\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": " << json_string(r.name) << ", \"run_name\": " << json_string(r.name)
+            << ", \"run_type\": \"iteration\", \"size\": " << r.size << ", \"iterations\": " << r.iterations
+            << ", \"real_time\": " << r.real_ns << ", \"cpu_time\": " << r.cpu_ns << ", \"time_unit\": \"ns\"";
+        if (r.items_per_second > 0.0) out << ", \"items_per_second\": " << r.items_per_second;
+        for (const auto& counter : r.counters) out << ", " << json_string(counter.first) << ": " << counter.second;
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace fai_benchmark
+
+#endif // FAI_BENCHMARKS_BENCHMARK_H
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "benchmark.h"
+
+/**
+ * Runs the registered benchmarks and writes Google Benchmark JSON.
+ *
+ * Usage: fai_benchmarks [--filter=REGEX] [--scale=X] [--min-time=SECONDS] [--json=FILE]
+ *
+ *   --filter    Runs only benchmarks whose "<name>/<size>" matches (default: all)
+ *   --scale     Multiplies every problem size, e.g. 0.1 for a quick smoke run (default 1)
+ *   --min-time  Minimum timed seconds per result (default 0.5)
+ *   --json      Output file (default benchmark_results.json)
+ *
+ * A FAI_PROFILING build also reports the profile counters of each benchmark,
+ * and writes a Chrome trace of all runs to the file named by FAI_TRACE.
+ *
+ * To compare two builds, run both with the same flags and then
+ *   python3 compare_results.py old.json new.json
+ */
+
+namespace {
+
+std::string flag_value(const std::string& argument, const std::string& name) {
+    const std::string prefix = "--" + name + "=";
+    return argument.compare(0, prefix.size(), prefix) == 0 ? argument.substr(prefix.size()) : std::string();
+}
+
+std::string build_type() {
+#ifdef NDEBUG
+    return "release";
+#else
+    return "debug";
+#endif
+}
+
+std::string simd() {
+#if defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    FAI_PROFILE_SESSION();
+    std::string filter = ".*", json = "benchmark_results.json";
+    double scale = 1.0, min_seconds = 0.5;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        std::string value;
+        if (!(value = flag_value(argument, "filter")).empty()) {
+            filter = value;
+        } else if (!(value = flag_value(argument, "scale")).empty()) {
+            scale = std::atof(value.c_str());
+        } else if (!(value = flag_value(argument, "min-time")).empty()) {
+            min_seconds = std::atof(value.c_str());
+        } else if (!(value = flag_value(argument, "json")).empty()) {
+            json = value;
+        } else {
+            std::cerr << "Unknown argument: " << argument << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [--filter=REGEX] [--scale=X] [--min-time=SECONDS] [--json=FILE]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (scale <= 0.0) {
+        std::cerr << "--scale must be positive" << std::endl;
+        return 1;
+    }
+    const std::regex pattern(filter);
+
+    std::vector<fai_benchmark::Result> results;
+    std::printf("%-44s %14s %14s %12s %16s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Items/s");
+    for (const fai_benchmark::Benchmark& benchmark : fai_benchmark::registry()) {
+        for (size_t base_size : benchmark.sizes) {
+            const size_t size = std::max<size_t>(1, static_cast<size_t>(base_size * scale));
+            if (!std::regex_search(benchmark.name + "/" + std::to_string(size), pattern)) continue;
+            fai_benchmark::Result result = fai_benchmark::run_benchmark(benchmark, size, min_seconds);
+            std::printf("%-44s %14.0f %14.0f %12zu %16.4g\n", result.name.c_str(), result.real_ns, result.cpu_ns,
+                        result.iterations, result.items_per_second);
+            std::fflush(stdout);
+            results.push_back(result);
+        }
+    }
+
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    std::ofstream out(json);
+    if (!out) {
+        std::cerr << "Cannot write " << json << std::endl;
+        return 1;
+    }
+    fai_benchmark::write_json(out,
+                              {{"date", date},
+                               {"host_name", host},
+                               {"executable", argv[0]},
+                               {"num_cpus", std::to_string(std::thread::hardware_concurrency())},
+                               {"library_build_type", build_type()},
+                               {"simd", simd()},
+                               {"scale", std::to_string(scale)},
+                               {"min_time", std::to_string(min_seconds)}},
+                              results);
+    std::cout << "Wrote " << results.size() << " results to " << json << std::endl;
+    return 0;
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Compares two benchmark result files written by fai_benchmarks.
+
+Usage: python3 compare_results.py OLD.json NEW.json [--threshold=0.05]
+
+Prints the real time of every benchmark present in both files and the change
+from OLD to NEW. Changes beyond the threshold (a fraction, 5% by default) are
+marked "faster" or "slower". The exit status is 1 if anything got slower, so
+the script can gate a change in CI.
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    return results.get("context", {}), {b["name"]: b for b in results["benchmarks"]}
+
+
+def main(argv):
+    threshold = 0.05
+    paths = []
+    for argument in argv[1:]:
+        if argument.startswith("--threshold="):
+            threshold = float(argument.split("=", 1)[1])
+        else:
+            paths.append(argument)
+    if len(paths) != 2:
+        print(__doc__.strip().splitlines()[2], file=sys.stderr)
+        return 2
+
+    old_context, old = load(paths[0])
+    new_context, new = load(paths[1])
+    for key in ("library_build_type", "simd", "scale"):
+        if old_context.get(key) != new_context.get(key):
+            print("warning: %s differs (%s vs %s)" % (key, old_context.get(key), new_context.get(key)))
+
+    slower = 0
+    print("%-44s %14s %14s %9s" % ("Benchmark", "Old (ns)", "New (ns)", "Change"))
+    for name, before in old.items():
+        after = new.get(name)
+        if after is None:
+            continue
+        change = after["real_time"] / before["real_time"] - 1.0 if before["real_time"] > 0 else 0.0
+        verdict = ""
+        if change > threshold:
+            verdict = "slower"
+            slower += 1
+        elif change < -threshold:
+            verdict = "faster"
+        print("%-44s %14.0f %14.0f %+8.1f%% %s" % (name, before["real_time"], after["real_time"], change * 100.0,
+                                                   verdict))
+    for name in new:
+        if name not in old:
+            print("%-44s %14s %14.0f %9s" % (name, "-", new[name]["real_time"], "new"))
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,102 @@
+#include <map>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "PA5_Naveen_Karasu.h"
+
+/**
+ * The 4-2-1 network of PA5 on generated examples: four features in [0, 1] and
+ * a label from a fixed linear rule, as in the synthetic timing of PA5's main.
+ * Every benchmark starts from a freshly initialised network (fixed seed), and
+ * one training iteration is one epoch. Throughput is in examples per second.
+ */
+
+namespace {
+
+const double LEARNING_RATE = 0.7;
+const size_t BATCH_SIZE = 256;
+
+const std::vector<pa5::Example>& synthetic_examples(size_t rows) {
+    static std::map<size_t, std::vector<pa5::Example>> cache;
+    auto found = cache.find(rows);
+    if (found != cache.end()) return found->second;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> feature(0.0, 1.0);
+    std::vector<pa5::Example>& data = cache[rows];
+    data.resize(rows);
+    for (pa5::Example& example : data) {
+        example.features = {feature(rng), feature(rng), feature(rng), feature(rng)};
+        const std::vector<double>& x = example.features;
+        example.label = 0.8 * x[0] - 0.5 * x[1] + 0.3 * x[2] - 0.6 * x[3] > 0.0 ? 1 : 0;
+    }
+    return data;
+}
+
+std::vector<size_t> all_rows(size_t rows) {
+    std::vector<size_t> indices(rows);
+    for (size_t i = 0; i < rows; ++i) indices[i] = i;
+    return indices;
+}
+
+void train_sgd_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa5::Example>& data = synthetic_examples(state.size());
+    const std::vector<size_t> rows = all_rows(state.size());
+    pa5::NeuralNetwork<> nn(LEARNING_RATE);
+    int misclassified = 0;
+    for (auto _ : state) {
+        misclassified = nn.train(data, rows, 1);
+        fai_benchmark::do_not_optimize(misclassified);
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+    state.set_counter("misclassified", misclassified);
+}
+
+void train_minibatch_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa5::Example>& data = synthetic_examples(state.size());
+    const std::vector<size_t> rows = all_rows(state.size());
+    pa5::NeuralNetwork<> nn(LEARNING_RATE);
+    int misclassified = 0;
+    for (auto _ : state) {
+        misclassified = nn.train_minibatch(data, rows, 1, BATCH_SIZE);
+        fai_benchmark::do_not_optimize(misclassified);
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+    state.set_counter("misclassified", misclassified);
+}
+
+void predict_batch_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa5::Example>& data = synthetic_examples(state.size());
+    const std::vector<float> features = pa5::feature_matrix(data, all_rows(state.size()));
+    pa5::NeuralNetwork<> nn(LEARNING_RATE);
+    std::vector<float> scores(state.size());
+    for (auto _ : state) {
+        nn.predict_batch(features.data(), state.size(), scores.data());
+        fai_benchmark::do_not_optimize(scores.data());
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+}
+
+void forward_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa5::Example>& data = synthetic_examples(state.size());
+    pa5::NeuralNetwork<> nn(LEARNING_RATE);
+    for (auto _ : state) {
+        float total = 0.0f;
+        for (const pa5::Example& example : data) {
+            float hidden[2];
+            total += nn.forward(example, hidden);
+        }
+        fai_benchmark::do_not_optimize(total);
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+}
+
+const bool registered = fai_benchmark::register_benchmarks({
+    {"nn/train_sgd", train_sgd_benchmark, {1 << 12, 1 << 16}},
+    {"nn/train_minibatch", train_minibatch_benchmark, {1 << 12, 1 << 16}},
+    {"nn/predict_batch", predict_batch_benchmark, {1 << 12, 1 << 16}},
+    {"nn/forward", forward_benchmark, {1 << 12, 1 << 16}},
+});
+
+} // namespace
@@ -0,0 +1,55 @@
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "PA1_Naveen_Karasu.h"
+
+/**
+ * Lowest-cost-first search (PA1) on generated road-network-like graphs: a
+ * chain through every node, so the goal is always reachable, plus random
+ * shortcuts. Throughput is in edges relaxed per second.
+ */
+
+namespace {
+
+using Graph = std::map<int, std::vector<std::pair<int, int>>>;
+
+const size_t SHORTCUTS_PER_NODE = 7;
+
+const Graph& random_graph(size_t nodes) {
+    static std::map<size_t, Graph> cache;
+    auto found = cache.find(nodes);
+    if (found != cache.end()) return found->second;
+
+    std::mt19937 rng(static_cast<unsigned>(nodes));
+    std::uniform_int_distribution<int> node(0, static_cast<int>(nodes) - 1);
+    std::uniform_int_distribution<int> cost(1, 100);
+    Graph& graph = cache[nodes];
+    for (size_t i = 0; i < nodes; ++i) {
+        auto& edges = graph[static_cast<int>(i)];
+        if (i + 1 < nodes) edges.push_back({static_cast<int>(i) + 1, cost(rng)});
+        for (size_t s = 0; s < SHORTCUTS_PER_NODE; ++s) edges.push_back({node(rng), cost(rng)});
+    }
+    return graph;
+}
+
+void lowest_cost_path_benchmark(fai_benchmark::State& state) {
+    const Graph& graph = random_graph(state.size());
+    const int goal = static_cast<int>(state.size()) - 1;
+    pa1::SearchResult<int> result;
+    for (auto _ : state) {
+        result = pa1::lowest_cost_path(graph, 0, goal);
+        fai_benchmark::do_not_optimize(result.cost);
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size() * (SHORTCUTS_PER_NODE + 1));
+    state.set_counter("cost", result.cost);
+    state.set_counter("expanded", static_cast<double>(result.expanded));
+}
+
+const bool registered = fai_benchmark::register_benchmarks({
+    {"search/lowest_cost_path", lowest_cost_path_benchmark, {1 << 10, 1 << 13, 1 << 16}},
+});
+
+} // namespace
@@ -0,0 +1,159 @@
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "PA4_Naveen_Karasu.h"
+
+/**
+ * Decision trees (PA4) on generated data of any size:
+ *
+ *   - categorical: the four forum features with eight values each and a
+ *     "reads"/"skips" label that depends on all of them, plus 5% label noise,
+ *     so trees grow to a few thousand nodes;
+ *   - flows: the four NUMERIC_FEATURES drawn log-normally, labelled "botnet"
+ *     for short flows of small packets, plus 5% label noise.
+ *
+ * Training throughput is in examples per second; inference in rows per second.
+ */
+
+namespace {
+
+const int CATEGORY_VALUES = 8;
+const double LABEL_NOISE = 0.05;
+
+const std::vector<std::string> CATEGORICAL_FEATURES = {"author", "thread", "length", "where_read"};
+
+const std::vector<pa4::Example>& categorical_examples(size_t rows) {
+    static std::map<size_t, std::vector<pa4::Example>> cache;
+    auto found = cache.find(rows);
+    if (found != cache.end()) return found->second;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> value(0, CATEGORY_VALUES - 1);
+    std::bernoulli_distribution noise(LABEL_NOISE);
+    std::vector<pa4::Example>& data = cache[rows];
+    data.resize(rows);
+    for (pa4::Example& example : data) {
+        int author = value(rng), thread = value(rng), length = value(rng), where = value(rng);
+        bool reads = ((author + 2 * thread + length) % 3 == 0) != (where < 2);
+        if (noise(rng)) reads = !reads;
+        example.author = "author" + std::to_string(author);
+        example.thread = "thread" + std::to_string(thread);
+        example.length = "length" + std::to_string(length);
+        example.where_read = "where" + std::to_string(where);
+        example.user_action = reads ? "reads" : "skips";
+    }
+    return data;
+}
+
+const std::vector<pa4::Example>& flow_examples(size_t rows) {
+    static std::map<size_t, std::vector<pa4::Example>> cache;
+    auto found = cache.find(rows);
+    if (found != cache.end()) return found->second;
+
+    std::mt19937 rng(11);
+    std::lognormal_distribution<double> duration(0.0, 2.0), packets(2.0, 1.5), packet_bytes(5.0, 1.0);
+    std::uniform_real_distribution<double> source_share(0.0, 1.0);
+    std::bernoulli_distribution noise(LABEL_NOISE);
+    std::vector<pa4::Example>& data = cache[rows];
+    data.resize(rows);
+    for (pa4::Example& example : data) {
+        double dur = duration(rng), pkts = std::ceil(packets(rng)), per_packet = packet_bytes(rng);
+        double bytes = std::round(pkts * per_packet);
+        bool botnet = dur < 1.0 && per_packet < 120.0;
+        if (noise(rng)) botnet = !botnet;
+        example.numeric = {dur, pkts, bytes, std::round(bytes * source_share(rng))};
+        example.user_action = botnet ? "botnet" : "normal";
+    }
+    return data;
+}
+
+void train_categorical_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa4::Example>& data = categorical_examples(state.size());
+    size_t nodes = 0;
+    for (auto _ : state) {
+        pa4::TreeArena arena;
+        fai_benchmark::do_not_optimize(pa4::train_decision_tree(data, CATEGORICAL_FEATURES, arena));
+        nodes = arena.num_nodes();
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+    state.set_counter("nodes", static_cast<double>(nodes));
+}
+
+void train_numeric_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa4::Example>& data = flow_examples(state.size());
+    size_t nodes = 0;
+    for (auto _ : state) {
+        pa4::TreeArena arena;
+        fai_benchmark::do_not_optimize(pa4::train_decision_tree(data, pa4::NUMERIC_FEATURES, arena));
+        nodes = arena.num_nodes();
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+    state.set_counter("nodes", static_cast<double>(nodes));
+}
+
+void train_numeric_parallel_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa4::Example>& data = flow_examples(state.size());
+    const std::vector<size_t> rows = pa4::all_rows(data);
+    TaskScheduler scheduler;
+    size_t nodes = 0;
+    for (auto _ : state) {
+        pa4::TreeArena arena;
+        pa4::NumericColumns columns = pa4::build_numeric_columns(data, pa4::NUMERIC_FEATURES);
+        fai_benchmark::do_not_optimize(
+            pa4::build_tree_parallel(data, rows, pa4::NUMERIC_FEATURES, columns, scheduler, arena));
+        nodes = arena.num_nodes();
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+    state.set_counter("nodes", static_cast<double>(nodes));
+    state.set_counter("threads", scheduler.num_threads());
+}
+
+// Trees are trained on a fixed sample so that only the number of rows scored changes with the size
+const size_t INFERENCE_TRAINING_ROWS = 1 << 14;
+
+void predict_flat_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa4::Example>& training = categorical_examples(INFERENCE_TRAINING_ROWS);
+    pa4::TreeArena arena;
+    pa4::FlatTree tree = pa4::compile_tree(pa4::train_decision_tree(training, CATEGORICAL_FEATURES, arena),
+                                           CATEGORICAL_FEATURES);
+    const std::vector<pa4::Example>& data = categorical_examples(state.size());
+    std::vector<uint32_t> codes(data.size() * CATEGORICAL_FEATURES.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        pa4::encode_example(tree, data[i], codes.data() + i * CATEGORICAL_FEATURES.size());
+    }
+    std::vector<int32_t> labels(data.size());
+    for (auto _ : state) {
+        pa4::predict_many(tree, codes.data(), data.size(), labels.data());
+        fai_benchmark::do_not_optimize(labels.data());
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+}
+
+void predict_pointer_benchmark(fai_benchmark::State& state) {
+    const std::vector<pa4::Example>& training = flow_examples(INFERENCE_TRAINING_ROWS);
+    pa4::TreeArena arena;
+    pa4::TreeNode* tree = pa4::train_decision_tree(training, pa4::NUMERIC_FEATURES, arena);
+    const std::vector<pa4::Example>& data = flow_examples(state.size());
+    size_t botnet = 0;
+    for (auto _ : state) {
+        botnet = 0;
+        for (const pa4::Example& example : data) botnet += pa4::predict(tree, example) == "botnet";
+        fai_benchmark::do_not_optimize(botnet);
+    }
+    state.set_items_processed(static_cast<double>(state.iterations()) * state.size());
+}
+
+const bool registered = fai_benchmark::register_benchmarks({
+    {"tree/train_categorical", train_categorical_benchmark, {1 << 12, 1 << 15, 1 << 17}},
+    {"tree/train_numeric", train_numeric_benchmark, {1 << 12, 1 << 15, 1 << 17}},
+    {"tree/train_numeric_parallel", train_numeric_parallel_benchmark, {1 << 15, 1 << 17}},
+    {"tree/predict_flat", predict_flat_benchmark, {1 << 12, 1 << 16}},
+    {"tree/predict_pointer", predict_pointer_benchmark, {1 << 12, 1 << 16}},
+});
+
+} // namespace
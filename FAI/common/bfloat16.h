@@ -0,0 +1,44 @@
+#ifndef FAI_COMMON_BFLOAT16_H
+#define FAI_COMMON_BFLOAT16_H
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @struct bfloat16
+ * @brief A 16-bit float: the sign, the 8 exponent bits and the top 7 mantissa bits of a float32.
+ *
+ * It has the range of float32 with about 3 significant digits, and halves the
+ * memory of float32 arrays. It is a storage type only: values are converted to
+ * float for arithmetic, so sums still accumulate in float32. Conversion rounds to
+ * nearest, ties to even; NaNs stay NaN.
+ *
+ * Example: bfloat16(0.1f) holds 0.10009765625, and float(bfloat16(1.0f)) == 1.0f.
+ */
+struct bfloat16 {
+    uint16_t bits = 0;
+
+    bfloat16() = default;
+
+    explicit bfloat16(float value) {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof word);
+        if ((word & 0x7fffffffu) > 0x7f800000u) {
+            bits = static_cast<uint16_t>((word >> 16) | 0x0040u); // Keep NaNs quiet
+        } else {
+            word += 0x7fffu + ((word >> 16) & 1u);
+            bits = static_cast<uint16_t>(word >> 16);
+        }
+    }
+
+    operator float() const {
+        uint32_t word = static_cast<uint32_t>(bits) << 16;
+        float value;
+        std::memcpy(&value, &word, sizeof value);
+        return value;
+    }
+};
+
+static_assert(sizeof(bfloat16) == 2, "bfloat16 must be two bytes");
+
+#endif // FAI_COMMON_BFLOAT16_H
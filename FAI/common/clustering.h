@@ -0,0 +1,975 @@
+#ifndef FAI_COMMON_CLUSTERING_H
+#define FAI_COMMON_CLUSTERING_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "model_text.h"
+#include "task_scheduler.h"
+
+/**
+ * Scoring engines for the project's clustering models, loaded from the
+ * parameters export_models.py extracts from the scikit-learn pickles.
+ *
+ * Both score a batch of rows given as one row-major array of doubles,
+ * `count` x num_features(), in the feature order of the model file, and both can
+ * be (re)fitted natively on such arrays, e.g. flows decoded from the Parquet
+ * captures, spreading the work over a TaskScheduler.
+ */
+
+namespace clustering_detail {
+
+/**
+ * @brief For every row, the index of the closest of `num_points` points and its squared distance
+ *
+ * With AVX2 four rows are scored at once: the block is transposed so that one
+ * register holds feature f of all four rows, and every point is compared against
+ * the four rows with packed subtract/multiply/add. Ties go to the lower point
+ * index, as in the scalar loop, and both compute the distance in the same order,
+ * so they agree bit for bit.
+ */
+inline void nearest_points(const double* rows, size_t count, size_t width, const double* points, size_t num_points,
+                           int32_t* nearest, double* distance) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    std::vector<double> block(4 * width);
+    for (; i + 4 <= count; i += 4) {
+        for (size_t f = 0; f < width; ++f) {
+            for (size_t r = 0; r < 4; ++r) block[f * 4 + r] = rows[(i + r) * width + f];
+        }
+        __m256d best = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        __m256d best_index = _mm256_set1_pd(-1.0);
+        for (size_t p = 0; p < num_points; ++p) {
+            const double* point = points + p * width;
+            __m256d sum = _mm256_setzero_pd();
+            for (size_t f = 0; f < width; ++f) {
+                __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(&block[f * 4]), _mm256_set1_pd(point[f]));
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+            }
+            __m256d closer = _mm256_cmp_pd(sum, best, _CMP_LT_OQ);
+            best = _mm256_blendv_pd(best, sum, closer);
+            best_index = _mm256_blendv_pd(best_index, _mm256_set1_pd(static_cast<double>(p)), closer);
+        }
+        double indices[4];
+        _mm256_storeu_pd(indices, best_index);
+        _mm256_storeu_pd(distance + i, best);
+        for (size_t r = 0; r < 4; ++r) nearest[i + r] = static_cast<int32_t>(indices[r]);
+    }
+#endif
+    for (; i < count; ++i) {
+        const double* row = rows + i * width;
+        double best = std::numeric_limits<double>::infinity();
+        int32_t best_index = -1;
+        for (size_t p = 0; p < num_points; ++p) {
+            const double* point = points + p * width;
+            double sum = 0.0;
+            for (size_t f = 0; f < width; ++f) {
+                double diff = row[f] - point[f];
+                sum = sum + diff * diff;
+            }
+            if (sum < best) {
+                best = sum;
+                best_index = static_cast<int32_t>(p);
+            }
+        }
+        nearest[i] = best_index;
+        distance[i] = best;
+    }
+}
+
+
+/**
+ * @brief Squared Euclidean distance, summed in feature order like nearest_points
+ */
+inline double squared_distance(const double* a, const double* b, size_t width) {
+    double sum = 0.0;
+    for (size_t f = 0; f < width; ++f) {
+        double diff = a[f] - b[f];
+        sum = sum + diff * diff;
+    }
+    return sum;
+}
+
+/**
+ * @brief Calls fn(chunk) for every chunk in [0, num_chunks), on `scheduler` or inline when it is null
+ */
+template <typename Fn>
+void for_each_chunk(size_t num_chunks, TaskScheduler* scheduler, Fn fn) {
+    if (scheduler) {
+        scheduler->parallel_for(0, num_chunks, fn);
+    } else {
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) fn(chunk);
+    }
+}
+
+// Rows handed to one task; results are merged chunk by chunk, so
+// they do not depend on the number of threads
+const size_t CHUNK_ROWS = 16384;
+
+// Most features a GridIndex indexes; with more, a cube of neighbour cells grows too large to pay off
+const size_t GRID_MAX_FEATURES = 4;
+
+using CellKey = std::array<int64_t, GRID_MAX_FEATURES>;
+
+struct CellKeyHash {
+    size_t operator()(const CellKey& key) const {
+        uint64_t h = 1469598103934665603ull;
+        for (int64_t v : key) h = (h ^ static_cast<uint64_t>(v)) * 1099511628211ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+/**
+ * @class GridIndex
+ * @brief Points bucketed into a uniform grid for fixed-radius (eps) neighbour queries.
+ *
+ * Cells have side eps / sqrt(d) (shaved by a hair against rounding), so any two
+ * points of one cell are within eps of each other, and all points within eps of
+ * a cell lie in the cells at an offset o with sum(max(|o_i| - 1, 0)^2) <= d.
+ * For the project's four features that is 841 of the 7^4 cells around a cell;
+ * only the occupied ones are stored.
+ *
+ * Cells are numbered in order of their first point and list their points in
+ * ascending order. Points wider than GRID_MAX_FEATURES are not indexed: the
+ * index is left empty, so callers check the width first (see DbscanModel::fit).
+ */
+class GridIndex {
+public:
+    GridIndex() = default;
+
+    GridIndex(const double* points, size_t count, size_t width, double eps) {
+        if (width == 0 || width > GRID_MAX_FEATURES) return;
+        width_ = width;
+        side_ = eps / std::sqrt(static_cast<double>(width)) * (1.0 - 1e-12);
+        const int64_t reach = 1 + static_cast<int64_t>(std::sqrt(static_cast<double>(width)));
+        CellKey offset{};
+        enumerate_offsets(0, width, reach, 0, offset);
+
+        cell_of_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            CellKey key = key_of(points + i * width);
+            auto found = cells_.emplace(key, keys_.size());
+            if (found.second) keys_.push_back(key);
+            cell_of_[i] = found.first->second;
+        }
+        start_.assign(keys_.size() + 1, 0);
+        for (size_t cell : cell_of_) start_[cell + 1]++;
+        for (size_t c = 0; c < keys_.size(); ++c) start_[c + 1] += start_[c];
+        order_.resize(count);
+        std::vector<size_t> next(start_.begin(), start_.end() - 1);
+        for (size_t i = 0; i < count; ++i) order_[next[cell_of_[i]]++] = i;
+    }
+
+    size_t num_cells() const { return keys_.size(); }
+    size_t cell_of(size_t point) const { return cell_of_[point]; }
+    const CellKey& key(size_t cell) const { return keys_[cell]; }
+    size_t cell_size(size_t cell) const { return start_[cell + 1] - start_[cell]; }
+    const size_t* cell_begin(size_t cell) const { return order_.data() + start_[cell]; }
+    const size_t* cell_end(size_t cell) const { return order_.data() + start_[cell + 1]; }
+
+    /**
+     * @brief The cell a point falls in (whether or not it is occupied)
+     */
+    CellKey key_of(const double* point) const {
+        CellKey key{};
+        for (size_t f = 0; f < width_; ++f) key[f] = static_cast<int64_t>(std::floor(point[f] / side_));
+        return key;
+    }
+
+    /**
+     * @brief Squared distance from a point to the box of a cell, a lower bound for its points
+     */
+    double box_distance(size_t cell, const double* point) const {
+        double sum = 0.0;
+        for (size_t f = 0; f < width_; ++f) {
+            const double low = keys_[cell][f] * side_, high = low + side_;
+            const double gap = point[f] < low ? low - point[f] : point[f] > high ? point[f] - high : 0.0;
+            sum += gap * gap;
+        }
+        // Shrunk a little, so that rounding in key_of() cannot make it exceed a true distance
+        return sum * (1.0 - 1e-9);
+    }
+
+    /**
+     * @brief Calls fn(cell) for every occupied cell that may hold points within eps of cell `key`
+     */
+    template <typename Fn>
+    void for_each_neighbour(const CellKey& key, Fn fn) const {
+        for (const CellKey& offset : offsets_) {
+            CellKey neighbour;
+            for (size_t f = 0; f < GRID_MAX_FEATURES; ++f) neighbour[f] = key[f] + offset[f];
+            auto found = cells_.find(neighbour);
+            if (found != cells_.end()) fn(found->second);
+        }
+    }
+
+private:
+    // `width` is passed by value (not read from width_) so the compiler can see it is at most GRID_MAX_FEATURES
+    void enumerate_offsets(size_t f, size_t width, int64_t reach, int64_t gap, CellKey& offset) {
+        if (f == width) {
+            offsets_.push_back(offset);
+            return;
+        }
+        for (int64_t o = -reach; o <= reach; ++o) {
+            const int64_t g = std::max<int64_t>(std::abs(o) - 1, 0);
+            if (gap + g * g > static_cast<int64_t>(width)) continue;
+            offset[f] = o;
+            enumerate_offsets(f + 1, width, reach, gap + g * g, offset);
+        }
+        offset[f] = 0;
+    }
+
+    size_t width_ = 0;
+    double side_ = 1.0;
+    std::vector<CellKey> offsets_;                         // Offsets of the cells that can hold neighbours
+    std::unordered_map<CellKey, size_t, CellKeyHash> cells_; // Occupied cell -> its number
+    std::vector<CellKey> keys_;                             // Key of each occupied cell
+    std::vector<size_t> cell_of_;                           // Cell of each point
+    std::vector<size_t> start_;                             // Points of cell c are order_[start_[c], start_[c + 1])
+    std::vector<size_t> order_;
+};
+
+/**
+ * @class KdTree
+ * @brief Exact nearest-neighbour queries within a radius, over a copy of the points.
+ *
+ * Nodes split their points at the median of the feature with the widest range
+ * and keep their bounding box; a query walks the closer child first and skips
+ * any node whose box is farther than the best point found so far. Ties go to
+ * the lowest point index, as in nearest_points().
+ */
+class KdTree {
+public:
+    KdTree() = default;
+
+    KdTree(const double* points, size_t count, size_t width) : width_(width), index_(count) {
+        std::iota(index_.begin(), index_.end(), 0);
+        if (count > 0) build(points, 0, count);
+        points_.resize(count * width);
+        for (size_t i = 0; i < count; ++i) {
+            std::copy(points + index_[i] * width, points + (index_[i] + 1) * width, points_.begin() + i * width);
+        }
+    }
+
+    /**
+     * @brief Index of the closest point within squared distance `radius2` of `query`, or -1
+     */
+    int64_t nearest(const double* query, double radius2) const {
+        double best = radius2;
+        int64_t best_index = -1;
+        if (!nodes_.empty()) search(0, query, best, best_index);
+        return best_index;
+    }
+
+private:
+    struct Node {
+        size_t begin, end;        // Points index_[begin, end)
+        int64_t left = -1, right = -1;
+        size_t low;               // Offset of the box's low corner in bounds_; the high corner follows
+    };
+
+    // Leaves hold at most this many points
+    static constexpr size_t LEAF_POINTS = 16;
+
+    int64_t build(const double* points, size_t begin, size_t end) {
+        Node node{begin, end, -1, -1, bounds_.size()};
+        bounds_.resize(bounds_.size() + 2 * width_);
+        double* low = bounds_.data() + node.low;
+        double* high = low + width_;
+        std::fill(low, high, std::numeric_limits<double>::infinity());
+        std::fill(high, high + width_, -std::numeric_limits<double>::infinity());
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t f = 0; f < width_; ++f) {
+                low[f] = std::min(low[f], points[index_[i] * width_ + f]);
+                high[f] = std::max(high[f], points[index_[i] * width_ + f]);
+            }
+        }
+        size_t split = 0;
+        for (size_t f = 1; f < width_; ++f) {
+            if (high[f] - low[f] > high[split] - low[split]) split = f;
+        }
+        const int64_t id = static_cast<int64_t>(nodes_.size());
+        nodes_.push_back(node);
+        if (end - begin <= LEAF_POINTS || high[split] == low[split]) return id;
+
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(index_.begin() + begin, index_.begin() + middle, index_.begin() + end,
+                         [&](size_t a, size_t b) { return points[a * width_ + split] < points[b * width_ + split]; });
+        const int64_t left = build(points, begin, middle);
+        const int64_t right = build(points, middle, end);
+        nodes_[id].left = left;
+        nodes_[id].right = right;
+        return id;
+    }
+
+    double box_distance(const Node& node, const double* query) const {
+        const double* low = bounds_.data() + node.low;
+        const double* high = low + width_;
+        double sum = 0.0;
+        for (size_t f = 0; f < width_; ++f) {
+            const double gap = query[f] < low[f] ? low[f] - query[f] : query[f] > high[f] ? query[f] - high[f] : 0.0;
+            sum += gap * gap;
+        }
+        return sum;
+    }
+
+    void search(int64_t id, const double* query, double& best, int64_t& best_index) const {
+        const Node& node = nodes_[id];
+        if (node.left < 0) {
+            for (size_t i = node.begin; i < node.end; ++i) {
+                const double d = squared_distance(query, points_.data() + i * width_, width_);
+                const int64_t index = static_cast<int64_t>(index_[i]);
+                if (d < best || (d == best && (best_index < 0 || index < best_index))) {
+                    best = d;
+                    best_index = index;
+                }
+            }
+            return;
+        }
+        double near_distance = box_distance(nodes_[node.left], query);
+        double far_distance = box_distance(nodes_[node.right], query);
+        int64_t near = node.left, far = node.right;
+        if (far_distance < near_distance) {
+            std::swap(near, far);
+            std::swap(near_distance, far_distance);
+        }
+        if (near_distance <= best) search(near, query, best, best_index);
+        if (far_distance <= best) search(far, query, best, best_index);
+    }
+
+    size_t width_ = 0;
+    std::vector<Node> nodes_;     // nodes_[0] is the root
+    std::vector<double> bounds_;  // Bounding box of each node, low corner then high corner
+    std::vector<size_t> index_;   // Points in tree order
+    std::vector<double> points_;  // Copies of the points in tree order
+};
+
+/**
+ * @brief Union-find over cell numbers, with path halving
+ */
+inline size_t find_root(std::vector<size_t>& parent, size_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace clustering_detail
+
+/**
+ * @struct KMeansOptions
+ * @brief Settings of KMeansModel::fit, with scikit-learn's defaults.
+ */
+struct KMeansOptions {
+    size_t max_iterations = 300;
+    double tolerance = 1e-4; // Stop once the centres move less than this, relative to the mean feature variance
+    uint32_t seed = 42;      // Seeds the k-means++ initialisation
+    bool hamerly = true;     // Skip distance computations with Hamerly's bounds; false runs plain Lloyd
+};
+
+/**
+ * @struct KMeansReport
+ * @brief What KMeansModel::fit did.
+ */
+struct KMeansReport {
+    size_t iterations = 0;
+    size_t distance_computations = 0; // Row-to-centre distances in the assignment steps
+    double inertia = 0.0;             // Sum of squared distances of the rows to their centres
+    bool converged = false;
+};
+
+/**
+ * @class KMeansModel
+ * @brief Nearest-centroid assignment with the centres of a trained KMeans model.
+ *
+ * Example:
+ *   KMeansModel kmeans;
+ *   if (kmeans.load("models/kmeans_model.txt")) kmeans.predict_batch(rows, count, clusters);
+ */
+class KMeansModel {
+public:
+    KMeansModel() = default;
+
+    /**
+     * @brief A model with the given features and row-major centres (num_clusters x features.size())
+     */
+    KMeansModel(const std::vector<std::string>& features, const std::vector<double>& centers = {})
+        : features_(features), centers_(centers) {}
+
+    /**
+     * @brief Reads a model file; false (and the model unchanged) if it is missing or malformed
+     */
+    bool load(const std::string& filename) {
+        std::ifstream in(filename);
+        std::vector<std::string> features;
+        size_t num_centers = 0;
+        if (!read_model_header(in, "kmeans", features) || !read_model_field(in, "centers", num_centers)) return false;
+        std::vector<double> centers(num_centers * features.size());
+        for (auto& value : centers) {
+            if (!(in >> value)) return false;
+        }
+        features_ = features;
+        centers_ = centers;
+        return true;
+    }
+
+    size_t num_features() const { return features_.size(); }
+    size_t num_clusters() const { return features_.empty() ? 0 : centers_.size() / features_.size(); }
+    const std::vector<std::string>& feature_names() const { return features_; }
+    const double* center(size_t k) const { return centers_.data() + k * features_.size(); }
+
+    /**
+     * @brief Writes the index of the closest centre of each row to `clusters`
+     */
+    void predict_batch(const double* rows, size_t count, int32_t* clusters) const {
+        std::vector<double> distance(count);
+        clustering_detail::nearest_points(rows, count, num_features(), centers_.data(), num_clusters(), clusters,
+                                          distance.data());
+    }
+
+    /**
+     * @brief Trains `k` centres on `count` rows and writes the cluster of every row to `clusters`
+     *
+     * k-means++ initialisation followed by Lloyd iterations, stopping when no row
+     * changes cluster or the centres move less than the tolerance, as in
+     * scikit-learn. A centre that loses all its rows stays where it is.
+     *
+     * With options.hamerly, each row keeps an upper bound on the distance to its
+     * centre and a lower bound on the distance to every other centre, moved by
+     * how far the centres drift each iteration. A row whose upper bound is below
+     * both its lower bound and half the distance from its centre to the next
+     * nearest centre cannot change cluster and is skipped; on the flow captures
+     * that skips most distance computations after the first few iterations. The
+     * bounds only skip work, so the clusters and centres are the same as plain
+     * Lloyd's.
+     *
+     * Rows are processed in chunks of CHUNK_ROWS spread over `scheduler`, and the
+     * per-chunk centre sums are added in chunk order, so the result does not
+     * depend on the number of threads.
+     *
+     * @param scheduler Scheduler that runs the chunks, or nullptr
+     */
+    KMeansReport fit(const double* rows, size_t count, size_t k, int32_t* clusters,
+                     const KMeansOptions& options = KMeansOptions(), TaskScheduler* scheduler = nullptr) {
+        using namespace clustering_detail;
+        const size_t width = features_.size();
+        KMeansReport report;
+        k = std::min(k, count);
+        if (k == 0 || width == 0) return report;
+        const size_t num_chunks = (count + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        auto chunk_range = [&](size_t chunk) {
+            return std::make_pair(chunk * CHUNK_ROWS, std::min(count, (chunk + 1) * CHUNK_ROWS));
+        };
+
+        // Tolerance relative to the data, as scikit-learn does
+        double variance = 0.0;
+        for (size_t f = 0; f < width; ++f) {
+            double mean = 0.0, squares = 0.0;
+            for (size_t i = 0; i < count; ++i) mean += rows[i * width + f];
+            mean /= count;
+            for (size_t i = 0; i < count; ++i) squares += (rows[i * width + f] - mean) * (rows[i * width + f] - mean);
+            variance += squares / count;
+        }
+        const double tolerance = options.tolerance * variance / width;
+
+        centers_ = initial_centers(rows, count, k, options.seed, scheduler);
+        std::vector<int32_t> previous(count, -1);
+        std::vector<double> upper, lower, separation(k), drift(k);
+        if (options.hamerly) {
+            upper.resize(count);
+            lower.resize(count);
+        }
+        std::vector<size_t> computations(num_chunks);
+
+        // Assign every row; `bounded` uses (and then maintains) the Hamerly bounds
+        auto assign = [&](bool bounded) {
+            if (bounded) {
+                for (size_t a = 0; a < k; ++a) {
+                    double nearest = std::numeric_limits<double>::infinity();
+                    for (size_t b = 0; b < k; ++b) {
+                        if (b != a) nearest = std::min(nearest, squared_distance(center(a), center(b), width));
+                    }
+                    separation[a] = std::sqrt(nearest) / 2.0;
+                }
+                report.distance_computations += k * (k - 1);
+            }
+            for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+                auto range = chunk_range(chunk);
+                size_t computed = 0;
+                if (!options.hamerly) {
+                    std::vector<double> distance(range.second - range.first);
+                    nearest_points(rows + range.first * width, range.second - range.first, width, centers_.data(), k,
+                                   clusters + range.first, distance.data());
+                    computations[chunk] = (range.second - range.first) * k;
+                    return;
+                }
+                for (size_t i = range.first; i < range.second; ++i) {
+                    const double* row = rows + i * width;
+                    if (bounded) {
+                        // Strict comparisons, so that a tie is always rescanned and goes to the lower index
+                        const double bound = std::max(separation[clusters[i]], lower[i]);
+                        if (upper[i] < bound) continue;
+                        upper[i] = std::sqrt(squared_distance(row, center(clusters[i]), width));
+                        computed++;
+                        if (upper[i] < bound) continue;
+                    }
+                    double best = std::numeric_limits<double>::infinity(), second = best;
+                    int32_t best_index = -1;
+                    for (size_t c = 0; c < k; ++c) {
+                        double d = squared_distance(row, center(c), width);
+                        if (d < best) {
+                            second = best;
+                            best = d;
+                            best_index = static_cast<int32_t>(c);
+                        } else if (d < second) {
+                            second = d;
+                        }
+                    }
+                    computed += k;
+                    clusters[i] = best_index;
+                    upper[i] = std::sqrt(best);
+                    lower[i] = std::sqrt(second);
+                }
+                computations[chunk] = computed;
+            });
+            for (size_t computed : computations) report.distance_computations += computed;
+        };
+
+        bool assigned = false;
+        while (report.iterations < options.max_iterations) {
+            assign(options.hamerly && assigned);
+            assigned = true;
+            report.iterations++;
+            const bool changed = !std::equal(clusters, clusters + count, previous.begin());
+            std::copy(clusters, clusters + count, previous.begin());
+            const double shift = update_centers(rows, count, k, clusters, drift, scheduler);
+            if (!changed) {
+                report.converged = true;
+                break;
+            }
+            if (options.hamerly) {
+                // Every bound moves by at most the drift of the centres involved
+                size_t fastest = 0;
+                for (size_t c = 1; c < k; ++c) {
+                    if (drift[c] > drift[fastest]) fastest = c;
+                }
+                double runner_up = 0.0;
+                for (size_t c = 0; c < k; ++c) {
+                    if (c != fastest) runner_up = std::max(runner_up, drift[c]);
+                }
+                for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+                    auto range = chunk_range(chunk);
+                    for (size_t i = range.first; i < range.second; ++i) {
+                        upper[i] += drift[clusters[i]];
+                        lower[i] -= static_cast<size_t>(clusters[i]) == fastest ? runner_up : drift[fastest];
+                    }
+                });
+            }
+            if (shift <= tolerance) {
+                report.converged = true;
+                // The centres moved since the last assignment; give every row its closest one
+                assign(options.hamerly);
+                break;
+            }
+        }
+
+        std::vector<double> partial(num_chunks, 0.0);
+        for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+            auto range = chunk_range(chunk);
+            for (size_t i = range.first; i < range.second; ++i) {
+                partial[chunk] += squared_distance(rows + i * width, center(clusters[i]), width);
+            }
+        });
+        for (double sum : partial) report.inertia += sum;
+        return report;
+    }
+
+private:
+    /**
+     * @brief k-means++: the first centre is a random row, each next one a row drawn with probability
+     *        proportional to its squared distance to the closest centre so far
+     */
+    std::vector<double> initial_centers(const double* rows, size_t count, size_t k, uint32_t seed,
+                                        TaskScheduler* scheduler) const {
+        using namespace clustering_detail;
+        const size_t width = features_.size();
+        const size_t num_chunks = (count + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        std::mt19937 rng(seed);
+        std::vector<double> centers;
+        size_t first = std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+        centers.insert(centers.end(), rows + first * width, rows + (first + 1) * width);
+
+        std::vector<double> closest(count, std::numeric_limits<double>::infinity()), partial(num_chunks);
+        while (centers.size() < k * width) {
+            const double* latest = centers.data() + centers.size() - width;
+            for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+                const size_t end = std::min(count, (chunk + 1) * CHUNK_ROWS);
+                double sum = 0.0;
+                for (size_t i = chunk * CHUNK_ROWS; i < end; ++i) {
+                    closest[i] = std::min(closest[i], squared_distance(rows + i * width, latest, width));
+                    sum += closest[i];
+                }
+                partial[chunk] = sum;
+            });
+            double total = 0.0;
+            for (double sum : partial) total += sum;
+            size_t pick = std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+            if (total > 0.0) {
+                double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+                pick = count - 1;
+                for (size_t i = 0; i < count; ++i) {
+                    target -= closest[i];
+                    if (target < 0.0) {
+                        pick = i;
+                        break;
+                    }
+                }
+            }
+            centers.insert(centers.end(), rows + pick * width, rows + (pick + 1) * width);
+        }
+        return centers;
+    }
+
+    /**
+     * @brief Moves every centre to the mean of its rows; returns the summed squared shift and
+     *        writes each centre's shift (not squared) to `drift`
+     */
+    double update_centers(const double* rows, size_t count, size_t k, const int32_t* clusters,
+                          std::vector<double>& drift, TaskScheduler* scheduler) {
+        using namespace clustering_detail;
+        const size_t width = features_.size();
+        const size_t num_chunks = (count + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        std::vector<double> sums(num_chunks * k * width, 0.0);
+        std::vector<size_t> sizes(num_chunks * k, 0);
+        for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+            const size_t end = std::min(count, (chunk + 1) * CHUNK_ROWS);
+            double* sum = sums.data() + chunk * k * width;
+            size_t* size = sizes.data() + chunk * k;
+            for (size_t i = chunk * CHUNK_ROWS; i < end; ++i) {
+                size[clusters[i]]++;
+                for (size_t f = 0; f < width; ++f) sum[clusters[i] * width + f] += rows[i * width + f];
+            }
+        });
+
+        double shift = 0.0;
+        for (size_t c = 0; c < k; ++c) {
+            std::vector<double> mean(width, 0.0);
+            size_t size = 0;
+            for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+                size += sizes[chunk * k + c];
+                for (size_t f = 0; f < width; ++f) mean[f] += sums[(chunk * k + c) * width + f];
+            }
+            drift[c] = 0.0;
+            if (size == 0) continue;
+            for (size_t f = 0; f < width; ++f) mean[f] /= size;
+            const double moved = squared_distance(mean.data(), center(c), width);
+            std::copy(mean.begin(), mean.end(), centers_.begin() + c * width);
+            drift[c] = std::sqrt(moved);
+            shift += moved;
+        }
+        return shift;
+    }
+
+    std::vector<std::string> features_;
+    std::vector<double> centers_;
+};
+
+/**
+ * @class DbscanModel
+ * @brief DBSCAN clusters kept as their core points, so that new rows can be labelled without refitting.
+ *
+ * A new row joins the cluster of its closest core point if that point is within
+ * `eps`, and is noise (-1) otherwise. This is the label DBSCAN would give the row
+ * as a border point of the fitted clusters, without refitting per request as
+ * fit_predict does.
+ *
+ * Exported models carry their core points. A model that was pickled without
+ * them (e.g. after fit_predict on a single row) can be refitted on reference
+ * data with fit().
+ */
+class DbscanModel {
+public:
+    DbscanModel() = default;
+    DbscanModel(const std::vector<std::string>& features, double eps, size_t min_samples)
+        : features_(features), eps_(eps), min_samples_(min_samples) {}
+
+    /**
+     * @brief Reads a model file; false (and the model unchanged) if it is missing or malformed
+     */
+    bool load(const std::string& filename) {
+        std::ifstream in(filename);
+        DbscanModel model;
+        size_t num_core = 0;
+        if (!read_model_header(in, "dbscan", model.features_) || !read_model_field(in, "eps", model.eps_) ||
+            !read_model_field(in, "min_samples", model.min_samples_) ||
+            !read_model_field(in, "core_points", num_core)) {
+            return false;
+        }
+        model.core_.resize(num_core * model.features_.size());
+        model.core_labels_.resize(num_core);
+        for (size_t p = 0; p < num_core; ++p) {
+            for (size_t f = 0; f < model.features_.size(); ++f) {
+                if (!(in >> model.core_[p * model.features_.size() + f])) return false;
+            }
+            if (!(in >> model.core_labels_[p])) return false;
+        }
+        model.index_core_points();
+        *this = model;
+        return true;
+    }
+
+    /**
+     * @brief Clusters `count` rows and keeps their core points
+     *
+     * Standard DBSCAN: a row is a core point if at least `min_samples` rows
+     * (itself included) lie within `eps`; clusters grow from core points in row
+     * order, as in scikit-learn.
+     *
+     * The rows are bucketed in a GridIndex and clustered cell by cell:
+     * 1. A cell with min_samples rows makes them all core; in other cells each
+     *    row counts its neighbours in the surrounding cells, stopping at min_samples.
+     * 2. Two cells with core rows are linked when some pair of their core rows
+     *    is within eps; the clusters are the connected groups of cells, numbered
+     *    in order of their first core row.
+     * 3. A border row takes the lowest-numbered cluster with a core row within eps.
+     * That gives exactly the labels of fit_exhaustive(), at a cost close to linear
+     * in `count` on the flow captures. The per-cell steps run in chunks on
+     * `scheduler`. With more than GRID_MAX_FEATURES features this falls back to
+     * fit_exhaustive().
+     *
+     * @param scheduler Scheduler that runs the chunks, or nullptr
+     * @return std::vector<int32_t> The cluster of every row (-1 for noise).
+     */
+    std::vector<int32_t> fit(const double* rows, size_t count, TaskScheduler* scheduler = nullptr) {
+        using namespace clustering_detail;
+        const size_t width = features_.size();
+        if (width == 0 || width > GRID_MAX_FEATURES) return fit_exhaustive(rows, count);
+        const double eps2 = eps_ * eps_;
+        GridIndex grid(rows, count, width, eps_);
+        const size_t num_cells = grid.num_cells();
+        const size_t cell_chunk = 256, num_chunks = (num_cells + cell_chunk - 1) / cell_chunk;
+        auto for_each_cell = [&](auto fn) {
+            for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+                const size_t end = std::min(num_cells, (chunk + 1) * cell_chunk);
+                for (size_t c = chunk * cell_chunk; c < end; ++c) fn(c, chunk);
+            });
+        };
+        auto within = [&](size_t p, size_t q) {
+            return squared_distance(rows + p * width, rows + q * width, width) <= eps2;
+        };
+
+        std::vector<std::vector<size_t>> neighbours(num_cells);
+        for_each_cell([&](size_t c, size_t) {
+            grid.for_each_neighbour(grid.key(c), [&](size_t n) { neighbours[c].push_back(n); });
+        });
+
+        // 1. Core rows
+        std::vector<char> core(count, 0);
+        for_each_cell([&](size_t c, size_t) {
+            const bool dense = grid.cell_size(c) >= min_samples_;
+            for (const size_t* p = grid.cell_begin(c); p != grid.cell_end(c); ++p) {
+                size_t found = 0;
+                for (size_t n = 0; !dense && n < neighbours[c].size() && found < min_samples_; ++n) {
+                    for (const size_t* q = grid.cell_begin(neighbours[c][n]);
+                         q != grid.cell_end(neighbours[c][n]) && found < min_samples_; ++q) {
+                        found += within(*p, *q);
+                    }
+                }
+                core[*p] = dense || found >= min_samples_;
+            }
+        });
+        std::vector<std::vector<size_t>> core_rows(num_cells);
+        for (size_t i = 0; i < count; ++i) {
+            if (core[i]) core_rows[grid.cell_of(i)].push_back(i);
+        }
+        auto close_to = [&](size_t p, size_t cell) {
+            for (size_t q : core_rows[cell]) {
+                if (within(p, q)) return true;
+            }
+            return false;
+        };
+
+        // Core rows of `cell` that may be within eps of `other`, closest to its box first
+        auto facing = [&](size_t cell, size_t other) {
+            std::vector<std::pair<double, size_t>> found;
+            for (size_t p : core_rows[cell]) {
+                const double gap = grid.box_distance(other, rows + p * width);
+                if (gap <= eps2) found.emplace_back(gap, p);
+            }
+            std::sort(found.begin(), found.end());
+            return found;
+        };
+
+        // 2. Clusters of linked core cells
+        std::vector<std::vector<std::pair<size_t, size_t>>> links(num_chunks);
+        for_each_cell([&](size_t c, size_t chunk) {
+            if (core_rows[c].empty()) return;
+            for (size_t n : neighbours[c]) {
+                if (n <= c || core_rows[n].empty()) continue;
+                const auto from = facing(c, n), to = facing(n, c);
+                bool linked = false;
+                for (size_t a = 0; a < from.size() && !linked; ++a) {
+                    for (size_t b = 0; b < to.size() && !linked; ++b) linked = within(from[a].second, to[b].second);
+                }
+                if (linked) links[chunk].emplace_back(c, n);
+            }
+        });
+        std::vector<size_t> parent(num_cells);
+        std::iota(parent.begin(), parent.end(), 0);
+        for (const auto& chunk_links : links) {
+            for (const auto& link : chunk_links) {
+                parent[find_root(parent, link.first)] = find_root(parent, link.second);
+            }
+        }
+        std::vector<int32_t> cell_label(num_cells, -1), root_label(num_cells, -1);
+        int32_t next_label = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!core[i]) continue;
+            const size_t c = grid.cell_of(i), root = find_root(parent, c);
+            if (root_label[root] < 0) root_label[root] = next_label++;
+            cell_label[c] = root_label[root];
+        }
+
+        // 3. Border rows
+        std::vector<int32_t> labels(count, -1);
+        for_each_cell([&](size_t c, size_t) {
+            for (const size_t* p = grid.cell_begin(c); p != grid.cell_end(c); ++p) {
+                if (core[*p]) {
+                    labels[*p] = cell_label[c];
+                    continue;
+                }
+                for (size_t n : neighbours[c]) {
+                    const int32_t label = cell_label[n];
+                    if (label >= 0 && (labels[*p] < 0 || label < labels[*p]) &&
+                        grid.box_distance(n, rows + *p * width) <= eps2 && close_to(*p, n)) {
+                        labels[*p] = label;
+                    }
+                }
+            }
+        });
+
+        keep_core_points(rows, count, core, labels);
+        return labels;
+    }
+
+    /**
+     * @brief fit() by brute force: every row is compared with every other, so the cost is quadratic in `count`
+     *
+     * Kept as the reference the grid version is checked against, and for rows
+     * with more than GRID_MAX_FEATURES features.
+     */
+    std::vector<int32_t> fit_exhaustive(const double* rows, size_t count) {
+        const size_t width = features_.size();
+        const double eps2 = eps_ * eps_;
+        auto neighbours = [&](size_t i, std::vector<size_t>& out) {
+            out.clear();
+            for (size_t j = 0; j < count; ++j) {
+                if (clustering_detail::squared_distance(rows + i * width, rows + j * width, width) <= eps2) {
+                    out.push_back(j);
+                }
+            }
+        };
+
+        std::vector<size_t> found;
+        std::vector<char> core(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            neighbours(i, found);
+            core[i] = found.size() >= min_samples_;
+        }
+
+        std::vector<int32_t> labels(count, -1);
+        int32_t next_label = 0;
+        std::vector<size_t> frontier;
+        for (size_t i = 0; i < count; ++i) {
+            if (!core[i] || labels[i] >= 0) continue;
+            labels[i] = next_label;
+            frontier.assign(1, i);
+            while (!frontier.empty()) {
+                size_t p = frontier.back();
+                frontier.pop_back();
+                neighbours(p, found);
+                for (size_t q : found) {
+                    if (labels[q] >= 0) continue;
+                    labels[q] = next_label;
+                    if (core[q]) frontier.push_back(q);
+                }
+            }
+            next_label++;
+        }
+
+        keep_core_points(rows, count, core, labels);
+        return labels;
+    }
+
+    size_t num_features() const { return features_.size(); }
+    size_t num_core_points() const { return core_labels_.size(); }
+    double eps() const { return eps_; }
+    size_t min_samples() const { return min_samples_; }
+    const std::vector<std::string>& feature_names() const { return features_; }
+
+    /**
+     * @brief Writes the cluster of each row to `labels`: that of the closest core point within eps, or -1
+     *
+     * The core points are searched through a KdTree, so a row costs about
+     * log(num_core_points()) distances; ties go to the lowest core point, giving
+     * the labels of a comparison with every core point.
+     *
+     * @param scheduler Scheduler that runs chunks of rows, or nullptr
+     */
+    void predict_batch(const double* rows, size_t count, int32_t* labels, TaskScheduler* scheduler = nullptr) const {
+        using namespace clustering_detail;
+        const size_t width = num_features();
+        const size_t num_chunks = (count + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        for_each_chunk(num_chunks, scheduler, [&](size_t chunk) {
+            const size_t end = std::min(count, (chunk + 1) * CHUNK_ROWS);
+            for (size_t i = chunk * CHUNK_ROWS; i < end; ++i) {
+                const int64_t point = core_tree_.nearest(rows + i * width, eps_ * eps_);
+                labels[i] = point >= 0 ? core_labels_[point] : -1;
+            }
+        });
+    }
+
+private:
+    /**
+     * @brief Stores the core rows (in row order) and their clusters, and indexes them for prediction
+     */
+    void keep_core_points(const double* rows, size_t count, const std::vector<char>& core,
+                          const std::vector<int32_t>& labels) {
+        const size_t width = features_.size();
+        core_.clear();
+        core_labels_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (!core[i]) continue;
+            core_.insert(core_.end(), rows + i * width, rows + (i + 1) * width);
+            core_labels_.push_back(labels[i]);
+        }
+        index_core_points();
+    }
+
+    void index_core_points() {
+        core_tree_ = clustering_detail::KdTree(core_.data(), num_core_points(), features_.size());
+    }
+
+    std::vector<std::string> features_;
+    double eps_ = 0.5;
+    size_t min_samples_ = 5;
+    std::vector<double> core_;          // Row-major core points
+    std::vector<int32_t> core_labels_;  // Cluster of each core point
+    clustering_detail::KdTree core_tree_; // Index of core_ for predict_batch
+};
+
+#endif // FAI_COMMON_CLUSTERING_H
@@ -0,0 +1,396 @@
+#ifndef FAI_COMMON_COLUMN_FILE_H
+#define FAI_COMMON_COLUMN_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "csv_reader.h"
+
+/**
+ * On-disk column file: a dataset already dictionary-encoded and split into row
+ * groups, so training code can stream it group by group with bounded memory.
+ *
+ * Layout (little-endian):
+ *   ColumnFileHeader
+ *   row group 0: column 0 values, column 1 values, ...
+ *   row group 1: ...
+ *   footer: per group {offset, num_rows}; per column {is_numeric, name, dictionary}
+ *
+ * Categorical columns are stored as uint32 codes into the column's dictionary
+ * (one dictionary for the whole file, values numbered in first-seen order), and
+ * numeric columns as doubles. Strings in the footer are a uint32 length followed
+ * by the bytes.
+ */
+
+const char COLUMN_FILE_MAGIC[8] = {'F', 'A', 'I', 'C', 'O', 'L', 'S', '1'};
+const uint32_t COLUMN_FILE_VERSION = 1;
+
+struct ColumnFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_columns;
+    uint64_t num_rows;
+    uint64_t num_groups;
+    uint64_t footer_offset;
+};
+
+/**
+ * @struct ColumnGroup
+ * @brief The values of one row group, one vector per column.
+ *
+ * Like CsvColumns, only `codes[c]` or `numbers[c]` is filled, depending on the
+ * column type. Columns that were not requested from read_group stay empty.
+ */
+struct ColumnGroup {
+    size_t num_rows = 0;
+    std::vector<std::vector<uint32_t>> codes;
+    std::vector<std::vector<double>> numbers;
+};
+
+/**
+ * @class ColumnFileWriter
+ * @brief Appends decoded CSV chunks to a column file as row groups.
+ *
+ * Each chunk's local dictionary codes are remapped to file-wide dictionaries,
+ * so memory grows with the number of distinct values, not with the rows.
+ *
+ * Example:
+ *   ColumnFileWriter writer;
+ *   writer.open("flows.cols");
+ *   for_each_csv_chunk("flows.csv", {"dur"}, [&](const CsvColumns& chunk) { writer.append(chunk); });
+ *   writer.close();
+ */
+class ColumnFileWriter {
+public:
+    ~ColumnFileWriter() { close(); }
+
+    bool open(const std::string& filename) {
+        out_.open(filename, std::ios::binary | std::ios::trunc);
+        if (!out_) return false;
+        ColumnFileHeader header = {};
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(out_);
+    }
+
+    /**
+     * @brief Writes one chunk as a row group; the first chunk fixes the columns
+     */
+    bool append(const CsvColumns& chunk) {
+        if (!out_.is_open()) return false;
+        if (names_.empty()) {
+            names_ = chunk.names;
+            is_numeric_ = chunk.is_numeric;
+            dictionaries_.resize(names_.size());
+            lookup_.resize(names_.size());
+        }
+        if (chunk.names != names_) return false;
+        if (chunk.num_rows == 0) return true;
+
+        groups_.push_back({static_cast<uint64_t>(out_.tellp()), chunk.num_rows});
+        std::vector<uint32_t> remapped(chunk.num_rows);
+        for (size_t c = 0; c < names_.size(); ++c) {
+            if (is_numeric_[c]) {
+                out_.write(reinterpret_cast<const char*>(chunk.numbers[c].data()), chunk.num_rows * sizeof(double));
+                continue;
+            }
+            std::vector<uint32_t> global;
+            for (const auto& value : chunk.dictionaries[c]) {
+                auto inserted = lookup_[c].emplace(value, static_cast<uint32_t>(dictionaries_[c].size()));
+                if (inserted.second) dictionaries_[c].push_back(value);
+                global.push_back(inserted.first->second);
+            }
+            for (size_t row = 0; row < chunk.num_rows; ++row) remapped[row] = global[chunk.codes[c][row]];
+            out_.write(reinterpret_cast<const char*>(remapped.data()), chunk.num_rows * sizeof(uint32_t));
+        }
+        num_rows_ += chunk.num_rows;
+        return static_cast<bool>(out_);
+    }
+
+    /**
+     * @brief Writes the footer and the final header; returns false on any write error
+     */
+    bool close() {
+        if (!out_.is_open()) return false;
+        ColumnFileHeader header = {};
+        memcpy(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic));
+        header.version = COLUMN_FILE_VERSION;
+        header.num_columns = static_cast<uint32_t>(names_.size());
+        header.num_rows = num_rows_;
+        header.num_groups = groups_.size();
+        header.footer_offset = static_cast<uint64_t>(out_.tellp());
+
+        for (const auto& group : groups_) {
+            write_u64(group.first);
+            write_u64(group.second);
+        }
+        for (size_t c = 0; c < names_.size(); ++c) {
+            out_.put(is_numeric_[c] ? 1 : 0);
+            write_string(names_[c]);
+            write_u32(static_cast<uint32_t>(dictionaries_[c].size()));
+            for (const auto& value : dictionaries_[c]) write_string(value);
+        }
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        bool ok = static_cast<bool>(out_);
+        out_.close();
+        return ok;
+    }
+
+private:
+    std::ofstream out_;
+    std::vector<std::string> names_;
+    std::vector<bool> is_numeric_;
+    std::vector<std::vector<std::string>> dictionaries_;
+    std::vector<std::unordered_map<std::string, uint32_t>> lookup_;
+    std::vector<std::pair<uint64_t, uint64_t>> groups_; // {offset, num_rows}
+    uint64_t num_rows_ = 0;
+
+    void write_u32(uint32_t value) { out_.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void write_u64(uint64_t value) { out_.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void write_string(const std::string& text) {
+        write_u32(static_cast<uint32_t>(text.size()));
+        out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+};
+
+/**
+ * @class ColumnFile
+ * @brief Reader for a column file: metadata up front, row groups on demand.
+ *
+ * open() reads only the header and footer. Row groups are fetched with pread,
+ * so several threads may read different groups of the same file at once.
+ */
+class ColumnFile {
+public:
+    ColumnFile() = default;
+    ~ColumnFile() { close(); }
+    ColumnFile(const ColumnFile&) = delete;
+    ColumnFile& operator=(const ColumnFile&) = delete;
+
+    /**
+     * @brief Opens and validates a column file; returns false if it is missing or malformed
+     */
+    bool open(const std::string& filename) {
+        close();
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if (fd_ < 0) return false;
+        if (!read_metadata()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        names_.clear();
+        is_numeric_.clear();
+        dictionaries_.clear();
+        groups_.clear();
+        num_rows_ = 0;
+    }
+
+    size_t num_rows() const { return num_rows_; }
+    size_t num_columns() const { return names_.size(); }
+    size_t num_groups() const { return groups_.size(); }
+    size_t group_rows(size_t g) const { return groups_[g].num_rows; }
+    const std::vector<std::string>& names() const { return names_; }
+    bool is_numeric(size_t c) const { return is_numeric_[c]; }
+    const std::vector<std::string>& dictionary(size_t c) const { return dictionaries_[c]; }
+
+    /**
+     * @brief Index of a column by name, or -1 if there is no such column
+     */
+    int column(const std::string& name) const {
+        for (size_t c = 0; c < names_.size(); ++c) {
+            if (names_[c] == name) return static_cast<int>(c);
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Reads row group g into `group`, reusing its buffers
+     *
+     * @param g Index of the row group.
+     * @param group Destination; its vectors keep their capacity between calls.
+     * @param wanted Columns to read (empty reads all of them); the others are left empty.
+     * @return bool false on a read error, or if a code is not below its dictionary's size.
+     */
+    bool read_group(size_t g, ColumnGroup& group, const std::vector<bool>& wanted = {}) const {
+        const size_t rows = groups_[g].num_rows;
+        group.num_rows = rows;
+        group.codes.resize(names_.size());
+        group.numbers.resize(names_.size());
+        uint64_t offset = groups_[g].offset;
+        for (size_t c = 0; c < names_.size(); ++c) {
+            const size_t bytes = rows * (is_numeric_[c] ? sizeof(double) : sizeof(uint32_t));
+            if (!wanted.empty() && !wanted[c]) {
+                group.codes[c].clear();
+                group.numbers[c].clear();
+            } else if (is_numeric_[c]) {
+                group.numbers[c].resize(rows);
+                if (!read_at(group.numbers[c].data(), bytes, offset)) return false;
+            } else {
+                group.codes[c].resize(rows);
+                if (!read_at(group.codes[c].data(), bytes, offset)) return false;
+                // Callers index dictionary(c) and tables of the same size with these codes
+                const size_t dictionary_size = dictionaries_[c].size();
+                for (uint32_t code : group.codes[c]) {
+                    if (code >= dictionary_size) return false;
+                }
+            }
+            offset += bytes;
+        }
+        return true;
+    }
+
+private:
+    struct GroupInfo {
+        uint64_t offset;
+        uint64_t num_rows;
+    };
+
+    int fd_ = -1;
+    std::vector<std::string> names_;
+    std::vector<bool> is_numeric_;
+    std::vector<std::vector<std::string>> dictionaries_;
+    std::vector<GroupInfo> groups_;
+    size_t num_rows_ = 0;
+
+    bool read_at(void* out, size_t bytes, uint64_t offset) const {
+        char* p = static_cast<char*>(out);
+        while (bytes > 0) {
+            ssize_t n = pread(fd_, p, bytes, static_cast<off_t>(offset));
+            if (n <= 0) return false;
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool read_metadata() {
+        ColumnFileHeader header;
+        if (!read_at(&header, sizeof(header), 0)) return false;
+        if (memcmp(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic)) != 0) return false;
+        if (header.version != COLUMN_FILE_VERSION) return false;
+
+        off_t file_size = lseek(fd_, 0, SEEK_END);
+        if (file_size < 0 || header.footer_offset > static_cast<uint64_t>(file_size)) return false;
+        std::vector<char> footer(static_cast<size_t>(file_size) - header.footer_offset);
+        if (!footer.empty() && !read_at(footer.data(), footer.size(), header.footer_offset)) return false;
+
+        size_t pos = 0;
+        auto take = [&](void* out, size_t bytes) {
+            if (footer.size() - pos < bytes) return false;
+            memcpy(out, footer.data() + pos, bytes);
+            pos += bytes;
+            return true;
+        };
+        auto take_string = [&](std::string& text) {
+            uint32_t length;
+            if (!take(&length, sizeof(length)) || footer.size() - pos < length) return false;
+            text.assign(footer.data() + pos, length);
+            pos += length;
+            return true;
+        };
+
+        // Each group entry takes 16 bytes and each column at least 9, so sizes the footer cannot hold are rejected
+        // before anything is allocated for them
+        if (header.num_groups > footer.size() / (2 * sizeof(uint64_t))) return false;
+        if (header.num_columns > (footer.size() - header.num_groups * 2 * sizeof(uint64_t)) / 9) return false;
+
+        uint64_t rows = 0;
+        groups_.resize(header.num_groups);
+        for (auto& group : groups_) {
+            if (!take(&group.offset, sizeof(group.offset)) || !take(&group.num_rows, sizeof(group.num_rows))) return false;
+            rows += group.num_rows;
+        }
+        if (rows != header.num_rows) return false;
+        names_.resize(header.num_columns);
+        dictionaries_.resize(header.num_columns);
+        for (size_t c = 0; c < header.num_columns; ++c) {
+            char numeric;
+            uint32_t size;
+            if (!take(&numeric, 1) || !take_string(names_[c]) || !take(&size, sizeof(size))) return false;
+            is_numeric_.push_back(numeric != 0);
+            if (size > (footer.size() - pos) / sizeof(uint32_t)) return false;
+            dictionaries_[c].resize(size);
+            for (auto& value : dictionaries_[c]) {
+                if (!take_string(value)) return false;
+            }
+        }
+
+        // Every group must fit before the footer
+        size_t row_bytes = 0;
+        for (size_t c = 0; c < header.num_columns; ++c) row_bytes += is_numeric_[c] ? sizeof(double) : sizeof(uint32_t);
+        for (const auto& group : groups_) {
+            if (group.offset < sizeof(header) || group.offset > header.footer_offset) return false;
+            if (row_bytes > 0 && group.num_rows > (header.footer_offset - group.offset) / row_bytes) return false;
+        }
+        num_rows_ = static_cast<size_t>(header.num_rows);
+        return true;
+    }
+};
+
+/**
+ * @brief Calls fn(group) for every row group in order, reading the next group while fn runs
+ *
+ * Two buffers alternate: while fn works on group g in one buffer, a background
+ * read fills the other with group g + 1, so disk I/O overlaps with compute and at
+ * most two groups are in memory at a time.
+ *
+ * @param file An open column file.
+ * @param wanted Columns to read (empty reads all of them).
+ * @param fn Called with each `const ColumnGroup&`.
+ * @return bool false if a read failed (fn is not called for that group or later ones).
+ */
+template <typename GroupFn>
+bool for_each_column_group(const ColumnFile& file, const std::vector<bool>& wanted, GroupFn fn) {
+    const size_t num_groups = file.num_groups();
+    if (num_groups == 0) return true;
+    ColumnGroup buffers[2];
+    std::future<bool> loading =
+        std::async(std::launch::async, [&file, &buffers, &wanted] { return file.read_group(0, buffers[0], wanted); });
+    for (size_t g = 0; g < num_groups; ++g) {
+        if (!loading.get()) return false;
+        if (g + 1 < num_groups) {
+            loading = std::async(std::launch::async, [&file, &buffers, &wanted, g] {
+                return file.read_group(g + 1, buffers[(g + 1) % 2], wanted);
+            });
+        }
+        fn(static_cast<const ColumnGroup&>(buffers[g % 2]));
+    }
+    return true;
+}
+
+/**
+ * @brief Converts a CSV file to a column file, one row group per CSV chunk
+ *
+ * Memory stays bounded by one chunk plus the dictionaries, so the CSV may be far
+ * larger than RAM.
+ *
+ * @param csv_filename Path of the CSV file; the first line is the header.
+ * @param column_filename Path of the column file to write.
+ * @param numeric_columns Names of columns stored as numbers instead of codes.
+ * @return bool false if the CSV could not be read or the output could not be written.
+ */
+inline bool convert_csv_to_column_file(const std::string& csv_filename, const std::string& column_filename,
+                                       const std::vector<std::string>& numeric_columns = {}) {
+    ColumnFileWriter writer;
+    if (!writer.open(column_filename)) return false;
+    bool ok = true;
+    bool read = for_each_csv_chunk(csv_filename, numeric_columns,
+                                   [&](const CsvColumns& chunk) { ok = writer.append(chunk) && ok; });
+    return writer.close() && read && ok;
+}
+
+#endif // FAI_COMMON_COLUMN_FILE_H
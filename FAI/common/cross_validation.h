@@ -0,0 +1,171 @@
+#ifndef FAI_COMMON_CROSS_VALIDATION_H
+#define FAI_COMMON_CROSS_VALIDATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "task_scheduler.h"
+
+/**
+ * @struct Fold
+ * @brief One train/test split of a dataset, as row indices into it.
+ *
+ * Learners read `data[train[i]]` directly, so no Example is ever copied.
+ */
+struct Fold {
+    std::vector<size_t> train;
+    std::vector<size_t> test;
+};
+
+/**
+ * @brief Returns 0..n-1 in an order shuffled by `seed`
+ */
+inline std::vector<size_t> shuffled_rows(size_t n, uint32_t seed) {
+    std::vector<size_t> rows(n);
+    for (size_t i = 0; i < n; ++i) rows[i] = i;
+    std::mt19937 rng(seed);
+    std::shuffle(rows.begin(), rows.end(), rng);
+    return rows;
+}
+
+/**
+ * @brief Shuffled counterpart of split_data: the first `train_ratio` of a seeded permutation trains
+ */
+inline Fold shuffle_split(size_t n, double train_ratio, uint32_t seed) {
+    std::vector<size_t> rows = shuffled_rows(n, seed);
+    size_t train_size = static_cast<size_t>(n * train_ratio);
+    Fold fold;
+    fold.train.assign(rows.begin(), rows.begin() + train_size);
+    fold.test.assign(rows.begin() + train_size, rows.end());
+    return fold;
+}
+
+/**
+ * @brief Splits rows into k stratified folds
+ *
+ * The rows of each label are shuffled and dealt round-robin to the folds, with
+ * the deal continuing from one label to the next, so every fold gets the same
+ * share of each label (within one row) and the folds differ in size by at most
+ * one. Fold i tests on its own rows and trains on all others. Both lists follow
+ * one seeded permutation of the data, so SGD learners see a shuffled order.
+ *
+ * Example: labels {0,0,0,0,1,1} with k = 2 gives two folds of three rows, each
+ * testing on two 0s and one 1.
+ *
+ * A label with fewer than k rows cannot reach every fold: its rows go to as
+ * many folds as it has, and the other folds test on none of that label (and so
+ * train on all of it). The remaining labels stay stratified.
+ *
+ * @param labels Label id of every row (any small non-negative integers).
+ * @param k Number of folds, from 2 to labels.size().
+ * @param seed Seed of the shuffles.
+ * @return std::vector<Fold> The k folds.
+ * @throws std::invalid_argument If k < 2 (no training or no test rows) or k > labels.size() (empty test folds).
+ */
+inline std::vector<Fold> stratified_k_fold(const std::vector<int>& labels, size_t k, uint32_t seed) {
+    const size_t n = labels.size();
+    if (k < 2 || k > n) {
+        throw std::invalid_argument("stratified_k_fold needs 2 <= k <= " + std::to_string(n) + " folds, got " +
+                                    std::to_string(k));
+    }
+    std::vector<size_t> order = shuffled_rows(n, seed);
+
+    // Stable partition of the shuffled rows by label, then deal them out
+    std::vector<size_t> by_label = order;
+    std::stable_sort(by_label.begin(), by_label.end(), [&](size_t a, size_t b) { return labels[a] < labels[b]; });
+    std::vector<size_t> fold_of(n);
+    for (size_t i = 0; i < n; ++i) fold_of[by_label[i]] = i % k;
+
+    std::vector<Fold> folds(k);
+    for (size_t f = 0; f < k; ++f) {
+        for (size_t row : order) (fold_of[row] == f ? folds[f].test : folds[f].train).push_back(row);
+    }
+    return folds;
+}
+
+/**
+ * @struct CrossValidationResult
+ * @brief Scores of one configuration on every fold.
+ */
+struct CrossValidationResult {
+    std::string name;
+    std::vector<double> scores;
+    double mean = 0.0;
+    double stddev = 0.0;
+};
+
+/**
+ * @struct CrossValidationReport
+ * @brief All configurations' results and the index of the one with the best mean score.
+ */
+struct CrossValidationReport {
+    std::vector<CrossValidationResult> results;
+    size_t best = 0;
+};
+
+/**
+ * @brief Trains and scores every (configuration, fold) pair concurrently
+ *
+ * Each pair is one task on the scheduler, so a grid of C configurations and k
+ * folds keeps up to C x k threads busy; learners that fork work of their own
+ * (such as train_random_forest) nest inside these tasks. The report does not
+ * depend on the number of threads: every score lands in its own slot and the
+ * aggregation runs afterwards in configuration order. Ties for the best mean go
+ * to the earlier configuration.
+ *
+ * Example:
+ *   vector<double> rates = {0.1, 0.7};
+ *   CrossValidationReport report = cross_validate(rates, {"lr 0.1", "lr 0.7"}, folds,
+ *       [&](double rate, const Fold& fold) { return train_and_score(rate, fold); }, scheduler);
+ *
+ * @param configs Hyperparameter configurations.
+ * @param names Display name of each configuration.
+ * @param folds Splits to evaluate on (see stratified_k_fold).
+ * @param train_and_score Called as fn(config, fold); returns the score (higher is better).
+ * @param scheduler Scheduler that runs the tasks.
+ * @return CrossValidationReport Per-configuration scores, mean and standard deviation.
+ */
+template <typename Config, typename TrainAndScore>
+CrossValidationReport cross_validate(const std::vector<Config>& configs, const std::vector<std::string>& names,
+                                     const std::vector<Fold>& folds, TrainAndScore train_and_score,
+                                     TaskScheduler& scheduler) {
+    const size_t num_folds = folds.size();
+    std::vector<double> scores(configs.size() * num_folds, 0.0);
+    scheduler.parallel_for(0, scores.size(), [&](size_t task) {
+        scores[task] = train_and_score(configs[task / num_folds], folds[task % num_folds]);
+    });
+
+    CrossValidationReport report;
+    for (size_t c = 0; c < configs.size(); ++c) {
+        CrossValidationResult result;
+        result.name = c < names.size() ? names[c] : "config " + std::to_string(c);
+        result.scores.assign(scores.begin() + c * num_folds, scores.begin() + (c + 1) * num_folds);
+        for (double score : result.scores) result.mean += score;
+        result.mean /= std::max<size_t>(num_folds, 1);
+        for (double score : result.scores) result.stddev += (score - result.mean) * (score - result.mean);
+        result.stddev = std::sqrt(result.stddev / std::max<size_t>(num_folds, 1));
+        report.results.push_back(result);
+        if (report.results[c].mean > report.results[report.best].mean) report.best = c;
+    }
+    return report;
+}
+
+/**
+ * @brief Prints one line per configuration (mean, standard deviation, fold scores) and the winner
+ */
+inline void print_cross_validation_report(const CrossValidationReport& report, std::ostream& out) {
+    for (const auto& result : report.results) {
+        out << result.name << ": mean " << result.mean << ", stddev " << result.stddev << ", folds";
+        for (double score : result.scores) out << " " << score;
+        out << "\n";
+    }
+    if (!report.results.empty()) out << "Best configuration: " << report.results[report.best].name << "\n";
+}
+
+#endif // FAI_COMMON_CROSS_VALIDATION_H
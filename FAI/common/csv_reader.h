@@ -0,0 +1,393 @@
+#ifndef FAI_COMMON_CSV_READER_H
+#define FAI_COMMON_CSV_READER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "task_scheduler.h"
+
+/**
+ * @struct CsvColumns
+ * @brief A CSV file decoded column by column.
+ *
+ * Categorical columns are dictionary-encoded: `codes[c][row]` indexes
+ * `dictionaries[c]`, whose values are numbered in the order they first appear
+ * in the file. Numeric columns are parsed into `numbers[c]` instead (empty or
+ * unparsable cells read as 0). Only one of `codes[c]` / `numbers[c]` is filled.
+ *
+ * For example, the PA4 dataset "Author,Thread,..." gives `dictionaries[0]` =
+ * {"known", "unknown"} and `codes[0]` = {0, 1, 1, 0, ...}.
+ */
+struct CsvColumns {
+    std::vector<std::string> names;
+    std::vector<bool> is_numeric;
+    std::vector<std::vector<std::string>> dictionaries;
+    std::vector<std::vector<uint32_t>> codes;
+    std::vector<std::vector<double>> numbers;
+    size_t num_rows = 0;
+
+    /**
+     * @brief Index of a column by header name, or -1 if there is no such column
+     */
+    int column(const std::string& name) const {
+        for (size_t c = 0; c < names.size(); ++c) {
+            if (names[c] == name) return static_cast<int>(c);
+        }
+        return -1;
+    }
+
+    /**
+     * @brief The decoded value of a categorical cell
+     */
+    const std::string& value(size_t c, size_t row) const { return dictionaries[c][codes[c][row]]; }
+};
+
+namespace csv_detail {
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* base = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base != MAP_FAILED) {
+                data_ = static_cast<const char*>(base);
+                size_ = static_cast<size_t>(info.st_size);
+                madvise(base, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Bit i is set if p[i] is ',' or '\n', for the 64 bytes starting at p
+ *
+ * Uses two 32-byte compares with AVX2, four 16-byte compares with SSE2, and a
+ * byte loop elsewhere.
+ */
+inline uint64_t delimiter_mask(const char* p) {
+#if defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int half = 0; half < 2; ++half) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * half));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma), _mm256_cmpeq_epi8(bytes, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hits))) << (32 * half);
+    }
+    return mask;
+#elif defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int quarter = 0; quarter < 4; ++quarter) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * quarter));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(hits))) << (16 * quarter);
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; ++i) {
+        if (p[i] == ',' || p[i] == '\n') mask |= uint64_t(1) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Calls on_field(column, text) for every cell and on_row() after every line in [begin, end)
+ *
+ * The range is scanned in 64-byte blocks: each block becomes a bit mask of
+ * delimiter positions, and the cells are cut out by walking the set bits, so the
+ * loop does one vector compare per 64 bytes instead of one branch per byte. Cells
+ * are string_views into the mapping and a trailing '\r' is dropped. Quoted
+ * fields are not supported. Blank lines are skipped.
+ */
+template <typename FieldFn, typename RowFn>
+void tokenize(const char* begin, const char* end, FieldFn on_field, RowFn on_row) {
+    const char* field_start = begin;
+    size_t column = 0;
+    auto emit = [&](const char* field_end, bool row_end) {
+        std::string_view text(field_start, static_cast<size_t>(field_end - field_start));
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        bool blank_line = row_end && column == 0 && text.empty();
+        if (!blank_line) on_field(column, text);
+        ++column;
+        if (row_end) {
+            if (!blank_line) on_row(column);
+            column = 0;
+        }
+    };
+
+    char tail[64];
+    for (const char* block = begin; block < end; block += 64) {
+        uint64_t mask;
+        if (end - block >= 64) {
+            mask = delimiter_mask(block);
+        } else {
+            size_t left = static_cast<size_t>(end - block);
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, block, left);
+            mask = delimiter_mask(tail) & ((uint64_t(1) << left) - 1);
+        }
+        while (mask) {
+            const char* delimiter = block + __builtin_ctzll(mask);
+            emit(delimiter, *delimiter == '\n');
+            field_start = delimiter + 1;
+            mask &= mask - 1;
+        }
+    }
+    // Last line without a trailing newline
+    if (field_start < end || column > 0) emit(end, true);
+}
+
+/**
+ * @brief Everything one chunk of the file decodes to, before the chunks are merged
+ */
+struct ChunkColumns {
+    size_t num_rows = 0;
+    std::vector<std::unordered_map<std::string_view, uint32_t>> lookup;
+    std::vector<std::vector<std::string_view>> dictionaries;
+    std::vector<std::vector<uint32_t>> codes;
+    std::vector<std::vector<double>> numbers;
+};
+
+inline double parse_number(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+    double value = 0.0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+inline ChunkColumns decode_chunk(const char* begin, const char* end, const std::vector<bool>& is_numeric) {
+    const size_t num_columns = is_numeric.size();
+    ChunkColumns chunk;
+    chunk.lookup.resize(num_columns);
+    chunk.dictionaries.resize(num_columns);
+    chunk.codes.resize(num_columns);
+    chunk.numbers.resize(num_columns);
+
+    auto on_field = [&](size_t c, std::string_view text) {
+        if (c >= num_columns) return;
+        if (is_numeric[c]) {
+            chunk.numbers[c].push_back(parse_number(text));
+            return;
+        }
+        auto inserted = chunk.lookup[c].emplace(text, static_cast<uint32_t>(chunk.dictionaries[c].size()));
+        if (inserted.second) chunk.dictionaries[c].push_back(text);
+        chunk.codes[c].push_back(inserted.first->second);
+    };
+    auto on_row = [&](size_t fields) {
+        // Short rows get empty cells so that every column keeps one entry per row
+        for (size_t c = fields; c < num_columns; ++c) on_field(c, std::string_view());
+        chunk.num_rows++;
+    };
+    tokenize(begin, end, on_field, on_row);
+    return chunk;
+}
+
+} // namespace csv_detail
+
+// Target size of the file ranges that are decoded independently
+const size_t CSV_CHUNK_BYTES = size_t(8) << 20;
+
+namespace csv_detail {
+
+/**
+ * @brief Reads the header line into `columns` and returns where the data starts
+ */
+inline const char* read_header(const char* data, const char* end, const std::vector<std::string>& numeric_columns,
+                               CsvColumns& columns) {
+    const char* header_end = static_cast<const char*>(memchr(data, '\n', static_cast<size_t>(end - data)));
+    header_end = header_end ? header_end : end;
+    tokenize(data, header_end, [&](size_t, std::string_view name) { columns.names.emplace_back(name); },
+             [](size_t) {});
+    for (const auto& name : columns.names) {
+        columns.is_numeric.push_back(find(numeric_columns.begin(), numeric_columns.end(), name) != numeric_columns.end());
+    }
+    return std::min(header_end + 1, end);
+}
+
+/**
+ * @brief Cuts [begin, end) into ranges of about CSV_CHUNK_BYTES that start right after a newline
+ *
+ * @return The range boundaries; range i is [bounds[i], bounds[i + 1]).
+ */
+inline std::vector<const char*> line_ranges(const char* begin, const char* end) {
+    std::vector<const char*> bounds = {begin};
+    while (bounds.back() < end) {
+        const char* next = bounds.back() + std::min(CSV_CHUNK_BYTES, static_cast<size_t>(end - bounds.back()));
+        if (next < end) {
+            const char* newline = static_cast<const char*>(memchr(next, '\n', static_cast<size_t>(end - next)));
+            next = newline ? newline + 1 : end;
+        }
+        bounds.push_back(next);
+    }
+    return bounds;
+}
+
+} // namespace csv_detail
+
+/**
+ * @brief Reads a CSV file through a memory mapping, decoding each column in one pass
+ *
+ * Steps:
+ * 1. Map the file and read the header line for the column names.
+ * 2. Cut the rest into ranges of about CSV_CHUNK_BYTES that start right after a
+ *    newline, so no line is split between ranges.
+ * 3. Decode every range on its own (as tasks on `scheduler` if one is given):
+ *    cells are found with SIMD delimiter masks and categorical cells are looked
+ *    up in a per-range dictionary of string_views into the mapping; no per-cell
+ *    strings are allocated.
+ * 4. Merge the range dictionaries in file order into one dictionary per column
+ *    and rewrite each range's codes into the final column arrays.
+ *
+ * The result does not depend on the number of threads. A missing or empty file
+ * gives an empty result.
+ *
+ * @param filename Path of the CSV file; the first line is the header.
+ * @param numeric_columns Names of columns to parse as numbers instead of encoding them.
+ * @param scheduler Optional scheduler for decoding ranges in parallel.
+ * @return CsvColumns The decoded columns.
+ */
+inline CsvColumns read_csv_columns(const std::string& filename,
+                                   const std::vector<std::string>& numeric_columns = {},
+                                   TaskScheduler* scheduler = nullptr) {
+    CsvColumns result;
+    csv_detail::MappedFile file(filename);
+    if (file.data() == nullptr) return result;
+    const char* data = file.data();
+    const char* end = data + file.size();
+
+    const char* body = csv_detail::read_header(data, end, numeric_columns, result);
+    const size_t num_columns = result.names.size();
+    std::vector<const char*> bounds = csv_detail::line_ranges(body, end);
+    const size_t num_chunks = bounds.size() - 1;
+
+    std::vector<csv_detail::ChunkColumns> chunks(num_chunks);
+    auto decode = [&](size_t i) { chunks[i] = csv_detail::decode_chunk(bounds[i], bounds[i + 1], result.is_numeric); };
+    if (scheduler && num_chunks > 1) {
+        scheduler->parallel_for(0, num_chunks, decode);
+    } else {
+        for (size_t i = 0; i < num_chunks; ++i) decode(i);
+    }
+
+    // Merge: global dictionaries in file order, then remap each chunk's codes
+    std::vector<size_t> row_offset(num_chunks + 1, 0);
+    for (size_t i = 0; i < num_chunks; ++i) row_offset[i + 1] = row_offset[i] + chunks[i].num_rows;
+    result.num_rows = row_offset[num_chunks];
+
+    result.dictionaries.resize(num_columns);
+    result.codes.resize(num_columns);
+    result.numbers.resize(num_columns);
+    std::vector<std::vector<std::vector<uint32_t>>> remap(num_columns, std::vector<std::vector<uint32_t>>(num_chunks));
+    for (size_t c = 0; c < num_columns; ++c) {
+        if (result.is_numeric[c]) {
+            result.numbers[c].resize(result.num_rows);
+            continue;
+        }
+        std::unordered_map<std::string_view, uint32_t> global;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            for (std::string_view value : chunks[i].dictionaries[c]) {
+                auto inserted = global.emplace(value, static_cast<uint32_t>(result.dictionaries[c].size()));
+                if (inserted.second) result.dictionaries[c].emplace_back(value);
+                remap[c][i].push_back(inserted.first->second);
+            }
+        }
+        result.codes[c].resize(result.num_rows);
+    }
+
+    auto scatter = [&](size_t i) {
+        for (size_t c = 0; c < num_columns; ++c) {
+            if (result.is_numeric[c]) {
+                std::copy(chunks[i].numbers[c].begin(), chunks[i].numbers[c].end(),
+                          result.numbers[c].begin() + row_offset[i]);
+                continue;
+            }
+            const std::vector<uint32_t>& local = chunks[i].codes[c];
+            uint32_t* out = result.codes[c].data() + row_offset[i];
+            for (size_t row = 0; row < local.size(); ++row) out[row] = remap[c][i][local[row]];
+        }
+    };
+    if (scheduler && num_chunks > 1) {
+        scheduler->parallel_for(0, num_chunks, scatter);
+    } else {
+        for (size_t i = 0; i < num_chunks; ++i) scatter(i);
+    }
+    return result;
+}
+
+/**
+ * @brief Streams a CSV file range by range with bounded memory
+ *
+ * Calls fn(chunk) once per range of about CSV_CHUNK_BYTES, in file order. Each
+ * chunk is a CsvColumns holding only that range's rows, with its own dictionaries
+ * (codes are local to the chunk). Use this instead of read_csv_columns when the
+ * file does not fit in memory, for example to convert it to a column file.
+ *
+ * @param filename Path of the CSV file; the first line is the header.
+ * @param numeric_columns Names of columns to parse as numbers instead of encoding them.
+ * @param fn Called with each decoded chunk.
+ * @return bool false if the file could not be opened.
+ */
+template <typename ChunkFn>
+bool for_each_csv_chunk(const std::string& filename, const std::vector<std::string>& numeric_columns, ChunkFn fn) {
+    csv_detail::MappedFile file(filename);
+    if (file.data() == nullptr) return false;
+    const char* end = file.data() + file.size();
+
+    CsvColumns header;
+    const char* body = csv_detail::read_header(file.data(), end, numeric_columns, header);
+    std::vector<const char*> bounds = csv_detail::line_ranges(body, end);
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        csv_detail::ChunkColumns decoded = csv_detail::decode_chunk(bounds[i], bounds[i + 1], header.is_numeric);
+        CsvColumns chunk;
+        chunk.names = header.names;
+        chunk.is_numeric = header.is_numeric;
+        chunk.num_rows = decoded.num_rows;
+        chunk.codes = std::move(decoded.codes);
+        chunk.numbers = std::move(decoded.numbers);
+        for (const auto& values : decoded.dictionaries) {
+            chunk.dictionaries.emplace_back(values.begin(), values.end());
+        }
+        fn(chunk);
+    }
+    return true;
+}
+
+#endif // FAI_COMMON_CSV_READER_H
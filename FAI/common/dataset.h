@@ -0,0 +1,195 @@
+#ifndef FAI_COMMON_DATASET_H
+#define FAI_COMMON_DATASET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "csv_reader.h"
+
+/**
+ * @struct AlignedAllocator
+ * @brief std::allocator replacement whose blocks start on an `Alignment`-byte boundary.
+ *
+ * 64 bytes is a cache line and a full AVX-512 register, so every column of a
+ * Dataset starts where vector loads are aligned and no line is shared between
+ * two columns.
+ */
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @class Dataset
+ * @brief A labelled dataset stored as contiguous float32 columns plus an int32 label array.
+ *
+ * Feature f of every row lives in `column(f)`, a 64-byte-aligned float array, and
+ * the label of every row in `labels()`, numbered 0..label_names().size()-1. This
+ * takes 4 bytes per cell and none per row, where a vector of Examples pays a heap
+ * block per row, and loops over one feature read consecutive memory and
+ * vectorise.
+ *
+ * Categorical features are stored as their dictionary codes (exact in float32 up
+ * to 2^24 values), with the values in `dictionary(f)`; numeric features have an
+ * empty dictionary.
+ *
+ * Learners never copy rows: subsets (train/test splits, folds, bootstrap samples)
+ * are index views, i.e. vectors of row numbers into one Dataset, as elsewhere in
+ * these programs. gather() packs a view into a row-major block for batch learners.
+ */
+class Dataset {
+public:
+    Dataset() = default;
+
+    /**
+     * @brief An all-zero dataset with the given features and `num_rows` rows
+     */
+    Dataset(const std::vector<std::string>& feature_names, size_t num_rows)
+        : feature_names_(feature_names), dictionaries_(feature_names.size()),
+          columns_(feature_names.size(), AlignedVector<float>(num_rows, 0.0f)), labels_(num_rows, 0),
+          num_rows_(num_rows) {}
+
+    size_t num_rows() const { return num_rows_; }
+    size_t num_features() const { return feature_names_.size(); }
+    const std::vector<std::string>& feature_names() const { return feature_names_; }
+
+    /**
+     * @brief Index of a feature by name, or -1 if there is no such feature
+     */
+    int feature_index(const std::string& name) const {
+        for (size_t f = 0; f < feature_names_.size(); ++f) {
+            if (feature_names_[f] == name) return static_cast<int>(f);
+        }
+        return -1;
+    }
+
+    float* column(size_t f) { return columns_[f].data(); }
+    const float* column(size_t f) const { return columns_[f].data(); }
+    float value(size_t row, size_t f) const { return columns_[f][row]; }
+
+    int32_t* labels() { return labels_.data(); }
+    const int32_t* labels() const { return labels_.data(); }
+    int32_t label(size_t row) const { return labels_[row]; }
+
+    /**
+     * @brief Names of the labels, indexed by label id
+     */
+    const std::vector<std::string>& label_names() const { return label_names_; }
+    void set_label_names(const std::vector<std::string>& names) { label_names_ = names; }
+
+    /**
+     * @brief Values of a categorical feature, indexed by code (empty for numeric features)
+     */
+    const std::vector<std::string>& dictionary(size_t f) const { return dictionaries_[f]; }
+    void set_dictionary(size_t f, const std::vector<std::string>& values) { dictionaries_[f] = values; }
+    bool is_categorical(size_t f) const { return !dictionaries_[f].empty(); }
+
+    /**
+     * @brief Bytes held by the feature columns and labels
+     */
+    size_t memory_bytes() const {
+        size_t total = labels_.capacity() * sizeof(int32_t);
+        for (const auto& column : columns_) total += column.capacity() * sizeof(float);
+        return total;
+    }
+
+    /**
+     * @brief Copies rows `rows[0..count)` into a row-major `count` x num_features() block
+     */
+    template <typename T>
+    void gather(const size_t* rows, size_t count, T* out) const {
+        const size_t width = num_features();
+        for (size_t f = 0; f < width; ++f) {
+            const float* values = columns_[f].data();
+            for (size_t r = 0; r < count; ++r) out[r * width + f] = static_cast<T>(values[rows[r]]);
+        }
+    }
+
+    /**
+     * @brief Builds a dataset from decoded CSV or Parquet columns
+     *
+     * Numeric columns are narrowed to float32, categorical ones keep their codes
+     * and dictionaries; a feature missing from `columns` reads as 0. The label ids
+     * follow the sorted order of the distinct label values (so equal values that
+     * appear under several codes, e.g. after relabelling a dictionary, share an id).
+     *
+     * Example: from_columns(read_csv_columns("flows.csv", {"dur"}), {"dur"}, "label")
+     *
+     * @param columns Decoded columns.
+     * @param features Names of the columns that become features, in order.
+     * @param label_column Name of the label column.
+     * @return Dataset The new dataset.
+     */
+    static Dataset from_columns(const CsvColumns& columns, const std::vector<std::string>& features,
+                                const std::string& label_column) {
+        Dataset data(features, columns.num_rows);
+        for (size_t f = 0; f < features.size(); ++f) {
+            int c = columns.column(features[f]);
+            if (c < 0) continue;
+            float* out = data.column(f);
+            if (columns.is_numeric[c]) {
+                for (size_t row = 0; row < data.num_rows_; ++row) out[row] = static_cast<float>(columns.numbers[c][row]);
+            } else {
+                for (size_t row = 0; row < data.num_rows_; ++row) out[row] = static_cast<float>(columns.codes[c][row]);
+                data.dictionaries_[f] = columns.dictionaries[c];
+            }
+        }
+
+        int c = columns.column(label_column);
+        if (c < 0 || columns.is_numeric[c]) return data;
+        const std::vector<std::string>& values = columns.dictionaries[c];
+        data.label_names_ = values;
+        std::sort(data.label_names_.begin(), data.label_names_.end());
+        data.label_names_.erase(std::unique(data.label_names_.begin(), data.label_names_.end()), data.label_names_.end());
+        std::vector<int32_t> id(values.size());
+        for (size_t code = 0; code < values.size(); ++code) {
+            id[code] = static_cast<int32_t>(
+                std::lower_bound(data.label_names_.begin(), data.label_names_.end(), values[code]) - data.label_names_.begin());
+        }
+        for (size_t row = 0; row < data.num_rows_; ++row) data.labels_[row] = id[columns.codes[c][row]];
+        return data;
+    }
+
+private:
+    std::vector<std::string> feature_names_;
+    std::vector<std::vector<std::string>> dictionaries_;
+    std::vector<std::string> label_names_;
+    std::vector<AlignedVector<float>> columns_;
+    AlignedVector<int32_t> labels_;
+    size_t num_rows_ = 0;
+};
+
+/**
+ * @brief Returns 0..n-1, the index view of a whole dataset
+ */
+inline std::vector<size_t> all_rows(const Dataset& data) {
+    std::vector<size_t> rows(data.num_rows());
+    for (size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+    return rows;
+}
+
+#endif // FAI_COMMON_DATASET_H
@@ -0,0 +1,295 @@
+#ifndef FAI_COMMON_FAST_MATH_H
+#define FAI_COMMON_FAST_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Vectorised exp and sigmoid over arrays, with a selectable precision tier.
+ *
+ * exp(x) is computed the usual way: x = n * ln2 + r with n an integer and
+ * |r| <= ln2 / 2, exp(r) by a Taylor polynomial, and 2^n built directly in the
+ * exponent bits. The degree of the polynomial sets the accuracy:
+ *
+ *   Exact   std::exp itself (bit-identical to the scalar sigmoid of PA5)
+ *   High    degree 11, relative error around 1e-14
+ *   Medium  degree 6, relative error around 1e-7 (float-level)
+ *   Low     degree 3, relative error around 1e-3
+ *
+ * Inputs are clamped to [-708, 709], so results stay finite and normal. Built
+ * with AVX2 and FMA (-mavx2 -mfma or -march=native), the polynomial tiers run
+ * 8 lanes per iteration as two 4-wide vectors; otherwise a branch-free scalar
+ * loop is used. measure_approximation_error reports each tier's worst case.
+ *
+ * Float arrays have their own kernel with float constants, clamped to
+ * [-87.3, 88.3], which runs 8 lanes per __m256 with AVX2. High uses degree 7
+ * there, since float rounding (around 1e-7) dominates beyond that; Medium and
+ * Low keep their degrees. Exact float arrays call the float std::exp, so they
+ * match the scalar float sigmoid of PA5 bit for bit.
+ */
+
+enum class ActivationPrecision { Exact, High, Medium, Low };
+
+namespace fast_math_detail {
+
+const double EXP_MIN = -708.0;
+const double EXP_MAX = 709.0;
+const double LOG2E = 1.4426950408889634;
+const double LN2_HI = 0.693145751953125;       // ln 2 with its low bits cleared, so n * LN2_HI is exact
+const double LN2_LO = 1.4286068203094173e-06;  // ln 2 - LN2_HI
+const double ROUND_MAGIC = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to an integer in the low bits
+
+// 1 / k! for the Taylor series of exp
+const double INVERSE_FACTORIAL[] = {1.0,
+                                    1.0,
+                                    1.0 / 2,
+                                    1.0 / 6,
+                                    1.0 / 24,
+                                    1.0 / 120,
+                                    1.0 / 720,
+                                    1.0 / 5040,
+                                    1.0 / 40320,
+                                    1.0 / 362880,
+                                    1.0 / 3628800,
+                                    1.0 / 39916800};
+
+template <int Degree>
+inline double exp_scalar(double x) {
+    x = std::min(std::max(x, EXP_MIN), EXP_MAX);
+    double shifted = x * LOG2E + ROUND_MAGIC;
+    double n = shifted - ROUND_MAGIC;
+    double r = (x - n * LN2_HI) - n * LN2_LO;
+
+    double p = INVERSE_FACTORIAL[Degree];
+    for (int k = Degree - 1; k >= 0; --k) p = p * r + INVERSE_FACTORIAL[k];
+
+    // The low mantissa bits of `shifted` hold n; move n + 1023 into the exponent field
+    uint64_t bits;
+    std::memcpy(&bits, &shifted, sizeof bits);
+    bits = (bits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof scale);
+    return p * scale;
+}
+
+// The same reduction in single precision
+const float EXP_MIN_FLOAT = -87.3f;               // 2^n stays a normal float
+const float EXP_MAX_FLOAT = 88.3f;
+const float LOG2E_FLOAT = 1.44269504f;
+const float LN2_HI_FLOAT = 0.693359375f;          // ln 2 rounded to 9 significant bits, so n * LN2_HI_FLOAT is exact
+const float LN2_LO_FLOAT = -2.12194440e-4f;       // ln 2 - LN2_HI_FLOAT
+const float ROUND_MAGIC_FLOAT = 12582912.0f;      // 1.5 * 2^23
+
+template <int Degree>
+inline float exp_scalar(float x) {
+    x = std::min(std::max(x, EXP_MIN_FLOAT), EXP_MAX_FLOAT);
+    float shifted = x * LOG2E_FLOAT + ROUND_MAGIC_FLOAT;
+    float n = shifted - ROUND_MAGIC_FLOAT;
+    float r = (x - n * LN2_HI_FLOAT) - n * LN2_LO_FLOAT;
+
+    float p = static_cast<float>(INVERSE_FACTORIAL[Degree]);
+    for (int k = Degree - 1; k >= 0; --k) p = p * r + static_cast<float>(INVERSE_FACTORIAL[k]);
+
+    uint32_t bits;
+    std::memcpy(&bits, &shifted, sizeof bits);
+    bits = (bits + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof scale);
+    return p * scale;
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+template <int Degree>
+inline __m256 exp_avx2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN_FLOAT)), _mm256_set1_ps(EXP_MAX_FLOAT));
+    const __m256 magic = _mm256_set1_ps(ROUND_MAGIC_FLOAT);
+    __m256 shifted = _mm256_fmadd_ps(x, _mm256_set1_ps(LOG2E_FLOAT), magic);
+    __m256 n = _mm256_sub_ps(shifted, magic);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HI_FLOAT), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LO_FLOAT), r);
+
+    __m256 p = _mm256_set1_ps(static_cast<float>(INVERSE_FACTORIAL[Degree]));
+    for (int k = Degree - 1; k >= 0; --k) {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(static_cast<float>(INVERSE_FACTORIAL[k])));
+    }
+
+    __m256i bits = _mm256_add_epi32(_mm256_castps_si256(shifted), _mm256_set1_epi32(127));
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(bits, 23)));
+}
+
+template <int Degree>
+inline __m256d exp_avx2(__m256d x) {
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_MIN)), _mm256_set1_pd(EXP_MAX));
+    const __m256d magic = _mm256_set1_pd(ROUND_MAGIC);
+    __m256d shifted = _mm256_fmadd_pd(x, _mm256_set1_pd(LOG2E), magic);
+    __m256d n = _mm256_sub_pd(shifted, magic);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+
+    __m256d p = _mm256_set1_pd(INVERSE_FACTORIAL[Degree]);
+    for (int k = Degree - 1; k >= 0; --k) p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(INVERSE_FACTORIAL[k]));
+
+    __m256i bits = _mm256_add_epi64(_mm256_castpd_si256(shifted), _mm256_set1_epi64x(1023));
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52)));
+}
+#endif
+
+/**
+ * @brief out[i] = exp(sign * in[i]), or 1 / (1 + exp(-in[i])) when Sigmoid is set
+ */
+template <int Degree, bool Sigmoid>
+inline void apply(const double* in, double* out, size_t n) {
+    const double sign = Sigmoid ? -1.0 : 1.0;
+    size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256d vsign = _mm256_set1_pd(sign), one = _mm256_set1_pd(1.0);
+    for (const size_t vector_end = n - n % 8; i < vector_end; i += 8) {
+        __m256d lo = exp_avx2<Degree>(_mm256_mul_pd(_mm256_loadu_pd(in + i), vsign));
+        __m256d hi = exp_avx2<Degree>(_mm256_mul_pd(_mm256_loadu_pd(in + i + 4), vsign));
+        if (Sigmoid) {
+            lo = _mm256_div_pd(one, _mm256_add_pd(one, lo));
+            hi = _mm256_div_pd(one, _mm256_add_pd(one, hi));
+        }
+        _mm256_storeu_pd(out + i, lo);
+        _mm256_storeu_pd(out + i + 4, hi);
+    }
+#endif
+    for (; i < n; ++i) {
+        double e = exp_scalar<Degree>(sign * in[i]);
+        out[i] = Sigmoid ? 1.0 / (1.0 + e) : e;
+    }
+}
+
+template <int Degree, bool Sigmoid>
+inline void apply(const float* in, float* out, size_t n) {
+    const float sign = Sigmoid ? -1.0f : 1.0f;
+    size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256 vsign = _mm256_set1_ps(sign), one = _mm256_set1_ps(1.0f);
+    for (const size_t vector_end = n - n % 8; i < vector_end; i += 8) {
+        __m256 e = exp_avx2<Degree>(_mm256_mul_ps(_mm256_loadu_ps(in + i), vsign));
+        if (Sigmoid) e = _mm256_div_ps(one, _mm256_add_ps(one, e));
+        _mm256_storeu_ps(out + i, e);
+    }
+#endif
+    for (; i < n; ++i) {
+        float e = exp_scalar<Degree>(sign * in[i]);
+        out[i] = Sigmoid ? 1.0f / (1.0f + e) : e;
+    }
+}
+
+template <bool Sigmoid>
+inline void apply(const double* in, double* out, size_t n, ActivationPrecision precision) {
+    switch (precision) {
+    case ActivationPrecision::Exact:
+        for (size_t i = 0; i < n; ++i) out[i] = Sigmoid ? 1.0 / (1.0 + std::exp(-in[i])) : std::exp(in[i]);
+        break;
+    case ActivationPrecision::High:
+        apply<11, Sigmoid>(in, out, n);
+        break;
+    case ActivationPrecision::Medium:
+        apply<6, Sigmoid>(in, out, n);
+        break;
+    case ActivationPrecision::Low:
+        apply<3, Sigmoid>(in, out, n);
+        break;
+    }
+}
+
+template <bool Sigmoid>
+inline void apply(const float* in, float* out, size_t n, ActivationPrecision precision) {
+    switch (precision) {
+    case ActivationPrecision::Exact:
+        for (size_t i = 0; i < n; ++i) out[i] = Sigmoid ? 1.0f / (1.0f + std::exp(-in[i])) : std::exp(in[i]);
+        break;
+    case ActivationPrecision::High:
+        apply<7, Sigmoid>(in, out, n);
+        break;
+    case ActivationPrecision::Medium:
+        apply<6, Sigmoid>(in, out, n);
+        break;
+    case ActivationPrecision::Low:
+        apply<3, Sigmoid>(in, out, n);
+        break;
+    }
+}
+
+} // namespace fast_math_detail
+
+/**
+ * @brief out[i] = exp(in[i]) for i < n; `in` and `out` may be the same array
+ */
+inline void exp_array(const double* in, double* out, size_t n, ActivationPrecision precision) {
+    fast_math_detail::apply<false>(in, out, n, precision);
+}
+
+/**
+ * @brief out[i] = 1 / (1 + exp(-in[i])) for i < n; `in` and `out` may be the same array
+ */
+inline void sigmoid_array(const double* in, double* out, size_t n, ActivationPrecision precision) {
+    fast_math_detail::apply<true>(in, out, n, precision);
+}
+
+/**
+ * @brief exp_array for float arrays
+ */
+inline void exp_array(const float* in, float* out, size_t n, ActivationPrecision precision) {
+    fast_math_detail::apply<false>(in, out, n, precision);
+}
+
+/**
+ * @brief sigmoid_array for float arrays
+ */
+inline void sigmoid_array(const float* in, float* out, size_t n, ActivationPrecision precision) {
+    fast_math_detail::apply<true>(in, out, n, precision);
+}
+
+/**
+ * @struct ApproximationError
+ * @brief Worst-case error of one precision tier against std::exp.
+ */
+struct ApproximationError {
+    double exp_relative = 0.0;     // max |approx - exp| / exp over the full clamped range
+    double sigmoid_absolute = 0.0; // max |approx - sigmoid| over [-40, 40]
+};
+
+/**
+ * @brief Measures a tier's maximum error on `samples` evenly spaced points of each range
+ *
+ * T selects the double or the float kernels; the float exp range is the float
+ * clamp range. Example: measure_approximation_error(ActivationPrecision::Medium).exp_relative
+ * is about 1e-7.
+ */
+template <typename T = double>
+inline ApproximationError measure_approximation_error(ActivationPrecision precision, size_t samples = 1 << 20) {
+    using namespace fast_math_detail;
+    const bool single = std::is_same<T, float>::value;
+    const double low = single ? EXP_MIN_FLOAT : EXP_MIN, high = single ? EXP_MAX_FLOAT : EXP_MAX;
+    std::vector<T> x(samples), y(samples);
+    ApproximationError error;
+
+    for (size_t i = 0; i < samples; ++i) x[i] = static_cast<T>(low + (high - low) * i / (samples - 1));
+    exp_array(x.data(), y.data(), samples, precision);
+    for (size_t i = 0; i < samples; ++i) {
+        double exact = std::exp(static_cast<double>(x[i]));
+        error.exp_relative = std::max(error.exp_relative, std::fabs(y[i] - exact) / exact);
+    }
+
+    for (size_t i = 0; i < samples; ++i) x[i] = static_cast<T>(-40.0 + 80.0 * i / (samples - 1));
+    sigmoid_array(x.data(), y.data(), samples, precision);
+    for (size_t i = 0; i < samples; ++i) {
+        double exact = 1.0 / (1.0 + std::exp(-static_cast<double>(x[i])));
+        error.sigmoid_absolute = std::max(error.sigmoid_absolute, std::fabs(y[i] - exact));
+    }
+    return error;
+}
+
+#endif // FAI_COMMON_FAST_MATH_H
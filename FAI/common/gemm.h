@@ -0,0 +1,223 @@
+#ifndef FAI_COMMON_GEMM_H
+#define FAI_COMMON_GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Blocked matrix multiply for the small dense layers of the PA5 networks.
+ *
+ * All matrices are row-major, all double or all float. gemm() computes
+ *   C = alpha * op(A) * op(B) + beta * C
+ * where op(X) is X or its transpose, which covers the three products of a dense
+ * layer: forward X * W, weight gradient X^T * dZ, and input gradient dZ * W^T.
+ *
+ * Large products are tiled the usual way (Goto/BLIS): a KC x NC block of op(B)
+ * and an MC x KC block of op(A) are packed into contiguous panels that stay in
+ * L2/L1, and a 4 x 8 register-blocked micro-kernel walks the panels. Built with
+ * AVX2 and FMA (-mavx2 -mfma or -march=native), the micro-kernel keeps the 4 x 8
+ * tile of C in eight ymm registers and does one broadcast and two fused
+ * multiply-adds per row and k step (for floats the 8 columns fit one register,
+ * so one fused multiply-add); otherwise a portable loop is used. Products too
+ * small to amortise packing run a direct triple loop.
+ */
+
+namespace gemm_detail {
+
+const size_t MR = 4;    // Rows of the micro-kernel tile
+const size_t NR = 8;    // Columns of the micro-kernel tile
+const size_t KC = 256;  // Depth of a packed block
+const size_t MC = 96;   // Rows of a packed A block
+const size_t NC = 2048; // Columns of a packed B block
+
+// Below this many multiply-adds the direct loop beats packing
+const size_t DIRECT_MAX_FLOPS = 4096;
+
+template <typename T>
+inline T element(const T* m, size_t ld, bool trans, size_t row, size_t col) {
+    return trans ? m[col * ld + row] : m[row * ld + col];
+}
+
+/**
+ * @brief Packs rows [i0, i0 + mc) x depth [p0, p0 + kc) of op(A) into MR-row panels, zero-padded
+ */
+template <typename T>
+inline void pack_a(const T* a, size_t lda, bool trans, size_t i0, size_t p0, size_t mc, size_t kc, T* out) {
+    for (size_t ir = 0; ir < mc; ir += MR) {
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t r = 0; r < MR; ++r) {
+                *out++ = ir + r < mc ? element(a, lda, trans, i0 + ir + r, p0 + p) : T(0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Packs depth [p0, p0 + kc) x columns [j0, j0 + nc) of op(B) into NR-column panels, zero-padded
+ */
+template <typename T>
+inline void pack_b(const T* b, size_t ldb, bool trans, size_t p0, size_t j0, size_t kc, size_t nc, T* out) {
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t c = 0; c < NR; ++c) {
+                *out++ = jr + c < nc ? element(b, ldb, trans, p0 + p, j0 + jr + c) : T(0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief tile[MR x NR] = packed A panel * packed B panel over kc steps
+ */
+inline void micro_kernel(size_t kc, const double* a, const double* b, double* tile) {
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d a0 = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(a0, b0, c00);
+        c01 = _mm256_fmadd_pd(a0, b1, c01);
+        __m256d a1 = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(a1, b0, c10);
+        c11 = _mm256_fmadd_pd(a1, b1, c11);
+        __m256d a2 = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(a2, b0, c20);
+        c21 = _mm256_fmadd_pd(a2, b1, c21);
+        __m256d a3 = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(a3, b0, c30);
+        c31 = _mm256_fmadd_pd(a3, b1, c31);
+    }
+    _mm256_storeu_pd(tile, c00);
+    _mm256_storeu_pd(tile + 4, c01);
+    _mm256_storeu_pd(tile + 8, c10);
+    _mm256_storeu_pd(tile + 12, c11);
+    _mm256_storeu_pd(tile + 16, c20);
+    _mm256_storeu_pd(tile + 20, c21);
+    _mm256_storeu_pd(tile + 24, c30);
+    _mm256_storeu_pd(tile + 28, c31);
+#else
+    double acc[MR * NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        for (size_t r = 0; r < MR; ++r) {
+            for (size_t c = 0; c < NR; ++c) acc[r * NR + c] += a[r] * b[c];
+        }
+    }
+    std::copy(acc, acc + MR * NR, tile);
+#endif
+}
+
+inline void micro_kernel(size_t kc, const float* a, const float* b, float* tile) {
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+    __m256 c2 = _mm256_setzero_ps(), c3 = _mm256_setzero_ps();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(a), b0, c0);
+        c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 1), b0, c1);
+        c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 2), b0, c2);
+        c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 3), b0, c3);
+    }
+    _mm256_storeu_ps(tile, c0);
+    _mm256_storeu_ps(tile + 8, c1);
+    _mm256_storeu_ps(tile + 16, c2);
+    _mm256_storeu_ps(tile + 24, c3);
+#else
+    float acc[MR * NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        for (size_t r = 0; r < MR; ++r) {
+            for (size_t c = 0; c < NR; ++c) acc[r * NR + c] += a[r] * b[c];
+        }
+    }
+    std::copy(acc, acc + MR * NR, tile);
+#endif
+}
+
+template <typename T>
+inline void gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda,
+                 const T* b, size_t ldb, T beta, T* c, size_t ldc) {
+    for (size_t i = 0; i < m; ++i) {
+        T* row = c + i * ldc;
+        if (beta == T(0)) std::fill(row, row + n, T(0));
+        else if (beta != T(1)) for (size_t j = 0; j < n; ++j) row[j] *= beta;
+    }
+    if (m == 0 || n == 0 || k == 0 || alpha == T(0)) return;
+
+    if (m * n * k <= DIRECT_MAX_FLOPS) {
+        for (size_t i = 0; i < m; ++i) {
+            T* row = c + i * ldc;
+            for (size_t p = 0; p < k; ++p) {
+                T scaled = alpha * element(a, lda, trans_a, i, p);
+                for (size_t j = 0; j < n; ++j) row[j] += scaled * element(b, ldb, trans_b, p, j);
+            }
+        }
+        return;
+    }
+
+    // Packing buffers are reused across calls on the same thread
+    static thread_local std::vector<T> packed_a, packed_b;
+    packed_a.resize(MC * KC);
+    packed_b.resize(KC * ((NC + NR - 1) / NR) * NR);
+    T tile[MR * NR];
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+        const size_t nc = std::min(NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            const size_t kc = std::min(KC, k - pc);
+            pack_b(b, ldb, trans_b, pc, jc, kc, nc, packed_b.data());
+            for (size_t ic = 0; ic < m; ic += MC) {
+                const size_t mc = std::min(MC, m - ic);
+                pack_a(a, lda, trans_a, ic, pc, mc, kc, packed_a.data());
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    const size_t cols = std::min(NR, nc - jr);
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        const size_t rows = std::min(MR, mc - ir);
+                        micro_kernel(kc, packed_a.data() + ir * kc, packed_b.data() + jr * kc, tile);
+                        for (size_t r = 0; r < rows; ++r) {
+                            T* out = c + (ic + ir + r) * ldc + jc + jr;
+                            for (size_t col = 0; col < cols; ++col) out[col] += alpha * tile[r * NR + col];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace gemm_detail
+
+/**
+ * @brief C = alpha * op(A) * op(B) + beta * C for row-major matrices
+ *
+ * @param trans_a Use A^T (A is stored K x M) instead of A (stored M x K).
+ * @param trans_b Use B^T (B is stored N x K) instead of B (stored K x N).
+ * @param m Rows of C.
+ * @param n Columns of C.
+ * @param k Inner dimension.
+ * @param alpha Scale of the product.
+ * @param a, lda A and its row stride.
+ * @param b, ldb B and its row stride.
+ * @param beta Scale of the old C (0 overwrites it, even if it holds NaNs).
+ * @param c, ldc C and its row stride.
+ */
+inline void gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, double alpha, const double* a,
+                 size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc) {
+    gemm_detail::gemm(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+/**
+ * @brief The same product for float matrices (alpha and beta are rounded to float)
+ */
+inline void gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha, const float* a,
+                 size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc) {
+    gemm_detail::gemm(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+#endif // FAI_COMMON_GEMM_H
@@ -0,0 +1,196 @@
+#ifndef FAI_COMMON_ISOLATION_FOREST_H
+#define FAI_COMMON_ISOLATION_FOREST_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "model_text.h"
+
+namespace isolation_forest_detail {
+
+/**
+ * @brief Average path length of an unsuccessful search in a binary search tree of n points, c(n)
+ */
+inline double average_path_length(double n) {
+    if (n <= 1.0) return 0.0;
+    if (n <= 2.0) return 1.0;
+    const double euler_gamma = 0.5772156649015329;
+    return 2.0 * (std::log(n - 1.0) + euler_gamma) - 2.0 * (n - 1.0) / n;
+}
+
+/**
+ * @brief The largest float that is <= t, so that float(x) <= t exactly when float(x) <= result
+ */
+inline float float_threshold(double t) {
+    float f = static_cast<float>(t);
+    if (static_cast<double>(f) > t) f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+    return f;
+}
+
+} // namespace isolation_forest_detail
+
+/**
+ * @class IsolationForestModel
+ * @brief Anomaly scores of an exported scikit-learn IsolationForest.
+ *
+ * Like scikit-learn, a row is converted to float32 and sent down every tree; a
+ * leaf at depth d holding n training samples contributes d + c(n). With E the
+ * mean over trees,
+ *
+ *   score_samples = -2^(-E / c(max_samples)),  predict = score - offset < 0 ? -1 : 1
+ *
+ * (-1 is an anomaly).
+ *
+ * All trees live in one flat node array. A leaf points back at itself, so a row
+ * can take exactly `depth` steps in a tree whatever leaf it ends in; with AVX2
+ * eight rows walk a tree together, each step gathering the node's feature,
+ * threshold and children for all eight lanes, with no branches. The path
+ * lengths are summed over the trees in the same order as in the scalar loop, so
+ * both give identical scores.
+ *
+ * Example:
+ *   IsolationForestModel forest;
+ *   if (forest.load("models/isolation_forest_model.txt")) forest.predict_batch(rows, count, labels);
+ */
+class IsolationForestModel {
+public:
+    /**
+     * @brief Reads a model file; false (and the model unchanged) if it is missing or malformed
+     */
+    bool load(const std::string& filename) {
+        std::ifstream in(filename);
+        IsolationForestModel model;
+        size_t num_trees = 0;
+        if (!read_model_header(in, "isolation_forest", model.features_) ||
+            !read_model_field(in, "max_samples", model.max_samples_) || !read_model_field(in, "offset", model.offset_) ||
+            !read_model_field(in, "trees", num_trees)) {
+            return false;
+        }
+        for (size_t t = 0; t < num_trees; ++t) {
+            size_t num_nodes = 0;
+            if (!read_model_field(in, "tree", num_nodes) || num_nodes == 0) return false;
+            const int32_t base = static_cast<int32_t>(model.feature_.size());
+            std::vector<int32_t> depth(num_nodes, 0);
+            int32_t tree_depth = 0;
+            for (size_t n = 0; n < num_nodes; ++n) {
+                int32_t left, right, feature;
+                double threshold, samples;
+                if (!(in >> left >> right >> feature >> threshold >> samples)) return false;
+                const int32_t self = base + static_cast<int32_t>(n);
+                if (left < 0) {
+                    model.left_.push_back(self);
+                    model.right_.push_back(self);
+                    model.feature_.push_back(0);
+                    model.threshold_.push_back(std::numeric_limits<float>::infinity());
+                    model.path_length_.push_back(depth[n] + isolation_forest_detail::average_path_length(samples));
+                } else {
+                    if (static_cast<size_t>(left) >= num_nodes || static_cast<size_t>(right) >= num_nodes ||
+                        feature < 0 || static_cast<size_t>(feature) >= model.features_.size()) {
+                        return false;
+                    }
+                    depth[left] = depth[right] = depth[n] + 1;
+                    tree_depth = std::max(tree_depth, depth[n] + 1);
+                    model.left_.push_back(base + left);
+                    model.right_.push_back(base + right);
+                    model.feature_.push_back(feature);
+                    model.threshold_.push_back(isolation_forest_detail::float_threshold(threshold));
+                    model.path_length_.push_back(0.0);
+                }
+            }
+            model.roots_.push_back(base);
+            model.depths_.push_back(tree_depth);
+        }
+        *this = model;
+        return true;
+    }
+
+    size_t num_features() const { return features_.size(); }
+    size_t num_trees() const { return roots_.size(); }
+    double offset() const { return offset_; }
+    const std::vector<std::string>& feature_names() const { return features_; }
+
+    /**
+     * @brief scikit-learn's score_samples: lower is more abnormal, in [-1, 0]
+     */
+    void score_samples(const double* rows, size_t count, double* scores) const {
+        const size_t width = features_.size();
+        const double normaliser = num_trees() * isolation_forest_detail::average_path_length(max_samples_);
+        size_t i = 0;
+#if defined(__AVX2__)
+        std::vector<float> block(8 * width);
+        for (; i + 8 <= count; i += 8) {
+            for (size_t f = 0; f < width; ++f) {
+                for (size_t r = 0; r < 8; ++r) block[f * 8 + r] = static_cast<float>(rows[(i + r) * width + f]);
+            }
+            const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), eight = _mm256_set1_epi32(8);
+            const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            __m256d low = _mm256_setzero_pd(), high = _mm256_setzero_pd();
+            for (size_t t = 0; t < roots_.size(); ++t) {
+                __m256i node = _mm256_set1_epi32(roots_[t]);
+                for (int32_t step = 0; step < depths_[t]; ++step) {
+                    __m256i feature = _mm256_i32gather_epi32(feature_.data(), node, 4);
+                    __m256 threshold = _mm256_i32gather_ps(threshold_.data(), node, 4);
+                    __m256 x = _mm256_i32gather_ps(block.data(), _mm256_add_epi32(_mm256_mullo_epi32(feature, eight), lane), 4);
+                    __m256i left = _mm256_i32gather_epi32(left_.data(), node, 4);
+                    __m256i right = _mm256_i32gather_epi32(right_.data(), node, 4);
+                    __m256 go_left = _mm256_cmp_ps(x, threshold, _CMP_LE_OQ);
+                    node = _mm256_castps_si256(
+                        _mm256_blendv_ps(_mm256_castsi256_ps(right), _mm256_castsi256_ps(left), go_left));
+                }
+                low = _mm256_add_pd(low, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), path_length_.data(),
+                                                                  _mm256_castsi256_si128(node), all_lanes, 8));
+                high = _mm256_add_pd(high, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), path_length_.data(),
+                                                                    _mm256_extracti128_si256(node, 1), all_lanes, 8));
+            }
+            double sums[8];
+            _mm256_storeu_pd(sums, low);
+            _mm256_storeu_pd(sums + 4, high);
+            for (size_t r = 0; r < 8; ++r) scores[i + r] = -std::exp2(-sums[r] / normaliser);
+        }
+#endif
+        std::vector<float> row(width);
+        for (; i < count; ++i) {
+            for (size_t f = 0; f < width; ++f) row[f] = static_cast<float>(rows[i * width + f]);
+            double sum = 0.0;
+            for (size_t t = 0; t < roots_.size(); ++t) {
+                int32_t node = roots_[t];
+                for (int32_t step = 0; step < depths_[t]; ++step) {
+                    node = row[feature_[node]] <= threshold_[node] ? left_[node] : right_[node];
+                }
+                sum += path_length_[node];
+            }
+            scores[i] = -std::exp2(-sum / normaliser);
+        }
+    }
+
+    /**
+     * @brief Writes -1 (anomaly) or 1 (normal) for each row to `labels`
+     */
+    void predict_batch(const double* rows, size_t count, int32_t* labels) const {
+        std::vector<double> scores(count);
+        score_samples(rows, count, scores.data());
+        for (size_t i = 0; i < count; ++i) labels[i] = scores[i] - offset_ < 0.0 ? -1 : 1;
+    }
+
+private:
+    std::vector<std::string> features_;
+    double max_samples_ = 256;
+    double offset_ = -0.5;
+    // One entry per node of every tree; children are indices into the same arrays
+    std::vector<int32_t> left_, right_, feature_;
+    std::vector<float> threshold_;
+    std::vector<double> path_length_; // d + c(n) for a leaf at depth d with n samples, 0 for internal nodes
+    std::vector<int32_t> roots_;      // First node of each tree
+    std::vector<int32_t> depths_;     // Depth of each tree
+};
+
+#endif // FAI_COMMON_ISOLATION_FOREST_H
@@ -0,0 +1,147 @@
+#ifndef FAI_COMMON_METRICS_H
+#define FAI_COMMON_METRICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "task_scheduler.h"
+
+/**
+ * @struct ConfusionMatrix
+ * @brief Counts of a binary classifier's predictions against the true labels.
+ */
+struct ConfusionMatrix {
+    size_t true_positive = 0;
+    size_t false_positive = 0;
+    size_t true_negative = 0;
+    size_t false_negative = 0;
+};
+
+/**
+ * @struct BinaryMetrics
+ * @brief Everything one evaluation pass of a binary classifier reports.
+ *
+ * `loss` is the mean binary cross-entropy of the scores, `accuracy` the share
+ * of rows whose score is on the right side of 0.5, and `auc` the area under
+ * the ROC curve (0.5 when only one label is present).
+ */
+struct BinaryMetrics {
+    size_t count = 0;
+    double loss = 0.0;
+    double accuracy = 0.0;
+    ConfusionMatrix confusion;
+    double auc = 0.5;
+
+    size_t misclassified() const { return confusion.false_positive + confusion.false_negative; }
+};
+
+namespace metrics_detail {
+
+/**
+ * @brief Area under the ROC curve by the rank-sum (Mann-Whitney) formula, ties sharing their mean rank
+ */
+inline double area_under_curve(const std::vector<double>& scores, const std::vector<int>& labels) {
+    std::vector<size_t> order(scores.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+
+    double positive_rank_sum = 0.0;
+    size_t positives = 0;
+    for (size_t start = 0; start < order.size();) {
+        size_t end = start;
+        while (end < order.size() && scores[order[end]] == scores[order[start]]) ++end;
+        const double mean_rank = (start + 1 + end) / 2.0;
+        for (size_t i = start; i < end; ++i) {
+            if (labels[order[i]] == 1) {
+                positive_rank_sum += mean_rank;
+                positives++;
+            }
+        }
+        start = end;
+    }
+    const size_t negatives = scores.size() - positives;
+    if (positives == 0 || negatives == 0) return 0.5;
+    return (positive_rank_sum - positives * (positives + 1) / 2.0) / (static_cast<double>(positives) * negatives);
+}
+
+} // namespace metrics_detail
+
+/**
+ * @brief Scores `count` rows in shards and computes all metrics in one sweep
+ *
+ * The rows are split into `num_shards` contiguous shards. Each shard is one task
+ * on `scheduler` (or runs inline when it is null): it calls
+ * score_shard(begin, end, scores, labels) to fill the scores (probability of
+ * label 1) and labels of rows [begin, end), then sums its loss and confusion
+ * counts. Partial sums are merged in shard order, and the AUC is ranked over all
+ * scores at the end, so the metrics do not depend on thread timing.
+ *
+ * Example:
+ *   BinaryMetrics m = evaluate_binary(rows.size(), 4, &scheduler,
+ *       [&](size_t begin, size_t end, double* scores, int* labels) { ... });
+ *
+ * @param count Number of rows
+ * @param num_shards Number of shards (at least 1)
+ * @param scheduler Scheduler that runs the shards, or nullptr
+ * @param score_shard Fills scores[i - begin] and labels[i - begin] for begin <= i < end
+ * @return BinaryMetrics Loss, accuracy, confusion matrix and AUC
+ */
+template <typename ScoreShard>
+BinaryMetrics evaluate_binary(size_t count, size_t num_shards, TaskScheduler* scheduler, ScoreShard score_shard) {
+    num_shards = std::max<size_t>(1, std::min(num_shards, std::max<size_t>(count, 1)));
+    std::vector<double> scores(count);
+    std::vector<int> labels(count);
+    std::vector<BinaryMetrics> partial(num_shards);
+
+    auto run_shard = [&](size_t shard) {
+        const size_t begin = count * shard / num_shards, end = count * (shard + 1) / num_shards;
+        score_shard(begin, end, scores.data() + begin, labels.data() + begin);
+        BinaryMetrics& sums = partial[shard];
+        for (size_t i = begin; i < end; ++i) {
+            const double p = std::min(std::max(scores[i], 1e-12), 1.0 - 1e-12);
+            const bool predicted = scores[i] >= 0.5;
+            if (labels[i] == 1) {
+                sums.loss -= std::log(p);
+                (predicted ? sums.confusion.true_positive : sums.confusion.false_negative)++;
+            } else {
+                sums.loss -= std::log(1.0 - p);
+                (predicted ? sums.confusion.false_positive : sums.confusion.true_negative)++;
+            }
+        }
+    };
+    if (scheduler) {
+        scheduler->parallel_for(0, num_shards, run_shard);
+    } else {
+        for (size_t shard = 0; shard < num_shards; ++shard) run_shard(shard);
+    }
+
+    BinaryMetrics metrics;
+    metrics.count = count;
+    for (const auto& sums : partial) {
+        metrics.loss += sums.loss;
+        metrics.confusion.true_positive += sums.confusion.true_positive;
+        metrics.confusion.false_positive += sums.confusion.false_positive;
+        metrics.confusion.true_negative += sums.confusion.true_negative;
+        metrics.confusion.false_negative += sums.confusion.false_negative;
+    }
+    if (count > 0) {
+        metrics.loss /= count;
+        metrics.accuracy = static_cast<double>(count - metrics.misclassified()) / count;
+    }
+    metrics.auc = metrics_detail::area_under_curve(scores, labels);
+    return metrics;
+}
+
+/**
+ * @brief Prints the metrics on one line, the confusion matrix as [TP FP; FN TN]
+ */
+inline void print_binary_metrics(const BinaryMetrics& metrics, std::ostream& out) {
+    const ConfusionMatrix& c = metrics.confusion;
+    out << "loss " << metrics.loss << ", accuracy " << metrics.accuracy << ", AUC " << metrics.auc << ", confusion ["
+        << c.true_positive << " " << c.false_positive << "; " << c.false_negative << " " << c.true_negative << "]\n";
+}
+
+#endif // FAI_COMMON_METRICS_H
@@ -0,0 +1,46 @@
+#ifndef FAI_COMMON_MODEL_TEXT_H
+#define FAI_COMMON_MODEL_TEXT_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * Readers for the plain-text model files written by
+ * "Final project_Group_2/export_models.py". Every file starts with
+ *
+ *   FAI <kind> 1
+ *   features <n> <name> ... <name>
+ *
+ * followed by `key value` lines and whitespace-separated numbers specific to the
+ * model kind. Numbers are written with Python's repr, so doubles round-trip
+ * exactly.
+ */
+
+/**
+ * @brief Reads the header of a model file; false if it is not a version-1 file of the given kind
+ */
+inline bool read_model_header(std::istream& in, const std::string& kind, std::vector<std::string>& features) {
+    std::string magic, file_kind, key;
+    int version = 0;
+    size_t count = 0;
+    if (!(in >> magic >> file_kind >> version) || magic != "FAI" || file_kind != kind || version != 1) return false;
+    if (!(in >> key >> count) || key != "features") return false;
+    features.resize(count);
+    for (auto& feature : features) {
+        if (!(in >> feature)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads `key value`; false if the next word is not `key`
+ */
+template <typename T>
+bool read_model_field(std::istream& in, const std::string& key, T& value) {
+    std::string word;
+    return static_cast<bool>(in >> word >> value) && word == key;
+}
+
+#endif // FAI_COMMON_MODEL_TEXT_H
@@ -0,0 +1,794 @@
+#ifndef FAI_COMMON_PARQUET_READER_H
+#define FAI_COMMON_PARQUET_READER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "column_file.h"
+#include "csv_reader.h"
+#include "task_scheduler.h"
+
+/**
+ * Self-contained reader for flat Parquet files, such as the netflow captures the
+ * final project exported with pyarrow. It decodes columns straight into the
+ * CsvColumns layout the learners already use, so no pandas or CSV round-trip is
+ * needed.
+ *
+ * Supported: flat schemas (required or optional columns, no nesting or repeats),
+ * UNCOMPRESSED and SNAPPY pages, data pages v1 and v2, PLAIN and dictionary
+ * (PLAIN_DICTIONARY / RLE_DICTIONARY) encodings, and the physical types INT32,
+ * INT64, FLOAT, DOUBLE (read as numbers) and BYTE_ARRAY (read as categorical
+ * strings). Other files are rejected with an error message.
+ */
+
+namespace parquet_detail {
+
+// Physical types
+const int TYPE_INT32 = 1;
+const int TYPE_INT64 = 2;
+const int TYPE_FLOAT = 4;
+const int TYPE_DOUBLE = 5;
+const int TYPE_BYTE_ARRAY = 6;
+
+// Page types, encodings and codecs
+const int PAGE_DATA = 0;
+const int PAGE_DICTIONARY = 2;
+const int PAGE_DATA_V2 = 3;
+const int ENCODING_PLAIN = 0;
+const int ENCODING_PLAIN_DICTIONARY = 2;
+const int ENCODING_RLE_DICTIONARY = 8;
+const int CODEC_UNCOMPRESSED = 0;
+const int CODEC_SNAPPY = 1;
+
+const int REPETITION_OPTIONAL = 1;
+const int REPETITION_REPEATED = 2;
+
+/**
+ * @class ThriftReader
+ * @brief Decoder for the Thrift compact protocol used by Parquet metadata.
+ *
+ * Structs are read with read_struct(fn), which calls fn(field_id, type) for every
+ * field; fn either reads the value or calls skip(type). Any overrun sets ok = false
+ * and makes all further reads return zeros.
+ */
+class ThriftReader {
+public:
+    ThriftReader(const uint8_t* begin, const uint8_t* end) : p_(begin), end_(end) {}
+
+    bool ok = true;
+
+    const uint8_t* position() const { return p_; }
+
+    uint64_t read_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p_ >= end_) return fail();
+            uint8_t byte = *p_++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        return fail();
+    }
+
+    int64_t read_i64() {
+        uint64_t value = read_varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    int32_t read_i32() { return static_cast<int32_t>(read_i64()); }
+
+    std::string read_binary() {
+        uint64_t length = read_varint();
+        if (static_cast<uint64_t>(end_ - p_) < length) {
+            fail();
+            return std::string();
+        }
+        std::string text(reinterpret_cast<const char*>(p_), static_cast<size_t>(length));
+        p_ += length;
+        return text;
+    }
+
+    /**
+     * @brief Reads a list header; returns the element count and sets `element_type`
+     */
+    size_t read_list(int& element_type) {
+        if (p_ >= end_) return static_cast<size_t>(fail());
+        uint8_t header = *p_++;
+        element_type = header & 0x0f;
+        size_t size = header >> 4;
+        if (size == 15) size = static_cast<size_t>(read_varint());
+        return size;
+    }
+
+    template <typename FieldFn>
+    void read_struct(FieldFn on_field) {
+        int16_t field_id = 0;
+        while (ok) {
+            if (p_ >= end_) {
+                fail();
+                return;
+            }
+            uint8_t header = *p_++;
+            if (header == 0) return; // STOP
+            int type = header & 0x0f;
+            int delta = header >> 4;
+            field_id = delta ? static_cast<int16_t>(field_id + delta) : static_cast<int16_t>(read_i64());
+            on_field(field_id, type);
+        }
+    }
+
+    void skip(int type) {
+        switch (type) {
+        case 1: case 2: break;                       // Boolean stored in the type
+        case 3: p_ = p_ < end_ ? p_ + 1 : p_; break; // Byte
+        case 4: case 5: case 6: read_varint(); break;
+        case 7: if (end_ - p_ < 8) fail(); else p_ += 8; break;
+        case 8: read_binary(); break;
+        case 9: case 10: {
+            int element_type;
+            size_t size = read_list(element_type);
+            for (size_t i = 0; i < size && ok; ++i) skip_element(element_type);
+            break;
+        }
+        case 11: {
+            size_t size = static_cast<size_t>(read_varint());
+            if (size == 0) break;
+            if (p_ >= end_) {
+                fail();
+                break;
+            }
+            uint8_t types = *p_++;
+            for (size_t i = 0; i < size && ok; ++i) {
+                skip_element(types >> 4);
+                skip_element(types & 0x0f);
+            }
+            break;
+        }
+        case 12: read_struct([this](int16_t, int field_type) { skip(field_type); }); break;
+        default: fail();
+        }
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+
+    uint64_t fail() {
+        ok = false;
+        p_ = end_;
+        return 0;
+    }
+
+    // List and map elements of boolean type take a whole byte
+    void skip_element(int type) {
+        if (type == 1 || type == 2) {
+            if (p_ < end_) ++p_;
+            else fail();
+        } else {
+            skip(type);
+        }
+    }
+};
+
+struct ColumnChunkInfo {
+    int type = 0;
+    int codec = 0;
+    int64_t num_values = 0;
+    int64_t data_page_offset = 0;
+    int64_t dictionary_page_offset = -1;
+    int64_t total_compressed_size = 0;
+};
+
+struct RowGroupInfo {
+    int64_t num_rows = 0;
+    std::vector<ColumnChunkInfo> columns;
+};
+
+struct SchemaColumn {
+    std::string name;
+    int type = -1;
+    int repetition = 0;
+};
+
+struct FileInfo {
+    int64_t num_rows = 0;
+    std::vector<SchemaColumn> columns; // Leaf columns in file order
+    std::vector<RowGroupInfo> row_groups;
+};
+
+inline bool parse_metadata(const uint8_t* begin, const uint8_t* end, FileInfo& info, std::string& error) {
+    ThriftReader reader(begin, end);
+    bool nested = false;
+    size_t schema_index = 0;
+    reader.read_struct([&](int16_t id, int type) {
+        if (id == 2 && type == 9) { // schema: list<SchemaElement>, the root first
+            int element_type;
+            size_t size = reader.read_list(element_type);
+            for (size_t i = 0; i < size && reader.ok; ++i, ++schema_index) {
+                SchemaColumn column;
+                int num_children = 0;
+                reader.read_struct([&](int16_t field, int field_type) {
+                    if (field == 1) column.type = reader.read_i32();
+                    else if (field == 3) column.repetition = reader.read_i32();
+                    else if (field == 4) column.name = reader.read_binary();
+                    else if (field == 5) num_children = reader.read_i32();
+                    else reader.skip(field_type);
+                });
+                if (schema_index == 0) continue;
+                if (num_children > 0 || column.repetition == REPETITION_REPEATED) nested = true;
+                info.columns.push_back(column);
+            }
+        } else if (id == 3) {
+            info.num_rows = reader.read_i64();
+        } else if (id == 4 && type == 9) { // row_groups: list<RowGroup>
+            int element_type;
+            size_t size = reader.read_list(element_type);
+            for (size_t i = 0; i < size && reader.ok; ++i) {
+                RowGroupInfo group;
+                reader.read_struct([&](int16_t field, int field_type) {
+                    if (field == 3) {
+                        group.num_rows = reader.read_i64();
+                    } else if (field == 1 && field_type == 9) { // columns: list<ColumnChunk>
+                        int chunk_type;
+                        size_t num_chunks = reader.read_list(chunk_type);
+                        for (size_t c = 0; c < num_chunks && reader.ok; ++c) {
+                            ColumnChunkInfo chunk;
+                            reader.read_struct([&](int16_t chunk_field, int chunk_field_type) {
+                                if (chunk_field != 3) {
+                                    reader.skip(chunk_field_type);
+                                    return;
+                                }
+                                reader.read_struct([&](int16_t meta, int meta_type) { // ColumnMetaData
+                                    if (meta == 1) chunk.type = reader.read_i32();
+                                    else if (meta == 4) chunk.codec = reader.read_i32();
+                                    else if (meta == 5) chunk.num_values = reader.read_i64();
+                                    else if (meta == 7) chunk.total_compressed_size = reader.read_i64();
+                                    else if (meta == 9) chunk.data_page_offset = reader.read_i64();
+                                    else if (meta == 11) chunk.dictionary_page_offset = reader.read_i64();
+                                    else reader.skip(meta_type);
+                                });
+                            });
+                            group.columns.push_back(chunk);
+                        }
+                    } else {
+                        reader.skip(field_type);
+                    }
+                });
+                info.row_groups.push_back(group);
+            }
+        } else {
+            reader.skip(type);
+        }
+    });
+    if (!reader.ok) {
+        error = "corrupt file metadata";
+        return false;
+    }
+    if (nested) {
+        error = "nested or repeated columns are not supported";
+        return false;
+    }
+    for (const auto& group : info.row_groups) {
+        if (group.columns.size() != info.columns.size()) {
+            error = "row group does not match the schema";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decompresses a raw Snappy block into exactly `out_size` bytes
+ */
+inline bool snappy_uncompress(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size) {
+    const uint8_t* end = in + in_size;
+    ThriftReader header(in, end); // The block starts with the uncompressed length as a varint
+    if (header.read_varint() != out_size || !header.ok) return false;
+    const uint8_t* p = header.position();
+    size_t written = 0;
+    while (p < end) {
+        uint8_t tag = *p++;
+        size_t length, offset = 0;
+        switch (tag & 3) {
+        case 0: { // Literal
+            length = tag >> 2;
+            if (length >= 60) {
+                size_t bytes = length - 59;
+                if (static_cast<size_t>(end - p) < bytes) return false;
+                length = 0;
+                for (size_t i = 0; i < bytes; ++i) length |= static_cast<size_t>(p[i]) << (8 * i);
+                p += bytes;
+            }
+            length += 1;
+            if (static_cast<size_t>(end - p) < length || out_size - written < length) return false;
+            memcpy(out + written, p, length);
+            p += length;
+            written += length;
+            continue;
+        }
+        case 1:
+            if (p >= end) return false;
+            length = ((tag >> 2) & 7) + 4;
+            offset = (static_cast<size_t>(tag >> 5) << 8) | *p++;
+            break;
+        case 2:
+            if (end - p < 2) return false;
+            length = (tag >> 2) + 1;
+            offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+            p += 2;
+            break;
+        default:
+            if (end - p < 4) return false;
+            length = (tag >> 2) + 1;
+            offset = p[0] | (static_cast<size_t>(p[1]) << 8) | (static_cast<size_t>(p[2]) << 16) |
+                     (static_cast<size_t>(p[3]) << 24);
+            p += 4;
+        }
+        if (offset == 0 || offset > written || out_size - written < length) return false;
+        // Copies may overlap their own output, so go byte by byte
+        for (size_t i = 0; i < length; ++i, ++written) out[written] = out[written - offset];
+    }
+    return written == out_size;
+}
+
+/**
+ * @brief Decodes `count` values of the RLE / bit-packed hybrid encoding
+ */
+inline bool decode_rle_hybrid(const uint8_t* p, const uint8_t* end, int bit_width, size_t count, uint32_t* out) {
+    if (bit_width < 0 || bit_width > 32) return false;
+    const size_t value_bytes = (static_cast<size_t>(bit_width) + 7) / 8;
+    size_t produced = 0;
+    while (produced < count) {
+        ThriftReader varint(p, end);
+        uint64_t header = varint.read_varint();
+        if (!varint.ok) return false;
+        p = varint.position();
+        if (header & 1) { // Bit-packed groups of 8 values, least significant bit first
+            size_t values = static_cast<size_t>(header >> 1) * 8;
+            size_t bytes = static_cast<size_t>(header >> 1) * bit_width;
+            if (static_cast<size_t>(end - p) < bytes) return false;
+            uint64_t buffer = 0;
+            int bits = 0;
+            const uint8_t* q = p;
+            for (size_t i = 0; i < values; ++i) {
+                while (bits < bit_width) {
+                    buffer |= static_cast<uint64_t>(*q++) << bits;
+                    bits += 8;
+                }
+                uint32_t value = bit_width == 32 ? static_cast<uint32_t>(buffer)
+                                                 : static_cast<uint32_t>(buffer & ((uint64_t(1) << bit_width) - 1));
+                buffer >>= bit_width;
+                bits -= bit_width;
+                if (produced < count) out[produced++] = value;
+            }
+            p += bytes;
+        } else { // Run of one repeated value
+            size_t run = static_cast<size_t>(header >> 1);
+            if (static_cast<size_t>(end - p) < value_bytes) return false;
+            uint32_t value = 0;
+            for (size_t i = 0; i < value_bytes; ++i) value |= static_cast<uint32_t>(p[i]) << (8 * i);
+            p += value_bytes;
+            for (size_t i = 0; i < run && produced < count; ++i) out[produced++] = value;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decoded values of one column chunk, before they are renumbered
+ *
+ * Numeric columns fill `numbers`. Categorical columns fill `codes` with indices
+ * into `dictionary`, which holds each distinct string once.
+ */
+struct DecodedColumn {
+    std::vector<double> numbers;
+    std::vector<uint32_t> codes;
+    std::vector<std::string> dictionary;
+    std::unordered_map<std::string, uint32_t> lookup;
+
+    uint32_t intern(std::string value) {
+        auto inserted = lookup.emplace(std::move(value), static_cast<uint32_t>(dictionary.size()));
+        if (inserted.second) dictionary.push_back(inserted.first->first);
+        return inserted.first->second;
+    }
+};
+
+/**
+ * @brief Reads `count` PLAIN-encoded values; numbers go to `numbers`, strings are interned into `codes`
+ */
+inline bool decode_plain(int type, const uint8_t*& p, const uint8_t* end, size_t count, DecodedColumn& column,
+                         std::vector<double>* numbers, std::vector<uint32_t>* codes) {
+    for (size_t i = 0; i < count; ++i) {
+        if (type == TYPE_BYTE_ARRAY) {
+            uint32_t length;
+            if (end - p < 4) return false;
+            memcpy(&length, p, 4);
+            p += 4;
+            if (static_cast<size_t>(end - p) < length) return false;
+            codes->push_back(column.intern(std::string(reinterpret_cast<const char*>(p), length)));
+            p += length;
+            continue;
+        }
+        size_t width = type == TYPE_INT32 || type == TYPE_FLOAT ? 4 : 8;
+        if (static_cast<size_t>(end - p) < width) return false;
+        double value;
+        if (type == TYPE_INT32) {
+            int32_t v;
+            memcpy(&v, p, 4);
+            value = v;
+        } else if (type == TYPE_INT64) {
+            int64_t v;
+            memcpy(&v, p, 8);
+            value = static_cast<double>(v);
+        } else if (type == TYPE_FLOAT) {
+            float v;
+            memcpy(&v, p, 4);
+            value = v;
+        } else {
+            memcpy(&value, p, 8);
+        }
+        numbers->push_back(value);
+        p += width;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes every page of one column chunk
+ *
+ * Null cells (definition level 0) read as 0 for numbers and as the empty string
+ * for categorical columns, the same as empty CSV cells.
+ */
+inline bool decode_column_chunk(const uint8_t* file, size_t file_size, const ColumnChunkInfo& chunk, bool optional,
+                                DecodedColumn& column, std::string& error) {
+    auto fail = [&](const std::string& reason) {
+        error = reason;
+        return false;
+    };
+    const int type = chunk.type;
+    const bool categorical = type == TYPE_BYTE_ARRAY;
+    int64_t start = chunk.data_page_offset;
+    if (chunk.dictionary_page_offset > 0 && chunk.dictionary_page_offset < start) start = chunk.dictionary_page_offset;
+    if (start < 0 || chunk.total_compressed_size < 0 ||
+        static_cast<uint64_t>(start) + static_cast<uint64_t>(chunk.total_compressed_size) > file_size) {
+        return fail("column chunk outside the file");
+    }
+    const uint8_t* p = file + start;
+    const uint8_t* end = p + chunk.total_compressed_size;
+
+    std::vector<double> dictionary_numbers;
+    std::vector<uint32_t> dictionary_codes;
+    std::vector<uint8_t> page;
+    std::vector<uint32_t> levels, indices;
+    size_t values_read = 0;
+    while (values_read < static_cast<size_t>(chunk.num_values) && p < end) {
+        int page_type = -1;
+        int32_t uncompressed_size = 0, compressed_size = 0;
+        int32_t num_values = 0, encoding = 0;
+        int32_t levels_bytes = 0, repetition_bytes = 0;
+        bool v2_compressed = true;
+        ThriftReader reader(p, end);
+        reader.read_struct([&](int16_t id, int field_type) {
+            if (id == 1) page_type = reader.read_i32();
+            else if (id == 2) uncompressed_size = reader.read_i32();
+            else if (id == 3) compressed_size = reader.read_i32();
+            else if (id == 5 || id == 7) { // DataPageHeader / DictionaryPageHeader
+                reader.read_struct([&](int16_t field, int t) {
+                    if (field == 1) num_values = reader.read_i32();
+                    else if (field == 2) encoding = reader.read_i32();
+                    else reader.skip(t);
+                });
+            } else if (id == 8) { // DataPageHeaderV2
+                reader.read_struct([&](int16_t field, int t) {
+                    if (field == 1) num_values = reader.read_i32();
+                    else if (field == 4) encoding = reader.read_i32();
+                    else if (field == 5) levels_bytes = reader.read_i32();
+                    else if (field == 6) repetition_bytes = reader.read_i32();
+                    else if (field == 7) v2_compressed = t == 1;
+                    else reader.skip(t);
+                });
+            } else {
+                reader.skip(field_type);
+            }
+        });
+        p = reader.position();
+        if (!reader.ok || compressed_size < 0 || uncompressed_size < 0 || end - p < compressed_size) {
+            return fail("corrupt page header");
+        }
+        const uint8_t* payload = p;
+        p += compressed_size;
+        if (page_type != PAGE_DATA && page_type != PAGE_DATA_V2 && page_type != PAGE_DICTIONARY) continue;
+
+        // Uncompress the page (v2 keeps its levels uncompressed in front of the values)
+        const size_t prefix = page_type == PAGE_DATA_V2 ? static_cast<size_t>(levels_bytes) + repetition_bytes : 0;
+        if (prefix > static_cast<size_t>(compressed_size) || prefix > static_cast<size_t>(uncompressed_size)) {
+            return fail("corrupt page header");
+        }
+        const uint8_t* data = payload;
+        const uint8_t* data_end = payload + compressed_size;
+        const bool compressed = chunk.codec != CODEC_UNCOMPRESSED && !(page_type == PAGE_DATA_V2 && !v2_compressed);
+        if (compressed && chunk.codec != CODEC_SNAPPY) {
+            return fail("unsupported compression codec " + std::to_string(chunk.codec));
+        }
+        if (compressed) {
+            // Snappy expands at most ~22x, so anything larger is a corrupt header
+            if (static_cast<size_t>(uncompressed_size) > static_cast<size_t>(compressed_size) * 32 + 64) {
+                return fail("corrupt page header");
+            }
+            page.resize(static_cast<size_t>(uncompressed_size));
+            memcpy(page.data(), payload, prefix);
+            if (!snappy_uncompress(payload + prefix, compressed_size - prefix, page.data() + prefix,
+                                   page.size() - prefix)) {
+                return fail("corrupt snappy page");
+            }
+            data = page.data();
+            data_end = page.data() + page.size();
+        }
+
+        if (page_type == PAGE_DICTIONARY) {
+            dictionary_numbers.clear();
+            dictionary_codes.clear();
+            if (!decode_plain(type, data, data_end, static_cast<size_t>(num_values), column, &dictionary_numbers,
+                              &dictionary_codes)) {
+                return fail("corrupt dictionary page");
+            }
+            continue;
+        }
+
+        // Definition levels: which of the page's values are present
+        const size_t count = static_cast<size_t>(num_values);
+        if (num_values < 0 || count > static_cast<size_t>(chunk.num_values) - values_read) {
+            return fail("corrupt page header");
+        }
+        levels.assign(count, 1);
+        if (optional) {
+            const uint8_t* levels_end = data_end;
+            if (page_type == PAGE_DATA) {
+                uint32_t length;
+                if (data_end - data < 4) return fail("corrupt page");
+                memcpy(&length, data, 4);
+                data += 4;
+                if (static_cast<size_t>(data_end - data) < length) return fail("corrupt page");
+                levels_end = data + length;
+            } else {
+                levels_end = data + levels_bytes;
+            }
+            if (!decode_rle_hybrid(data, levels_end, 1, count, levels.data())) {
+                return fail("corrupt definition levels");
+            }
+            data = levels_end;
+        } else if (page_type == PAGE_DATA_V2) {
+            data += levels_bytes;
+        }
+        if (page_type == PAGE_DATA_V2) data += repetition_bytes;
+        size_t present = 0;
+        for (uint32_t level : levels) present += level != 0;
+
+        // Values of the present cells
+        std::vector<double> numbers;
+        std::vector<uint32_t> codes;
+        if (encoding == ENCODING_PLAIN) {
+            if (!decode_plain(type, data, data_end, present, column, &numbers, &codes)) {
+                return fail("corrupt data page");
+            }
+        } else if (encoding == ENCODING_PLAIN_DICTIONARY || encoding == ENCODING_RLE_DICTIONARY) {
+            if (data >= data_end && present > 0) return fail("corrupt data page");
+            indices.resize(present);
+            int bit_width = present > 0 ? *data++ : 0;
+            if (!decode_rle_hybrid(data, data_end, bit_width, present, indices.data())) {
+                return fail("corrupt dictionary indices");
+            }
+            const size_t dictionary_size = categorical ? dictionary_codes.size() : dictionary_numbers.size();
+            for (uint32_t index : indices) {
+                if (index >= dictionary_size) return fail("dictionary index out of range");
+                if (categorical) codes.push_back(dictionary_codes[index]);
+                else numbers.push_back(dictionary_numbers[index]);
+            }
+        } else {
+            return fail("unsupported encoding " + std::to_string(encoding));
+        }
+
+        // Spread the values over the cells, filling nulls
+        size_t next = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bool is_present = levels[i] != 0;
+            if (categorical) column.codes.push_back(is_present ? codes[next] : column.intern(std::string()));
+            else column.numbers.push_back(is_present ? numbers[next] : 0.0);
+            next += is_present;
+        }
+        values_read += count;
+    }
+    if (values_read != static_cast<size_t>(chunk.num_values)) {
+        return fail("column chunk ended early");
+    }
+    return true;
+}
+
+/**
+ * @brief Renumbers a decoded categorical column so that codes follow first appearance, as in CsvColumns
+ */
+inline void renumber_first_seen(DecodedColumn& column, std::vector<std::string>& dictionary,
+                                std::vector<uint32_t>& codes) {
+    const uint32_t unseen = UINT32_MAX;
+    std::vector<uint32_t> remap(column.dictionary.size(), unseen);
+    codes.resize(column.codes.size());
+    for (size_t row = 0; row < column.codes.size(); ++row) {
+        uint32_t& code = remap[column.codes[row]];
+        if (code == unseen) {
+            code = static_cast<uint32_t>(dictionary.size());
+            dictionary.push_back(std::move(column.dictionary[column.codes[row]]));
+        }
+        codes[row] = code;
+    }
+}
+
+} // namespace parquet_detail
+
+/**
+ * @brief Decodes a Parquet file one row group at a time
+ *
+ * Calls fn(group) for every row group in file order with a CsvColumns holding
+ * that group's rows of the selected columns. Integer and floating-point columns
+ * are numeric; string columns are categorical, with codes numbered in order of
+ * first appearance within the group (like a chunk of for_each_csv_chunk). The
+ * columns of a row group are decoded as parallel tasks when a scheduler is given.
+ *
+ * @param filename Path of the Parquet file.
+ * @param columns Names of the columns to read, in the order wanted (empty reads all).
+ * @param fn Called with each `const CsvColumns&`.
+ * @param scheduler Optional scheduler for decoding columns in parallel.
+ * @param error If given, receives the reason of a failure.
+ * @return bool false if the file is missing, malformed or uses an unsupported feature.
+ */
+template <typename GroupFn>
+bool for_each_parquet_row_group(const std::string& filename, const std::vector<std::string>& columns, GroupFn fn,
+                                TaskScheduler* scheduler = nullptr, std::string* error = nullptr) {
+    using namespace parquet_detail;
+    std::string message;
+    auto fail = [&](const std::string& reason) {
+        if (error) *error = filename + ": " + reason;
+        return false;
+    };
+
+    csv_detail::MappedFile file(filename);
+    if (file.data() == nullptr) return fail("cannot open file");
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+    const size_t size = file.size();
+    if (size < 12 || memcmp(data, "PAR1", 4) != 0 || memcmp(data + size - 4, "PAR1", 4) != 0) {
+        return fail("not a Parquet file");
+    }
+    uint32_t footer_length;
+    memcpy(&footer_length, data + size - 8, 4);
+    if (footer_length > size - 12) return fail("corrupt footer");
+    FileInfo info;
+    if (!parse_metadata(data + size - 8 - footer_length, data + size - 8, info, message)) return fail(message);
+
+    // Resolve the selected columns
+    std::vector<size_t> selected;
+    if (columns.empty()) {
+        for (size_t c = 0; c < info.columns.size(); ++c) selected.push_back(c);
+    }
+    for (const auto& name : columns) {
+        size_t c = 0;
+        while (c < info.columns.size() && info.columns[c].name != name) ++c;
+        if (c == info.columns.size()) return fail("no column named " + name);
+        selected.push_back(c);
+    }
+    CsvColumns header;
+    for (size_t c : selected) {
+        int type = info.columns[c].type;
+        if (type != TYPE_INT32 && type != TYPE_INT64 && type != TYPE_FLOAT && type != TYPE_DOUBLE &&
+            type != TYPE_BYTE_ARRAY) {
+            return fail("column " + info.columns[c].name + " has an unsupported type");
+        }
+        header.names.push_back(info.columns[c].name);
+        header.is_numeric.push_back(type != TYPE_BYTE_ARRAY);
+    }
+
+    for (const RowGroupInfo& group : info.row_groups) {
+        std::vector<DecodedColumn> decoded(selected.size());
+        std::vector<std::string> errors(selected.size());
+        auto decode = [&](size_t i) {
+            const size_t c = selected[i];
+            decode_column_chunk(data, size, group.columns[c], info.columns[c].repetition == REPETITION_OPTIONAL,
+                                decoded[i], errors[i]);
+        };
+        if (scheduler && selected.size() > 1) {
+            scheduler->parallel_for(0, selected.size(), decode);
+        } else {
+            for (size_t i = 0; i < selected.size(); ++i) decode(i);
+        }
+
+        CsvColumns result;
+        result.names = header.names;
+        result.is_numeric = header.is_numeric;
+        result.num_rows = static_cast<size_t>(group.num_rows);
+        result.dictionaries.resize(selected.size());
+        result.codes.resize(selected.size());
+        result.numbers.resize(selected.size());
+        for (size_t i = 0; i < selected.size(); ++i) {
+            if (!errors[i].empty()) return fail("column " + header.names[i] + ": " + errors[i]);
+            size_t rows = result.is_numeric[i] ? decoded[i].numbers.size() : decoded[i].codes.size();
+            if (rows != result.num_rows) return fail("column " + header.names[i] + " has the wrong row count");
+            if (result.is_numeric[i]) {
+                result.numbers[i] = std::move(decoded[i].numbers);
+            } else {
+                renumber_first_seen(decoded[i], result.dictionaries[i], result.codes[i]);
+            }
+        }
+        fn(static_cast<const CsvColumns&>(result));
+    }
+    return true;
+}
+
+/**
+ * @brief Reads selected columns of a whole Parquet file into CsvColumns
+ *
+ * The result has the same layout as read_csv_columns: one dictionary per
+ * categorical column numbered in order of first appearance, and one double per
+ * row for numeric columns. A missing or unreadable file gives an empty result
+ * (see `error` for the reason).
+ *
+ * Example:
+ *   CsvColumns flows = read_parquet_columns("11-Rbot-20110818-2.binetflow.parquet",
+ *                                           {"dur", "tot_pkts", "label"});
+ *
+ * @param filename Path of the Parquet file.
+ * @param columns Names of the columns to read (empty reads all).
+ * @param scheduler Optional scheduler for decoding columns in parallel.
+ * @param error If given, receives the reason of a failure.
+ * @return CsvColumns The decoded columns.
+ */
+inline CsvColumns read_parquet_columns(const std::string& filename, const std::vector<std::string>& columns = {},
+                                       TaskScheduler* scheduler = nullptr, std::string* error = nullptr) {
+    CsvColumns result;
+    std::vector<std::unordered_map<std::string, uint32_t>> lookup;
+    bool ok = for_each_parquet_row_group(filename, columns, [&](const CsvColumns& group) {
+        if (result.names.empty()) {
+            result.names = group.names;
+            result.is_numeric = group.is_numeric;
+            result.dictionaries.resize(group.names.size());
+            result.codes.resize(group.names.size());
+            result.numbers.resize(group.names.size());
+            lookup.resize(group.names.size());
+        }
+        for (size_t c = 0; c < group.names.size(); ++c) {
+            if (group.is_numeric[c]) {
+                result.numbers[c].insert(result.numbers[c].end(), group.numbers[c].begin(), group.numbers[c].end());
+                continue;
+            }
+            std::vector<uint32_t> global;
+            for (const auto& value : group.dictionaries[c]) {
+                auto inserted = lookup[c].emplace(value, static_cast<uint32_t>(result.dictionaries[c].size()));
+                if (inserted.second) result.dictionaries[c].push_back(value);
+                global.push_back(inserted.first->second);
+            }
+            for (uint32_t code : group.codes[c]) result.codes[c].push_back(global[code]);
+        }
+        result.num_rows += group.num_rows;
+    }, scheduler, error);
+    return ok ? result : CsvColumns();
+}
+
+/**
+ * @brief Converts selected columns of a Parquet file to a column file, one row group per Parquet row group
+ *
+ * The column file can then be streamed by the out-of-core trainers.
+ *
+ * @return bool false if the Parquet file could not be read or the output could not be written.
+ */
+inline bool convert_parquet_to_column_file(const std::string& parquet_filename, const std::string& column_filename,
+                                           const std::vector<std::string>& columns = {},
+                                           std::string* error = nullptr) {
+    ColumnFileWriter writer;
+    if (!writer.open(column_filename)) return false;
+    bool ok = true;
+    bool read = for_each_parquet_row_group(
+        parquet_filename, columns, [&](const CsvColumns& group) { ok = writer.append(group) && ok; }, nullptr, error);
+    return writer.close() && read && ok;
+}
+
+#endif // FAI_COMMON_PARQUET_READER_H
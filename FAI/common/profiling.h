@@ -0,0 +1,468 @@
+#ifndef FAI_COMMON_PROFILING_H
+#define FAI_COMMON_PROFILING_H
+
+/**
+ * Hot-path instrumentation: event counters, scoped timers, optional hardware
+ * counters and Chrome-trace export.
+ *
+ * Algorithms are instrumented only through the macros
+ *
+ *   FAI_COUNT(HEAP_PUSHES);                    // one event
+ *   FAI_COUNT_N(FORWARD_PASSES, rows);         // `rows` events
+ *   FAI_SCOPED_TIMER("pa4::train_decision_tree");
+ *   FAI_PROFILE_SESSION();                     // in main(): report at exit
+ *
+ * which expand to nothing unless FAI_PROFILING is defined to 1 (the CMake
+ * option of the same name). A normal build therefore contains no counter
+ * code at all, and this header then defines nothing else.
+ *
+ * With profiling on:
+ * - Every thread counts into its own cache-line-aligned block, with a plain
+ *   load and store and no atomic read-modify-write, so threads never contend.
+ *   Totals sum the blocks of all threads that ever counted.
+ * - A ScopedTimer records one complete ("X") event for its scope in the
+ *   thread's event buffer. With hardware counters enabled it also reads the
+ *   thread's perf_event_open group (cycles, instructions, cache misses, branch
+ *   misses) at both ends and attaches the differences to the event.
+ * - FAI_PROFILE_SESSION prints the counter totals and a per-timer summary to
+ *   stderr when main() returns. If the environment variable FAI_TRACE names a
+ *   file, it also writes the Chrome trace there (open it in chrome://tracing or
+ *   ui.perfetto.dev). FAI_PERF=1 turns the hardware counters on.
+ */
+
+#if defined(FAI_PROFILING) && FAI_PROFILING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Events counted on the hot paths
+ */
+enum ProfileCounter : int {
+    HEAP_PUSHES,       // Lowest-cost-first search: entries pushed on the priority queue
+    HEAP_POPS,         // ... entries popped from it
+    EDGE_RELAXATIONS,  // ... edges that lowered a node's cost
+    RULE_FIRINGS,      // Bottom-up proof: rules whose head was added as a new fact
+    SPLIT_EVALUATIONS, // Decision trees: candidate splits scored (each threshold of a numeric feature counts)
+    FORWARD_PASSES,    // Neural network: examples run forward
+    BACKWARD_PASSES,   // ... examples backpropagated
+    NUM_PROFILE_COUNTERS
+};
+
+inline const char* profile_counter_name(int counter) {
+    static const char* const names[NUM_PROFILE_COUNTERS] = {"heap_pushes",       "heap_pops",      "edge_relaxations",
+                                                            "rule_firings",      "split_evaluations",
+                                                            "forward_passes",    "backward_passes"};
+    return names[counter];
+}
+
+const size_t NUM_HARDWARE_COUNTERS = 4;
+
+inline const char* hardware_counter_name(size_t counter) {
+    static const char* const names[NUM_HARDWARE_COUNTERS] = {"cycles", "instructions", "cache_misses",
+                                                             "branch_misses"};
+    return names[counter];
+}
+
+/**
+ * @class HardwareCounters
+ * @brief The calling thread's CPU cycle, instruction, cache-miss and branch-miss counters.
+ *
+ * Opened with perf_event_open as one group counting user-space events of the
+ * opening thread only. Kernels or containers that forbid it (see
+ * /proc/sys/kernel/perf_event_paranoid), or events the CPU lacks, simply leave
+ * those counters unavailable; read() then reports them as zero.
+ */
+class HardwareCounters {
+public:
+    HardwareCounters() {
+#if defined(__linux__)
+        static const uint64_t configs[NUM_HARDWARE_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                                PERF_COUNT_HW_CACHE_MISSES,
+                                                                PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = leader_ < 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+            if (fd < 0) continue;
+            if (leader_ < 0) leader_ = fd;
+            slots_[num_open_] = i;
+            fds_[num_open_++] = fd;
+        }
+        if (leader_ >= 0) {
+            ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    ~HardwareCounters() {
+#if defined(__linux__)
+        for (size_t i = 0; i < num_open_; ++i) close(fds_[i]);
+#endif
+    }
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    /**
+     * @brief True if at least one counter could be opened
+     */
+    bool available() const { return num_open_ > 0; }
+
+    /**
+     * @brief Bitmask of the counters that are open (bit i is hardware_counter_name(i))
+     */
+    unsigned mask() const {
+        unsigned bits = 0;
+        for (size_t i = 0; i < num_open_; ++i) bits |= 1u << slots_[i];
+        return bits;
+    }
+
+    /**
+     * @brief Current values since the group was opened, zero for unavailable counters
+     */
+    std::array<uint64_t, NUM_HARDWARE_COUNTERS> read() const {
+        std::array<uint64_t, NUM_HARDWARE_COUNTERS> values{};
+#if defined(__linux__)
+        if (leader_ < 0) return values;
+        uint64_t buffer[1 + NUM_HARDWARE_COUNTERS] = {};
+        if (::read(leader_, buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(uint64_t))) return values;
+        for (size_t i = 0; i < num_open_ && i < buffer[0]; ++i) values[slots_[i]] = buffer[1 + i];
+#endif
+        return values;
+    }
+
+private:
+    int leader_ = -1;
+    size_t num_open_ = 0;
+    int fds_[NUM_HARDWARE_COUNTERS] = {};
+    size_t slots_[NUM_HARDWARE_COUNTERS] = {};
+};
+
+namespace profiling_detail {
+
+// Timer events kept per thread; later ones are dropped (and counted) so a long run cannot exhaust memory
+const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+struct TimerEvent {
+    const char* name; // String literal passed to FAI_SCOPED_TIMER
+    uint64_t start_ns, duration_ns;
+    unsigned hardware_mask;
+    std::array<uint64_t, NUM_HARDWARE_COUNTERS> hardware;
+};
+
+/**
+ * @brief Counters and timer events of one thread
+ *
+ * Only the owning thread writes `counts`; relaxed atomics make the concurrent
+ * reads of profile_totals() well defined and compile to plain loads and stores.
+ * The event mutex is taken by the owner for each timer and by the exporter, so
+ * it is uncontended except while exporting.
+ */
+struct alignas(64) ThreadProfile {
+    std::atomic<uint64_t> counts[NUM_PROFILE_COUNTERS] = {};
+    unsigned id = 0;
+    std::mutex events_mutex;
+    std::vector<TimerEvent> events;
+    uint64_t dropped_events = 0;
+    std::unique_ptr<HardwareCounters> hardware; // Opened on the thread's first timer when enabled
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadProfile>> threads;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<bool> hardware_enabled{false};
+};
+
+// Never destroyed, so threads that count during static destruction still have somewhere to write
+inline Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+inline ThreadProfile* register_thread() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(std::make_unique<ThreadProfile>());
+    r.threads.back()->id = static_cast<unsigned>(r.threads.size());
+    return r.threads.back().get();
+}
+
+inline ThreadProfile& this_thread() {
+    static thread_local ThreadProfile* profile = nullptr;
+    if (!profile) profile = register_thread();
+    return *profile;
+}
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch)
+            .count());
+}
+
+inline std::string json_string(const char* text) {
+    std::string out = "\"";
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        out += static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c;
+    }
+    return out + "\"";
+}
+
+} // namespace profiling_detail
+
+/**
+ * @brief Adds `n` to one of the calling thread's counters
+ */
+inline void profile_count(ProfileCounter counter, uint64_t n = 1) {
+    std::atomic<uint64_t>& value = profiling_detail::this_thread().counts[counter];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sums every counter over all threads
+ */
+inline std::array<uint64_t, NUM_PROFILE_COUNTERS> profile_totals() {
+    std::array<uint64_t, NUM_PROFILE_COUNTERS> totals{};
+    profiling_detail::Registry& r = profiling_detail::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& thread : r.threads) {
+        for (int c = 0; c < NUM_PROFILE_COUNTERS; ++c) totals[c] += thread->counts[c].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+/**
+ * @brief Turns the hardware counters of later timers on or off
+ */
+inline void enable_hardware_counters(bool enabled) {
+    profiling_detail::registry().hardware_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @class ScopedTimer
+ * @brief Records the time (and hardware counters) of its scope as one trace event.
+ *
+ * `name` must outlive the profile; FAI_SCOPED_TIMER passes string literals.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name_(name), thread_(profiling_detail::this_thread()) {
+        if (profiling_detail::registry().hardware_enabled.load(std::memory_order_relaxed)) {
+            if (!thread_.hardware) thread_.hardware = std::make_unique<HardwareCounters>();
+            if (thread_.hardware->available()) {
+                hardware_ = thread_.hardware.get();
+                hardware_start_ = hardware_->read();
+            }
+        }
+        start_ns_ = profiling_detail::now_ns();
+    }
+
+    ~ScopedTimer() {
+        profiling_detail::TimerEvent event;
+        event.name = name_;
+        event.start_ns = start_ns_;
+        event.duration_ns = profiling_detail::now_ns() - start_ns_;
+        event.hardware_mask = 0;
+        event.hardware = {};
+        if (hardware_) {
+            std::array<uint64_t, NUM_HARDWARE_COUNTERS> end = hardware_->read();
+            event.hardware_mask = hardware_->mask();
+            for (size_t i = 0; i < NUM_HARDWARE_COUNTERS; ++i) event.hardware[i] = end[i] - hardware_start_[i];
+        }
+        std::lock_guard<std::mutex> lock(thread_.events_mutex);
+        if (thread_.events.size() < profiling_detail::MAX_EVENTS_PER_THREAD) {
+            thread_.events.push_back(event);
+        } else {
+            thread_.dropped_events++;
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name_;
+    profiling_detail::ThreadProfile& thread_;
+    HardwareCounters* hardware_ = nullptr;
+    std::array<uint64_t, NUM_HARDWARE_COUNTERS> hardware_start_{};
+    uint64_t start_ns_ = 0;
+};
+
+/**
+ * @brief Writes all timer events and counter totals as a Chrome trace (JSON object format)
+ *
+ * Timers become complete ("X") events on their thread's track, with any hardware
+ * counter differences as args. The counter totals are one counter ("C") event at
+ * the end of the trace, and the per-thread breakdown is under "otherData".
+ */
+inline void write_chrome_trace(std::ostream& out) {
+    using profiling_detail::json_string;
+    profiling_detail::Registry& r = profiling_detail::registry();
+    const uint64_t end_ns = profiling_detail::now_ns();
+    const std::array<uint64_t, NUM_PROFILE_COUNTERS> totals = profile_totals();
+
+    std::lock_guard<std::mutex> lock(r.mutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"FAI\"}}";
+    for (const auto& thread : r.threads) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id
+            << ",\"args\":{\"name\":\"thread " << thread->id << "\"}}";
+        std::lock_guard<std::mutex> events_lock(thread->events_mutex);
+        for (const profiling_detail::TimerEvent& event : thread->events) {
+            out << ",\n{\"name\":" << json_string(event.name) << ",\"cat\":\"fai\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << thread->id << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0;
+            if (event.hardware_mask) {
+                out << ",\"args\":{";
+                const char* separator = "";
+                for (size_t i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+                    if (!(event.hardware_mask & (1u << i))) continue;
+                    out << separator << "\"" << hardware_counter_name(i) << "\":" << event.hardware[i];
+                    separator = ",";
+                }
+                out << "}";
+            }
+            out << "}";
+        }
+    }
+    out << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << end_ns / 1000.0 << ",\"args\":{";
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; ++c) {
+        out << (c ? "," : "") << "\"" << profile_counter_name(c) << "\":" << totals[c];
+    }
+    out << "}}\n],\n\"displayTimeUnit\":\"ns\",\n\"otherData\":{\"threads\":{";
+    for (size_t t = 0; t < r.threads.size(); ++t) {
+        const profiling_detail::ThreadProfile& thread = *r.threads[t];
+        out << (t ? "," : "") << "\"" << thread.id << "\":{";
+        for (int c = 0; c < NUM_PROFILE_COUNTERS; ++c) {
+            out << (c ? "," : "") << "\"" << profile_counter_name(c)
+                << "\":" << thread.counts[c].load(std::memory_order_relaxed);
+        }
+        out << ",\"dropped_events\":" << thread.dropped_events << "}";
+    }
+    out << "}}}\n";
+}
+
+/**
+ * @brief Prints the non-zero counters and, per timer name, calls, total time and hardware figures
+ */
+inline void print_profile_summary(std::ostream& out) {
+    struct TimerTotals {
+        uint64_t calls = 0, nanoseconds = 0;
+        unsigned hardware_mask = 0;
+        std::array<uint64_t, NUM_HARDWARE_COUNTERS> hardware{};
+    };
+    std::map<std::string, TimerTotals> timers;
+    profiling_detail::Registry& r = profiling_detail::registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& thread : r.threads) {
+            std::lock_guard<std::mutex> events_lock(thread->events_mutex);
+            for (const profiling_detail::TimerEvent& event : thread->events) {
+                TimerTotals& totals = timers[event.name];
+                totals.calls++;
+                totals.nanoseconds += event.duration_ns;
+                totals.hardware_mask |= event.hardware_mask;
+                for (size_t i = 0; i < NUM_HARDWARE_COUNTERS; ++i) totals.hardware[i] += event.hardware[i];
+            }
+        }
+    }
+
+    const std::array<uint64_t, NUM_PROFILE_COUNTERS> totals = profile_totals();
+    out << "Profile counters:" << std::endl;
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; ++c) {
+        if (totals[c]) out << "  " << std::left << std::setw(20) << profile_counter_name(c) << totals[c] << std::endl;
+    }
+    out << "Profile timers:" << std::endl;
+    for (const auto& timer : timers) {
+        out << "  " << std::left << std::setw(40) << timer.first << std::right << std::setw(8) << timer.second.calls
+            << " calls " << std::fixed << std::setprecision(3) << std::setw(12) << timer.second.nanoseconds / 1e6
+            << " ms";
+        for (size_t i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+            if (timer.second.hardware_mask & (1u << i)) {
+                out << "  " << hardware_counter_name(i) << "=" << timer.second.hardware[i];
+            }
+        }
+        out << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+/**
+ * @class ProfileSession
+ * @brief Reports the profile when it goes out of scope (see FAI_PROFILE_SESSION).
+ */
+class ProfileSession {
+public:
+    ProfileSession() {
+        const char* perf = std::getenv("FAI_PERF");
+        if (perf && std::strcmp(perf, "0") != 0) enable_hardware_counters(true);
+        const char* trace = std::getenv("FAI_TRACE");
+        if (trace) trace_path_ = trace;
+    }
+
+    ~ProfileSession() {
+        print_profile_summary(std::cerr);
+        if (trace_path_.empty()) return;
+        std::ofstream out(trace_path_);
+        if (out) {
+            write_chrome_trace(out);
+            std::cerr << "Wrote trace to " << trace_path_ << std::endl;
+        } else {
+            std::cerr << "Cannot write trace to " << trace_path_ << std::endl;
+        }
+    }
+
+    ProfileSession(const ProfileSession&) = delete;
+    ProfileSession& operator=(const ProfileSession&) = delete;
+
+private:
+    std::string trace_path_;
+};
+
+#define FAI_PROFILING_CONCAT_(a, b) a##b
+#define FAI_PROFILING_CONCAT(a, b) FAI_PROFILING_CONCAT_(a, b)
+#define FAI_COUNT(counter) ::profile_count(::counter)
+#define FAI_COUNT_N(counter, n) ::profile_count(::counter, static_cast<uint64_t>(n))
+#define FAI_SCOPED_TIMER(name) ::ScopedTimer FAI_PROFILING_CONCAT(fai_scoped_timer_, __LINE__)(name)
+#define FAI_PROFILE_SESSION() ::ProfileSession fai_profile_session
+
+#else
+
+#define FAI_COUNT(counter) ((void)0)
+#define FAI_COUNT_N(counter, n) ((void)0)
+#define FAI_SCOPED_TIMER(name) ((void)0)
+#define FAI_PROFILE_SESSION() ((void)0)
+
+#endif // FAI_PROFILING
+
+#endif // FAI_COMMON_PROFILING_H
@@ -0,0 +1,76 @@
+#ifndef FAI_COMMON_QUANTIZE_H
+#define FAI_COMMON_QUANTIZE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Symmetric int8 quantisation helpers for post-training quantised models.
+ *
+ * A real value x is stored as q = round(x / scale) clamped to [-127, 127], with
+ * scale = max|x| / 127 taken from the weights themselves or from calibration
+ * data. A dot product of two quantised vectors is accumulated exactly in int32
+ * and dequantised once with the product of the two scales.
+ */
+
+/**
+ * @brief Scale that maps [-max_abs, max_abs] onto [-127, 127] (1 if max_abs is 0)
+ */
+inline float symmetric_scale(float max_abs) {
+    return max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+}
+
+/**
+ * @brief Largest absolute value of n floats
+ */
+inline float max_abs(const float* values, size_t n) {
+    float largest = 0.0f;
+    for (size_t i = 0; i < n; ++i) largest = std::max(largest, std::fabs(values[i]));
+    return largest;
+}
+
+/**
+ * @brief out[i] = round(values[i] / scale), clamped to [-127, 127]
+ */
+inline void quantize_symmetric(const float* values, size_t n, float scale, int8_t* out) {
+    // Adding and subtracting 1.5 * 2^23 rounds a float of magnitude below 2^22 to
+    // the nearest integer without a library call, so the loop vectorises
+    const float inverse = 1.0f / scale, round_magic = 12582912.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float q = std::min(127.0f, std::max(-127.0f, values[i] * inverse));
+        out[i] = static_cast<int8_t>((q + round_magic) - round_magic);
+    }
+}
+
+/**
+ * @brief Exact int32 dot product of two int8 vectors
+ *
+ * With AVX2, 16 pairs per step are sign-extended to int16, then multiplied and
+ * pairwise added into int32 lanes by one madd. Since |q| <= 127, the int32 sum
+ * cannot overflow for vectors shorter than 133000 elements.
+ */
+inline int32_t dot_int8(const int8_t* a, const int8_t* b, size_t n) {
+    size_t i = 0;
+    int32_t sum = 0;
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (const size_t vector_end = n - n % 16; i < vector_end; i += 16) {
+        __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtsi128_si32(half);
+#endif
+    for (; i < n; ++i) sum += static_cast<int32_t>(a[i]) * b[i];
+    return sum;
+}
+
+#endif // FAI_COMMON_QUANTIZE_H
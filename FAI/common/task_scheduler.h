@@ -0,0 +1,249 @@
+#ifndef FAI_COMMON_TASK_SCHEDULER_H
+#define FAI_COMMON_TASK_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct TaskGroup
+ * @brief Counts the outstanding tasks of one fork-join region.
+ *
+ * Tasks are spawned into a group and the spawning code later calls
+ * TaskScheduler::wait on the same group. A group lives on the stack of the
+ * function that forks the work, so it must outlive every task it tracks.
+ *
+ * The first exception thrown by one of its tasks is kept in `error` and
+ * rethrown by wait() once every task of the group has finished.
+ */
+struct TaskGroup {
+    std::atomic<size_t> pending{0};
+    std::mutex mutex;              // Guards `error` and the last decrement of `pending`
+    std::condition_variable done;  // Signalled when `pending` drops to zero
+    std::exception_ptr error;
+};
+
+/**
+ * @class TaskScheduler
+ * @brief Work-stealing thread pool for nested fork-join parallelism.
+ *
+ * Every worker owns a deque of tasks:
+ * - A worker pushes the tasks it spawns to the back of its own deque and pops
+ *   from the back as well (LIFO), so it keeps working depth-first on data that
+ *   is still in its cache.
+ * - An idle worker steals from the front of another worker's deque (FIFO), which
+ *   hands it the oldest and usually largest piece of outstanding work.
+ *
+ * Threads that are not workers (for example `main`) push to a shared injection
+ * deque. A worker that calls wait() does not block: it keeps running tasks until
+ * its group is finished, so recursive algorithms can fork and join at any depth
+ * without deadlocking the pool. Any other thread helps while there is queued
+ * work and then sleeps until the group's last task signals it.
+ *
+ * Example:
+ *   TaskScheduler scheduler(8);
+ *   TaskGroup group;
+ *   scheduler.spawn(group, [&] { left = build(left_half); });
+ *   scheduler.spawn(group, [&] { right = build(right_half); });
+ *   scheduler.wait(group);
+ */
+class TaskScheduler {
+public:
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param num_threads Number of workers; 0 uses one per hardware thread.
+     */
+    explicit TaskScheduler(unsigned num_threads = 0) {
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // Deque 0 is the injection deque used by non-worker threads.
+        for (unsigned i = 0; i <= num_threads; ++i) {
+            deques_.emplace_back(new WorkDeque);
+        }
+        for (unsigned i = 1; i <= num_threads; ++i) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief Number of worker threads (not counting threads that help in wait()).
+     */
+    size_t num_threads() const { return workers_.size(); }
+
+    /**
+     * @brief Queues a task that belongs to the given group.
+     *
+     * @param group Group that wait() is later called on.
+     * @param fn Work to run; it may itself spawn and wait on other groups.
+     */
+    void spawn(TaskGroup& group, std::function<void()> fn) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        WorkDeque& deque = *deques_[current_deque()];
+        {
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            deque.tasks.push_back(Task{std::move(fn), &group});
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        // Taking the sleep lock orders this wake-up after a worker's predicate check.
+        { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+        wake_.notify_one();
+    }
+
+    /**
+     * @brief Runs queued tasks on the calling thread until the group is finished.
+     *
+     * Rethrows the first exception thrown by a task of the group, after all of
+     * its tasks have finished (so none of them still refers to the group).
+     */
+    void wait(TaskGroup& group) {
+        const bool worker = tls_owner_ == this;
+        while (group.pending.load(std::memory_order_acquire) > 0) {
+            Task task;
+            if (take_task(current_deque(), task)) {
+                run(task);
+            } else if (worker) {
+                std::this_thread::yield();
+            } else {
+                std::unique_lock<std::mutex> lock(group.mutex);
+                group.done.wait(lock, [&group] { return group.pending.load(std::memory_order_acquire) == 0; });
+            }
+        }
+        // The last task decrements and signals under the lock; taking it here means that
+        // task has let go of the group before the caller may destroy it.
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            std::swap(error, group.error);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    /**
+     * @brief Calls fn(i) for every i in [begin, end) and returns once all calls finish.
+     *
+     * The range is cut into about four contiguous chunks per worker, each one
+     * task that calls fn for its indices in order.
+     */
+    template <typename Fn>
+    void parallel_for(size_t begin, size_t end, Fn fn) {
+        if (begin >= end) return;
+        const size_t num_chunks = std::min(end - begin, std::max<size_t>(1, num_threads() * 4));
+        const size_t chunk = (end - begin + num_chunks - 1) / num_chunks;
+        TaskGroup group;
+        for (size_t start = begin; start < end; start += chunk) {
+            const size_t stop = std::min(end, start + chunk);
+            spawn(group, [&fn, start, stop] {
+                for (size_t i = start; i < stop; ++i) fn(i);
+            });
+        }
+        wait(group);
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+    };
+
+    struct WorkDeque {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkDeque>> deques_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    // Which scheduler the current thread works for, and the deque it owns there.
+    static inline thread_local const TaskScheduler* tls_owner_ = nullptr;
+    static inline thread_local size_t tls_deque_ = 0;
+
+    size_t current_deque() const {
+        return tls_owner_ == this ? tls_deque_ : 0;
+    }
+
+    static void run(Task& task) {
+        TaskGroup& group = *task.group;
+        std::exception_ptr error;
+        try {
+            task.fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (error && !group.error) group.error = error;
+        if (group.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) group.done.notify_all();
+    }
+
+    /**
+     * @brief Pops from the back of the own deque, otherwise steals from the front of another.
+     */
+    bool take_task(size_t self, Task& task) {
+        if (queued_.load(std::memory_order_acquire) == 0) return false;
+        {
+            WorkDeque& own = *deques_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (size_t k = 1; k < deques_.size(); ++k) {
+            WorkDeque& victim = *deques_[(self + k) % deques_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t self) {
+        tls_owner_ = this;
+        tls_deque_ = self;
+        while (true) {
+            Task task;
+            if (take_task(self, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] {
+                return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+            });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+        }
+    }
+};
+
+#endif // FAI_COMMON_TASK_SCHEDULER_H
@@ -0,0 +1,374 @@
+#ifndef FAI_COMMON_TRAINING_H
+#define FAI_COMMON_TRAINING_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Convergence-aware training: learning-rate schedules, SGD / momentum / Adam
+ * updates, validation-based early stopping, and binary checkpoints from which
+ * an interrupted run resumes exactly where it stopped.
+ *
+ * All of it works on a flat parameter array, so any learner that can export its
+ * weights (e.g. NeuralNetwork::get_parameters) and compute a descent direction
+ * per batch can use it.
+ */
+
+/**
+ * @struct LearningRateSchedule
+ * @brief The learning rate of each epoch as a multiple of the base rate.
+ *
+ * - Constant: the base rate throughout.
+ * - Step: multiplied by `step_factor` every `step_epochs` epochs.
+ * - Cosine: falls along half a cosine from the base rate at epoch 0 to
+ *   `min_fraction` times the base rate at epoch `total_epochs`, and stays there.
+ *
+ * Example: LearningRateSchedule::step(10, 0.5).rate(0.8, 25) == 0.2
+ */
+struct LearningRateSchedule {
+    enum class Kind { Constant, Step, Cosine };
+
+    Kind kind = Kind::Constant;
+    int step_epochs = 10;
+    double step_factor = 0.5;
+    int total_epochs = 80;
+    double min_fraction = 0.0;
+
+    static LearningRateSchedule constant() { return LearningRateSchedule(); }
+
+    static LearningRateSchedule step(int every, double factor) {
+        LearningRateSchedule schedule;
+        schedule.kind = Kind::Step;
+        schedule.step_epochs = every;
+        schedule.step_factor = factor;
+        return schedule;
+    }
+
+    static LearningRateSchedule cosine(int total_epochs, double min_fraction = 0.0) {
+        LearningRateSchedule schedule;
+        schedule.kind = Kind::Cosine;
+        schedule.total_epochs = total_epochs;
+        schedule.min_fraction = min_fraction;
+        return schedule;
+    }
+
+    /**
+     * @brief Learning rate of epoch `epoch` (counted from 0)
+     */
+    double rate(double base_rate, int epoch) const {
+        switch (kind) {
+        case Kind::Step:
+            return base_rate * std::pow(step_factor, step_epochs > 0 ? epoch / step_epochs : 0);
+        case Kind::Cosine: {
+            if (total_epochs <= 0 || epoch >= total_epochs) return base_rate * min_fraction;
+            const double progress = static_cast<double>(epoch) / total_epochs;
+            const double pi = 3.14159265358979323846;
+            return base_rate * (min_fraction + (1.0 - min_fraction) * 0.5 * (1.0 + std::cos(pi * progress)));
+        }
+        case Kind::Constant:
+            break;
+        }
+        return base_rate;
+    }
+};
+
+enum class OptimizerKind { SGD, Momentum, Adam };
+
+/**
+ * @struct OptimizerOptions
+ * @brief Which update rule to use and its hyper-parameters.
+ */
+struct OptimizerOptions {
+    OptimizerKind kind = OptimizerKind::SGD;
+    double momentum = 0.9; // Momentum: fraction of the previous step carried over
+    double beta1 = 0.9;    // Adam: decay of the first-moment average
+    double beta2 = 0.999;  // Adam: decay of the second-moment average
+    double epsilon = 1e-8; // Adam: added to the root of the second moment
+};
+
+/**
+ * @class Optimizer
+ * @brief Applies one update per batch to a flat parameter array.
+ *
+ * step() takes the batch's descent direction, i.e. the negative gradient of the
+ * loss averaged over the batch, and moves the parameters by:
+ *
+ *   SGD       p += rate * d
+ *   Momentum  v = momentum * v + d;  p += rate * v
+ *   Adam      m = b1 * m + (1 - b1) * d;  s = b2 * s + (1 - b2) * d^2;
+ *             p += rate * m_hat / (sqrt(s_hat) + epsilon), with the usual bias correction
+ *
+ * The moments are kept in double whatever the parameter type, and are part of
+ * a TrainingCheckpoint so that a resumed run continues with the same state.
+ */
+class Optimizer {
+public:
+    Optimizer(const OptimizerOptions& options, size_t num_parameters)
+        : options_(options), first_(num_parameters, 0.0),
+          second_(options.kind == OptimizerKind::Adam ? num_parameters : 0, 0.0) {}
+
+    template <typename T>
+    void step(T* params, const T* direction, double rate) {
+        steps_++;
+        switch (options_.kind) {
+        case OptimizerKind::SGD:
+            for (size_t k = 0; k < first_.size(); ++k) params[k] += static_cast<T>(rate * direction[k]);
+            break;
+        case OptimizerKind::Momentum:
+            for (size_t k = 0; k < first_.size(); ++k) {
+                first_[k] = options_.momentum * first_[k] + direction[k];
+                params[k] += static_cast<T>(rate * first_[k]);
+            }
+            break;
+        case OptimizerKind::Adam: {
+            const double first_correction = 1.0 - std::pow(options_.beta1, static_cast<double>(steps_));
+            const double second_correction = 1.0 - std::pow(options_.beta2, static_cast<double>(steps_));
+            for (size_t k = 0; k < first_.size(); ++k) {
+                const double d = direction[k];
+                first_[k] = options_.beta1 * first_[k] + (1.0 - options_.beta1) * d;
+                second_[k] = options_.beta2 * second_[k] + (1.0 - options_.beta2) * d * d;
+                const double m_hat = first_[k] / first_correction, s_hat = second_[k] / second_correction;
+                params[k] += static_cast<T>(rate * m_hat / (std::sqrt(s_hat) + options_.epsilon));
+            }
+            break;
+        }
+        }
+    }
+
+    uint64_t steps() const { return steps_; }
+    const std::vector<double>& first_moment() const { return first_; }
+    const std::vector<double>& second_moment() const { return second_; }
+
+    /**
+     * @brief Restores the state saved in a checkpoint; false if it does not fit this optimizer
+     */
+    bool restore(uint64_t steps, const std::vector<double>& first, const std::vector<double>& second) {
+        if (first.size() != first_.size() || second.size() != second_.size()) return false;
+        steps_ = steps;
+        first_ = first;
+        second_ = second;
+        return true;
+    }
+
+private:
+    OptimizerOptions options_;
+    std::vector<double> first_;  // Momentum velocity or Adam first moment
+    std::vector<double> second_; // Adam second moment (empty otherwise)
+    uint64_t steps_ = 0;
+};
+
+/**
+ * @struct EarlyStopping
+ * @brief Tracks the validation loss and says when it has stopped improving.
+ *
+ * An epoch improves if its loss is below the best so far by more than
+ * `min_delta`. Training should stop after `patience` epochs in a row without
+ * improvement; patience 0 never stops.
+ */
+struct EarlyStopping {
+    int patience = 0;
+    double min_delta = 0.0;
+    double best_loss = std::numeric_limits<double>::infinity();
+    int best_epoch = 0; // Epochs completed when the best loss was seen
+    int stale_epochs = 0;
+
+    /**
+     * @brief Records the loss after `epoch` completed epochs; true if it is a new best
+     */
+    bool update(double loss, int epoch) {
+        if (loss < best_loss - min_delta) {
+            best_loss = loss;
+            best_epoch = epoch;
+            stale_epochs = 0;
+            return true;
+        }
+        stale_epochs++;
+        return false;
+    }
+
+    bool should_stop() const { return patience > 0 && stale_epochs >= patience; }
+};
+
+/**
+ * @struct TrainingOptions
+ * @brief Everything a convergence-aware training run needs besides the data.
+ */
+struct TrainingOptions {
+    int max_epochs = 80;
+    size_t batch_size = 1;
+    LearningRateSchedule schedule;
+    OptimizerOptions optimizer;
+    int patience = 0;       // See EarlyStopping; needs validation rows
+    double min_delta = 0.0; // See EarlyStopping
+    std::string checkpoint; // Saved after every epoch; empty disables
+    bool resume = false;    // Continue from `checkpoint` if it was written by the same configuration
+};
+
+/**
+ * @struct TrainingReport
+ * @brief What a training run did.
+ */
+struct TrainingReport {
+    int epochs_run = 0;     // Epochs completed, including those before a resume
+    int resumed_from = 0;   // Epochs restored from the checkpoint (0 for a fresh run)
+    int best_epoch = 0;     // Epoch whose weights were kept
+    double best_loss = std::numeric_limits<double>::infinity(); // Its validation loss
+    bool stopped_early = false;
+};
+
+/**
+ * @struct TrainingCheckpoint
+ * @brief The complete state of a run after `epoch` epochs.
+ */
+struct TrainingCheckpoint {
+    int32_t epoch = 0;
+    std::vector<double> parameters;
+    std::vector<double> best_parameters;
+    std::vector<double> first_moment;
+    std::vector<double> second_moment;
+    uint64_t optimizer_steps = 0;
+    double best_loss = std::numeric_limits<double>::infinity();
+    int32_t best_epoch = 0;
+    int32_t stale_epochs = 0;
+    uint64_t fingerprint = 0; // run_fingerprint of the run that wrote it
+};
+
+// Starting value of a fingerprint (the FNV-1a offset basis)
+const uint64_t FINGERPRINT_SEED = 14695981039346656037ull;
+
+/**
+ * @brief Folds `bytes` bytes into a 64-bit FNV-1a hash
+ */
+inline uint64_t fingerprint_bytes(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) hash = (hash ^ p[i]) * 1099511628211ull;
+    return hash;
+}
+
+template <typename T>
+inline uint64_t fingerprint_value(uint64_t hash, const T& value) {
+    return fingerprint_bytes(hash, &value, sizeof(value));
+}
+
+/**
+ * @brief Hash of everything in `options` that shapes the weights after a given epoch
+ *
+ * Covers the base rate, batch size, schedule, optimiser and early-stopping
+ * settings. max_epochs is left out on purpose: it only says where the run
+ * stops, so raising it is how a finished or interrupted run is continued. A
+ * learner mixes its training data into the result with fingerprint_bytes, and
+ * stores it in every checkpoint so that a resume under a different
+ * configuration is refused.
+ */
+inline uint64_t run_fingerprint(const TrainingOptions& options, double base_rate) {
+    uint64_t hash = FINGERPRINT_SEED;
+    hash = fingerprint_value(hash, base_rate);
+    hash = fingerprint_value(hash, static_cast<uint64_t>(options.batch_size));
+    hash = fingerprint_value(hash, static_cast<int32_t>(options.schedule.kind));
+    hash = fingerprint_value(hash, static_cast<int32_t>(options.schedule.step_epochs));
+    hash = fingerprint_value(hash, options.schedule.step_factor);
+    hash = fingerprint_value(hash, static_cast<int32_t>(options.schedule.total_epochs));
+    hash = fingerprint_value(hash, options.schedule.min_fraction);
+    hash = fingerprint_value(hash, static_cast<int32_t>(options.optimizer.kind));
+    hash = fingerprint_value(hash, options.optimizer.momentum);
+    hash = fingerprint_value(hash, options.optimizer.beta1);
+    hash = fingerprint_value(hash, options.optimizer.beta2);
+    hash = fingerprint_value(hash, options.optimizer.epsilon);
+    hash = fingerprint_value(hash, static_cast<int32_t>(options.patience));
+    hash = fingerprint_value(hash, options.min_delta);
+    return hash;
+}
+
+namespace training_detail {
+
+const char CHECKPOINT_MAGIC[8] = {'F', 'A', 'I', 'C', 'K', 'P', 'T', '2'};
+
+// Fixed-size file header; the four arrays follow in this order, as doubles
+struct CheckpointHeader {
+    char magic[8];
+    int32_t epoch;
+    int32_t best_epoch;
+    int32_t stale_epochs;
+    int32_t reserved;
+    uint64_t optimizer_steps;
+    uint64_t fingerprint;
+    double best_loss;
+    uint64_t sizes[4];
+};
+
+} // namespace training_detail
+
+/**
+ * @brief Writes a checkpoint to `filename`; false if the file cannot be written
+ *
+ * The data goes to `filename + ".tmp"` first and is renamed over `filename` only
+ * when complete, so a run killed mid-write leaves the previous checkpoint intact.
+ * The file is native-endian and meant to be read back on the same machine.
+ */
+inline bool save_checkpoint(const TrainingCheckpoint& checkpoint, const std::string& filename) {
+    using namespace training_detail;
+    const std::vector<double>* arrays[4] = {&checkpoint.parameters, &checkpoint.best_parameters,
+                                            &checkpoint.first_moment, &checkpoint.second_moment};
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.epoch = checkpoint.epoch;
+    header.best_epoch = checkpoint.best_epoch;
+    header.stale_epochs = checkpoint.stale_epochs;
+    header.optimizer_steps = checkpoint.optimizer_steps;
+    header.fingerprint = checkpoint.fingerprint;
+    header.best_loss = checkpoint.best_loss;
+    for (int a = 0; a < 4; ++a) header.sizes[a] = arrays[a]->size();
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto* array : arrays) {
+            file.write(reinterpret_cast<const char*>(array->data()),
+                       static_cast<std::streamsize>(array->size() * sizeof(double)));
+        }
+        if (!file) return false;
+    }
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+/**
+ * @brief Reads a checkpoint written by save_checkpoint; false if it is missing, truncated or not a checkpoint
+ */
+inline bool load_checkpoint(const std::string& filename, TrainingCheckpoint& checkpoint) {
+    using namespace training_detail;
+    std::ifstream file(filename, std::ios::binary);
+    CheckpointHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) return false;
+
+    TrainingCheckpoint loaded;
+    std::vector<double>* arrays[4] = {&loaded.parameters, &loaded.best_parameters, &loaded.first_moment,
+                                      &loaded.second_moment};
+    for (int a = 0; a < 4; ++a) {
+        if (header.sizes[a] > (1u << 30)) return false;
+        arrays[a]->resize(header.sizes[a]);
+        if (!file.read(reinterpret_cast<char*>(arrays[a]->data()),
+                       static_cast<std::streamsize>(header.sizes[a] * sizeof(double)))) {
+            return false;
+        }
+    }
+    loaded.epoch = header.epoch;
+    loaded.best_epoch = header.best_epoch;
+    loaded.stale_epochs = header.stale_epochs;
+    loaded.optimizer_steps = header.optimizer_steps;
+    loaded.fingerprint = header.fingerprint;
+    loaded.best_loss = header.best_loss;
+    checkpoint = std::move(loaded);
+    return true;
+}
+
+#endif // FAI_COMMON_TRAINING_H